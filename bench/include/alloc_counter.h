@@ -0,0 +1,16 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+
+/**
+ * \brief Number of operator new calls made by the benchmark binary
+ */
+size_t allocations_count();
@@ -0,0 +1,103 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+/**
+ * \brief Temporary CIS base dir shared by benchmarks
+ *
+ * Core executables are taken from the directory of benchmark binary,
+ * so the benchmark runs against the build it belongs to.
+ */
+class bench_env
+{
+public:
+    static bench_env& instance()
+    {
+        static bench_env env;
+
+        return env;
+    }
+
+    void init(const std::filesystem::path& argv0)
+    {
+        tools_dir_ = std::filesystem::absolute(argv0).parent_path();
+        base_dir_ = std::filesystem::temp_directory_path()
+                  / ("cis1_core_bench_" + std::to_string(::getpid()));
+
+        // Set before any benchmark runs, so in-process benchmarks
+        // don't depend on registration order
+        ::setenv("cis_base_dir", base_dir_.c_str(), 1);
+
+        std::filesystem::create_directories(base_dir_ / "core");
+        std::filesystem::create_directories(base_dir_ / "sessions");
+        std::filesystem::create_directories(base_dir_ / "logs");
+        std::filesystem::create_directories(base_dir_ / "jobs" / "bench" / "noop");
+
+        std::ofstream cis_conf(base_dir_ / "core" / "cis.conf");
+        for(auto tool : {
+                "startjob",
+                "setparam",
+                "getparam",
+                "setvalue",
+                "getvalue",
+                "cis_cron",
+                "cis_cron_daemon",
+                "maintenance"})
+        {
+            cis_conf << tool << "=" << tool << "\n";
+
+            std::filesystem::create_symlink(
+                    tools_dir_ / tool,
+                    base_dir_ / "core" / tool);
+        }
+
+        auto job_dir = base_dir_ / "jobs" / "bench" / "noop";
+
+        std::ofstream(job_dir / "job.conf")
+                << "script=script\n"
+                << "keep_last_success_builds=1\n"
+                << "keep_last_break_builds=1\n";
+
+        std::ofstream(job_dir / "script") << "#!/bin/sh\n";
+
+        std::filesystem::permissions(
+                job_dir / "script",
+                std::filesystem::perms::owner_all);
+    }
+
+    ~bench_env()
+    {
+        if(!base_dir_.empty())
+        {
+            std::error_code ec;
+            std::filesystem::remove_all(base_dir_, ec);
+        }
+    }
+
+    const std::filesystem::path& tools_dir() const
+    {
+        return tools_dir_;
+    }
+
+    const std::filesystem::path& base_dir() const
+    {
+        return base_dir_;
+    }
+
+private:
+    std::filesystem::path tools_dir_;
+    std::filesystem::path base_dir_;
+};
@@ -0,0 +1,161 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "bench_env.h"
+#include "build_index.h"
+#include "os.h"
+
+constexpr int query_projects = 10;
+constexpr int query_jobs = 100;
+constexpr int query_builds_per_job = 100;
+
+std::string job_name(int project, int job)
+{
+    return "project_" + std::to_string(project) + "/job_" + std::to_string(job);
+}
+
+/**
+ * Base dir with 1k jobs by 100 builds, every 10th build is broken,
+ * every job has builds.index.
+ */
+const std::filesystem::path& query_base_dir()
+{
+    static const auto dir = []()
+    {
+        auto dir = bench_env::instance().base_dir() / "query";
+
+        for(int p = 0; p < query_projects; ++p)
+        {
+            for(int j = 0; j < query_jobs; ++j)
+            {
+                auto job_dir = dir / "jobs" / job_name(p, j);
+
+                std::filesystem::create_directories(job_dir);
+                std::ofstream(job_dir / "job.conf") << "script=script\n";
+
+                std::ofstream index(job_dir / "builds.index");
+
+                for(int b = 0; b < query_builds_per_job; ++b)
+                {
+                    std::stringstream ss;
+                    ss << std::setfill('0') << std::setw(6) << b;
+
+                    auto build_dir = job_dir / ss.str();
+                    auto exit_code = b % 10 == 0 ? 1 : 0;
+                    auto session_id = "session_" + std::to_string(b);
+
+                    std::filesystem::create_directory(build_dir);
+                    std::ofstream(build_dir / "exitcode.txt") << exit_code << "\n";
+                    std::ofstream(build_dir / "session_id.txt") << session_id << "\n";
+
+                    cis1::build_record record;
+                    record.number = b;
+                    record.state = exit_code == 0
+                            ? cis1::build_state::successful
+                            : cis1::build_state::broken;
+                    record.exit_code = exit_code;
+                    record.started = 1500000000 + b * 60;
+                    record.finished = record.started + 30;
+                    record.session_id = session_id;
+
+                    cis1::write_build_record(index, record);
+                }
+            }
+        }
+
+        return dir;
+    }();
+
+    return dir;
+}
+
+void query_last_broken_of_job(benchmark::State& state)
+{
+    auto& dir = query_base_dir();
+    cis1::os std_os;
+
+    cis1::build_filter filter;
+    filter.job = cis1::job_mask::compile("project_3/job_42");
+    filter.state = cis1::build_state::broken;
+    filter.limit = 50;
+
+    for(auto _ : state)
+    {
+        std::error_code ec;
+
+        auto builds = cis1::query_builds(dir, filter, ec, std_os);
+
+        benchmark::DoNotOptimize(builds);
+    }
+}
+
+BENCHMARK(query_last_broken_of_job)
+    ->Unit(benchmark::kMillisecond);
+
+void query_session_all_jobs(benchmark::State& state)
+{
+    auto& dir = query_base_dir();
+    cis1::os std_os;
+
+    cis1::build_filter filter;
+    filter.session_id = "session_42";
+
+    for(auto _ : state)
+    {
+        std::error_code ec;
+
+        auto builds = cis1::query_builds(dir, filter, ec, std_os);
+
+        benchmark::DoNotOptimize(builds);
+    }
+}
+
+BENCHMARK(query_session_all_jobs)
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * What query costs without index: every build dir is opened.
+ */
+void scan_build_dirs_all_jobs(benchmark::State& state)
+{
+    auto& dir = query_base_dir();
+    cis1::os std_os;
+
+    for(auto _ : state)
+    {
+        size_t count = 0;
+
+        for(int p = 0; p < query_projects; ++p)
+        {
+            for(int j = 0; j < query_jobs; ++j)
+            {
+                std::error_code ec;
+
+                auto name = job_name(p, j);
+
+                count += cis1::scan_build_dirs(
+                        dir / "jobs" / name,
+                        name,
+                        ec,
+                        std_os).size();
+            }
+        }
+
+        benchmark::DoNotOptimize(count);
+    }
+}
+
+BENCHMARK(scan_build_dirs_all_jobs)
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,267 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include <cis1_proto_utils/read_istream_kv_str.h>
+
+#include "bench_env.h"
+#include "context.h"
+#include "job.h"
+#include "memory_os.h"
+#include "os.h"
+#include "session.h"
+
+/**
+ * Parsing of key-value files: cis.conf, job.conf, job.params and session
+ * values share read_istream_kv_str. Values have escaped characters,
+ * decoding is measured separately.
+ */
+std::string make_kv_file(int64_t keys)
+{
+    std::stringstream ss;
+
+    for(int64_t i = 0; i < keys; ++i)
+    {
+        ss << "key_" << i << "=value \\= " << i << " with \\\\ escapes\n";
+    }
+
+    return ss.str();
+}
+
+void read_kv(benchmark::State& state, bool decode)
+{
+    const auto content = make_kv_file(state.range(0));
+
+    for(auto _ : state)
+    {
+        std::stringstream ss(content);
+        std::map<std::string, std::string> values;
+        std::error_code ec;
+
+        cis1::proto_utils::read_istream_kv_str(ss, values, ec, decode);
+
+        benchmark::DoNotOptimize(values);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * content.size());
+}
+
+BENCHMARK_CAPTURE(read_kv, raw, false)
+    ->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK_CAPTURE(read_kv, decoded, true)
+    ->Arg(10)->Arg(100)->Arg(1000);
+
+/**
+ * Base dir with jobs/config/job_${params} jobs, each has job.conf,
+ * script and job.params with given count of params.
+ */
+const std::filesystem::path& config_base_dir()
+{
+    static const auto dir = []()
+    {
+        auto dir = bench_env::instance().base_dir() / "config";
+
+        for(int params : {0, 10, 100, 1000})
+        {
+            auto job_dir = dir / "jobs" / "config" / ("job_" + std::to_string(params));
+
+            std::filesystem::create_directories(job_dir);
+
+            std::ofstream(job_dir / "job.conf")
+                    << "script=script\n"
+                    << "keep_last_success_builds=5\n"
+                    << "keep_last_break_builds=5\n"
+                    << "timeout=600\n";
+
+            std::ofstream(job_dir / "script") << "#!/bin/sh\n";
+
+            std::filesystem::permissions(
+                    job_dir / "script",
+                    std::filesystem::perms::owner_all);
+
+            std::ofstream job_params(job_dir / "job.params");
+            for(int i = 0; i < params; ++i)
+            {
+                job_params << "param_" << i << "=default " << i << "\n";
+            }
+        }
+
+        std::filesystem::create_directories(dir / "sessions");
+
+        return dir;
+    }();
+
+    return dir;
+}
+
+void load_job(benchmark::State& state)
+{
+    cis1::os std_os;
+    cis1::context ctx(config_base_dir(), {});
+
+    const auto name = "config/job_" + std::to_string(state.range(0));
+
+    for(auto _ : state)
+    {
+        std::error_code ec;
+
+        auto job = cis1::load_job(name, ec, ctx, std_os);
+
+        benchmark::DoNotOptimize(job);
+    }
+}
+
+BENCHMARK(load_job)
+    ->Arg(0)->Arg(10)->Arg(100)->Arg(1000)
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * Build directory creation: build number, script, job.conf and job.params
+ * copies. Created build is removed outside of measurement, so the job
+ * always has the same count of builds.
+ */
+void prepare_build(benchmark::State& state)
+{
+    cis1::os std_os;
+    cis1::context ctx(config_base_dir(), {});
+    cis1::session session{"bench_session", false};
+
+    const auto name = "config/job_" + std::to_string(state.range(0));
+
+    std::error_code ec;
+
+    auto job = cis1::load_job(name, ec, ctx, std_os);
+    if(ec)
+    {
+        state.SkipWithError(ec.message().c_str());
+
+        return;
+    }
+
+    auto params = job->params();
+
+    for(auto _ : state)
+    {
+        auto handle = job->prepare_build(ctx, session, params, ec);
+        if(ec)
+        {
+            state.SkipWithError(ec.message().c_str());
+
+            break;
+        }
+
+        state.PauseTiming();
+        std::filesystem::remove_all(
+                config_base_dir() / "jobs" / name / handle.number_string());
+        state.ResumeTiming();
+    }
+}
+
+BENCHMARK(prepare_build)
+    ->Arg(0)->Arg(100)
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * Same as load_job and prepare_build over cis1::memory_os, isolates CPU
+ * cost from the filesystem. Job has given count of existing builds,
+ * prepare_build lists all of them to get the next build number.
+ */
+void seed_memory_job(cis1::memory_os& os, int64_t builds)
+{
+    std::error_code ec;
+
+    os.write_file(
+            "/base/jobs/job/job.conf",
+            "script=script\n"
+            "keep_last_success_builds=5\n"
+            "keep_last_break_builds=5\n",
+            ec);
+    os.write_file("/base/jobs/job/job.params", make_kv_file(10), ec);
+    os.write_file("/base/jobs/job/script", "#!/bin/sh\n", ec, true);
+
+    for(int64_t i = 0; i < builds; ++i)
+    {
+        char name[8];
+        std::snprintf(name, sizeof(name), "%06d", static_cast<int>(i));
+
+        os.create_directories(std::filesystem::path{"/base/jobs/job"} / name, ec);
+    }
+}
+
+void load_job_memory(benchmark::State& state)
+{
+    cis1::memory_os os;
+    cis1::context ctx("/base", {});
+
+    seed_memory_job(os, 0);
+
+    for(auto _ : state)
+    {
+        std::error_code ec;
+
+        auto job = cis1::load_job("job", ec, ctx, os);
+
+        benchmark::DoNotOptimize(job);
+    }
+}
+
+BENCHMARK(load_job_memory)
+    ->Unit(benchmark::kMicrosecond);
+
+void prepare_build_memory(benchmark::State& state)
+{
+    cis1::memory_os os;
+    cis1::context ctx("/base", {});
+    cis1::session session{"bench_session", false};
+
+    seed_memory_job(os, state.range(0));
+
+    std::error_code ec;
+
+    auto job = cis1::load_job("job", ec, ctx, os);
+    if(ec)
+    {
+        state.SkipWithError(ec.message().c_str());
+
+        return;
+    }
+
+    auto params = job->params();
+
+    // first build writes build index of existing builds
+    auto handle = job->prepare_build(ctx, session, params, ec);
+    os.remove_all("/base/jobs/job/" + handle.number_string(), ec);
+
+    for(auto _ : state)
+    {
+        auto handle = job->prepare_build(ctx, session, params, ec);
+        if(ec)
+        {
+            state.SkipWithError(ec.message().c_str());
+
+            break;
+        }
+
+        state.PauseTiming();
+        os.remove_all("/base/jobs/job/" + handle.number_string(), ec);
+        state.ResumeTiming();
+    }
+}
+
+BENCHMARK(prepare_build_memory)
+    ->Arg(0)->Arg(1000)->Arg(10000)->Arg(100000)
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,171 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+#include "bench_env.h"
+#include "context.h"
+#include "cron.h"
+#include "cron_schedule.h"
+#include "os.h"
+
+void write_crons(
+        const std::filesystem::path& path,
+        int64_t entries,
+        int64_t generation = 0,
+        int64_t changed = 0)
+{
+    std::ofstream file(path);
+
+    for(int64_t i = 0; i < entries; ++i)
+    {
+        // first changed entries get new expression every generation
+        auto minute = i < changed ? generation % 60 : i % 60;
+
+        file << "project/job_" << i << " 0 " << minute << " * * * *\n";
+    }
+}
+
+/**
+ * cron_manager::update with crons file of given size, timers are
+ * created at the first update. Measures rereading of unchanged file
+ * and diffing with 1% of entries changed.
+ */
+void cron_manager_update(benchmark::State& state, int64_t changed_percent)
+{
+    auto dir = bench_env::instance().base_dir() / "cron";
+    auto crons_path = dir / "crons";
+
+    std::filesystem::create_directories(dir);
+
+    const auto entries = state.range(0);
+    const auto changed = entries * changed_percent / 100;
+
+    write_crons(crons_path, entries);
+
+    boost::asio::io_context io_ctx;
+    cis1::os std_os;
+    cis1::context ctx(bench_env::instance().base_dir(), {});
+    cron_manager manager(io_ctx, ctx, crons_path, std_os);
+
+    manager.update();
+
+    int64_t generation = 0;
+
+    for(auto _ : state)
+    {
+        if(changed != 0)
+        {
+            state.PauseTiming();
+            write_crons(crons_path, entries, ++generation, changed);
+            state.ResumeTiming();
+        }
+
+        manager.update();
+    }
+
+    state.SetItemsProcessed(state.iterations() * entries);
+}
+
+BENCHMARK_CAPTURE(cron_manager_update, unchanged, 0)
+    ->Arg(100)->Arg(1000)->Arg(10000)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(cron_manager_update, churn_1pct, 1)
+    ->Arg(100)->Arg(1000)->Arg(10000)
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * Scheduling of single timer: cron_next evaluation and
+ * steady_timer arming, followed by cancel.
+ */
+void cron_timer_schedule(benchmark::State& state, const std::string& expr)
+{
+    boost::asio::io_context io_ctx;
+    cron_timer timer(cis1::cron_schedule::compile(expr).value(), io_ctx);
+
+    for(auto _ : state)
+    {
+        timer.run([](){});
+        timer.cancel();
+    }
+
+    // drop cancelled handlers
+    io_ctx.run();
+}
+
+BENCHMARK_CAPTURE(cron_timer_schedule, every_minute, "0 * * * * *");
+BENCHMARK_CAPTURE(cron_timer_schedule, daily, "0 30 4 * * *");
+BENCHMARK_CAPTURE(cron_timer_schedule, yearly, "0 0 0 29 2 *");
+
+/**
+ * Next fire computations from spread start times: compiled bitmask
+ * evaluation against croncpp stepping.
+ */
+const std::vector<std::time_t>& next_fire_times()
+{
+    static const auto times = []()
+    {
+        std::vector<std::time_t> times;
+
+        // one year from 2019-01-01 with odd step
+        for(std::time_t t = 1546300800; t < 1577836800; t += 7919 * 13)
+        {
+            times.push_back(t);
+        }
+
+        return times;
+    }();
+
+    return times;
+}
+
+void cron_next_compiled(benchmark::State& state, const std::string& expr)
+{
+    auto schedule = cis1::cron_schedule::compile(expr).value();
+    auto& times = next_fire_times();
+
+    for(auto _ : state)
+    {
+        for(auto t : times)
+        {
+            benchmark::DoNotOptimize(schedule.next(t));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * times.size());
+}
+
+void cron_next_croncpp(benchmark::State& state, const std::string& expr)
+{
+    auto cronexpr = cron::make_cron(expr);
+    auto& times = next_fire_times();
+
+    for(auto _ : state)
+    {
+        for(auto t : times)
+        {
+            benchmark::DoNotOptimize(cron::cron_next(cronexpr, t));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * times.size());
+}
+
+BENCHMARK_CAPTURE(cron_next_compiled, every_minute, "0 * * * * *");
+BENCHMARK_CAPTURE(cron_next_croncpp, every_minute, "0 * * * * *");
+BENCHMARK_CAPTURE(cron_next_compiled, weekdays, "0 30 9 * * MON-FRI");
+BENCHMARK_CAPTURE(cron_next_croncpp, weekdays, "0 30 9 * * MON-FRI");
+BENCHMARK_CAPTURE(cron_next_compiled, leap_day, "0 0 0 29 2 *");
+BENCHMARK_CAPTURE(cron_next_croncpp, leap_day, "0 0 0 29 2 *");
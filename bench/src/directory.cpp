@@ -0,0 +1,114 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+#include "alloc_counter.h"
+#include "bench_env.h"
+#include "os.h"
+#include "utils.h"
+
+/**
+ * Job directory with 100k builds, iterated the way prepare_build
+ * looks for the last build number.
+ */
+const std::filesystem::path& big_job_dir()
+{
+    static const auto dir = []()
+    {
+        auto dir = bench_env::instance().base_dir() / "jobs" / "bench" / "big";
+
+        std::filesystem::create_directories(dir);
+
+        for(int i = 0; i < 100000; ++i)
+        {
+            std::stringstream ss;
+            ss << std::setfill('0') << std::setw(6) << i;
+
+            std::filesystem::create_directory(dir / ss.str());
+        }
+
+        return dir;
+    }();
+
+    return dir;
+}
+
+void list_directory_100k(benchmark::State& state)
+{
+    auto& dir = big_job_dir();
+    cis1::os std_os;
+
+    auto before = allocations_count();
+
+    for(auto _ : state)
+    {
+        int max_build_num = -1;
+
+        for(auto& entry : std_os.list_directory(dir))
+        {
+            if(entry->is_directory() && is_build(entry->path().filename().string()))
+            {
+                int build_num = std::stoi(entry->path().filename().string());
+                max_build_num = std::max(max_build_num, build_num);
+            }
+        }
+
+        benchmark::DoNotOptimize(max_build_num);
+    }
+
+    state.counters["allocs"] = benchmark::Counter(
+            allocations_count() - before,
+            benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(list_directory_100k)
+    ->Unit(benchmark::kMillisecond);
+
+void iterate_directory_100k(benchmark::State& state)
+{
+    auto& dir = big_job_dir();
+    cis1::os std_os;
+
+    auto before = allocations_count();
+
+    for(auto _ : state)
+    {
+        int max_build_num = -1;
+        std::error_code ec;
+
+        std_os.iterate_directory(
+                dir,
+                [&](const cis1::dir_entry& entry)
+                {
+                    if(entry.type == cis1::dir_entry_type::directory
+                    && is_build(entry.name))
+                    {
+                        max_build_num = std::max<int>(
+                                max_build_num,
+                                build_number(entry.name));
+                    }
+
+                    return true;
+                },
+                ec);
+
+        benchmark::DoNotOptimize(max_build_num);
+    }
+
+    state.counters["allocs"] = benchmark::Counter(
+            allocations_count() - before,
+            benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(iterate_directory_100k)
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,133 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <string>
+
+#include <boost/process/environment.hpp>
+
+#include "alloc_counter.h"
+#include "environment.h"
+
+/**
+ * Environment usage of single startjob run: context construction with
+ * cis.conf executables, lookups, locally set variables, passing env to
+ * job runner and spawning a process.
+ * cis1::environment::current() copies process environment into a single
+ * buffer on each call, it is counted in every iteration.
+ */
+
+const std::map<std::string, std::string> executables =
+{
+    {"startjob", "startjob"},
+    {"setparam", "setparam"},
+    {"getparam", "getparam"},
+    {"setvalue", "setvalue"},
+    {"getvalue", "getvalue"},
+    {"cis_cron", "cis_cron"},
+    {"maintenance", "maintenance"}
+};
+
+const char* lookups[] =
+{
+    "parent_startjob_id",
+    "session_id",
+    "webui_internal_address",
+    "webui_internal_port",
+    "job_name",
+    "build_number",
+    "cgroup_root",
+    "maintenance"
+};
+
+// Previously env was copied into job_runner_factory, job_runner member
+// and process::async_system argument
+void spawn(boost::process::environment env)
+{
+    benchmark::DoNotOptimize(env);
+}
+
+void run(boost::process::environment env)
+{
+    boost::process::environment member = env;
+    spawn(member);
+}
+
+void run(const cis1::environment& env)
+{
+    cis1::environment member = env;
+    auto block = member.make_block();
+    benchmark::DoNotOptimize(block);
+}
+
+void startjob_env_boost(benchmark::State& state)
+{
+    auto before = allocations_count();
+
+    for(auto _ : state)
+    {
+        boost::process::environment env = boost::this_process::environment();
+
+        for(auto& [k, v] : executables)
+        {
+            env[k] = v;
+        }
+
+        for(auto key : lookups)
+        {
+            std::string var;
+            if(auto it = env.find(key); it != env.end())
+            {
+                var = it->to_vector()[0];
+            }
+            benchmark::DoNotOptimize(var);
+        }
+
+        env["session_id"] = "session";
+        env["job_name"] = "job";
+        env["build_number"] = "000001";
+
+        run(env);
+    }
+
+    state.counters["allocs"] = benchmark::Counter(
+            allocations_count() - before,
+            benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(startjob_env_boost);
+
+void startjob_env_cis1(benchmark::State& state)
+{
+    auto before = allocations_count();
+
+    for(auto _ : state)
+    {
+        auto env = cis1::environment::current().overlay(executables);
+
+        for(auto key : lookups)
+        {
+            auto var = env.get(key);
+            benchmark::DoNotOptimize(var);
+        }
+
+        env.set("session_id", "session");
+        env.set("job_name", "job");
+        env.set("build_number", "000001");
+
+        run(env);
+    }
+
+    state.counters["allocs"] = benchmark::Counter(
+            allocations_count() - before,
+            benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(startjob_env_cis1);
@@ -0,0 +1,94 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <boost/asio.hpp>
+
+#include "bench_env.h"
+#include "environment.h"
+#include "job_runner.h"
+#include "os.h"
+
+/**
+ * Output throughput of job_runner: script cats given count of
+ * 100 byte lines to stdout, each line goes through line callback.
+ * Includes process spawn, see startup benchmarks for the spawn alone.
+ */
+void job_runner_output(benchmark::State& state)
+{
+    auto dir = bench_env::instance().base_dir() / "job_runner";
+
+    std::filesystem::create_directories(dir);
+
+    const auto lines = state.range(0);
+    const std::string line(99, 'x');
+
+    // output is prepared, so shell loop doesn't dominate the measurement
+    {
+        std::ofstream output(dir / "output");
+        for(int64_t i = 0; i < lines; ++i)
+        {
+            output << line << "\n";
+        }
+    }
+
+    std::ofstream(dir / "script")
+            << "#!/bin/sh\n"
+            << "exec cat " << (dir / "output") << "\n";
+
+    std::filesystem::permissions(
+            dir / "script",
+            std::filesystem::perms::owner_all);
+
+    cis1::os std_os;
+    auto env = cis1::environment::current();
+
+    size_t bytes = 0;
+
+    for(auto _ : state)
+    {
+        boost::asio::io_context io_ctx;
+        cis1::job_runner runner(io_ctx, env, dir, cis1::run_options{}, std_os);
+
+        int exit_code = -1;
+
+        runner.run(
+                "script",
+                [&](std::error_code, int code)
+                {
+                    exit_code = code;
+                },
+                [&](const std::string& str)
+                {
+                    bytes += str.size();
+                },
+                [](const std::string&){});
+
+        io_ctx.run();
+
+        if(exit_code != 0)
+        {
+            state.SkipWithError("script failed");
+
+            break;
+        }
+    }
+
+    state.SetBytesProcessed(bytes);
+    state.SetItemsProcessed(state.iterations() * lines);
+}
+
+BENCHMARK(job_runner_output)
+    ->Arg(1000)->Arg(100000)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
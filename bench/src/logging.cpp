@@ -0,0 +1,250 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <scl/file_recorder.h>
+#include <tpl_helpers/overloaded.h>
+
+#include "bench_env.h"
+#include "context.h"
+#include "logger.h"
+#include "os.h"
+#include "session.h"
+
+uintmax_t dir_size(const std::filesystem::path& dir)
+{
+    uintmax_t size = 0;
+
+    for(auto& entry : std::filesystem::recursive_directory_iterator(dir))
+    {
+        if(entry.is_regular_file())
+        {
+            size += entry.file_size();
+        }
+    }
+
+    return size;
+}
+
+/**
+ * Logs typical start_job record with CIS_LOG, reports records/s
+ * and bytes per record written to logs dir.
+ */
+void log_records(benchmark::State& state, const std::string& log_format)
+{
+    auto logs_dir = bench_env::instance().base_dir() / ("logs_" + log_format);
+
+    std::filesystem::remove_all(logs_dir);
+    std::filesystem::create_directories(logs_dir / "logs");
+
+    cis1::os std_os;
+    cis1::context ctx{logs_dir, {}};
+    ctx.set_env_var("log_format", log_format);
+
+    init_cis_log(make_logger_options(std::nullopt, ctx, std_os), ctx);
+
+    const std::string job_name = "project/subproject/job";
+    uint32_t build = 0;
+
+    for(auto _ : state)
+    {
+        CIS_LOG(actions::job_stats,
+                R"(job_name="%s" build=%s exit_code=%s)",
+                job_name,
+                ++build,
+                0);
+    }
+
+    close_logs();
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes_per_record"] = benchmark::Counter(
+            static_cast<double>(dir_size(logs_dir)) / state.iterations());
+}
+
+BENCHMARK_CAPTURE(log_records, text, std::string("text"));
+BENCHMARK_CAPTURE(log_records, binary, std::string("binary"));
+
+/**
+ * Lower bound of text log cost: formatting and single write per record,
+ * without timestamp and record decoration of the text recorder.
+ */
+void log_text_line(benchmark::State& state)
+{
+    auto path = bench_env::instance().base_dir() / "logs" / "text_line.log";
+
+    auto* file = std::fopen(path.c_str(), "ab");
+    std::setvbuf(file, nullptr, _IONBF, 0);
+
+    const std::string job_name = "project/subproject/job";
+    uint32_t build = 0;
+
+    for(auto _ : state)
+    {
+        auto line = SCFormat(
+                R"(job_name="%s" build=%s exit_code=%s)",
+                job_name,
+                ++build,
+                0);
+        line += '\n';
+
+        std::fwrite(line.data(), 1, line.size(), file);
+    }
+
+    std::fclose(file);
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes_per_record"] = benchmark::Counter(
+            static_cast<double>(std::filesystem::file_size(path))
+                    / state.iterations());
+}
+
+BENCHMARK(log_text_line);
+
+/**
+ * \brief Write syscalls and written bytes of the process (Linux only)
+ */
+struct io_counters
+{
+    static io_counters read()
+    {
+        io_counters counters;
+
+        std::ifstream io("/proc/self/io");
+        std::string key;
+        uint64_t value;
+
+        while(io >> key >> value)
+        {
+            if(key == "syscw:")
+            {
+                counters.write_calls = value;
+            }
+            else if(key == "wchar:")
+            {
+                counters.write_bytes = value;
+            }
+        }
+
+        return counters;
+    }
+
+    uint64_t write_calls = 0;
+    uint64_t write_bytes = 0;
+};
+
+void set_io_counters(
+        benchmark::State& state,
+        const io_counters& before)
+{
+    auto after = io_counters::read();
+    auto events = static_cast<double>(state.iterations());
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["syscalls_per_event"] = benchmark::Counter(
+            (after.write_calls - before.write_calls) / events);
+    state.counters["bytes_per_event"] = benchmark::Counter(
+            (after.write_bytes - before.write_bytes) / events);
+}
+
+/**
+ * Record of tee_log before the fan-out: cis, session and offline webui
+ * loggers build and write it independently.
+ */
+void tee_records_separate_loggers(benchmark::State& state)
+{
+    using CoreRecord = cis1::core_logger::CoreRecord;
+    using FileRecorder = scl::FileRecorder<CoreRecord>;
+
+    auto base_dir = bench_env::instance().base_dir() / "tee_separate";
+
+    std::filesystem::remove_all(base_dir);
+    std::filesystem::create_directories(base_dir / "logs");
+    std::filesystem::create_directories(base_dir / "sessions");
+
+    auto make_logger = [](const std::filesystem::path& dir, const std::string& name)
+    {
+        FileRecorder::Options recorder_options;
+        recorder_options.log_directory = dir;
+        recorder_options.file_name_template = name;
+        recorder_options.align = true;
+
+        scl::RecordersCont<CoreRecord> recorders;
+        recorders.push_back(std::get<0>(FileRecorder::Init(recorder_options)));
+
+        return std::get<0>(CoreLogger::Init({}, std::move(recorders)));
+    };
+
+    auto cis = make_logger(base_dir / "logs", "cis.%n.log");
+    auto session = make_logger(base_dir / "sessions", "session.%n.log");
+    auto combined = make_logger(base_dir / "sessions", "session.combined.log");
+
+    uint32_t build = 0;
+    auto before = io_counters::read();
+
+    for(auto _ : state)
+    {
+        auto message = SCFormat(R"(job_name="%s" build=%s)", "project/job", ++build);
+
+        cis->SesActRecord(scl::Level::Action, actions::job_stats, message);
+        session->ActRecord(scl::Level::Action, actions::job_stats, message);
+        combined->ActRecord(scl::Level::Action, actions::job_stats, message);
+    }
+
+    cis.reset();
+    session.reset();
+    combined.reset();
+
+    set_io_counters(state, before);
+}
+
+BENCHMARK(tee_records_separate_loggers);
+
+/**
+ * Record of tee_log built once and passed to cis, session and offline
+ * webui logs, on caller thread or on shared writer thread.
+ */
+void tee_records_fanout(benchmark::State& state, const std::string& log_writer)
+{
+    auto base_dir = bench_env::instance().base_dir() / ("tee_fanout_" + log_writer);
+
+    std::filesystem::remove_all(base_dir);
+    std::filesystem::create_directories(base_dir / "logs");
+    std::filesystem::create_directories(base_dir / "sessions");
+
+    cis1::os std_os;
+    cis1::context ctx{base_dir, {}};
+    ctx.set_env_var("log_writer", log_writer);
+
+    cis1::session session("session", true);
+
+    auto options = make_logger_options(session.session_id(), ctx, std_os);
+    init_cis_log(options, ctx);
+    init_session_log(options, ctx, session);
+
+    uint32_t build = 0;
+    auto before = io_counters::read();
+
+    for(auto _ : state)
+    {
+        TEE_LOG(actions::job_stats, R"(job_name="%s" build=%s)", "project/job", ++build);
+    }
+
+    close_logs();
+
+    set_io_counters(state, before);
+}
+
+BENCHMARK_CAPTURE(tee_records_fanout, sync, std::string("sync"));
+BENCHMARK_CAPTURE(tee_records_fanout, async, std::string("async"));
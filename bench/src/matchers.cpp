@@ -0,0 +1,132 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <iomanip>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "job_mask.h"
+#include "utils.h"
+
+/**
+ * Names as found in job directory: builds and a few job files.
+ */
+std::vector<std::string> make_dir_names()
+{
+    std::vector<std::string> names;
+
+    for(int i = 0; i < 1000; ++i)
+    {
+        std::stringstream ss;
+        ss << std::setfill('0') << std::setw(6) << i;
+        names.push_back(ss.str());
+    }
+
+    names.push_back("job.conf");
+    names.push_back("job.params");
+    names.push_back("script");
+
+    return names;
+}
+
+/**
+ * Job names as found in crons file.
+ */
+std::vector<std::string> make_job_names()
+{
+    std::vector<std::string> names;
+
+    for(int i = 0; i < 1000; ++i)
+    {
+        names.push_back(
+                "project_" + std::to_string(i % 10)
+                + "/job_" + std::to_string(i)
+                + (i % 3 ? "_nightly" : ""));
+    }
+
+    return names;
+}
+
+void is_build_regex(benchmark::State& state)
+{
+    static const std::regex build_mask("^\\d{6}$");
+    auto names = make_dir_names();
+
+    for(auto _ : state)
+    {
+        for(auto& name : names)
+        {
+            benchmark::DoNotOptimize(std::regex_match(name, build_mask));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * names.size());
+}
+
+BENCHMARK(is_build_regex);
+
+void is_build_digits(benchmark::State& state)
+{
+    auto names = make_dir_names();
+
+    for(auto _ : state)
+    {
+        for(auto& name : names)
+        {
+            benchmark::DoNotOptimize(is_build(name));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * names.size());
+}
+
+BENCHMARK(is_build_digits);
+
+void cron_list_regex(benchmark::State& state, const std::string& mask)
+{
+    std::regex rx(mask);
+    auto names = make_job_names();
+
+    for(auto _ : state)
+    {
+        for(auto& name : names)
+        {
+            benchmark::DoNotOptimize(std::regex_match(name, rx));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * names.size());
+}
+
+BENCHMARK_CAPTURE(cron_list_regex, prefix, std::string{"project_1/.*"});
+BENCHMARK_CAPTURE(cron_list_regex, suffix, std::string{".*_nightly"});
+BENCHMARK_CAPTURE(cron_list_regex, generic, std::string{"project_[0-4]/job_\\d+"});
+
+void cron_list_job_mask(benchmark::State& state, const std::string& mask)
+{
+    auto compiled = cis1::job_mask::compile(mask).value();
+    auto names = make_job_names();
+
+    for(auto _ : state)
+    {
+        for(auto& name : names)
+        {
+            benchmark::DoNotOptimize(compiled.matches(name));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * names.size());
+}
+
+BENCHMARK_CAPTURE(cron_list_job_mask, prefix, std::string{"project_1/.*"});
+BENCHMARK_CAPTURE(cron_list_job_mask, suffix, std::string{".*_nightly"});
+BENCHMARK_CAPTURE(cron_list_job_mask, generic, std::string{"project_[0-4]/job_\\d+"});
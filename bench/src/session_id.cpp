@@ -0,0 +1,60 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+#include <boost/process/environment.hpp>
+
+#include "session_id.h"
+
+/**
+ * Session id creation in invoke_session: localtime, put_time and
+ * stringstream of previous ids against ULID-like generator.
+ */
+
+static void session_id_legacy(benchmark::State& state)
+{
+    for(auto _ : state)
+    {
+        auto now = std::chrono::system_clock::now();
+        auto time = std::chrono::system_clock::to_time_t(now);
+        auto id = boost::this_process::get_id();
+        std::stringstream ss;
+        ss << std::put_time(std::localtime(&time), "%Y-%m-%d-%H-%M-%S-")
+           << id << "_"  << 1;
+        auto session_id = ss.str();
+        benchmark::DoNotOptimize(session_id);
+    }
+}
+BENCHMARK(session_id_legacy);
+
+static void session_id_generated(benchmark::State& state)
+{
+    for(auto _ : state)
+    {
+        auto session_id = cis1::generate_session_id();
+        benchmark::DoNotOptimize(session_id);
+    }
+}
+BENCHMARK(session_id_generated)->ThreadRange(1, 4);
+
+static void session_id_parse(benchmark::State& state)
+{
+    auto session_id = cis1::generate_session_id();
+
+    for(auto _ : state)
+    {
+        auto info = cis1::parse_session_id(session_id);
+        benchmark::DoNotOptimize(info);
+    }
+}
+BENCHMARK(session_id_parse);
@@ -0,0 +1,86 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include <boost/process.hpp>
+
+#include "bench_env.h"
+#include "context.h"
+#include "os.h"
+
+namespace bp = boost::process;
+
+/**
+ * Measures time from exec of a core tool until it finishes with
+ * minimal useful work (context, session and loggers are initialized).
+ */
+void startup(
+        benchmark::State& state,
+        const std::string& tool,
+        const std::vector<std::string>& args)
+{
+    auto& env = bench_env::instance();
+
+    auto proc_env = boost::this_process::environment();
+    bp::environment child_env = proc_env;
+    child_env["cis_base_dir"] = env.base_dir().string();
+    child_env["session_id"] = "bench_session";
+
+    for(auto _ : state)
+    {
+        bp::system(
+                (env.base_dir() / "core" / tool).string(),
+                bp::args(args),
+                child_env,
+                bp::start_dir = env.base_dir().string(),
+                bp::std_in.close(),
+                bp::std_out > bp::null,
+                bp::std_err > bp::null);
+    }
+}
+
+BENCHMARK_CAPTURE(startup, getvalue, "getvalue", {"bench_value"})
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(startup, setvalue, "setvalue", {"bench_value", "1"})
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(startup, getparam, "getparam", {"bench_param"})
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(startup, setparam, "setparam", {"bench_param", "1"})
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(startup, startjob, "startjob", {"bench/noop"})
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * In-process part of startup shared by all tools.
+ */
+void init_context(benchmark::State& state)
+{
+    cis1::os std_os;
+
+    for(auto _ : state)
+    {
+        std::error_code ec;
+
+        auto ctx = cis1::init_context(ec, std_os);
+        if(ec)
+        {
+            state.SkipWithError(ec.message().c_str());
+
+            break;
+        }
+
+        benchmark::DoNotOptimize(ctx);
+    }
+}
+
+BENCHMARK(init_context)
+    ->Unit(benchmark::kMicrosecond);
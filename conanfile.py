@@ -8,6 +8,8 @@ class Cis1CoreNative(ConanFile):
     author = "MokinIA <mia@tomsksoft.com>"
     generators = "cmake"
     settings = "os", "arch", "compiler", "build_type"
+    options = {"benchmarks": [True, False], "strip_debug_log": [True, False]}
+    default_options = {"benchmarks": False, "strip_debug_log": False}
     exports = []
     exports_sources = [
         "CMakeLists.txt",
@@ -16,7 +18,8 @@ class Cis1CoreNative(ConanFile):
         "Doxyfile.in",
         "version.txt",
         "component_version.txt",
-        "cmake/*"]
+        "cmake/*",
+        "bench/*"]
     requires = ("gtest/1.8.1@bincrafters/stable",
                 "boost_process/1.69.0@bincrafters/stable",
                 "boost_program_options/1.69.0@bincrafters/stable",
@@ -31,8 +34,14 @@ class Cis1CoreNative(ConanFile):
                 "sc_logger/1.0.3@tomsksoft/cis1",
                 "croncpp/1.0@tomsksoft/cis1")
 
+    def requirements(self):
+        if self.options.benchmarks:
+            self.requires("benchmark/1.5.0")
+
     def build(self):
         cmake = CMake(self)
+        cmake.definitions["BUILD_BENCHMARKS"] = self.options.benchmarks
+        cmake.definitions["STRIP_DEBUG_LOG"] = self.options.strip_debug_log
         cmake.configure()
         cmake.build()
 
@@ -43,6 +52,12 @@ class Cis1CoreNative(ConanFile):
         self.copy("getparam", dst="bin", src="bin")
         self.copy("setvalue", dst="bin", src="bin")
         self.copy("getvalue", dst="bin", src="bin")
+        self.copy("buildquery", dst="bin", src="bin")
+        self.copy("sessiongraph", dst="bin", src="bin")
+        self.copy("logdecode", dst="bin", src="bin")
+        self.copy("sessiongc", dst="bin", src="bin")
+        self.copy("libcis1_core_c.so", dst="bin", src="bin")
+        self.copy("cis1_core_c.dll", dst="bin", src="bin")
         self.copy("libcis1_core.a", dst="lib", src="lib")
         self.copy("libcis1_core.lib", dst="lib", src="lib")
         self.copy("FindFilesystem.cmake", dst="cmake/modules", src="cmake/modules")
@@ -100,6 +100,16 @@ def main(argv = None):
 
             return 1
 
+    # scripts call core in process if the library is built
+
+    if os.name == 'nt':
+        core_lib_name = "cis1_core_c.dll"
+    else:
+        core_lib_name = "libcis1_core_c.so"
+
+    if os.path.isfile(os.path.join(execs_dir, core_lib_name)):
+        cis_config["cis1_core_c"] = core_lib_name
+
     os.mkdir(deploy_dir)
 
     os.mkdir(os.path.join(deploy_dir, "core"))
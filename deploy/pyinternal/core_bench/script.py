@@ -0,0 +1,61 @@
+#!/usr/bin/env python
+import sys
+import os
+import time
+
+sys.path.append(
+    os.path.join(
+        os.path.dirname(
+            os.path.dirname(
+                os.path.dirname(
+                    os.path.abspath(__file__)))), "shared_code"))
+
+from cis import CisCurrentBuild
+
+def calls_per_second(call, calls):
+    started = time.perf_counter()
+
+    for i in range(calls):
+        r = call(i)
+
+        assert r == 0 or r[0] == 0, ("Call should return 0.")
+
+    return calls / (time.perf_counter() - started)
+
+def bench(mode, cis_current_build, calls):
+    results = [
+        ("setvalue", lambda i: cis_current_build.setvalue("bench", str(i))),
+        ("getvalue", lambda i: cis_current_build.getvalue("bench")),
+        ("setparam", lambda i: cis_current_build.setparam("bench", str(i))),
+        ("getparam", lambda i: cis_current_build.getparam("bench"))]
+
+    for (name, call) in results:
+        print("{:<12} {:<10} {:>12.1f} calls/s".format(
+            mode,
+            name,
+            calls_per_second(call, calls)))
+
+def main(argv = None):
+    print("Benchmark of CisCurrentBuild calls.")
+
+    subprocess_build = CisCurrentBuild(use_core_lib = False)
+
+    (r, calls) = subprocess_build.getparam("calls")
+
+    assert r == 0, ("Getparam should return 0.")
+
+    calls = int(calls)
+
+    bench("subprocess", subprocess_build, calls)
+
+    library_build = CisCurrentBuild()
+
+    if library_build.core_lib == None:
+        print("libcis1_core_c is not available (cis1_core_c in cis.conf).")
+
+        return 1
+
+    bench("library", library_build, calls)
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,9 +1,147 @@
+import atexit
+import ctypes
 import os
 import re
 import subprocess
+import sys
+
+class CisCoreLibrary:
+    """Calls libcis1_core_c in this process instead of core executables."""
+
+    ABI_VERSION = 1
+
+    OK = 0
+
+    BUFFER_TOO_SMALL = 2
+
+    def __init__(self, path):
+        lib = ctypes.CDLL(path)
+
+        lib.cis1_abi_version.restype = ctypes.c_int
+
+        assert lib.cis1_abi_version() == self.ABI_VERSION, (
+            "Unsupported libcis1_core_c ABI version")
+
+        lib.cis1_open.restype = ctypes.c_void_p
+        lib.cis1_close.argtypes = [ctypes.c_void_p]
+        lib.cis1_last_error.argtypes = [ctypes.c_void_p]
+        lib.cis1_last_error.restype = ctypes.c_char_p
+
+        for get_function in [lib.cis1_get_value, lib.cis1_get_param]:
+            get_function.argtypes = [
+                ctypes.c_void_p,
+                ctypes.c_char_p,
+                ctypes.c_char_p,
+                ctypes.c_size_t,
+                ctypes.POINTER(ctypes.c_size_t)]
+            get_function.restype = ctypes.c_int
+
+        for set_function in [lib.cis1_set_value, lib.cis1_set_param]:
+            set_function.argtypes = [
+                ctypes.c_void_p,
+                ctypes.c_char_p,
+                ctypes.c_char_p]
+            set_function.restype = ctypes.c_int
+
+        lib.cis1_start_job.argtypes = [
+            ctypes.c_void_p,
+            ctypes.c_char_p,
+            ctypes.POINTER(ctypes.c_int)]
+        lib.cis1_start_job.restype = ctypes.c_int
+
+        self.lib = lib
+
+        self.core = lib.cis1_open()
+
+        error = self.last_error()
+
+        if error != "":
+            self.close()
+
+            raise OSError(error)
+
+        atexit.register(self.close)
+
+    def close(self):
+        if self.core != None:
+            self.lib.cis1_close(self.core)
+
+            self.core = None
+
+    def last_error(self):
+        return self.lib.cis1_last_error(self.core).decode("utf-8")
+
+    def check(self, r):
+        if r == self.OK:
+            return 0
+
+        print(self.last_error(), file = sys.stderr)
+
+        return 1
+
+    def get(self, get_function, name):
+        required_size = ctypes.c_size_t(0)
+
+        value = ctypes.create_string_buffer(256)
+
+        r = get_function(
+            self.core,
+            name.encode("utf-8"),
+            value,
+            len(value),
+            ctypes.byref(required_size))
+
+        if r == self.BUFFER_TOO_SMALL:
+            value = ctypes.create_string_buffer(required_size.value)
+
+            r = get_function(
+                self.core,
+                name.encode("utf-8"),
+                value,
+                len(value),
+                ctypes.byref(required_size))
+
+        if r != self.OK:
+            return (self.check(r), "")
+
+        return (0, value.value.decode("utf-8"))
+
+    def set(self, set_function, name, value):
+        return self.check(
+            set_function(
+                self.core,
+                name.encode("utf-8"),
+                value.encode("utf-8")))
+
+    def setvalue(self, name, value):
+        return self.set(self.lib.cis1_set_value, name, value)
+
+    def getvalue(self, name):
+        return self.get(self.lib.cis1_get_value, name)
+
+    def setparam(self, name, value):
+        return self.set(self.lib.cis1_set_param, name, value)
+
+    def getparam(self, name):
+        return self.get(self.lib.cis1_get_param, name)
+
+    def startjob(self, name):
+        exit_code = ctypes.c_int(-1)
+
+        sys.stdout.flush()
+
+        r = self.lib.cis1_start_job(
+            self.core,
+            name.encode("utf-8"),
+            ctypes.byref(exit_code))
+
+        if r != self.OK:
+            return (self.check(r), None)
+
+        return (0, exit_code.value)
 
 class CisCurrentBuild:
-    def __init__(self):
+    def __init__(self, use_core_lib = True):
         # set cis_base_dir
 
         cis_base_dir = os.getenv("cis_base_dir")
@@ -111,12 +249,44 @@ class CisCurrentBuild:
 
         self.build_number = build_number
 
+        # load core library, executables are used if it is not available
+
+        self.core_lib = None
+
+        core_lib_name = os.getenv("cis1_core_c")
+
+        if use_core_lib and core_lib_name != None:
+            try:
+                self.core_lib = CisCoreLibrary(
+                    os.path.join(self.cis_base_dir, "core", core_lib_name))
+            except (OSError, AttributeError, AssertionError):
+                self.core_lib = None
+
+        # params and values exported by core on job start, see export_params
+        # and export_session_values in job.conf
+
+        self.env_params = os.getenv("cis_params") == "env"
+
+        self.env_values = os.getenv("cis_values") == "env"
+
+    def env_name(self, prefix, name):
+        return prefix + "_" + "".join(
+            chr(c) if chr(c).isascii() and (chr(c).isalnum() or c == 95)
+            else "%%%02X" % c
+            for c in name.encode("utf-8"))
+
     def is_exe(self, path):
         path = os.path.join(self.cis_base_dir, "core", path)
 
         return os.path.isfile(path) and os.access(path, os.X_OK)
 
     def startjob(self, name):
+        # started job can change session values
+        self.env_values = False
+
+        if self.core_lib != None:
+            return self.core_lib.startjob(name)
+
         startjob_proc = subprocess.Popen(
             args = [
                 os.path.join(self.cis_base_dir, "core", self.startjob_exe),
@@ -144,6 +314,11 @@ class CisCurrentBuild:
         return (startjob_proc.returncode, exitcode)
 
     def setvalue(self, name, value):
+        self.env_values = False
+
+        if self.core_lib != None:
+            return self.core_lib.setvalue(name, value)
+
         setvalue_proc = subprocess.Popen(
             args = [
                 os.path.join(self.cis_base_dir, "core", self.setvalue_exe),
@@ -155,6 +330,15 @@ class CisCurrentBuild:
         return setvalue_proc.returncode
 
     def getvalue(self, name):
+        if self.env_values:
+            value = os.getenv(self.env_name("cis_value", name))
+
+            if value != None:
+                return (0, value)
+
+        if self.core_lib != None:
+            return self.core_lib.getvalue(name)
+
         getvalue_proc = subprocess.Popen(
             args = [
                 os.path.join(self.cis_base_dir, "core", self.getvalue_exe),
@@ -170,6 +354,11 @@ class CisCurrentBuild:
         return (getvalue_proc.returncode, getvalue_result)
 
     def setparam(self, name, value):
+        self.env_params = False
+
+        if self.core_lib != None:
+            return self.core_lib.setparam(name, value)
+
         setparam_proc = subprocess.Popen(
             args = [
                 os.path.join(self.cis_base_dir, "core", self.setparam_exe),
@@ -181,6 +370,15 @@ class CisCurrentBuild:
         return setparam_proc.returncode
 
     def getparam(self, name):
+        if self.env_params:
+            value = os.getenv(self.env_name("cis_param", name))
+
+            if value != None:
+                return (0, value)
+
+        if self.core_lib != None:
+            return self.core_lib.getparam(name)
+
         getparam_proc = subprocess.Popen(
             args = [
                 os.path.join(self.cis_base_dir, "core", self.getparam_exe),
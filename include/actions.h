@@ -21,6 +21,9 @@ enum class actions
     finish_job,
     startjob_stdout,
     startjob_stderr,
+    job_stats,
+    session_gc,
+    spawn,
 };
 
 inline std::string ToString(const actions action)
@@ -49,6 +52,12 @@ inline std::string ToString(const actions action)
             return "startjob_stdout";
         case actions::startjob_stderr:
             return "startjob_stderr";
+        case actions::job_stats:
+            return "job_stats";
+        case actions::session_gc:
+            return "session_gc";
+        case actions::spawn:
+            return "spawn";
         default:
             return "unknown";
     }
@@ -0,0 +1,219 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include "actions.h"
+
+namespace cis1
+{
+
+/**
+ * \brief Binary log record types
+ *
+ * Every record is [u32 size][u8 type][u64 pid][payload], size includes
+ * the whole record, numbers are in host byte order:
+ *  - process: u32 magic, u8 version, u64 ppid, u16 size + session id
+ *  - format: u32 format id, u16 size + format string
+ *  - event: i64 unix time ns, u16 action, u32 format id, u8 args count, args
+ *
+ * Arg is u8 binary_arg_type and value, string is u32 size + bytes.
+ * Process and format records are written once per writer, so records
+ * of several processes appended to the same file can be decoded.
+ */
+enum class binary_record_type : uint8_t
+{
+    process = 1,
+    format = 2,
+    event = 3,
+};
+
+enum class binary_arg_type : uint8_t
+{
+    int64 = 0,
+    uint64 = 1,
+    float64 = 2,
+    string = 3,
+};
+
+constexpr uint32_t binary_log_magic = 0x42534943; // "CISB"
+constexpr uint8_t binary_log_version = 1;
+
+/**
+ * \brief Appends log records in binary form, formatting is left to decoder
+ *
+ * Each record is written with single unbuffered write to the file
+ * opened for append. Not thread safe.
+ */
+class binary_log_writer
+{
+public:
+    /**
+     * \brief Opens log file for append and writes process record
+     * \return Writer or nullptr on error
+     * @param[in] path Log file, parent directory is created if missing
+     * @param[in] pid
+     * @param[in] ppid
+     * @param[in] session_id Empty if process is outside the session
+     * @param[out] ec
+     */
+    static std::unique_ptr<binary_log_writer> open(
+            const std::filesystem::path& path,
+            uint64_t pid,
+            uint64_t ppid,
+            const std::string& session_id,
+            std::error_code& ec);
+
+    ~binary_log_writer();
+
+    binary_log_writer(const binary_log_writer&) = delete;
+    binary_log_writer& operator=(const binary_log_writer&) = delete;
+
+    /**
+     * \brief Writes event record
+     *
+     * Format is SCFormat compatible, each %s is replaced by next arg.
+     * Formats are identified by address, so format must be
+     * a string literal.
+     * @param[in] act
+     * @param[in] format
+     * @param[in] args Integers, floats, strings or types with operator<<
+     */
+    template <class... Args>
+    void record(actions act, const char* format, const Args&... args)
+    {
+        auto format_id = intern(format);
+
+        begin(binary_record_type::event);
+        put(unix_time_ns());
+        put(static_cast<uint16_t>(act));
+        put(format_id);
+        put(static_cast<uint8_t>(sizeof...(Args)));
+        (put_arg(args), ...);
+        commit();
+    }
+
+private:
+    binary_log_writer(std::FILE* file, uint64_t pid);
+
+    static int64_t unix_time_ns();
+
+    uint32_t intern(const char* format);
+    void begin(binary_record_type type);
+    void commit();
+
+    template <class T>
+    void put(T value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        auto size = buf_.size();
+        buf_.resize(size + sizeof(value));
+        std::memcpy(&buf_[size], &value, sizeof(value));
+    }
+
+    void put_string(std::string_view str)
+    {
+        put(binary_arg_type::string);
+        put(static_cast<uint32_t>(str.size()));
+        buf_.append(str.data(), str.size());
+    }
+
+    template <class T>
+    void put_arg(const T& value)
+    {
+        if constexpr(std::is_same_v<T, bool>)
+        {
+            put(binary_arg_type::uint64);
+            put(static_cast<uint64_t>(value));
+        }
+        else if constexpr(std::is_integral_v<T> && std::is_signed_v<T>)
+        {
+            put(binary_arg_type::int64);
+            put(static_cast<int64_t>(value));
+        }
+        else if constexpr(std::is_integral_v<T>)
+        {
+            put(binary_arg_type::uint64);
+            put(static_cast<uint64_t>(value));
+        }
+        else if constexpr(std::is_floating_point_v<T>)
+        {
+            put(binary_arg_type::float64);
+            put(static_cast<double>(value));
+        }
+        else if constexpr(std::is_convertible_v<const T&, std::string_view>)
+        {
+            put_string(value);
+        }
+        else if constexpr(std::is_same_v<T, std::filesystem::path>)
+        {
+            put_string(value.string());
+        }
+        else
+        {
+            std::ostringstream ss;
+            ss << value;
+            put_string(ss.str());
+        }
+    }
+
+    std::FILE* file_;
+    uint64_t pid_;
+    std::string buf_;
+    std::vector<const char*> formats_;
+};
+
+/**
+ * \brief Decoded event record
+ */
+struct binary_log_entry
+{
+    int64_t time_ns = 0;
+    uint64_t pid = 0;
+    uint64_t ppid = 0;
+    std::string session_id;
+    uint16_t action = 0;
+    std::string message; ///< Format with substituted args
+};
+
+/**
+ * \brief Decodes binary log
+ *
+ * Torn record at the end of the stream is ignored.
+ * @param[in] is
+ * @param[in] on_entry Called for every event record in file order
+ * @param[out] ec cant_read_binary_log if stream isn't a binary log
+ */
+void read_binary_log(
+        std::istream& is,
+        const std::function<void(const binary_log_entry&)>& on_entry,
+        std::error_code& ec);
+
+/**
+ * \brief Makes text log line from entry
+ * \return "YYYY-MM-DD HH:MM:SS.ffffff pid ppid session action message"
+ * @param[in] entry
+ */
+std::string format_binary_log_entry(const binary_log_entry& entry);
+
+} // namespace cis1
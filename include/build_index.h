@@ -0,0 +1,210 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+
+#include "os_interface.h"
+#include "job_mask.h"
+
+namespace cis1
+{
+
+enum class build_state
+{
+    pending,
+    successful,
+    broken,
+    removed,
+};
+
+/**
+ * \brief Single build entry of jobs/<job>/builds.index
+ *
+ * Index is append-only, one record per line:
+ * "<number> <state> <exit_code|-> <started> <finished> <session_id|->",
+ * times are unix seconds (0 if unknown). Later record of the same
+ * build overrides earlier one, unknown fields keep previous values.
+ */
+struct build_record
+{
+    std::string job;
+    uint32_t number = 0;
+    build_state state = build_state::pending;
+    std::optional<int> exit_code;
+    int64_t started = 0;
+    int64_t finished = 0;
+    std::string session_id;
+};
+
+/**
+ * \brief Build history filter, unset fields match everything
+ */
+struct build_filter
+{
+    std::optional<job_mask> job;
+    std::optional<build_state> state;
+    std::optional<int> exit_code;
+    std::optional<std::string> session_id;
+    std::optional<int64_t> since; ///< started >= since
+    std::optional<int64_t> until; ///< started < until
+    size_t limit = 0; ///< 0 means no limit
+};
+
+/**
+ * \brief String representation of build state
+ * \return State name
+ * @param[in] state
+ */
+std::string_view to_string(build_state state);
+
+/**
+ * \brief Parses build state name
+ * \return Build state or std::nullopt if name is unknown
+ * @param[in] str
+ */
+std::optional<build_state> build_state_from_string(std::string_view str);
+
+/**
+ * \brief Writes single index record
+ * @param[in] os Output stream
+ * @param[in] record
+ */
+void write_build_record(
+        std::ostream& os,
+        const build_record& record);
+
+/**
+ * \brief Appends record to jobs/<job>/builds.index
+ *
+ * Creates index from build dirs first if it doesn't exist. Holds shared
+ * lock of builds.index.lock, so concurrent appends aren't lost by
+ * rewrites of index.
+ * @param[in] job_dir Path to job dir
+ * @param[in] record
+ * @param[out] ec
+ * @param[in] os
+ */
+void append_build_record(
+        const std::filesystem::path& job_dir,
+        const build_record& record,
+        std::error_code& ec,
+        const os_interface& os);
+
+/**
+ * \brief Reads actual builds of job (without removed ones)
+ *
+ * Falls back to scanning build dirs if index doesn't exist.
+ * \return Builds ordered by number
+ * @param[in] job_dir Path to job dir
+ * @param[in] job_name Job name stored in records
+ * @param[out] ec
+ * @param[in] os
+ */
+std::vector<build_record> read_build_index(
+        const std::filesystem::path& job_dir,
+        const std::string& job_name,
+        std::error_code& ec,
+        const os_interface& os);
+
+/**
+ * \brief Makes build records from build dirs (exitcode.txt, session_id.txt)
+ * \return Builds ordered by number, times are unknown
+ * @param[in] job_dir Path to job dir
+ * @param[in] job_name Job name stored in records
+ * @param[out] ec
+ * @param[in] os
+ */
+std::vector<build_record> scan_build_dirs(
+        const std::filesystem::path& job_dir,
+        const std::string& job_name,
+        std::error_code& ec,
+        const os_interface& os);
+
+/**
+ * \brief Rewrites index with given records only
+ *
+ * New index is written to temp file and renamed over the old one
+ * under exclusive lock of builds.index.lock.
+ * @param[in] job_dir Path to job dir
+ * @param[in] records
+ * @param[out] ec
+ * @param[in] os
+ */
+void write_build_index(
+        const std::filesystem::path& job_dir,
+        const std::vector<build_record>& records,
+        std::error_code& ec,
+        const os_interface& os);
+
+/**
+ * \brief Removes records of given builds from index
+ *
+ * Reads and rewrites index under exclusive lock of builds.index.lock,
+ * so records appended meanwhile are kept.
+ * @param[in] job_dir Path to job dir
+ * @param[in] job_name Job name stored in records
+ * @param[in] numbers Build numbers
+ * @param[out] ec
+ * @param[in] os
+ */
+void remove_build_records(
+        const std::filesystem::path& job_dir,
+        const std::string& job_name,
+        const std::vector<uint32_t>& numbers,
+        std::error_code& ec,
+        const os_interface& os);
+
+/**
+ * \brief Removes index which missed an update
+ *
+ * Reads fall back to build dirs and the next append creates the index
+ * from them again, so queries don't give wrong results.
+ * @param[in] job_dir Path to job dir
+ * @param[out] ec
+ * @param[in] os
+ */
+void invalidate_build_index(
+        const std::filesystem::path& job_dir,
+        std::error_code& ec,
+        const os_interface& os);
+
+/**
+ * \brief Checks whether build matches filter (job mask is not checked)
+ * \return true if build matches
+ * @param[in] record
+ * @param[in] filter
+ */
+bool matches(
+        const build_record& record,
+        const build_filter& filter);
+
+/**
+ * \brief Searches builds of all jobs under base_dir/jobs
+ *
+ * Job mask is applied before job index is read.
+ * \return Matching builds, newest first
+ * @param[in] base_dir CIS base dir
+ * @param[in] filter
+ * @param[out] ec
+ * @param[in] os
+ */
+std::vector<build_record> query_builds(
+        const std::filesystem::path& base_dir,
+        const build_filter& filter,
+        std::error_code& ec,
+        const os_interface& os);
+
+} // namespace cis1
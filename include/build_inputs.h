@@ -0,0 +1,84 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+#include "environment.h"
+#include "os_interface.h"
+
+namespace cis1
+{
+
+/// Max size of variables exported from one file, bigger files
+/// are passed to the build by path only
+constexpr size_t max_exported_env_size = 64 * 1024;
+
+/**
+ * \brief Makes env variable name part from param or value name
+ * \return Name with bytes except [A-Za-z0-9_] replaced by %XX
+ * @param[in] name
+ */
+std::string encode_env_name(const std::string& name);
+
+/**
+ * \brief Exports key-value file to build environment
+ *
+ * Sets ${prefix}_${encoded_name} variables with decoded values and
+ * ${prefix}s=env, or only ${prefix}s=file if variables exceed max_size.
+ * ${prefix}s_file is set to kv_file path if it exists.
+ * @param[in,out] env
+ * @param[in] kv_file
+ * @param[in] prefix
+ * @param[out] ec
+ * @param[in] os
+ * @param[in] max_size
+ */
+void export_kv_file(
+        environment& env,
+        const std::filesystem::path& kv_file,
+        const std::string& prefix,
+        std::error_code& ec,
+        const os_interface& os,
+        size_t max_size = max_exported_env_size);
+
+/**
+ * \brief Exports resolved params of the build as cis_param_* variables
+ * @param[in,out] env
+ * @param[in] build_dir
+ * @param[out] ec
+ * @param[in] os
+ */
+void export_build_params(
+        environment& env,
+        const std::filesystem::path& build_dir,
+        std::error_code& ec,
+        const os_interface& os);
+
+/**
+ * \brief Saves session values to ${build_dir}/session_values.dat
+ *        and exports them as cis_value_* variables
+ *
+ * Values set after the build start are not exported.
+ * @param[in,out] env Environment with session_id
+ * @param[in] base_dir
+ * @param[in] build_dir
+ * @param[out] ec
+ * @param[in] os
+ */
+void export_session_values(
+        environment& env,
+        const std::filesystem::path& base_dir,
+        const std::filesystem::path& build_dir,
+        std::error_code& ec,
+        const os_interface& os);
+
+} // namespace cis1
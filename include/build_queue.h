@@ -0,0 +1,119 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+#include "file_lock_interface.h"
+#include "os_interface.h"
+
+namespace cis1
+{
+
+/**
+ * \brief Limit of builds running at once which share queue directory
+ */
+struct slot_limit
+{
+    std::filesystem::path dir; ///< Queue directory (created if missing)
+    uint32_t slots;            ///< Builds allowed at once, 0 means no limit
+};
+
+/**
+ * \brief Fair queue of builds waiting for free slots
+ *
+ * Queue is implemented with advisory locks (os_interface::open_lock_file)
+ * on files in queue directory, so it is shared by all processes on host:
+ *  - "queue.lock" serializes queue state changes and stores next ticket
+ *  - "waiting.N" is locked by alive waiter with ticket N
+ *  - "slot.N" is locked by running build
+ * Only the waiter with the lowest alive ticket may take a slot,
+ * so builds start in arrival order. Locks are released by kernel
+ * when process dies, waiting files of dead waiters are removed
+ * by the next waiters.
+ * Limits are acquired one by one in given order, slots are held
+ * until release() or destruction.
+ */
+class build_queue
+{
+public:
+    using on_acquired_cb_t = std::function<void(std::error_code ec)>;
+
+    /**
+     * \brief Constructs queue
+     * @param[in] io_ctx Context used to poll queue state
+     * @param[in] limits Limits to acquire, in order
+     * @param[in] os
+     * @param[in] poll_interval Delay between attempts to take a slot
+     */
+    build_queue(
+            boost::asio::io_context& io_ctx,
+            std::vector<slot_limit> limits,
+            const os_interface& os,
+            std::chrono::milliseconds poll_interval =
+                    std::chrono::milliseconds{100});
+
+    build_queue(const build_queue&) = delete;
+    build_queue& operator=(const build_queue&) = delete;
+
+    ~build_queue();
+
+    /**
+     * \brief Waits in queue until slot is taken for each limit
+     *
+     * Callback is called on io_ctx (or inline if no wait is needed)
+     * with cant_acquire_build_slot on failure.
+     * @param[in] cb
+     */
+    void async_acquire(on_acquired_cb_t cb);
+
+    /**
+     * \brief Releases taken slots and leaves queue
+     */
+    void release();
+
+    /**
+     * \brief Getter for time spent in queue
+     * \return Time from async_acquire() to the last slot taken
+     */
+    std::chrono::microseconds wait_time() const;
+
+private:
+    struct entry
+    {
+        slot_limit limit;
+        std::unique_ptr<file_lock_interface> queue_lock;
+        std::unique_ptr<file_lock_interface> waiting_lock;
+        std::unique_ptr<file_lock_interface> slot_lock;
+        uint64_t ticket = 0;
+    };
+
+    void enqueue(entry& e, std::error_code& ec);
+    bool try_take_slot(entry& e, std::error_code& ec);
+    void poll();
+    void finish(std::error_code ec);
+
+    boost::asio::steady_timer timer_;
+    const os_interface& os_;
+    std::chrono::milliseconds poll_interval_;
+    std::vector<entry> entries_;
+    size_t current_ = 0;
+    on_acquired_cb_t cb_;
+    std::chrono::steady_clock::time_point started_;
+    std::chrono::microseconds wait_time_{0};
+};
+
+} // namespace cis1
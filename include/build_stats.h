@@ -0,0 +1,73 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace cis1
+{
+
+/**
+ * \brief Resources consumed by build process tree
+ */
+struct build_stats
+{
+    std::chrono::microseconds wall_time{0};
+    std::chrono::microseconds user_cpu{0};
+    std::chrono::microseconds system_cpu{0};
+    /// Peak of the process tree, 0 if unknown (peak of earlier build
+    /// of this process wasn't exceeded)
+    uint64_t max_rss_kb = 0;
+    uint64_t read_bytes = 0;
+    uint64_t write_bytes = 0;
+    /// Source of the counters: "rusage", "cgroup" or "rusage_shared"
+    /// (other builds ran in the same process, rusage includes them)
+    std::string accounting = "rusage";
+    /// Build was terminated because of timeout
+    bool timed_out = false;
+    /// Time spent waiting for free build slot before start
+    std::chrono::microseconds queue_wait{0};
+};
+
+/**
+ * \brief Snapshot of resources used by terminated and waited-for children
+ * \return Accumulated children usage (wall_time is always zero)
+ */
+build_stats children_usage();
+
+/**
+ * \brief Computes resources consumed between two children_usage() calls
+ * \return Usage difference, max_rss_kb is taken from after
+ * @param[in] before Snapshot made before child started
+ * @param[in] after Snapshot made after child was waited for
+ */
+build_stats usage_delta(
+        const build_stats& before,
+        const build_stats& after);
+
+/**
+ * \brief Writes stats in key=value format (stats.txt)
+ * @param[in] os Output stream
+ * @param[in] stats
+ */
+void write_build_stats(
+        std::ostream& os,
+        const build_stats& stats);
+
+/**
+ * \brief Makes single line stats summary for logs
+ * \return Summary string
+ * @param[in] stats
+ */
+std::string format_build_stats(const build_stats& stats);
+
+} // namespace cis1
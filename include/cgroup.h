@@ -0,0 +1,91 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <system_error>
+
+#include <boost/asio/io_context.hpp>
+
+#include "build_stats.h"
+#include "os_interface.h"
+
+namespace cis1
+{
+
+/**
+ * \brief cgroup v2 limits for job builds (job.conf keys)
+ *
+ * Values are written verbatim to the corresponding cgroup files,
+ * empty value leaves the limit untouched.
+ */
+struct cgroup_limits
+{
+    std::string cpu_max;    ///< cpu.max, e.g. "150000 100000"
+    std::string memory_max; ///< memory.max, e.g. "2G"
+    std::string io_max;     ///< io.max, e.g. "8:0 rbps=10485760 wbps=10485760"
+};
+
+/**
+ * \brief Creates cgroup for single build and applies limits
+ * \return Path to created cgroup or std::nullopt
+ *         if cgroups are not delegated to CIS
+ * @param[in] root Delegated cgroup v2 directory (cgroup_root in cis.conf)
+ * @param[in] name Name of the new child cgroup
+ * @param[in] limits
+ * @param[out] ec
+ * @param[in] os
+ */
+std::optional<std::filesystem::path> create_cgroup(
+        const std::filesystem::path& root,
+        const std::string& name,
+        const cgroup_limits& limits,
+        std::error_code& ec,
+        const os_interface& os);
+
+/**
+ * \brief Overrides stats with counters accounted by cgroup
+ *
+ * cpu.stat, memory.peak and io.stat are used if available.
+ * Stats are left untouched if no process was accounted in cgroup.
+ * @param[in] cgroup Path to cgroup
+ * @param[in, out] stats
+ * @param[in] os
+ */
+void read_cgroup_stats(
+        const std::filesystem::path& cgroup,
+        build_stats& stats,
+        const os_interface& os);
+
+/**
+ * \brief Checks whether any limit is set
+ * @param[in] limits
+ */
+bool has_limits(const cgroup_limits& limits);
+
+/**
+ * \brief Kills remaining processes of cgroup and removes it
+ *
+ * Killed processes leave cgroup asynchronously, so removal is retried
+ * on io_ctx timer without blocking other handlers.
+ * @param[in] io_ctx
+ * @param[in] cgroup Path to cgroup
+ * @param[in] os Must outlive the removal
+ * @param[in] on_removed Called with cant_remove_cgroup if retries are exhausted
+ */
+void async_remove_cgroup(
+        boost::asio::io_context& io_ctx,
+        const std::filesystem::path& cgroup,
+        const os_interface& os,
+        std::function<void(std::error_code)> on_removed);
+
+} // namespace cis1
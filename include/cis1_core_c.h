@@ -0,0 +1,144 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+/**
+ * \file cis1_core_c.h
+ * \brief Stable C ABI of libcis1_core_c for build scripts
+ *
+ * Calls do the same as setvalue, getvalue, setparam, getparam and
+ * startjob executables, but in the calling process, so scripts don't
+ * pay for process start, context, session and loggers init on each call.
+ * Handle reads cis_base_dir, session_id and other variables from the
+ * process environment like the executables do, only one handle
+ * per process is supported.
+ */
+
+#include <stddef.h>
+
+#ifdef _WIN32
+#   define CIS1_CORE_C_API __declspec(dllexport)
+#else
+#   define CIS1_CORE_C_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// Incremented when existing functions change
+#define CIS1_CORE_C_ABI_VERSION 1
+
+/// Call succeeded
+#define CIS1_OK 0
+/// Call failed, see cis1_last_error()
+#define CIS1_ERROR 1
+/// Result doesn't fit the buffer, required size is returned
+#define CIS1_BUFFER_TOO_SMALL 2
+
+typedef struct cis1_core cis1_core;
+
+/**
+ * \brief Returns CIS1_CORE_C_ABI_VERSION of the library
+ */
+CIS1_CORE_C_API int cis1_abi_version(void);
+
+/**
+ * \brief Initializes context, session and logs
+ * \return Handle, never NULL, if init failed all calls return CIS1_ERROR
+ */
+CIS1_CORE_C_API cis1_core* cis1_open(void);
+
+/**
+ * \brief Closes logs and frees handle
+ * @param[in] core
+ */
+CIS1_CORE_C_API void cis1_close(cis1_core* core);
+
+/**
+ * \brief Message of the last error of the handle
+ * \return Null terminated string valid until the next call, empty if none
+ * @param[in] core
+ */
+CIS1_CORE_C_API const char* cis1_last_error(const cis1_core* core);
+
+/**
+ * \brief Reads session value
+ * \return CIS1_OK, CIS1_ERROR or CIS1_BUFFER_TOO_SMALL
+ * @param[in] core
+ * @param[in] name
+ * @param[out] value Buffer for null terminated value
+ * @param[in] value_size
+ * @param[out] required_size Value size with terminating null, may be NULL
+ */
+CIS1_CORE_C_API int cis1_get_value(
+        cis1_core* core,
+        const char* name,
+        char* value,
+        size_t value_size,
+        size_t* required_size);
+
+/**
+ * \brief Writes session value
+ * \return CIS1_OK or CIS1_ERROR
+ * @param[in] core
+ * @param[in] name
+ * @param[in] value
+ */
+CIS1_CORE_C_API int cis1_set_value(
+        cis1_core* core,
+        const char* name,
+        const char* value);
+
+/**
+ * \brief Reads param of the current build
+ * \return CIS1_OK, CIS1_ERROR or CIS1_BUFFER_TOO_SMALL
+ * @param[in] core
+ * @param[in] name
+ * @param[out] value Buffer for null terminated value
+ * @param[in] value_size
+ * @param[out] required_size Value size with terminating null, may be NULL
+ */
+CIS1_CORE_C_API int cis1_get_param(
+        cis1_core* core,
+        const char* name,
+        char* value,
+        size_t value_size,
+        size_t* required_size);
+
+/**
+ * \brief Writes param of the current build
+ * \return CIS1_OK or CIS1_ERROR
+ * @param[in] core
+ * @param[in] name
+ * @param[in] value
+ */
+CIS1_CORE_C_API int cis1_set_param(
+        cis1_core* core,
+        const char* name,
+        const char* value);
+
+/**
+ * \brief Runs build of the job in the current session and waits for it
+ *
+ * Params are taken from the session like startjob does.
+ * \return CIS1_OK if the build was run, CIS1_ERROR otherwise
+ * @param[in] core
+ * @param[in] job_name
+ * @param[out] exit_code Exit code of the build script
+ */
+CIS1_CORE_C_API int cis1_start_job(
+        cis1_core* core,
+        const char* job_name,
+        int* exit_code);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -58,7 +58,7 @@ public:
      * \brief Getter for environment
      * \return environment merged from process and locally set variables
      */
-    virtual const boost::process::environment& env() const override;
+    virtual const environment& env() const override;
 
     /**
      * \brief Getter for CIS base directory
@@ -81,7 +81,7 @@ public:
 private:
     const std::filesystem::path base_dir_;
     const std::map<std::string, std::string> executables_;
-    boost::process::environment env_;
+    environment env_;
     size_t process_id_;
     size_t parent_startjob_id_;
 };
@@ -11,7 +11,7 @@
 #include <string>
 #include <filesystem>
 
-#include <boost/process.hpp>
+#include "environment.h"
 
 namespace cis1
 {
@@ -44,7 +44,7 @@ struct context_interface
      * \brief Getter for environment
      * \return environment merged from process and locally set variables
      */
-    virtual const boost::process::environment& env() const = 0;
+    virtual const environment& env() const = 0;
 
     /**
      * \brief Getter for CIS base directory
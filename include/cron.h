@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <deque>
 #include <set>
 #include <fstream>
 #include <filesystem>
@@ -17,7 +18,9 @@
 #include <croncpp.h>
 
 #include "context_interface.h"
+#include "cron_schedule.h"
 #include "os_interface.h"
+#include "process_launcher.h"
 
 /**
  * \brief Cron entry
@@ -128,15 +131,17 @@ class cron_timer
 public:
     /**
      * \brief Constructs cron_timer instance
-     * @param[in] expr Cron expression to manage
+     * @param[in] schedule Compiled cron expression to manage
      * @param[in] ctx
      */
     cron_timer(
-            const cron::cronexpr& expr,
+            const cis1::cron_schedule& schedule,
             boost::asio::io_context& ctx);
 
     /**
      * \brief Starts timer according to cron expr
+     *
+     * Timer isn't started if expression has no next time.
      * @param[in] cb Callback to execute when timer expires
      */
     void run(const std::function<void()>& cb);
@@ -147,18 +152,34 @@ public:
     void cancel();
 
 private:
-    cron::cronexpr expr_;
+    cis1::cron_schedule schedule_;
     boost::asio::steady_timer timer_;
+    std::time_t last_ = -1; ///< Last fire time, timer may expire early
+};
+
+/**
+ * \brief Jobs sharing one cron expression and its timer
+ */
+struct cron_group
+{
+    cron_timer timer;
+    std::set<std::string> jobs;
 };
 
 /// \cond DO_NOT_DOCUMENT
 class cron_manager_run_job_Test;
 class cron_manager_update_Test;
+class cron_manager_update_groups_Test;
+class cron_manager_spawn_rate_Test;
 /// \endcond
 
 /**
  * \brief CRON expressions manager
  *        Executes jobs automatically.
+ *
+ * Entries with identical expressions share one timer, so next fire time
+ * is computed once per unique expression. Hashed values of expressions
+ * are resolved by job name, see cis1::resolve_hashed_cron.
  */
 class cron_manager
 {
@@ -177,12 +198,31 @@ public:
             cis1::os_interface& os);
     /**
      * \brief Load all cron entries from file
+     *
+     * Queued jobs which are no longer in crons file are dropped.
      */
     void update();
 
+    /**
+     * \brief Limits rate of started jobs
+     *
+     * Jobs fired above the rate are queued and started evenly spaced,
+     * job already waiting in the queue isn't queued twice.
+     * @param[in] rate Max jobs started per second, 0 means no limit
+     */
+    void set_max_spawns_per_second(uint32_t rate);
+
+    /**
+     * \brief Starts jobs with launcher instead of spawning in place
+     * @param[in] launcher Must outlive cron_manager
+     */
+    void set_launcher(cis1::process_launcher& launcher);
+
     /// \cond DO_NOT_DOCUMENT
     FRIEND_TEST(::cron_manager, run_job);
     FRIEND_TEST(::cron_manager, update);
+    FRIEND_TEST(::cron_manager, update_groups);
+    FRIEND_TEST(::cron_manager, spawn_rate);
     /// \endcond
 
 private:
@@ -190,13 +230,32 @@ private:
     cis1::context_interface& ctx_;
     std::filesystem::path crons_file_path_;
     cis1::os_interface& os_;
-    std::map<cron_entry, cron_timer> timers_;
+    cis1::process_launcher* launcher_ = nullptr;
+    /// Groups by expression
+    std::map<std::string, cron_group> timers_;
+    uint32_t max_spawns_per_second_ = 0;
+    std::deque<std::string> spawn_queue_;
+    std::set<std::string> queued_jobs_;
+    boost::asio::steady_timer spawn_timer_;
+    bool spawn_timer_armed_ = false;
+    std::chrono::steady_clock::time_point next_spawn_;
 
     /**
      * \brief Execute job with given name
      * @param[in] job job name to execute
      */
     void run_job(const std::string& job);
+
+    /**
+     * \brief Execute job now or queue it if spawn rate is exceeded
+     * @param[in] job job name to execute
+     */
+    void enqueue_job(const std::string& job);
+
+    /**
+     * \brief Execute queued jobs allowed by spawn rate
+     */
+    void spawn_queued();
 };
 
 /**
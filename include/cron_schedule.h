@@ -0,0 +1,83 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <string>
+
+#include <croncpp.h>
+
+namespace cis1
+{
+
+/**
+ * \brief Compiled cron expression
+ *
+ * Expression syntax and meaning are the croncpp ones: six fields
+ * "sec min hour day_of_month month day_of_week", both day fields must
+ * match, time is UTC unless CRON_USE_LOCAL_TIME is defined like for
+ * croncpp itself. Fields consisting of numbers, names, "*", "?",
+ * ranges, steps and lists are compiled to bitmasks and the next time is
+ * found by skipping whole months, days, hours and minutes with bit scans.
+ * Other expressions accepted by croncpp fall back to cron::cron_next.
+ */
+class cron_schedule
+{
+public:
+    /**
+     * \brief Compiles expression
+     * \return Compiled schedule or std::nullopt if croncpp rejects expression
+     * @param[in] expr Cron expression
+     */
+    static std::optional<cron_schedule> compile(const std::string& expr);
+
+    /**
+     * \brief Finds next fire time
+     * \return The earliest matching time strictly after now, same as
+     *         cron::cron_next, or -1 if expression doesn't match in 4 years
+     * @param[in] now
+     */
+    std::time_t next(std::time_t now) const;
+
+    /**
+     * \brief Checks whether bitmask evaluation is used
+     * \return false if cron::cron_next is used
+     */
+    bool compiled() const;
+
+private:
+    cron_schedule() = default;
+
+    uint64_t seconds_ = 0; ///< bits 0-59
+    uint64_t minutes_ = 0; ///< bits 0-59
+    uint32_t hours_ = 0; ///< bits 0-23
+    uint32_t days_of_month_ = 0; ///< bits 1-31
+    uint16_t months_ = 0; ///< bits 1-12
+    uint8_t days_of_week_ = 0; ///< bits 0-6, 0 is sunday
+    std::optional<cron::cronexpr> fallback_;
+};
+
+/**
+ * \brief Replaces hashed values of expression with job specific numbers
+ *
+ * Hashed values spread fires of the same schedule deterministically
+ * by job name, like H of Jenkins. Field item "H" becomes a number from
+ * field range, "H(a-b)" a number from a to b, "H/s" and "H(a-b)/s" become
+ * steps from a hashed start in the first step. Day of month "H" is from
+ * 1 to 28, so it matches every month. Malformed hashed items are left as
+ * is, so croncpp rejects expression.
+ * \return Expression without hashed values
+ * @param[in] expr Cron expression
+ * @param[in] job Job name
+ */
+std::string resolve_hashed_cron(const std::string& expr, const std::string& job);
+
+} // namespace cis1
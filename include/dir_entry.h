@@ -0,0 +1,48 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+namespace cis1
+{
+
+/**
+ * \brief Type of directory entry
+ */
+enum class dir_entry_type
+{
+    unknown,
+    regular,
+    directory,
+    symlink,
+    other,
+};
+
+/**
+ * \brief Directory entry passed to os_interface::iterate_directory callback
+ *
+ * Name points into internal buffer and is valid only during the callback.
+ */
+struct dir_entry
+{
+    std::string_view name;
+    dir_entry_type type;
+    uint64_t inode;
+};
+
+/**
+ * \brief Directory iteration callback
+ * \return false to stop iteration, true otherwise
+ */
+using dir_entry_cb_t = std::function<bool(const dir_entry&)>;
+
+} // namespace cis1
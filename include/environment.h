@@ -0,0 +1,144 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/process/environment.hpp>
+
+namespace cis1
+{
+
+/**
+ * \brief Flat copy-on-write set of environment variables
+ *
+ * Consists of shared immutable base (snapshot of process environment
+ * copied into a single buffer) and overlay with locally set and unset
+ * variables.
+ * Copies share both parts, overlay is cloned on first modification
+ * of a shared copy. Instance isn't thread-safe, distinct copies are.
+ *
+ * Snapshot doesn't follow later setenv/putenv calls, each current()
+ * call takes a new one.
+ */
+class environment
+{
+public:
+    /**
+     * \brief Null-terminated array of "key=value" entries (envp)
+     */
+    class block
+    {
+    public:
+        /**
+         * \brief Getter for envp suitable for execve
+         * \return Pointer to null-terminated array
+         */
+        char** data();
+
+    private:
+        friend class environment;
+
+        /// keeps referenced base entries alive
+        std::shared_ptr<const void> base_;
+        std::vector<std::string> storage_;
+        std::vector<char*> entries_;
+    };
+
+    /**
+     * \brief Constructs empty environment
+     */
+    environment();
+
+    /**
+     * \brief Snapshot of current process environment
+     * \return Environment owning copy of process variables
+     */
+    static environment current();
+
+    /**
+     * \brief Getter for variable
+     * \return Variable value or std::nullopt if variable isn't set
+     * @param[in] key Variable name
+     */
+    std::optional<std::string_view> find(std::string_view key) const;
+
+    /**
+     * \brief Getter for variable
+     * \return Variable value or empty string if variable isn't set
+     * @param[in] key Variable name
+     */
+    std::string get(std::string_view key) const;
+
+    /**
+     * \brief Sets variable in overlay
+     * @param[in] key Variable name
+     * @param[in] val Value
+     */
+    void set(
+            const std::string& key,
+            const std::string& val);
+
+    /**
+     * \brief Unsets variables which names start with prefix
+     * @param[in] prefix
+     */
+    void erase_prefixed(std::string_view prefix);
+
+    /**
+     * \brief Makes copy with additional variables
+     * \return New environment, this one is left untouched
+     * @param[in] vars Variables to set
+     */
+    environment overlay(
+            const std::map<std::string, std::string>& vars) const;
+
+    /**
+     * \brief Makes envp for spawning process
+     *
+     * Only overlaid variables are copied, base entries are referenced.
+     * \return envp block
+     */
+    block make_block() const;
+
+    /**
+     * \brief Converts to boost representation
+     * \return Environment suitable for boost::process
+     */
+    boost::process::environment native() const;
+
+private:
+    struct base_t
+    {
+        /// "name=value\0" entries one after another
+        std::string storage;
+        /// Variable name to entry in storage
+        std::unordered_map<std::string_view, const char*> index;
+    };
+
+    /// std::nullopt value hides base variable, std::less<> allows
+    /// lookups by std::string_view without allocation
+    using overlay_t = std::map<std::string, std::optional<std::string>, std::less<>>;
+
+    environment(std::shared_ptr<const base_t> base);
+
+    overlay_t& mutable_overlay();
+
+    std::shared_ptr<const base_t> base_;
+    std::shared_ptr<overlay_t> overlay_;
+};
+
+} // namespace cis1
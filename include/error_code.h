@@ -43,6 +43,24 @@ enum class error_code
     cant_execute_script,
     invalid_kv_file_format,
     script_is_not_executable,
+    cant_write_build_stats_file,
+    cant_create_cgroup,
+    cant_apply_cgroup_limits,
+    cant_remove_cgroup,
+    cant_read_job_dir,
+    cant_read_build_index,
+    cant_write_build_index,
+    cant_read_session_graph,
+    cant_write_session_graph,
+    cant_acquire_build_slot,
+    cant_read_binary_log,
+    cant_write_binary_log,
+    cant_read_logs_dir,
+    cant_compress_log,
+    cant_write_session_index,
+    cant_write_session_values_file,
+    cant_write_closed_sessions,
+    cant_collect_sessions,
 };
 
 std::error_code make_error_code(error_code ec);
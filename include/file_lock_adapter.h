@@ -0,0 +1,72 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <system_error>
+
+#include "file_lock_interface.h"
+
+namespace cis1
+{
+
+/**
+ * \brief Adapts flock(2) to file_lock_interface
+ *
+ * Lock file is created if missing. On platforms without flock all
+ * locks are taken immediately.
+ */
+class file_lock_adapter
+    : public file_lock_interface
+{
+public:
+    /**
+     * \brief Opens lock file
+     * @param[in] path Path to lock file
+     * @param[out] ec
+     */
+    file_lock_adapter(
+            const std::filesystem::path& path,
+            std::error_code& ec);
+
+    ~file_lock_adapter();
+
+    file_lock_adapter(const file_lock_adapter&) = delete;
+    file_lock_adapter& operator=(const file_lock_adapter&) = delete;
+
+    /**
+     * \brief Waits for exclusive lock
+     * \return true if lock is taken false on error
+     */
+    virtual bool lock() override;
+
+    /**
+     * \brief Waits for shared lock
+     * \return true if lock is taken false on error
+     */
+    virtual bool lock_shared() override;
+
+    /**
+     * \brief Takes exclusive lock if it's free
+     * \return true if lock is taken false otherwise
+     */
+    virtual bool try_lock() override;
+
+    /**
+     * \brief Releases lock
+     */
+    virtual void unlock() override;
+
+private:
+    int fd_ = -1;
+
+    bool flock(int operation);
+};
+
+} // namespace cis1
@@ -0,0 +1,48 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+namespace cis1
+{
+
+/**
+ * \brief Interface for advisory lock of file shared between processes
+ *
+ * Lock is held by the object, it's released on unlock(), on destruction
+ * and when process dies.
+ */
+struct file_lock_interface
+{
+    virtual ~file_lock_interface() = default;
+
+    /**
+     * \brief Waits for exclusive lock
+     * \return true if lock is taken false on error
+     */
+    virtual bool lock() = 0;
+
+    /**
+     * \brief Waits for shared lock
+     * \return true if lock is taken false on error
+     */
+    virtual bool lock_shared() = 0;
+
+    /**
+     * \brief Takes exclusive lock if it's free
+     * \return true if lock is taken false otherwise
+     */
+    virtual bool try_lock() = 0;
+
+    /**
+     * \brief Releases lock
+     */
+    virtual void unlock() = 0;
+};
+
+} // namespace cis1
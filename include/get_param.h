@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <map>
 #include <optional>
 #include <string>
 
@@ -36,4 +37,18 @@ std::optional<std::string> get_param(
         std::error_code& ec,
         const os_interface& os);
 
+/**
+ * \brief Function for retrieving all params of current build in one read
+ * \return Params by name or std::nullopt
+ * @param[in] ctx
+ * @param[in] session
+ * @param[out] ec
+ * @param[in] os
+ */
+std::optional<std::map<std::string, std::string>> get_params(
+        const cis1::context_interface& ctx,
+        const session_interface& session,
+        std::error_code& ec,
+        const os_interface& os);
+
 } // namespace cis1
@@ -13,8 +13,11 @@
 #include <sstream>
 #include <iomanip>
 
+#include "build_index.h"
+#include "build_queue.h"
 #include "context_interface.h"
 #include "os_interface.h"
+#include "cgroup.h"
 #include "job_runner.h"
 #include "session_interface.h"
 
@@ -30,10 +33,17 @@ public:
     using job_runner_factory_t =
             std::function<std::unique_ptr<job_runner_interface>(
                     boost::asio::io_context& ctx,
-                    boost::process::environment env,
+                    const environment& env,
                     const std::filesystem::path& working_dir,
+                    const run_options& options,
                     const os_interface& os)>;
 
+    using on_build_finish_cb_t =
+            std::function<void(
+                    std::error_code ec,
+                    int exit_code,
+                    std::optional<build_stats> stats)>;
+
     /**
      * \brief Represents job.conf and job.params
      */
@@ -43,6 +53,11 @@ public:
         uint32_t keep_successful_builds;
         uint32_t keep_broken_builds;
         std::vector<std::pair<std::string, std::string>> params;
+        cgroup_limits limits;
+        uint32_t timeout = 0; ///< seconds, 0 means no timeout
+        uint32_t max_concurrent_builds = 0; ///< 0 means no limit
+        bool export_params = false; ///< pass params as cis_param_* env
+        bool export_session_values = false; ///< pass values as cis_value_* env
     };
 
     /**
@@ -69,13 +84,34 @@ public:
          * @param[in] newline_cb Callback called when newline arrive in stdout
          *                       or stderr
          * @param[out] exit_code Job exit code (if job finished correctly)
+         * @param[out] stats Resources consumed by job (if job finished)
          */
         void execute(
                 cis1::context_interface& ctx,
                 bool force,
                 std::error_code& ec,
                 std::function<void(bool, const std::string&)> newline_cb,
-                int& exit_code);
+                int& exit_code,
+                std::optional<build_stats>& stats);
+
+        /**
+         * \brief Starts pending build on io_ctx (see job::async_execute)
+         * \return Runner which must outlive io_ctx.run()
+         * @param[in] io_ctx
+         * @param[in] ctx
+         * @param[in] env Environment passed to build
+         * @param[in] force Try to execute even if script is not executable
+         * @param[in] newline_cb Callback called when newline arrive in stdout
+         *                       or stderr
+         * @param[in] on_finish Called once when build is finished
+         */
+        std::unique_ptr<job_runner_interface> async_execute(
+                boost::asio::io_context& io_ctx,
+                cis1::context_interface& ctx,
+                const environment& env,
+                bool force,
+                std::function<void(bool, const std::string&)> newline_cb,
+                on_build_finish_cb_t on_finish);
 
         /**
          * \brief String getter for build number
@@ -122,6 +158,19 @@ public:
      */
     void cleanup(std::error_code& ec);
 
+    /**
+     * \brief Removes pending build which won't be executed
+     * @param[in] build_number Number of pending build
+     * @param[out] ec
+     */
+    void discard_build(uint32_t build_number, std::error_code& ec);
+
+    /**
+     * \brief Getter for job name
+     * \return Job name relative to jobs dir
+     */
+    const std::string& name() const;
+
     /**
      * \brief Getter for keep successful builds count
      * \return Count of successful builds to keep
@@ -134,12 +183,42 @@ public:
      */
     uint32_t keep_broken_builds() const;
 
+    /**
+     * \brief Getter for builds with exit_code == 0
+     * \return Build dirs by build number
+     */
+    const std::map<uint32_t, std::filesystem::path>& successful_builds() const;
+
+    /**
+     * \brief Getter for builds with exit_code != 0
+     * \return Build dirs by build number
+     */
+    const std::map<uint32_t, std::filesystem::path>& broken_builds() const;
+
+    /**
+     * \brief Getter for builds without exit_code
+     * \return Build dirs by build number
+     */
+    const std::map<uint32_t, std::filesystem::path>& pending_builds() const;
+
     /**
      * \brief Getter for params
      * \return Ordered vector of job params
      */
     const std::vector<std::pair<std::string, std::string>>& params() const;
 
+    /**
+     * \brief Getter for build timeout
+     * \return Timeout in seconds, 0 if build isn't limited
+     */
+    uint32_t timeout() const;
+
+    /**
+     * \brief Overrides build timeout from job.conf
+     * @param[in] seconds Timeout in seconds, 0 disables timeout
+     */
+    void set_timeout(uint32_t seconds);
+
     /**
      * \brief Make pending build
      * @param[in] ctx
@@ -161,6 +240,7 @@ public:
      * @param[in] newline_cb Callback called when newline arrive in stdout
      *                       or stderr
      * @param[out] exit_code Build exit_code
+     * @param[out] stats Resources consumed by build, also saved to stats.txt
      * @param[in] force Try to execute even if script isn't executable
      * @param[in] job_runner_factory
      */
@@ -170,6 +250,7 @@ public:
             std::error_code& ec,
             std::function<void(bool, const std::string&)> newline_cb,
             int& exit_code,
+            std::optional<build_stats>& stats,
             bool force,
             job_runner_factory_t job_runner_factory =
                             [](auto&&... args)
@@ -178,6 +259,41 @@ public:
                                         std::forward<decltype(args)>(args)...);
                             });
 
+    /**
+     * \brief Starts pending build without waiting for it
+     *
+     * Several builds may run on the same io_ctx concurrently.
+     * If job.conf max_concurrent_builds or cis.conf max_concurrent_builds
+     * (host-wide) is set build waits for free slot first, see build_queue.
+     * Nested builds (with parent_job_name) aren't limited.
+     * \return Runner which must outlive io_ctx.run() or nullptr
+     *         if build failed to start (on_finish is already called)
+     * @param[in] build_number Number of build to execute
+     * @param[in] io_ctx
+     * @param[in] ctx
+     * @param[in] env Environment passed to build
+     * @param[in] force Try to execute even if script isn't executable
+     * @param[in] newline_cb Callback called when newline arrive in stdout
+     *                       or stderr
+     * @param[in] on_finish Called once with error, exit code and stats
+     *                      when build process group is finished
+     * @param[in] job_runner_factory
+     */
+    std::unique_ptr<job_runner_interface> async_execute(
+            uint32_t build_number,
+            boost::asio::io_context& io_ctx,
+            cis1::context_interface& ctx,
+            const environment& env,
+            bool force,
+            std::function<void(bool, const std::string&)> newline_cb,
+            on_build_finish_cb_t on_finish,
+            job_runner_factory_t job_runner_factory =
+                            [](auto&&... args)
+                            {
+                                return std::make_unique<job_runner>(
+                                        std::forward<decltype(args)>(args)...);
+                            });
+
 private:
     std::string name_;
     config config_;
@@ -186,6 +302,12 @@ private:
     std::map<uint32_t, std::filesystem::path> successful_builds_;
     std::map<uint32_t, std::filesystem::path> broken_builds_;
     std::map<uint32_t, std::filesystem::path> pending_builds_;
+
+    /// Queues of started builds, slots are held until build is finished
+    std::map<uint32_t, std::shared_ptr<build_queue>> queues_;
+
+    /// Index records of prepared builds, repeated in finish record
+    std::map<uint32_t, build_record> pending_records_;
 };
 
 /**
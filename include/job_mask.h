@@ -0,0 +1,52 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cis1
+{
+
+/**
+ * \brief Compiled job name mask (ECMAScript regex, full match)
+ *
+ * Masks consisting of literal text and ".*" wildcards (the usual
+ * shape, e.g. "project/.*" or ".*_nightly") are matched without
+ * std::regex. Other masks fall back to std::regex compiled once.
+ */
+class job_mask
+{
+public:
+    /**
+     * \brief Compiles mask
+     * \return Compiled mask or std::nullopt if mask is invalid regex
+     * @param[in] mask
+     */
+    static std::optional<job_mask> compile(const std::string& mask);
+
+    /**
+     * \brief Checks whether job name matches the whole mask
+     * \return true if name matches
+     * @param[in] name Job name
+     */
+    bool matches(std::string_view name) const;
+
+private:
+    job_mask() = default;
+
+    /// Literal parts separated by ".*", used if regex_ is empty
+    std::vector<std::string> segments_;
+    std::optional<std::regex> regex_;
+};
+
+} // namespace cis1
@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <filesystem>
 #include <functional>
 
@@ -18,6 +20,7 @@
 #include <gtest/gtest_prod.h>
 
 #include "os_interface.h"
+#include "environment.h"
 #include "job_runner_interface.h"
 #include "process.h"
 
@@ -40,12 +43,14 @@ public:
      * @param[in] ctx
      * @param[in] env Environment for process
      * @param[in] working_dir Dir where process will be executed
+     * @param[in] options Execution constraints
      * @param[in] os
      */
     job_runner(
             boost::asio::io_context& ctx,
-            boost::process::environment env,
+            const environment& env,
             const std::filesystem::path& working_dir,
+            const run_options& options,
             const os_interface& os);
 
     /**
@@ -61,6 +66,12 @@ public:
             on_line_read_cb_t&& on_out_line_read_cb,
             on_line_read_cb_t&& on_err_line_read_cb) override;
 
+    /**
+     * \brief Getter for resources consumed by finished job
+     * \return Build stats or std::nullopt if job is not finished
+     */
+    virtual std::optional<build_stats> stats() const override;
+
     /// \cond DO_NOT_DOCUMENT
     FRIEND_TEST(::job_execute, job_runner);
     /// \endcond
@@ -69,13 +80,33 @@ private:
     boost::asio::io_context& ctx_;
     boost::process::async_pipe out_pipe_;
     boost::process::async_pipe err_pipe_;
-    boost::process::environment env_;
+    environment env_;
     std::filesystem::path working_dir_;
+    run_options options_;
     boost::asio::streambuf outbuf_;
     boost::asio::streambuf errbuf_;
     on_line_read_cb_t on_out_line_read_cb_;
     on_line_read_cb_t on_err_line_read_cb_;
     const os_interface& os_;
+    build_stats start_usage_;
+    std::chrono::steady_clock::time_point start_time_;
+    std::optional<build_stats> stats_;
+    boost::asio::steady_timer timeout_timer_;
+    boost::asio::steady_timer kill_timer_;
+    boost::asio::steady_timer group_timer_;
+    boost::asio::signal_set signals_;
+    int pgid_ = 0;
+    bool terminating_ = false;
+    bool timed_out_ = false;
+    std::function<void()> on_group_exit_;
+    /// Other job ran in this process at the same time
+    bool overlapped_ = false;
+    size_t start_index_ = 0;
+
+    /// Count of running jobs in this process
+    static std::atomic<size_t> running_;
+    /// Count of jobs started by this process
+    static std::atomic<size_t> started_;
 
     template <class Process = process>
     void run_impl(
@@ -95,12 +126,31 @@ private:
         on_out_line_read_cb_ = std::move(on_out_line_read_cb);
         on_err_line_read_cb_ = std::move(on_err_line_read_cb);
 
+        start_usage_ = children_usage();
+        start_time_ = std::chrono::steady_clock::now();
+
+        overlapped_ = running_++ != 0;
+        start_index_ = started_++;
+
         p.async_system(
                 ctx_,
-                std::move(on_exit_cb),
+                [this, on_exit_cb = std::move(on_exit_cb)](
+                        std::error_code err,
+                        int exit_code)
+                {
+                    on_exit(err, exit_code, on_exit_cb);
+                },
                 run_prefix + filename,
                 env_,
                 working_dir_,
+                child_setup{
+                        options_.cgroup
+                                ? (options_.cgroup.value() / "cgroup.procs").string()
+                                : std::string{},
+                        [this](int pid)
+                        {
+                            on_spawn(pid);
+                        }},
                 p.std_in().close(),
                 p.std_out() > out_pipe_,
                 p.std_err() > err_pipe_);
@@ -126,6 +176,19 @@ private:
                         boost::asio::placeholders::bytes_transferred));
     }
 
+    void on_spawn(int pid);
+
+    void terminate(bool timed_out);
+
+    void kill_process_group();
+
+    void wait_group_exit();
+
+    void on_exit(
+            std::error_code err,
+            int exit_code,
+            const on_exit_cb_t& on_exit_cb);
+
     void on_out_line_read(
             const boost::system::error_code& error,
             std::size_t bytes_transferred);
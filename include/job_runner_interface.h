@@ -8,13 +8,31 @@
 
 #pragma once
 
+#include <chrono>
+#include <filesystem>
 #include <functional>
+#include <optional>
 #include <string>
 #include <system_error>
 
+#include "build_stats.h"
+
 namespace cis1
 {
 
+/**
+ * \brief Execution constraints of single job run
+ */
+struct run_options
+{
+    /// cgroup v2 directory the job process is moved into
+    std::optional<std::filesystem::path> cgroup;
+    /// Time limit for job, zero means no limit
+    std::chrono::seconds timeout{0};
+    /// Delay between SIGTERM and SIGKILL on termination
+    std::chrono::seconds kill_grace{10};
+};
+
 /**
  * \brief Abstracts jobs running
  */
@@ -40,6 +58,12 @@ struct job_runner_interface
             on_exit_cb_t&& on_exit_cb,
             on_line_read_cb_t&& on_out_line_read_cb,
             on_line_read_cb_t&& on_err_line_read_cb) = 0;
+
+    /**
+     * \brief Getter for resources consumed by finished job
+     * \return Build stats or std::nullopt if job is not finished
+     */
+    virtual std::optional<build_stats> stats() const = 0;
 };
 
 } // namespace cis1
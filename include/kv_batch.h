@@ -0,0 +1,98 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <map>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cis1
+{
+
+using kv_list = std::vector<std::pair<std::string, std::string>>;
+
+/// Output of getparam and getvalue
+enum class kv_output_format
+{
+    lines, ///< value per line
+    shell, ///< name='value' per line, only names which are shell identifiers
+    null,  ///< name\0value\0
+};
+
+/// Parsed arguments of getparam and getvalue
+struct kv_get_args
+{
+    std::vector<std::string> names;
+    bool all = false;
+    kv_output_format format = kv_output_format::lines;
+};
+
+/**
+ * \brief Parses getparam/getvalue args:
+ *        [--shell|--null] (--all | name...)
+ *
+ * --all without format option means --shell.
+ * \return Parsed args or std::nullopt if args are invalid
+ * @param[in] args Args without executable name
+ */
+std::optional<kv_get_args> parse_kv_get_args(
+        const std::vector<std::string>& args);
+
+/**
+ * \brief Parses setparam/setvalue args: name value [name value...]
+ * \return Pairs or std::nullopt if args are invalid
+ * @param[in] args Args without executable name
+ */
+std::optional<kv_list> parse_kv_set_args(
+        const std::vector<std::string>& args);
+
+/**
+ * \brief Picks requested pairs from all values
+ * \return Pairs in order of args, missing names have empty value
+ * @param[in] args
+ * @param[in] values
+ */
+kv_list select_kv(
+        const kv_get_args& args,
+        const std::map<std::string, std::string>& values);
+
+/**
+ * \brief Quotes string for POSIX shell
+ * @param[in] str
+ */
+std::string shell_quote(const std::string& str);
+
+/**
+ * \brief Checks name can be assigned in POSIX shell
+ * @param[in] name
+ */
+bool is_shell_identifier(const std::string& name);
+
+/**
+ * \brief Prints pairs in given format
+ * \return Count of pairs skipped because format can't represent them
+ * @param[in] os
+ * @param[in] kv
+ * @param[in] format
+ */
+size_t print_kv(
+        std::ostream& os,
+        const kv_list& kv,
+        kv_output_format format);
+
+/**
+ * \brief Formats pairs for one log record: "name"="value" "name"="value"
+ * @param[in] kv
+ */
+std::string format_kv_record(const kv_list& kv);
+
+} // namespace cis1
@@ -0,0 +1,197 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <scl/recorder.h>
+#include <cis1_core_logger/core_record.h>
+
+#include "log_rotation.h"
+
+namespace cis1
+{
+
+using log_record_ptr = std::shared_ptr<const core_logger::CoreRecord>;
+using log_recorder_ptr = std::shared_ptr<scl::IRecorder<core_logger::CoreRecord>>;
+
+/**
+ * \brief Log destinations, used as bit flags
+ */
+enum class log_sink : uint8_t
+{
+    cis = 1 << 0,
+    session = 1 << 1,
+    webui = 1 << 2,
+    offline_webui = 1 << 3,
+};
+
+constexpr uint8_t operator|(log_sink lhs, log_sink rhs)
+{
+    return static_cast<uint8_t>(lhs) | static_cast<uint8_t>(rhs);
+}
+
+constexpr uint8_t operator|(uint8_t lhs, log_sink rhs)
+{
+    return lhs | static_cast<uint8_t>(rhs);
+}
+
+/**
+ * \brief Calls recorders on single worker thread shared by all async sinks
+ *
+ * Records of each recorder are written in the order they were posted.
+ * Destructor writes queued records.
+ */
+class async_log_writer
+{
+public:
+    async_log_writer();
+
+    async_log_writer(const async_log_writer&) = delete;
+    async_log_writer& operator=(const async_log_writer&) = delete;
+
+    ~async_log_writer();
+
+    /**
+     * \brief Queues record, doesn't wait for the recorder
+     * @param[in] record
+     * @param[in] recorder
+     */
+    void post(log_record_ptr record, log_recorder_ptr recorder);
+
+    /**
+     * \brief Waits until all queued records are written
+     */
+    void flush();
+
+private:
+    void run();
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::pair<log_record_ptr, log_recorder_ptr>> queue_;
+    bool busy_ = false;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+/**
+ * \brief Dispatches each record to several sinks
+ *
+ * Record is built once and shared by all sinks it is dispatched to,
+ * sinks which are not set are skipped.
+ */
+class log_fanout
+{
+public:
+    /**
+     * \brief Sets recorder of sink
+     * @param[in] sink
+     * @param[in] recorder
+     * @param[in] async Record on shared writer thread instead of caller one
+     */
+    void set_sink(
+            log_sink sink,
+            log_recorder_ptr recorder,
+            bool async = false);
+
+    /**
+     * \brief Checks if any of sinks is set
+     * @param[in] sinks log_sink flags
+     */
+    bool has_sinks(uint8_t sinks) const;
+
+    /**
+     * \brief Passes record to sinks
+     * @param[in] record
+     * @param[in] sinks log_sink flags
+     */
+    void dispatch(
+            const core_logger::CoreRecord& record,
+            uint8_t sinks);
+
+    /**
+     * \brief Waits for async sinks
+     */
+    void flush();
+
+    /**
+     * \brief Waits for async sinks and removes all sinks
+     */
+    void reset();
+
+private:
+    struct sink_entry
+    {
+        log_recorder_ptr recorder;
+        bool async = false;
+    };
+
+    static constexpr size_t sinks_count = 4;
+
+    std::array<sink_entry, sinks_count> sinks_;
+    std::unique_ptr<async_log_writer> writer_;
+};
+
+/**
+ * \brief CoreLogger recorder which passes records to log_fanout
+ */
+class fanout_recorder
+    : public scl::IRecorder<core_logger::CoreRecord>
+{
+public:
+    /**
+     * @param[in] fanout
+     * @param[in] sinks log_sink flags
+     */
+    fanout_recorder(log_fanout& fanout, uint8_t sinks);
+
+    void OnRecord(const core_logger::CoreRecord& record) final;
+
+private:
+    log_fanout& fanout_;
+    uint8_t sinks_;
+};
+
+/**
+ * \brief Recorder of daily rotated log
+ *
+ * Recorder made by factory replaces current one on the first record
+ * of each new day, so long-running processes switch to the log of the day.
+ */
+class daily_recorder
+    : public scl::IRecorder<core_logger::CoreRecord>
+{
+public:
+    using factory_t = std::function<log_recorder_ptr()>;
+
+    /**
+     * @param[in] recorder Recorder of current day
+     * @param[in] factory Makes recorder of new day, returns nullptr
+     *                    on error (previous recorder is kept)
+     */
+    daily_recorder(log_recorder_ptr recorder, factory_t factory);
+
+    void OnRecord(const core_logger::CoreRecord& record) final;
+
+private:
+    log_recorder_ptr recorder_;
+    factory_t factory_;
+    log_day day_;
+};
+
+} // namespace cis1
@@ -0,0 +1,215 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "environment.h"
+#include "os_interface.h"
+
+namespace cis1
+{
+
+/**
+ * \brief Log rotation settings (cis.conf keys)
+ */
+struct log_rotation_options
+{
+    /// log_size_limit, max bytes in text log segment, no limit if not set
+    std::optional<size_t> size_limit;
+    /// log_keep_segments, count of cis log segments kept, 0 keeps all
+    size_t keep_segments = 0;
+    /// log_compress_after, rotated segment is compressed when it isn't
+    /// modified for this time
+    std::chrono::seconds compress_after{60};
+};
+
+/**
+ * \brief Reads log rotation settings
+ * \return Settings, invalid values are replaced by defaults
+ * @param[in] env Environment with cis.conf values
+ */
+log_rotation_options load_log_rotation_options(const environment& env);
+
+/**
+ * \brief Makes cis log name for current day, so logs are rotated daily
+ * \return "${prefix}.YYYY-MM-DD${suffix}"
+ * @param[in] prefix
+ * @param[in] suffix
+ */
+std::string dated_log_name(
+        const std::string& prefix,
+        const std::string& suffix);
+
+/**
+ * \brief Detects start of new local day, so long-running processes
+ *        switch daily logs
+ */
+class log_day
+{
+public:
+    /**
+     * @param[in] now
+     */
+    explicit log_day(std::time_t now = std::time(nullptr));
+
+    /**
+     * \brief Checks if new day started, cheap enough for each record
+     * \return true once for each new day
+     * @param[in] now
+     */
+    bool changed(std::time_t now = std::time(nullptr));
+
+private:
+    std::time_t next_day_;
+};
+
+/**
+ * \brief Finds rotated text log segments which can be compressed
+ *
+ * Segment "${series}.${n}.log" is rotated if the series has a segment
+ * with greater number or the series is dated by past day
+ * ("cis.YYYY-MM-DD"), the newest segment of other series may still
+ * be written.
+ * \return Segments paths
+ * @param[in] dir Directory with logs
+ * @param[in] compress_after Min time since last modification
+ * @param[out] ec
+ * @param[in] os
+ */
+std::vector<std::filesystem::path> find_rotated_logs(
+        const std::filesystem::path& dir,
+        std::chrono::seconds compress_after,
+        std::error_code& ec,
+        const os_interface& os);
+
+/**
+ * \brief Finds rotated text log segments of one session
+ *
+ * Segments "${session_id}.${n}.log" are probed by number like
+ * collect_closed_sessions does, so sessions directory isn't listed.
+ * The newest segment may still be written and is never returned.
+ * \return Segments paths
+ * @param[in] sessions_dir Directory with session logs
+ * @param[in] session_id
+ * @param[in] compress_after Min time since last modification
+ * @param[out] ec
+ * @param[in] os
+ */
+std::vector<std::filesystem::path> find_rotated_session_logs(
+        const std::filesystem::path& sessions_dir,
+        const std::string& session_id,
+        std::chrono::seconds compress_after,
+        std::error_code& ec,
+        const os_interface& os);
+
+/**
+ * \brief Compresses file to ${path}.gz and removes it
+ * @param[in] path
+ * @param[out] ec
+ * @param[in] os
+ */
+void compress_log(
+        const std::filesystem::path& path,
+        std::error_code& ec,
+        const os_interface& os);
+
+/**
+ * \brief Removes the oldest cis log segments
+ *
+ * Only text segments ("cis.YYYY-MM-DD.${n}.log" and ".log.gz")
+ * are counted and removed.
+ * \return Count of removed segments
+ * @param[in] logs_dir
+ * @param[in] keep_segments Count of segments to keep, 0 keeps all
+ * @param[out] ec
+ * @param[in] os
+ */
+size_t apply_log_retention(
+        const std::filesystem::path& logs_dir,
+        size_t keep_segments,
+        std::error_code& ec,
+        const os_interface& os);
+
+/**
+ * \brief Rewrites sessions/${session_id}.index with names of all
+ *        files of the session found by find_session_files
+ * @param[in] base_dir
+ * @param[in] session_id
+ * @param[out] ec
+ * @param[in] os
+ */
+void update_session_index(
+        const std::filesystem::path& base_dir,
+        const std::string& session_id,
+        std::error_code& ec,
+        const os_interface& os);
+
+/**
+ * \brief Compresses log segments on worker thread
+ *
+ * Destructor waits for queued segments.
+ */
+class log_compressor
+{
+public:
+    using on_compressed_cb_t = std::function<void(
+            const std::filesystem::path& path,
+            std::error_code ec)>;
+
+    /**
+     * \brief Starts worker thread
+     * @param[in] os Cloned for worker thread
+     * @param[in] on_compressed Called on worker thread after each segment
+     */
+    explicit log_compressor(
+            const os_interface& os,
+            on_compressed_cb_t on_compressed = {});
+
+    log_compressor(const log_compressor&) = delete;
+    log_compressor& operator=(const log_compressor&) = delete;
+
+    ~log_compressor();
+
+    /**
+     * \brief Queues segment, doesn't block on compression
+     * @param[in] path
+     */
+    void enqueue(std::filesystem::path path);
+
+    /**
+     * \brief Waits until all queued segments are compressed
+     */
+    void wait();
+
+private:
+    void run();
+
+    std::unique_ptr<os_interface> os_;
+    on_compressed_cb_t on_compressed_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::filesystem::path> queue_;
+    bool busy_ = false;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+} // namespace cis1
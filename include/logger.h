@@ -17,17 +17,113 @@
 #include "os.h"
 
 #include "actions.h"
+#include "binary_log.h"
 
-#define CIS_LOG(action, format, ...) cis_log(action, SCFormat(format, ##__VA_ARGS__))
-#define SES_LOG(action, format, ...) session_log(action, SCFormat(format, ##__VA_ARGS__))
-#define WEBUI_LOG(action, format, ...) webui_log(action, SCFormat(format, ##__VA_ARGS__))
-#define TEE_LOG(action, format, ...) tee_log(action, SCFormat(format, ##__VA_ARGS__))
+/**
+ * \brief Log record levels in ascending order
+ */
+enum class log_level
+{
+    debug,
+    info,
+    warning,
+    error,
+    action,
+};
+
+/**
+ * \brief Level of records logged with CIS_LOG, SES_LOG and TEE_LOG
+ * \return Level by record action
+ * @param[in] act
+ */
+constexpr log_level action_log_level(actions act)
+{
+    switch(act)
+    {
+        case actions::error:
+            return log_level::error;
+        case actions::job_stats:
+        case actions::session_gc:
+        case actions::spawn:
+            return log_level::info;
+        default:
+            return log_level::action;
+    }
+}
+
+/// Records below threshold are skipped before args are formatted,
+/// set by make_logger_options()
+extern log_level log_threshold;
+
+inline bool log_enabled(log_level level)
+{
+    return level >= log_threshold;
+}
+
+/**
+ * \brief Checks if log calls of level are compiled
+ *
+ * Debug calls are compiled out if built with STRIP_DEBUG_LOG.
+ */
+constexpr bool log_level_compiled(log_level level)
+{
+#ifdef CIS_STRIP_DEBUG_LOG
+    return level != log_level::debug;
+#else
+    (void) level;
+
+    return true;
+#endif
+}
+
+// args are evaluated only if level is enabled
+#define LOG_IF_ENABLED(level, call) \
+    do \
+    { \
+        if constexpr(log_level_compiled(level)) \
+        { \
+            if(log_enabled(level)) \
+            { \
+                call; \
+            } \
+        } \
+    } while(false)
+
+#define CIS_LOG_LEVEL(level, act, format, ...) \
+    LOG_IF_ENABLED(level, cis_log_fmt(level, act, format, ##__VA_ARGS__))
+#define SES_LOG_LEVEL(level, act, format, ...) \
+    LOG_IF_ENABLED(level, session_log_fmt(level, act, format, ##__VA_ARGS__))
+#define TEE_LOG_LEVEL(level, act, format, ...) \
+    LOG_IF_ENABLED(level, tee_log_fmt(level, act, format, ##__VA_ARGS__))
+
+#define CIS_LOG(act, format, ...) \
+    CIS_LOG_LEVEL(action_log_level(act), act, format, ##__VA_ARGS__)
+#define SES_LOG(act, format, ...) \
+    SES_LOG_LEVEL(action_log_level(act), act, format, ##__VA_ARGS__)
+#define TEE_LOG(act, format, ...) \
+    TEE_LOG_LEVEL(action_log_level(act), act, format, ##__VA_ARGS__)
+#define WEBUI_LOG(act, format, ...) webui_log(act, SCFormat(format, ##__VA_ARGS__))
+
+#define CIS_DEBUG(act, format, ...) \
+    CIS_LOG_LEVEL(log_level::debug, act, format, ##__VA_ARGS__)
+#define SES_DEBUG(act, format, ...) \
+    SES_LOG_LEVEL(log_level::debug, act, format, ##__VA_ARGS__)
 
 using LoggerPtr = cis1::core_logger::LoggerPtr;
 using CoreLogger = cis1::core_logger::CoreLogger;
 
+/**
+ * \brief Parses log level name
+ * \return Level or std::nullopt if name is unknown
+ * @param[in] str "debug", "info", "warning", "error" or "action"
+ */
+std::optional<log_level> log_level_from_string(const std::string& str);
+
 /**
  * \brief Make Logger options by cis context and os
+ *
+ * Also sets log_threshold from cis_log_level environment variable
+ * or log_level in cis.conf, "info" by default.
  * @param[in] session_id
  * @param[in] ctx
  * @param[in] std_os
@@ -48,6 +144,9 @@ void init_webui_log(
 
 /**
  * \brief Initialize global logging
+ *
+ * If log_format=binary is set in cis.conf logs/cis.YYYY-MM-DD.blog is written
+ * by binary_log_writer instead of text log (see logdecode).
  * @param[in] options
  * @param[in] ctx
  */
@@ -57,6 +156,9 @@ void init_cis_log(
 
 /**
  * \brief Initialize session logging
+ *
+ * If log_format=binary is set in cis.conf sessions/${session_id}.blog
+ * is written instead of text session log.
  * @param[in] options
  * @param[in] ctx
  * @param[in] session
@@ -73,7 +175,10 @@ void init_session_log(
  * If cis log is not initialized doesn nothing.\n
  * If an webui log initialized also writes to webui log
  */
-void cis_log(actions act, const std::string& message);
+void cis_log(
+        actions act,
+        const std::string& message,
+        log_level level = log_level::action);
 
 /**
  * \brief Record the message to an session log
@@ -81,7 +186,10 @@ void cis_log(actions act, const std::string& message);
  * If session log is not initialized doesn nothing.\n
  * If an webui log initialized also writes to webui log
  */
-void session_log(actions act, const std::string& message);
+void session_log(
+        actions act,
+        const std::string& message,
+        log_level level = log_level::action);
 
 /**
  * \brief Record the message to an webui log
@@ -93,10 +201,128 @@ void webui_log(actions act, const std::string& message);
 /**
  * \brief Record the message to session and cis logs
  *
- * If an webui log initialized also writes to webui log
+ * If an webui log initialized also writes to webui log.\n
+ * Record is built once and shared by all logs.
+ */
+void tee_log(
+        actions act,
+        const std::string& message,
+        log_level level = log_level::action);
+
+/**
+ * \brief Checks if webui or offline webui log is initialized
+ */
+bool webui_log_enabled();
+
+/**
+ * \brief Waits until records of async sinks are written
+ *
+ * Text file logs are written on shared writer thread
+ * if log_writer=async is set in cis.conf.
  */
-void tee_log(actions act, const std::string& message);
+void flush_logs();
+
+/**
+ * \brief Writes queued records and closes all logs
+ */
+void close_logs();
 
 extern LoggerPtr cis_logger;
 extern LoggerPtr session_logger;
 extern LoggerPtr webui_logger;
+extern std::unique_ptr<cis1::binary_log_writer> cis_binary_logger;
+extern std::unique_ptr<cis1::binary_log_writer> session_binary_logger;
+
+/**
+ * \brief Getter for binary cis log, reopens it for new day
+ * \return Writer or nullptr if cis log isn't binary
+ */
+cis1::binary_log_writer* cis_binary_log();
+
+/**
+ * \brief Record to cis log, formatting is skipped for binary log
+ */
+template <class... Args>
+void cis_log_fmt(
+        log_level level,
+        actions act,
+        const char* format,
+        const Args&... args)
+{
+    auto* binary_log = cis_binary_log();
+    if(!binary_log)
+    {
+        cis_log(act, SCFormat(format, args...), level);
+
+        return;
+    }
+
+    binary_log->record(act, format, args...);
+
+    if(webui_log_enabled())
+    {
+        webui_log(act, SCFormat(format, args...));
+    }
+}
+
+/**
+ * \brief Record to session log, formatting is skipped for binary log
+ */
+template <class... Args>
+void session_log_fmt(
+        log_level level,
+        actions act,
+        const char* format,
+        const Args&... args)
+{
+    if(!session_binary_logger)
+    {
+        session_log(act, SCFormat(format, args...), level);
+
+        return;
+    }
+
+    session_binary_logger->record(act, format, args...);
+
+    if(webui_log_enabled())
+    {
+        webui_log(act, SCFormat(format, args...));
+    }
+}
+
+/**
+ * \brief Record to session and cis logs, formatting is skipped
+ *        for binary logs
+ */
+template <class... Args>
+void tee_log_fmt(
+        log_level level,
+        actions act,
+        const char* format,
+        const Args&... args)
+{
+    auto* binary_log = cis_binary_log();
+
+    // log format is the same for both logs
+    if(!binary_log && !session_binary_logger)
+    {
+        tee_log(act, SCFormat(format, args...), level);
+
+        return;
+    }
+
+    if(binary_log)
+    {
+        binary_log->record(act, format, args...);
+    }
+
+    if(session_binary_logger)
+    {
+        session_binary_logger->record(act, format, args...);
+    }
+
+    if(webui_log_enabled())
+    {
+        webui_log(act, SCFormat(format, args...));
+    }
+}
@@ -0,0 +1,320 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <functional>
+#include <optional>
+
+#include "os_interface.h"
+
+namespace cis1
+{
+
+/**
+ * \brief Process started with memory_os::spawn_process
+ */
+struct spawned_process
+{
+    std::string start_dir;
+    std::string executable;
+    std::vector<std::string> args;
+    environment env;
+};
+
+/**
+ * \brief In-memory implementation of os_interface
+ *
+ * Keeps filesystem tree and environment in memory, so code working through
+ * os_interface can be tested and benchmarked without disk I/O. Clones share
+ * the same tree like instances of cis1::os share the disk, all calls are
+ * thread safe. Errors follow std::filesystem and POSIX where practical:
+ * missing entries give no_such_file_or_directory, removing non-empty
+ * directory gives directory_not_empty and so on.
+ *
+ * Relative paths are resolved from "/". Symlinks and permissions except
+ * owner executable bit aren't supported.
+ *
+ * Opened ofstream writes directly to file content, so written data is
+ * visible to other streams without flush, and removed or renamed file keeps
+ * receiving data like unlinked inode. Opened ifstream reads snapshot of
+ * content taken at open.
+ *
+ * Advisory locks behave like flock(2) on inodes.
+ *
+ * Processes aren't started, spawn_process records them and calls spawn
+ * handler if it's set, the handler may simulate process effects.
+ */
+class memory_os
+    : public os_interface
+{
+public:
+    using spawn_handler_t = std::function<void(const spawned_process&)>;
+
+    /**
+     * \brief Constructs memory_os instance with empty root directory
+     */
+    memory_os();
+
+    /**
+     * \brief Makes clone sharing filesystem of current instance
+     * \return Cloned os instance
+     */
+    std::unique_ptr<os_interface> clone() const override;
+
+    /**
+     * \brief Environment var getter
+     * \return Environment var string if var exists empty string otherwise
+     * @param[in] name Variable name
+     */
+    std::string get_env_var(
+            const std::string& name) const override;
+
+    /**
+     * \brief Checks whether dir is directory
+     * @param[in] dir Path to fs entry
+     * @param[out] ec
+     */
+    bool is_directory(
+            const std::filesystem::path& dir,
+            std::error_code& ec) const override;
+
+    /**
+     * \brief Check whether fs entry exists
+     * @param[in] path Path to entry
+     * @param[out] ec
+     */
+    bool exists(
+            const std::filesystem::path& path,
+            std::error_code& ec) const override;
+
+    /**
+     * \brief Streams directory entries to callback in name order
+     *
+     * Entries are copied before the first call, so callback may modify
+     * the directory.
+     * @param[in] path Path to directory
+     * @param[in] cb Called for each entry
+     * @param[out] ec
+     */
+    void iterate_directory(
+            const std::filesystem::path& path,
+            const dir_entry_cb_t& cb,
+            std::error_code& ec) const override;
+
+    /**
+     * \brief Getter for directory entries
+     * \return Array of fs_entries in directory
+     * @param[in] path Path to directory
+     * \throw std::filesystem::filesystem_error if path isn't directory
+     */
+    std::vector<
+            std::unique_ptr<fs_entry_interface>> list_directory(
+            const std::filesystem::path& path) const override;
+
+    /**
+     * \brief Makes new directory
+     * \return true is directory created successfully false otherwise
+     * @param[in] dir Path to directory
+     * @param[out] ec
+     */
+    bool create_directory(
+            const std::filesystem::path& dir,
+            std::error_code& ec) const override;
+
+    /**
+     * \brief Copies file or directory without recursion
+     *
+     * Like std::filesystem::copy with default options: subdirectories
+     * of copied directory are created empty.
+     * @param[in] from Path to source fs entry
+     * @param[in] to Path to destination fs entry
+     * @param[out] ec
+     */
+    void copy(
+            const std::filesystem::path& from,
+            const std::filesystem::path& to,
+            std::error_code& ec) const override;
+
+    /**
+     * \brief Renames fs entry, existing destination file is replaced
+     * @param[in] from Path to source fs entry
+     * @param[in] to Path to destination fs entry
+     * @param[out] ec
+     */
+    void rename(
+            const std::filesystem::path& from,
+            const std::filesystem::path& to,
+            std::error_code& ec) const override;
+
+    /**
+     * \brief Open file for reading
+     * @param[in] path Path to file
+     * @param[in] mode Open mode default is std::ios_base::in
+     */
+    std::unique_ptr<ifstream_interface> open_ifstream(
+            const std::filesystem::path& path,
+            std::ios_base::openmode mode = std::ios_base::in) const override;
+
+    /**
+     * \brief Open file for writing
+     * @param[in] path Path to file
+     * @param[in] mode Open mode default is std::ios_base::out
+     */
+    std::unique_ptr<ofstream_interface> open_ofstream(
+            const std::filesystem::path& path,
+            std::ios_base::openmode mode = std::ios_base::out) const override;
+
+    /**
+     * \brief Opens file for locking, creates it if missing
+     *
+     * Locks behave like flock(2) between instances sharing the tree,
+     * waiting lock blocks calling thread.
+     * \return Lock or nullptr on error
+     * @param[in] path Path to lock file
+     * @param[out] ec
+     */
+    std::unique_ptr<file_lock_interface> open_lock_file(
+            const std::filesystem::path& path,
+            std::error_code& ec) const override;
+
+    /**
+     * \brief Records process and calls spawn handler
+     * @param[in] start_dir Dir where process will be executed
+     * @param[in] executable
+     * @param[in] args Args passed to process
+     * @param[in] env Environment passed to process
+     */
+    void spawn_process(
+            const std::string& start_dir,
+            const std::string& executable,
+            const std::vector<std::string>& args,
+            const environment& env) const override;
+
+    /**
+     * \brief Remove fs entry (except for non-empty dir)
+     * @param[in] path Path to fs entry
+     * @param[out] ec
+     */
+    void remove(
+            const std::filesystem::path& path,
+            std::error_code& ec) const override;
+
+    /**
+     * \brief Remove fs entry
+     * @param[in] path Path to fs entry
+     * @param[out] ec
+     */
+    void remove_all(
+            const std::filesystem::path& path,
+            std::error_code& ec) const override;
+
+    /**
+     * \brief Checks fs entry is executable
+     * @param[in] path Path to fs entry
+     * @param[out] ec
+     */
+    bool is_executable(
+            const std::filesystem::path& path,
+            std::error_code& ec) const override;
+
+    /**
+     * \brief Makes fs entry executable
+     * @param[in] path Path to fs entry
+     * @param[out] ec
+     */
+    void make_executable(
+            const std::filesystem::path& path,
+            std::error_code& ec) const override;
+
+    /**
+     * \brief Getter for last modification time of fs entry
+     *
+     * Time is updated when file is created or opened for writing.
+     * @param[in] path Path to fs entry
+     * @param[out] ec
+     */
+    std::filesystem::file_time_type last_write_time(
+            const std::filesystem::path& path,
+            std::error_code& ec) const override;
+
+    /**
+     * \brief Sets last modification time of fs entry
+     * @param[in] path Path to fs entry
+     * @param[in] time
+     * @param[out] ec
+     */
+    void set_last_write_time(
+            const std::filesystem::path& path,
+            std::filesystem::file_time_type time,
+            std::error_code& ec) const override;
+
+    /**
+     * \brief Sets environment var returned by get_env_var
+     * @param[in] name
+     * @param[in] value
+     */
+    void set_env_var(
+            const std::string& name,
+            const std::string& value);
+
+    /**
+     * \brief Makes directory with all missing parents
+     * @param[in] dir Path to directory
+     * @param[out] ec
+     */
+    void create_directories(
+            const std::filesystem::path& dir,
+            std::error_code& ec);
+
+    /**
+     * \brief Replaces file content, creates missing parent directories
+     * @param[in] path Path to file
+     * @param[in] content
+     * @param[out] ec
+     * @param[in] executable Owner executable bit of the file
+     */
+    void write_file(
+            const std::filesystem::path& path,
+            const std::string& content,
+            std::error_code& ec,
+            bool executable = false);
+
+    /**
+     * \brief Getter for file content
+     * \return Content or std::nullopt if path isn't regular file
+     * @param[in] path Path to file
+     */
+    std::optional<std::string> read_file(
+            const std::filesystem::path& path) const;
+
+    /**
+     * \brief Sets callback called for each spawned process
+     * @param[in] handler
+     */
+    void set_spawn_handler(spawn_handler_t handler);
+
+    /**
+     * \brief Getter for processes spawned by this instance and its clones
+     * \return Processes in spawn order
+     */
+    std::vector<spawned_process> spawned() const;
+
+    /// \cond DO_NOT_DOCUMENT
+    struct lock_state;
+    struct node;
+    struct state;
+    /// \endcond
+
+private:
+    explicit memory_os(const std::shared_ptr<state>& state);
+
+    std::shared_ptr<state> state_;
+};
+
+} // namespace cis1
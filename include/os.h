@@ -61,6 +61,17 @@ public:
             std::unique_ptr<fs_entry_interface>> list_directory(
             const std::filesystem::path& path) const override;
 
+    /**
+     * \brief Streams directory entries to callback
+     * @param[in] path Path to directory
+     * @param[in] cb Called for each entry except "." and ".."
+     * @param[out] ec
+     */
+    void iterate_directory(
+            const std::filesystem::path& path,
+            const dir_entry_cb_t& cb,
+            std::error_code& ec) const override;
+
     /**
      * \brief Makes new directory
      * \return true is directory created successfully false otherwise
@@ -82,6 +93,17 @@ public:
             const std::filesystem::path& to,
             std::error_code& ec) const override;
 
+    /**
+     * \brief Renames fs entry, existing destination file is replaced atomically
+     * @param[in] from Path to source fs entry
+     * @param[in] to Path to destination fs entry
+     * @param[out] ec
+     */
+    void rename(
+            const std::filesystem::path& from,
+            const std::filesystem::path& to,
+            std::error_code& ec) const override;
+
     /**
      * \brief Open file for reading
      * @param[in] path Path to file
@@ -100,6 +122,16 @@ public:
             const std::filesystem::path& path,
             std::ios_base::openmode mode = std::ios_base::out) const override;
 
+    /**
+     * \brief Opens file for flock(2), creates it if missing
+     * \return Lock or nullptr on error
+     * @param[in] path Path to lock file
+     * @param[out] ec
+     */
+     std::unique_ptr<file_lock_interface> open_lock_file(
+            const std::filesystem::path& path,
+            std::error_code& ec) const override;
+
     /**
      * \brief Creates child process and detaches it
      * @param[in] start_dir Dir where process will be executed
@@ -111,7 +143,7 @@ public:
             const std::string& start_dir,
             const std::string& executable,
             const std::vector<std::string>& args,
-            boost::process::environment env) const override;
+            const environment& env) const override;
 
     /**
      * \brief Remove fs entry (except for non-empty dir)
@@ -148,6 +180,26 @@ public:
     void make_executable(
             const std::filesystem::path& path,
             std::error_code& ec) const override;
+
+    /**
+     * \brief Getter for last modification time of fs entry
+     * @param[in] path Path to fs entry
+     * @param[out] ec
+     */
+    std::filesystem::file_time_type last_write_time(
+            const std::filesystem::path& path,
+            std::error_code& ec) const override;
+
+    /**
+     * \brief Sets last modification time of fs entry
+     * @param[in] path Path to fs entry
+     * @param[in] time
+     * @param[out] ec
+     */
+    void set_last_write_time(
+            const std::filesystem::path& path,
+            std::filesystem::file_time_type time,
+            std::error_code& ec) const override;
 };
 
 } // namespace cis1
@@ -17,7 +17,10 @@
 
 #include "ifstream_interface.h"
 #include "ofstream_interface.h"
+#include "file_lock_interface.h"
 #include "fs_entry_interface.h"
+#include "dir_entry.h"
+#include "environment.h"
 
 namespace cis1
 {
@@ -61,10 +64,19 @@ struct os_interface
             const std::filesystem::path& path,
             std::error_code& ec) const = 0;
 
-    /*
-    virtual polymorphic_range<fs_entry_interface> directory_iterator(
-            const std::filesystem::path& path) const = 0;
-    */
+    /**
+     * \brief Streams directory entries to callback
+     *
+     * Doesn't allocate per entry. Entry type of symlinks is resolved
+     * to type of their target (like fs_entry_interface::is_directory).
+     * @param[in] path Path to directory
+     * @param[in] cb Called for each entry except "." and ".."
+     * @param[out] ec
+     */
+    virtual void iterate_directory(
+            const std::filesystem::path& path,
+            const dir_entry_cb_t& cb,
+            std::error_code& ec) const = 0;
 
     /**
      * \brief Getter for directory entries
@@ -96,6 +108,17 @@ struct os_interface
             const std::filesystem::path& to,
             std::error_code& ec) const = 0;
 
+    /**
+     * \brief Renames fs entry, existing destination file is replaced atomically
+     * @param[in] from Path to source fs entry
+     * @param[in] to Path to destination fs entry
+     * @param[out] ec
+     */
+    virtual void rename(
+            const std::filesystem::path& from,
+            const std::filesystem::path& to,
+            std::error_code& ec) const = 0;
+
     /**
      * \brief Open file for reading
      * @param[in] path Path to file
@@ -114,6 +137,16 @@ struct os_interface
             const std::filesystem::path& path,
             std::ios_base::openmode mode = std::ios_base::out) const = 0;
 
+    /**
+     * \brief Opens file for advisory locking, creates it if missing
+     * \return Lock or nullptr on error
+     * @param[in] path Path to lock file
+     * @param[out] ec
+     */
+    virtual std::unique_ptr<file_lock_interface> open_lock_file(
+            const std::filesystem::path& path,
+            std::error_code& ec) const = 0;
+
     /**
      * \brief Creates child process and detaches it
      * @param[in] start_dir Dir where process will be executed
@@ -125,7 +158,7 @@ struct os_interface
             const std::string& start_dir,
             const std::string& executable,
             const std::vector<std::string>& args,
-            boost::process::environment env) const = 0;
+            const environment& env) const = 0;
 
     /**
      * \brief Remove fs entry (except for non-empty dir)
@@ -162,6 +195,26 @@ struct os_interface
     virtual void make_executable(
             const std::filesystem::path& path,
             std::error_code& ec) const = 0;
+
+    /**
+     * \brief Getter for last modification time of fs entry
+     * @param[in] path Path to fs entry
+     * @param[out] ec
+     */
+    virtual std::filesystem::file_time_type last_write_time(
+            const std::filesystem::path& path,
+            std::error_code& ec) const = 0;
+
+    /**
+     * \brief Sets last modification time of fs entry
+     * @param[in] path Path to fs entry
+     * @param[in] time
+     * @param[out] ec
+     */
+    virtual void set_last_write_time(
+            const std::filesystem::path& path,
+            std::filesystem::file_time_type time,
+            std::error_code& ec) const = 0;
 };
 
 } // namespace cis1
@@ -0,0 +1,67 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "job.h"
+
+namespace cis1
+{
+
+/**
+ * \brief Prepared build run by run_parallel and its result
+ */
+struct parallel_build
+{
+    job& build_job;
+    uint32_t build_number;
+    environment env; ///< Environment passed to build
+
+    std::error_code ec;
+    int exit_code = -1;
+    std::optional<build_stats> stats;
+    int64_t started_ms = 0;
+    int64_t finished_ms = 0;
+};
+
+/**
+ * \brief Runs prepared builds concurrently on single io_context
+ *
+ * Builds are started in given order, at most max_concurrent at once.
+ * Returns when all builds are finished.
+ * @param[in,out] builds Builds to run, results are stored in them
+ * @param[in] max_concurrent Concurrency limit, 0 means no limit
+ * @param[in] ctx
+ * @param[in] force Try to execute even if script isn't executable
+ * @param[in] on_started Called right before build is started
+ * @param[in] on_finished Called when build is finished
+ * @param[in] on_line Called for each line of build stdout (error is false)
+ *                    and stderr (error is true)
+ * @param[in] job_runner_factory
+ */
+void run_parallel(
+        std::vector<parallel_build>& builds,
+        size_t max_concurrent,
+        cis1::context_interface& ctx,
+        bool force,
+        std::function<void(parallel_build&)> on_started,
+        std::function<void(parallel_build&)> on_finished,
+        std::function<void(parallel_build&, bool error, const std::string&)> on_line,
+        job::job_runner_factory_t job_runner_factory =
+                        [](auto&&... args)
+                        {
+                            return std::make_unique<job_runner>(
+                                    std::forward<decltype(args)>(args)...);
+                        });
+
+} // namespace cis1
@@ -14,11 +14,118 @@
 
 #include <boost/system/error_code.hpp>
 #include <boost/process.hpp>
+#include <boost/process/extend.hpp>
 #include <boost/asio.hpp>
 
+#include "environment.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace cis1
 {
 
+/**
+ * \brief Prepares child process between fork and exec
+ *
+ * Makes the child a leader of new process group, so the whole
+ * process tree can be signalled at once. Moves the child into cgroup
+ * if cgroup.procs path is given. Failure to join cgroup is not fatal,
+ * job runs without isolation.
+ */
+class child_setup
+    : public boost::process::extend::handler
+{
+public:
+    /**
+     * \brief Constructs child_setup instance
+     * @param[in] cgroup_procs Path to cgroup.procs or empty string
+     * @param[in] on_spawn Called in parent with pid of started child
+     */
+    explicit child_setup(
+            std::string cgroup_procs = {},
+            std::function<void(int)> on_spawn = {})
+        : cgroup_procs_(std::move(cgroup_procs))
+        , on_spawn_(std::move(on_spawn))
+    {}
+
+    /**
+     * \brief Called in child process right before exec
+     */
+    template <class Executor>
+    void on_exec_setup(Executor&) const
+    {
+#ifdef __linux__
+        // Only async-signal-safe calls are allowed here
+        ::setpgid(0, 0);
+
+        if(!cgroup_procs_.empty())
+        {
+            int fd = ::open(cgroup_procs_.c_str(), O_WRONLY | O_CLOEXEC);
+            if(fd != -1)
+            {
+                // "0" means the writing process itself
+                [[maybe_unused]] auto written = ::write(fd, "0", 1);
+                ::close(fd);
+            }
+        }
+#endif
+    }
+
+    /**
+     * \brief Called in parent process after child was started
+     */
+    template <class Executor>
+    void on_success(Executor& exec) const
+    {
+#ifdef __linux__
+        // Repeat in parent to avoid race with early signals,
+        // fails harmlessly if child already did exec
+        ::setpgid(exec.pid, exec.pid);
+
+        if(on_spawn_)
+        {
+            on_spawn_(exec.pid);
+        }
+#endif
+    }
+
+private:
+    std::string cgroup_procs_;
+    std::function<void(int)> on_spawn_;
+};
+
+/**
+ * \brief Passes environment to child process without
+ *        building boost::process::environment
+ */
+class env_setup
+    : public boost::process::extend::handler
+{
+public:
+    /**
+     * \brief Constructs env_setup instance
+     * @param[in] env Environment passed to process
+     */
+    explicit env_setup(const environment& env)
+        : block_(env.make_block())
+    {}
+
+    /**
+     * \brief Called in parent process before fork
+     */
+    template <class Executor>
+    void on_setup(Executor& exec) const
+    {
+        exec.env = block_.data();
+    }
+
+private:
+    mutable environment::block block_;
+};
+
 /**
  * \brief Default implementation for process-related things
  */
@@ -32,6 +139,7 @@ public:
      * @param[in] cmd Command to run
      * @param[in] env Environment passed to process
      * @param[in] path Directory to run process
+     * @param[in] setup Child process setup
      * @param[in] std_in
      * @param[in] std_out
      * @param[in] std_err
@@ -43,8 +151,9 @@ public:
                     boost::system::error_code err,
                     int exit_code)>&& cb,
             std::string cmd,
-            boost::process::environment env,
+            const environment& env,
             std::filesystem::path path,
+            const child_setup& setup,
             StdIn std_in,
             StdOut std_out,
             StdErr std_err) const
@@ -53,8 +162,13 @@ public:
                 io_ctx,
                 cb,
                 cmd,
-                env,
+#ifdef __linux__
+                env_setup{env},
+#else
+                env.native(),
+#endif
                 boost::process::start_dir = path.string(),
+                setup,
                 std_in,
                 std_out,
                 std_err);
@@ -0,0 +1,140 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <boost/asio.hpp>
+
+#include "os_interface.h"
+
+namespace cis1
+{
+
+/**
+ * \brief Counters of process_launcher
+ */
+struct launcher_stats
+{
+    uint64_t spawned = 0; ///< started processes
+    uint64_t failed = 0; ///< spawn errors
+    uint64_t reaped = 0; ///< exited children collected
+    /// time from launch call to return of spawn of the last process
+    std::chrono::microseconds last_latency{0};
+    std::chrono::microseconds max_latency{0};
+    std::chrono::microseconds total_latency{0};
+
+    /**
+     * \brief Started processes which haven't exited yet
+     */
+    uint64_t outstanding() const;
+};
+
+/**
+ * \brief Starts detached processes on a dedicated worker thread
+ *
+ * Fork and exec of os_interface::spawn_process don't block handlers of
+ * io_context. Exited children are reaped on io_context by SIGCHLD and by
+ * polling once a second while some are outstanding, since SIGCHLD may be
+ * consumed by other handlers (linux only). Owner must not have other
+ * children waited elsewhere.
+ * Results and counters are updated on io_context, stats() must be
+ * called from it too.
+ */
+class process_launcher
+{
+public:
+    /**
+     * \brief Constructs process_launcher instance and starts worker
+     * @param[in] io_ctx Context for results and child reaping
+     * @param[in] os Cloned for the worker
+     */
+    process_launcher(
+            boost::asio::io_context& io_ctx,
+            const os_interface& os);
+
+    /**
+     * \brief Stops worker, not started processes are dropped
+     *
+     * Results already posted to io_context are ignored when run later.
+     */
+    ~process_launcher();
+
+    process_launcher(const process_launcher&) = delete;
+    process_launcher& operator=(const process_launcher&) = delete;
+
+    /**
+     * \brief Queues process start, arguments are the same as spawn_process
+     * @param[in] start_dir Dir where process will be executed
+     * @param[in] executable
+     * @param[in] args Args passed to process
+     * @param[in] env Environment passed to process
+     */
+    void launch(
+            const std::string& start_dir,
+            const std::string& executable,
+            const std::vector<std::string>& args,
+            const environment& env);
+
+    /**
+     * \brief Getter for counters
+     */
+    const launcher_stats& stats() const;
+
+    /**
+     * \brief Logs summary of counters
+     */
+    void log_stats() const;
+
+private:
+    struct request
+    {
+        std::string start_dir;
+        std::string executable;
+        std::vector<std::string> args;
+        environment env;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    boost::asio::io_context& io_ctx_;
+    std::unique_ptr<os_interface> os_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<request> queue_;
+    bool stopping_ = false;
+    launcher_stats stats_;
+    /// Expires with launcher, guards results posted by worker
+    std::shared_ptr<void> alive_ = std::make_shared<bool>(true);
+#ifdef __linux__
+    boost::asio::signal_set child_signals_;
+    boost::asio::steady_timer reap_timer_;
+    bool reap_timer_armed_ = false;
+#endif
+    std::thread worker_;
+
+    void work();
+
+    void on_spawned(
+            const request& req,
+            std::chrono::microseconds latency,
+            const std::string& error);
+
+    void wait_child_signal();
+
+    void poll_children();
+
+    void reap_children();
+};
+
+} // namespace cis1
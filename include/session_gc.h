@@ -0,0 +1,149 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "environment.h"
+#include "os_interface.h"
+
+namespace cis1
+{
+
+/**
+ * \brief Session garbage collection settings (cis.conf keys)
+ */
+struct session_gc_options
+{
+    /// session_keep_hours, files of closed session are kept for this time
+    std::chrono::seconds keep_closed{7 * 24 * 3600};
+    /// session_abandon_hours, session without close record is collected
+    /// when none of its files is modified for this time
+    std::chrono::seconds keep_abandoned{30 * 24 * 3600};
+    /// session_gc_threads, count of threads removing files
+    uint32_t threads = 4;
+    /// session_gc_rate, max removed files per second, 0 means no limit
+    uint32_t max_removes_per_second = 0;
+};
+
+/**
+ * \brief Result of collection
+ */
+struct session_gc_stats
+{
+    size_t sessions = 0; ///< sessions which files are removed
+    size_t files = 0; ///< removed files
+    size_t failed = 0; ///< files which can't be removed
+};
+
+/**
+ * \brief Reads session gc settings
+ * \return Settings, invalid values are replaced by defaults
+ * @param[in] env Environment with cis.conf values
+ */
+session_gc_options load_session_gc_options(const environment& env);
+
+/**
+ * \brief Path of journal of closed sessions, line is "${unix_time} ${session_id}"
+ * @param[in] base_dir
+ */
+std::filesystem::path closed_sessions_path(const std::filesystem::path& base_dir);
+
+/**
+ * \brief Finds files of the session by their known names
+ *
+ * Probes ${session_id}.dat, .prm, their lock files, .graph, .combined.log,
+ * .blog and .${n}.log[.gz] segments, so sessions directory isn't listed.
+ * \return Names of existing files, found before error if ec is set
+ * @param[in] sessions_dir
+ * @param[in] session_id
+ * @param[out] ec
+ * @param[in] os
+ */
+std::vector<std::string> find_session_files(
+        const std::filesystem::path& sessions_dir,
+        const std::string& session_id,
+        std::error_code& ec,
+        const os_interface& os);
+
+/**
+ * \brief Appends close record of the session to the journal
+ * @param[in] base_dir
+ * @param[in] session_id
+ * @param[out] ec
+ * @param[in] os
+ */
+void record_closed_session(
+        const std::filesystem::path& base_dir,
+        const std::string& session_id,
+        std::error_code& ec,
+        const os_interface& os);
+
+/**
+ * \brief Limits rate of operations shared by several threads
+ */
+class rate_limiter
+{
+public:
+    /**
+     * @param[in] per_second Max operations per second, 0 means no limit
+     */
+    explicit rate_limiter(uint32_t per_second);
+
+    /**
+     * \brief Blocks until the next operation is allowed
+     */
+    void acquire();
+
+private:
+    std::mutex mutex_;
+    std::chrono::nanoseconds interval_;
+    std::chrono::steady_clock::time_point next_;
+};
+
+/**
+ * \brief Removes files of sessions closed more than keep_closed ago
+ *
+ * Candidates are taken from the journal, files of the session are taken
+ * from its index, so sessions directory isn't listed. Journal records of
+ * kept sessions and sessions with failed removal are written back.
+ * \return Stats
+ * @param[in] base_dir
+ * @param[in] options
+ * @param[out] ec
+ * @param[in] os
+ */
+session_gc_stats collect_closed_sessions(
+        const std::filesystem::path& base_dir,
+        const session_gc_options& options,
+        std::error_code& ec,
+        const os_interface& os);
+
+/**
+ * \brief Lists sessions directory and removes files of sessions which
+ *        aren't modified for keep_abandoned, e.g. opened before the journal
+ *        or killed before close
+ * \return Stats
+ * @param[in] base_dir
+ * @param[in] options
+ * @param[out] ec
+ * @param[in] os
+ */
+session_gc_stats collect_abandoned_sessions(
+        const std::filesystem::path& base_dir,
+        const session_gc_options& options,
+        std::error_code& ec,
+        const os_interface& os);
+
+} // namespace cis1
@@ -0,0 +1,119 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+
+#include "os_interface.h"
+
+namespace cis1
+{
+
+/**
+ * \brief Finished build of session with edge to parent build
+ *
+ * sessions/<session_id>.graph is append-only, one node per line:
+ * "<job> <build> <parent_job|-> <parent_build|-> <started_ms> <finished_ms> <exit_code>".
+ */
+struct graph_node
+{
+    std::string job;
+    std::string build;
+    std::string parent_job;   ///< empty for top level builds
+    std::string parent_build; ///< empty for top level builds
+    int64_t started_ms = 0;
+    int64_t finished_ms = 0;
+    int exit_code = 0;
+};
+
+/**
+ * \brief Node of critical path
+ */
+struct critical_step
+{
+    size_t node; ///< Index in analyzed nodes
+    int64_t duration_ms;
+    int64_t self_ms; ///< Time not covered by child builds
+};
+
+/**
+ * \brief Parallelism of child builds of single build
+ */
+struct fan_out
+{
+    size_t node; ///< Index of parent in analyzed nodes
+    size_t children;
+    int64_t children_ms; ///< Sum of child durations
+    int64_t busy_ms;     ///< Time when at least one child ran
+};
+
+/**
+ * \brief Session graph summary
+ */
+struct graph_summary
+{
+    int64_t wall_ms = 0; ///< From first start to last finish
+    int64_t work_ms = 0; ///< Sum of self times of all builds
+    double parallelism = 0; ///< work_ms / wall_ms
+    std::vector<critical_step> critical_path;
+    std::vector<fan_out> fan_outs; ///< Builds with several children
+};
+
+/**
+ * \brief Path to graph file of session
+ * \return base_dir/sessions/<session_id>.graph
+ * @param[in] base_dir
+ * @param[in] session_id
+ */
+std::filesystem::path session_graph_path(
+        const std::filesystem::path& base_dir,
+        const std::string& session_id);
+
+/**
+ * \brief Appends node to session graph file
+ * @param[in] path Path to graph file
+ * @param[in] node
+ * @param[out] ec
+ * @param[in] os
+ */
+void append_graph_node(
+        const std::filesystem::path& path,
+        const graph_node& node,
+        std::error_code& ec,
+        const os_interface& os);
+
+/**
+ * \brief Reads session graph file
+ * \return Nodes in order of finish
+ * @param[in] path Path to graph file
+ * @param[out] ec
+ * @param[in] os
+ */
+std::vector<graph_node> read_session_graph(
+        const std::filesystem::path& path,
+        std::error_code& ec,
+        const os_interface& os);
+
+/**
+ * \brief Computes critical path and parallelism of session
+ *
+ * Parent build waits for the child finished last, so critical path
+ * goes from top level build finished last through such children.
+ * Builds whose parent isn't in graph are treated as top level.
+ * \return Summary
+ * @param[in] nodes
+ */
+graph_summary analyze_session_graph(const std::vector<graph_node>& nodes);
+
+} // namespace cis1
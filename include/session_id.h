@@ -0,0 +1,85 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+
+namespace cis1
+{
+
+/// Length of generated session id
+constexpr size_t session_id_size = 26;
+
+/**
+ * \brief Generator of ULID-like session ids
+ *
+ * Id is 48 bit unix time in milliseconds and 80 random bits in Crockford
+ * base32, so ids sort by creation time as strings. Random part is
+ * incremented for ids of the same millisecond, so ids of one generator
+ * are strictly increasing, and 80 random bits make collisions of
+ * generators on different hosts improbable.
+ */
+class session_id_generator
+{
+public:
+    /**
+     * \brief Seeds generator from std::random_device, pid and clock
+     */
+    session_id_generator();
+
+    /**
+     * @param[in] seed
+     */
+    explicit session_id_generator(uint64_t seed);
+
+    /**
+     * \brief Makes id for current time, thread safe
+     */
+    std::string next();
+
+    /**
+     * \brief Makes id for given time, thread safe
+     * @param[in] unix_time_ms Time, ids aren't decreasing if it goes back
+     */
+    std::string next(int64_t unix_time_ms);
+
+private:
+    std::mutex mutex_;
+    std::mt19937_64 random_;
+    int64_t last_ms_ = -1;
+    uint16_t random_hi_ = 0; ///< upper 16 of 80 random bits
+    uint64_t random_lo_ = 0; ///< lower 64 of 80 random bits
+};
+
+/**
+ * \brief Makes new session id with process-wide generator
+ */
+std::string generate_session_id();
+
+/**
+ * \brief Session id fields
+ */
+struct session_id_info
+{
+    int64_t unix_time_ms; ///< session open time
+    bool legacy; ///< "YYYY-MM-DD-HH-MM-SS-pid_ppid" id of older versions
+};
+
+/**
+ * \brief Parses generated or legacy session id
+ * \return Fields or std::nullopt if id has unknown format
+ * @param[in] session_id
+ */
+std::optional<session_id_info> parse_session_id(const std::string& session_id);
+
+} // namespace cis1
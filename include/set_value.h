@@ -8,6 +8,10 @@
 
 #pragma once
 
+#include <string>
+#include <utility>
+#include <vector>
+
 #include <cis1_proto_utils/read_istream_kv_str.h>
 #include "error_code.h"
 #include "context_interface.h"
@@ -34,4 +38,19 @@ void set_value(
         std::error_code& ec,
         const os_interface& os);
 
+/**
+ * \brief Sets several values with one atomic rewrite of the file
+ * @param[in] ctx
+ * @param[in] session
+ * @param[in] new_values Pairs of name and value, last pair wins for same names
+ * @param[out] ec
+ * @param[in] os
+ */
+void set_values(
+        const cis1::context_interface& ctx,
+        const session_interface& session,
+        const std::vector<std::pair<std::string, std::string>>& new_values,
+        std::error_code& ec,
+        const os_interface& os);
+
 } // namespace cis1
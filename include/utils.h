@@ -8,14 +8,24 @@
 
 #pragma once
 
+#include <cstdint>
+#include <filesystem>
 #include <string>
+#include <string_view>
 #include <optional>
 
 /**
  * \brief Validate whether this name is build name
  * @param[in] dir_name Name to check
  */
-bool is_build(const std::string& dir_name);
+bool is_build(std::string_view dir_name);
+
+/**
+ * \brief Converts build name to build number
+ * \return Build number
+ * @param[in] dir_name Name which passed is_build check
+ */
+uint32_t build_number(std::string_view dir_name);
 
 /**
  * \brief Tries to convert string to uint32_t
@@ -23,3 +33,43 @@ bool is_build(const std::string& dir_name);
  * @param[in] str String to convert
  */
 std::optional<uint32_t> u32_from_string(const std::string& str);
+
+/**
+ * \brief Tries to convert "true" or "false" to bool
+ * \return Converted bool if conversion possible or std::nullopt otherwise
+ * @param[in] str String to convert
+ */
+std::optional<bool> bool_from_string(const std::string& str);
+
+/**
+ * \brief Checks whether str starts with prefix
+ * @param[in] str
+ * @param[in] prefix
+ */
+bool starts_with(std::string_view str, std::string_view prefix);
+
+/**
+ * \brief Checks whether str ends with suffix
+ * @param[in] str
+ * @param[in] suffix
+ */
+bool ends_with(std::string_view str, std::string_view suffix);
+
+/**
+ * \brief Path of temporary file of this thread, which replaces the file
+ *        by rename when it is written completely
+ * @param[in] path Path to file
+ */
+std::filesystem::path tmp_file_path(const std::filesystem::path& path);
+
+/**
+ * \brief Current time for build records
+ * \return Seconds since unix epoch
+ */
+int64_t unix_time_now();
+
+/**
+ * \brief Current time with milliseconds precision
+ * \return Milliseconds since unix epoch
+ */
+int64_t unix_time_now_ms();
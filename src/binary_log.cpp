@@ -0,0 +1,422 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "binary_log.h"
+
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <iterator>
+#include <map>
+
+#include "error_code.h"
+
+namespace cis1
+{
+
+namespace
+{
+
+// type and pid follow the record size
+constexpr size_t record_header_size =
+        sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint64_t);
+
+class record_reader
+{
+public:
+    record_reader(const char* begin, const char* end)
+        : pos_(begin)
+        , end_(end)
+    {}
+
+    template <class T>
+    bool get(T& value)
+    {
+        if(static_cast<size_t>(end_ - pos_) < sizeof(value))
+        {
+            return false;
+        }
+
+        std::memcpy(&value, pos_, sizeof(value));
+        pos_ += sizeof(value);
+
+        return true;
+    }
+
+    template <class Size>
+    bool get_string(std::string& str)
+    {
+        Size size;
+        if(!get(size) || static_cast<size_t>(end_ - pos_) < size)
+        {
+            return false;
+        }
+
+        str.assign(pos_, size);
+        pos_ += size;
+
+        return true;
+    }
+
+private:
+    const char* pos_;
+    const char* end_;
+};
+
+bool read_arg(record_reader& reader, std::string& str)
+{
+    binary_arg_type type;
+    if(!reader.get(type))
+    {
+        return false;
+    }
+
+    switch(type)
+    {
+        case binary_arg_type::int64:
+        {
+            int64_t value;
+            if(!reader.get(value))
+            {
+                return false;
+            }
+
+            str = std::to_string(value);
+
+            return true;
+        }
+        case binary_arg_type::uint64:
+        {
+            uint64_t value;
+            if(!reader.get(value))
+            {
+                return false;
+            }
+
+            str = std::to_string(value);
+
+            return true;
+        }
+        case binary_arg_type::float64:
+        {
+            double value;
+            if(!reader.get(value))
+            {
+                return false;
+            }
+
+            std::ostringstream ss;
+            ss << value;
+            str = ss.str();
+
+            return true;
+        }
+        case binary_arg_type::string:
+            return reader.get_string<uint32_t>(str);
+        default:
+            return false;
+    }
+}
+
+struct process_info
+{
+    uint64_t ppid = 0;
+    std::string session_id;
+    std::vector<std::string> formats;
+};
+
+} // namespace
+
+binary_log_writer::binary_log_writer(std::FILE* file, uint64_t pid)
+    : file_(file)
+    , pid_(pid)
+{}
+
+binary_log_writer::~binary_log_writer()
+{
+    std::fclose(file_);
+}
+
+std::unique_ptr<binary_log_writer> binary_log_writer::open(
+        const std::filesystem::path& path,
+        uint64_t pid,
+        uint64_t ppid,
+        const std::string& session_id,
+        std::error_code& ec)
+{
+    std::filesystem::create_directories(path.parent_path(), ec);
+    if(ec)
+    {
+        ec = cis1::error_code::cant_write_binary_log;
+
+        return nullptr;
+    }
+
+    auto* file = std::fopen(path.string().c_str(), "ab");
+    if(!file)
+    {
+        ec = cis1::error_code::cant_write_binary_log;
+
+        return nullptr;
+    }
+
+    // every record must reach the file with single write
+    std::setvbuf(file, nullptr, _IONBF, 0);
+
+    std::unique_ptr<binary_log_writer> writer(new binary_log_writer(file, pid));
+
+    writer->begin(binary_record_type::process);
+    writer->put(binary_log_magic);
+    writer->put(binary_log_version);
+    writer->put(ppid);
+    writer->put(static_cast<uint16_t>(session_id.size()));
+    writer->buf_.append(session_id);
+    writer->commit();
+
+    return writer;
+}
+
+int64_t binary_log_writer::unix_time_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+uint32_t binary_log_writer::intern(const char* format)
+{
+    for(size_t i = 0; i < formats_.size(); ++i)
+    {
+        if(formats_[i] == format)
+        {
+            return static_cast<uint32_t>(i);
+        }
+    }
+
+    auto id = static_cast<uint32_t>(formats_.size());
+    formats_.push_back(format);
+
+    std::string_view str = format;
+
+    begin(binary_record_type::format);
+    put(id);
+    put(static_cast<uint16_t>(str.size()));
+    buf_.append(str.data(), str.size());
+    commit();
+
+    return id;
+}
+
+void binary_log_writer::begin(binary_record_type type)
+{
+    buf_.clear();
+    put(uint32_t{0});
+    put(type);
+    put(pid_);
+}
+
+void binary_log_writer::commit()
+{
+    auto size = static_cast<uint32_t>(buf_.size());
+    std::memcpy(&buf_[0], &size, sizeof(size));
+
+    std::fwrite(buf_.data(), 1, buf_.size(), file_);
+}
+
+void read_binary_log(
+        std::istream& is,
+        const std::function<void(const binary_log_entry&)>& on_entry,
+        std::error_code& ec)
+{
+    std::string data{
+            std::istreambuf_iterator<char>(is),
+            std::istreambuf_iterator<char>()};
+
+    std::map<uint64_t, process_info> processes;
+
+    binary_log_entry entry;
+    std::vector<std::string> args;
+
+    const char* pos = data.data();
+    const char* end = data.data() + data.size();
+    bool first = true;
+
+    while(static_cast<size_t>(end - pos) >= record_header_size)
+    {
+        uint32_t size;
+        std::memcpy(&size, pos, sizeof(size));
+
+        if(size < record_header_size)
+        {
+            ec = cis1::error_code::cant_read_binary_log;
+
+            return;
+        }
+
+        if(size > static_cast<size_t>(end - pos))
+        {
+            if(first)
+            {
+                ec = cis1::error_code::cant_read_binary_log;
+
+                return;
+            }
+
+            // record is being written or writer died in the middle
+            break;
+        }
+
+        record_reader reader(pos + sizeof(size), pos + size);
+        pos += size;
+
+        binary_record_type type;
+        uint64_t pid;
+        reader.get(type);
+        reader.get(pid);
+
+        if(first && type != binary_record_type::process)
+        {
+            ec = cis1::error_code::cant_read_binary_log;
+
+            return;
+        }
+
+        first = false;
+
+        switch(type)
+        {
+            case binary_record_type::process:
+            {
+                uint32_t magic;
+                uint8_t version;
+                process_info info;
+
+                if(!reader.get(magic) || magic != binary_log_magic
+                || !reader.get(version) || version != binary_log_version
+                || !reader.get(info.ppid)
+                || !reader.get_string<uint16_t>(info.session_id))
+                {
+                    ec = cis1::error_code::cant_read_binary_log;
+
+                    return;
+                }
+
+                // pid may be reused by another process
+                processes[pid] = std::move(info);
+
+                break;
+            }
+            case binary_record_type::format:
+            {
+                uint32_t id;
+                std::string format;
+
+                if(!reader.get(id) || !reader.get_string<uint16_t>(format))
+                {
+                    break;
+                }
+
+                auto& formats = processes[pid].formats;
+                if(formats.size() <= id)
+                {
+                    formats.resize(id + 1);
+                }
+
+                formats[id] = std::move(format);
+
+                break;
+            }
+            case binary_record_type::event:
+            {
+                uint32_t format_id;
+                uint8_t args_count;
+
+                if(!reader.get(entry.time_ns)
+                || !reader.get(entry.action)
+                || !reader.get(format_id)
+                || !reader.get(args_count))
+                {
+                    break;
+                }
+
+                args.resize(args_count);
+
+                bool valid = true;
+                for(auto& arg : args)
+                {
+                    valid = valid && read_arg(reader, arg);
+                }
+
+                if(!valid)
+                {
+                    break;
+                }
+
+                auto& process = processes[pid];
+
+                entry.pid = pid;
+                entry.ppid = process.ppid;
+                entry.session_id = process.session_id;
+                entry.message.clear();
+
+                std::string_view format = format_id < process.formats.size()
+                        ? process.formats[format_id]
+                        : std::string_view{};
+
+                size_t next_arg = 0;
+
+                for(size_t i = 0; i < format.size(); ++i)
+                {
+                    if(format[i] == '%' && i + 1 < format.size()
+                    && format[i + 1] == 's' && next_arg < args.size())
+                    {
+                        entry.message += args[next_arg++];
+                        ++i;
+                    }
+                    else
+                    {
+                        entry.message += format[i];
+                    }
+                }
+
+                on_entry(entry);
+
+                break;
+            }
+            default:
+                // records of newer versions are skipped
+                break;
+        }
+    }
+}
+
+std::string format_binary_log_entry(const binary_log_entry& entry)
+{
+    auto seconds = static_cast<std::time_t>(entry.time_ns / 1000000000);
+    auto micros = (entry.time_ns % 1000000000) / 1000;
+
+    std::tm tm{};
+#ifdef _WIN32
+    gmtime_s(&tm, &seconds);
+#else
+    gmtime_r(&seconds, &tm);
+#endif
+
+    std::ostringstream ss;
+
+    ss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S")
+       << "." << std::setfill('0') << std::setw(6) << micros
+       << " " << entry.pid
+       << " " << entry.ppid
+       << " " << (entry.session_id.empty() ? "-" : entry.session_id)
+       << " " << ToString(static_cast<actions>(entry.action))
+       << " " << entry.message;
+
+    return ss.str();
+}
+
+} // namespace cis1
@@ -0,0 +1,677 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "build_index.h"
+
+#include <algorithm>
+#include <charconv>
+#include <iomanip>
+#include <sstream>
+
+#include "utils.h"
+#include "error_code.h"
+
+namespace cis1
+{
+
+namespace
+{
+
+constexpr auto index_file = "builds.index";
+constexpr auto index_lock_file = "builds.index.lock";
+
+template <class T>
+std::optional<T> number_from_string(std::string_view str)
+{
+    T result{};
+
+    auto [ptr, err] = std::from_chars(
+            str.data(),
+            str.data() + str.size(),
+            result);
+    if(err != std::errc{} || ptr != str.data() + str.size())
+    {
+        return std::nullopt;
+    }
+
+    return result;
+}
+
+std::string_view next_field(std::string_view& line)
+{
+    auto pos = line.find(' ');
+    auto field = line.substr(0, pos);
+
+    line.remove_prefix(pos == line.npos ? line.size() : pos + 1);
+
+    return field;
+}
+
+bool parse_record(
+        std::string_view line,
+        build_record& record)
+{
+    auto number = number_from_string<uint32_t>(next_field(line));
+    auto state = build_state_from_string(next_field(line));
+    auto exit_code = next_field(line);
+    auto started = number_from_string<int64_t>(next_field(line));
+    auto finished = number_from_string<int64_t>(next_field(line));
+    auto session_id = next_field(line);
+
+    if(!number || !state || !started || !finished || session_id.empty())
+    {
+        return false;
+    }
+
+    record.number = number.value();
+    record.state = state.value();
+    record.exit_code.reset();
+    if(exit_code != "-")
+    {
+        record.exit_code = number_from_string<int>(exit_code);
+        if(!record.exit_code)
+        {
+            return false;
+        }
+    }
+    record.started = started.value();
+    record.finished = finished.value();
+    record.session_id = session_id == "-" ? "" : session_id;
+
+    return true;
+}
+
+void merge_record(
+        build_record& to,
+        build_record& from)
+{
+    to.state = from.state;
+    if(from.exit_code)
+    {
+        to.exit_code = from.exit_code;
+    }
+    if(from.started != 0)
+    {
+        to.started = from.started;
+    }
+    if(from.finished != 0)
+    {
+        to.finished = from.finished;
+    }
+    if(!from.session_id.empty())
+    {
+        to.session_id = std::move(from.session_id);
+    }
+}
+
+std::optional<std::string> read_first_line(
+        const std::filesystem::path& path,
+        const os_interface& os)
+{
+    auto file = os.open_ifstream(path);
+    if(!file || !file->is_open())
+    {
+        return std::nullopt;
+    }
+
+    std::string line;
+
+    std::getline(file->istream(), line);
+
+    return line;
+}
+
+/**
+ * Appenders hold shared lock, rewriters hold exclusive one,
+ * so appended records aren't lost by rename of rewritten index.
+ */
+std::unique_ptr<file_lock_interface> lock_index(
+        const std::filesystem::path& job_dir,
+        bool exclusive,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    auto lock = os.open_lock_file(job_dir / index_lock_file, ec);
+    if(!lock || !(exclusive ? lock->lock() : lock->lock_shared()))
+    {
+        ec = error_code::cant_write_build_index;
+
+        return nullptr;
+    }
+
+    return lock;
+}
+
+/**
+ * Index lock must be held exclusively.
+ */
+void rewrite_index(
+        const std::filesystem::path& job_dir,
+        const std::vector<build_record>& records,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    auto index_path = job_dir / index_file;
+
+    // crash or full disk leaves old index, never truncated one
+    auto tmp_path = tmp_file_path(index_path);
+
+    {
+        auto index = os.open_ofstream(tmp_path, std::ios::trunc);
+        if(!index || !index->is_open())
+        {
+            ec = error_code::cant_write_build_index;
+
+            return;
+        }
+
+        auto& out = index->ostream();
+        for(auto& record : records)
+        {
+            write_build_record(out, record);
+        }
+
+        if(!out.flush())
+        {
+            ec = error_code::cant_write_build_index;
+        }
+    }
+
+    if(!ec)
+    {
+        os.rename(tmp_path, index_path, ec);
+    }
+
+    if(ec)
+    {
+        std::error_code remove_ec;
+        os.remove(tmp_path, remove_ec);
+
+        ec = error_code::cant_write_build_index;
+    }
+}
+
+void query_dir(
+        const std::filesystem::path& dir,
+        const std::string& prefix,
+        const build_filter& filter,
+        std::vector<build_record>& result,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    std::vector<std::string> subdirs;
+
+    os.iterate_directory(
+            dir,
+            [&](const dir_entry& entry)
+            {
+                if(entry.type == dir_entry_type::directory)
+                {
+                    subdirs.emplace_back(entry.name);
+                }
+
+                return true;
+            },
+            ec);
+    if(ec)
+    {
+        ec = error_code::cant_read_job_dir;
+
+        return;
+    }
+
+    for(auto& subdir : subdirs)
+    {
+        auto path = dir / subdir;
+        auto name = prefix.empty() ? subdir : prefix + "/" + subdir;
+
+        if(!os.exists(path / "job.conf", ec))
+        {
+            if(ec)
+            {
+                ec = error_code::cant_read_job_dir;
+
+                return;
+            }
+
+            // project dir, jobs are nested
+            query_dir(path, name, filter, result, ec, os);
+            if(ec)
+            {
+                return;
+            }
+
+            continue;
+        }
+
+        if(filter.job && !filter.job->matches(name))
+        {
+            continue;
+        }
+
+        // job name is set for matched builds only
+        auto builds = read_build_index(path, {}, ec, os);
+        if(ec)
+        {
+            return;
+        }
+
+        for(auto& build : builds)
+        {
+            if(matches(build, filter))
+            {
+                result.push_back(std::move(build));
+                result.back().job = name;
+            }
+        }
+    }
+}
+
+} // namespace
+
+std::string_view to_string(build_state state)
+{
+    switch(state)
+    {
+        case build_state::pending:
+            return "pending";
+        case build_state::successful:
+            return "successful";
+        case build_state::broken:
+            return "broken";
+        case build_state::removed:
+            return "removed";
+    }
+
+    return "unknown";
+}
+
+std::optional<build_state> build_state_from_string(std::string_view str)
+{
+    for(auto state : {
+                build_state::pending,
+                build_state::successful,
+                build_state::broken,
+                build_state::removed})
+    {
+        if(str == to_string(state))
+        {
+            return state;
+        }
+    }
+
+    return std::nullopt;
+}
+
+void write_build_record(
+        std::ostream& os,
+        const build_record& record)
+{
+    os << std::setfill('0') << std::setw(6) << record.number
+       << " " << to_string(record.state) << " ";
+
+    if(record.exit_code)
+    {
+        os << record.exit_code.value();
+    }
+    else
+    {
+        os << "-";
+    }
+
+    os << " " << record.started
+       << " " << record.finished
+       << " " << (record.session_id.empty() ? "-" : record.session_id)
+       << "\n";
+}
+
+void append_build_record(
+        const std::filesystem::path& job_dir,
+        const build_record& record,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    auto index_path = job_dir / index_file;
+
+    auto lock = lock_index(job_dir, false, ec, os);
+    if(!lock)
+    {
+        return;
+    }
+
+    if(!os.exists(index_path, ec))
+    {
+        if(ec)
+        {
+            ec = error_code::cant_write_build_index;
+
+            return;
+        }
+
+        // conversion isn't atomic, other process may create index meanwhile
+        if(!lock->lock())
+        {
+            ec = error_code::cant_write_build_index;
+
+            return;
+        }
+
+        if(!os.exists(index_path, ec))
+        {
+            if(ec)
+            {
+                ec = error_code::cant_write_build_index;
+
+                return;
+            }
+
+            // builds made before index was introduced
+            auto records = scan_build_dirs(job_dir, record.job, ec, os);
+            if(ec)
+            {
+                return;
+            }
+
+            rewrite_index(job_dir, records, ec, os);
+            if(ec)
+            {
+                return;
+            }
+        }
+    }
+
+    auto index = os.open_ofstream(
+            index_path,
+            std::ios_base::out | std::ios_base::app);
+    if(!index || !index->is_open())
+    {
+        ec = error_code::cant_write_build_index;
+
+        return;
+    }
+
+    auto& out = index->ostream();
+
+    write_build_record(out, record);
+
+    if(!out.flush())
+    {
+        ec = error_code::cant_write_build_index;
+    }
+}
+
+std::vector<build_record> read_build_index(
+        const std::filesystem::path& job_dir,
+        const std::string& job_name,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    auto index = os.open_ifstream(job_dir / index_file);
+    if(!index || !index->is_open())
+    {
+        return scan_build_dirs(job_dir, job_name, ec, os);
+    }
+
+    std::stringstream content;
+    content << index->istream().rdbuf();
+
+    auto data = content.str();
+    std::string_view rest = data;
+
+    std::vector<build_record> records;
+    build_record record;
+
+    while(!rest.empty())
+    {
+        auto line = rest.substr(0, rest.find('\n'));
+        rest.remove_prefix(std::min(rest.size(), line.size() + 1));
+
+        // line may be torn if writer was killed, it is skipped
+        if(parse_record(line, record))
+        {
+            records.push_back(std::move(record));
+        }
+    }
+
+    // records of one build keep their order, later ones override
+    std::stable_sort(
+            records.begin(),
+            records.end(),
+            [](auto& lhs, auto& rhs)
+            {
+                return lhs.number < rhs.number;
+            });
+
+    std::vector<build_record> result;
+    result.reserve(records.size());
+
+    for(auto& build : records)
+    {
+        if(!result.empty() && result.back().number == build.number)
+        {
+            merge_record(result.back(), build);
+        }
+        else
+        {
+            result.push_back(std::move(build));
+            result.back().job = job_name;
+        }
+    }
+
+    result.erase(
+            std::remove_if(
+                    result.begin(),
+                    result.end(),
+                    [](auto& build)
+                    {
+                        return build.state == build_state::removed;
+                    }),
+            result.end());
+
+    return result;
+}
+
+std::vector<build_record> scan_build_dirs(
+        const std::filesystem::path& job_dir,
+        const std::string& job_name,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    std::vector<build_record> result;
+
+    os.iterate_directory(
+            job_dir,
+            [&](const dir_entry& entry)
+            {
+                if(entry.type != dir_entry_type::directory
+                || !is_build(entry.name))
+                {
+                    return true;
+                }
+
+                auto build_path = job_dir / entry.name;
+
+                build_record record;
+                record.job = job_name;
+                record.number = build_number(entry.name);
+
+                auto exit_code = read_first_line(
+                        build_path / "exitcode.txt",
+                        os);
+                if(exit_code)
+                {
+                    record.exit_code = number_from_string<int>(
+                            exit_code.value());
+                }
+
+                if(!record.exit_code)
+                {
+                    record.state = build_state::pending;
+                }
+                else if(record.exit_code.value() == 0)
+                {
+                    record.state = build_state::successful;
+                }
+                else
+                {
+                    record.state = build_state::broken;
+                }
+
+                record.session_id = read_first_line(
+                        build_path / "session_id.txt",
+                        os).value_or("");
+
+                result.push_back(std::move(record));
+
+                return true;
+            },
+            ec);
+    if(ec)
+    {
+        ec = error_code::cant_read_job_dir;
+
+        return {};
+    }
+
+    std::sort(
+            result.begin(),
+            result.end(),
+            [](auto& lhs, auto& rhs)
+            {
+                return lhs.number < rhs.number;
+            });
+
+    return result;
+}
+
+void write_build_index(
+        const std::filesystem::path& job_dir,
+        const std::vector<build_record>& records,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    auto lock = lock_index(job_dir, true, ec, os);
+    if(!lock)
+    {
+        return;
+    }
+
+    rewrite_index(job_dir, records, ec, os);
+}
+
+void remove_build_records(
+        const std::filesystem::path& job_dir,
+        const std::string& job_name,
+        const std::vector<uint32_t>& numbers,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    auto lock = lock_index(job_dir, true, ec, os);
+    if(!lock)
+    {
+        return;
+    }
+
+    auto records = read_build_index(job_dir, job_name, ec, os);
+    if(ec)
+    {
+        return;
+    }
+
+    records.erase(
+            std::remove_if(
+                    records.begin(),
+                    records.end(),
+                    [&](const build_record& record)
+                    {
+                        return std::find(
+                                numbers.begin(),
+                                numbers.end(),
+                                record.number) != numbers.end();
+                    }),
+            records.end());
+
+    rewrite_index(job_dir, records, ec, os);
+}
+
+void invalidate_build_index(
+        const std::filesystem::path& job_dir,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    auto lock = lock_index(job_dir, true, ec, os);
+    if(!lock)
+    {
+        return;
+    }
+
+    os.remove(job_dir / index_file, ec);
+    if(ec)
+    {
+        ec = error_code::cant_write_build_index;
+    }
+}
+
+bool matches(
+        const build_record& record,
+        const build_filter& filter)
+{
+    return (!filter.state || record.state == filter.state)
+        && (!filter.exit_code || record.exit_code == filter.exit_code)
+        && (!filter.session_id || record.session_id == filter.session_id)
+        && (!filter.since || record.started >= filter.since.value())
+        && (!filter.until || record.started < filter.until.value());
+}
+
+std::vector<build_record> query_builds(
+        const std::filesystem::path& base_dir,
+        const build_filter& filter,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    std::vector<build_record> result;
+
+    query_dir(base_dir / "jobs", "", filter, result, ec, os);
+    if(ec)
+    {
+        return {};
+    }
+
+    auto newer = [](const build_record& lhs, const build_record& rhs)
+    {
+        if(lhs.started != rhs.started)
+        {
+            return lhs.started > rhs.started;
+        }
+
+        if(lhs.job != rhs.job)
+        {
+            return lhs.job < rhs.job;
+        }
+
+        return lhs.number > rhs.number;
+    };
+
+    if(filter.limit != 0 && filter.limit < result.size())
+    {
+        std::partial_sort(
+                result.begin(),
+                result.begin() + filter.limit,
+                result.end(),
+                newer);
+        result.resize(filter.limit);
+    }
+    else
+    {
+        std::sort(result.begin(), result.end(), newer);
+    }
+
+    return result;
+}
+
+} // namespace cis1
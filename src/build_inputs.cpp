@@ -0,0 +1,144 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "build_inputs.h"
+
+#include <cctype>
+#include <map>
+
+#include <cis1_proto_utils/read_istream_kv_str.h>
+
+#include "error_code.h"
+
+namespace cis1
+{
+
+std::string encode_env_name(const std::string& name)
+{
+    static const char hex[] = "0123456789ABCDEF";
+
+    std::string encoded;
+    encoded.reserve(name.size());
+
+    for(unsigned char c : name)
+    {
+        if(std::isalnum(c) || c == '_')
+        {
+            encoded += static_cast<char>(c);
+        }
+        else
+        {
+            encoded += '%';
+            encoded += hex[c >> 4];
+            encoded += hex[c & 0xf];
+        }
+    }
+
+    return encoded;
+}
+
+void export_kv_file(
+        environment& env,
+        const std::filesystem::path& kv_file,
+        const std::string& prefix,
+        std::error_code& ec,
+        const os_interface& os,
+        size_t max_size)
+{
+    std::map<std::string, std::string> values;
+
+    bool exists = os.exists(kv_file, ec);
+    if(ec)
+    {
+        return;
+    }
+
+    if(exists)
+    {
+        auto file = os.open_ifstream(kv_file);
+        if(!file || !file->is_open())
+        {
+            ec = cis1::error_code::invalid_kv_file_format;
+
+            return;
+        }
+
+        const auto decode = true;
+        proto_utils::read_istream_kv_str(file->istream(), values, ec, decode);
+        if(ec)
+        {
+            ec = cis1::error_code::invalid_kv_file_format;
+
+            return;
+        }
+
+        env.set(prefix + "s_file", kv_file.string());
+    }
+
+    size_t size = 0;
+    for(auto& [name, value] : values)
+    {
+        // "${prefix}_${name}=${value}\0"
+        size += prefix.size() + encode_env_name(name).size() + value.size() + 3;
+    }
+
+    if(size > max_size)
+    {
+        env.set(prefix + "s", "file");
+
+        return;
+    }
+
+    for(auto& [name, value] : values)
+    {
+        env.set(prefix + "_" + encode_env_name(name), value);
+    }
+
+    env.set(prefix + "s", "env");
+}
+
+void export_build_params(
+        environment& env,
+        const std::filesystem::path& build_dir,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    export_kv_file(env, build_dir / "job.params", "cis_param", ec, os);
+    if(ec)
+    {
+        ec = cis1::error_code::cant_read_job_params_file;
+    }
+}
+
+void export_session_values(
+        environment& env,
+        const std::filesystem::path& base_dir,
+        const std::filesystem::path& build_dir,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    auto session_dat = base_dir / "sessions" / (env.get("session_id") + ".dat");
+    auto snapshot = build_dir / "session_values.dat";
+
+    if(os.exists(session_dat, ec))
+    {
+        os.copy(session_dat, snapshot, ec);
+    }
+
+    if(!ec)
+    {
+        export_kv_file(env, snapshot, "cis_value", ec, os);
+    }
+
+    if(ec)
+    {
+        ec = cis1::error_code::cant_read_session_values_file;
+    }
+}
+
+} // namespace cis1
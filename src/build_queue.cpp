@@ -0,0 +1,304 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "build_queue.h"
+
+#include <charconv>
+
+#include "error_code.h"
+
+namespace cis1
+{
+
+namespace
+{
+
+const std::string waiting_prefix = "waiting.";
+
+std::filesystem::path waiting_path(
+        const std::filesystem::path& dir,
+        uint64_t ticket)
+{
+    return dir / (waiting_prefix + std::to_string(ticket));
+}
+
+} // namespace
+
+build_queue::build_queue(
+        boost::asio::io_context& io_ctx,
+        std::vector<slot_limit> limits,
+        const os_interface& os,
+        std::chrono::milliseconds poll_interval)
+    : timer_(io_ctx)
+    , os_(os)
+    , poll_interval_(poll_interval)
+{
+    for(auto& limit : limits)
+    {
+        if(limit.slots != 0)
+        {
+            entry e;
+            e.limit = std::move(limit);
+
+            entries_.push_back(std::move(e));
+        }
+    }
+}
+
+build_queue::~build_queue()
+{
+    release();
+}
+
+void build_queue::async_acquire(on_acquired_cb_t cb)
+{
+    cb_ = std::move(cb);
+    started_ = std::chrono::steady_clock::now();
+    current_ = 0;
+
+    poll();
+}
+
+void build_queue::release()
+{
+    timer_.cancel();
+
+    for(auto& e : entries_)
+    {
+        if(e.waiting_lock)
+        {
+            std::error_code ec;
+
+            os_.remove(waiting_path(e.limit.dir, e.ticket), ec);
+        }
+
+        e.waiting_lock.reset();
+        e.slot_lock.reset();
+        e.queue_lock.reset();
+    }
+}
+
+std::chrono::microseconds build_queue::wait_time() const
+{
+    return wait_time_;
+}
+
+void build_queue::enqueue(entry& e, std::error_code& ec)
+{
+    os_.create_directory(e.limit.dir, ec);
+    if(ec)
+    {
+        ec = cis1::error_code::cant_acquire_build_slot;
+
+        return;
+    }
+
+    e.queue_lock = os_.open_lock_file(e.limit.dir / "queue.lock", ec);
+    if(ec || !e.queue_lock || !e.queue_lock->lock())
+    {
+        ec = cis1::error_code::cant_acquire_build_slot;
+
+        return;
+    }
+
+    // next ticket is stored in the lock file itself
+    uint64_t ticket = 0;
+
+    if(auto is = os_.open_ifstream(e.limit.dir / "queue.lock");
+            is && is->is_open())
+    {
+        std::string line;
+        std::getline(is->istream(), line);
+
+        std::from_chars(line.data(), line.data() + line.size(), ticket);
+    }
+
+    e.ticket = ticket;
+
+    auto os = os_.open_ofstream(
+            e.limit.dir / "queue.lock",
+            std::ios::out | std::ios::trunc);
+    if(!os || !os->is_open()
+    || !(os->ostream() << (ticket + 1) << std::flush))
+    {
+        ec = cis1::error_code::cant_acquire_build_slot;
+    }
+
+    if(!ec)
+    {
+        e.waiting_lock = os_.open_lock_file(
+                waiting_path(e.limit.dir, ticket),
+                ec);
+        if(ec || !e.waiting_lock || !e.waiting_lock->try_lock())
+        {
+            e.waiting_lock.reset();
+
+            ec = cis1::error_code::cant_acquire_build_slot;
+        }
+    }
+
+    e.queue_lock->unlock();
+}
+
+bool build_queue::try_take_slot(entry& e, std::error_code& ec)
+{
+    if(!e.queue_lock->lock())
+    {
+        ec = cis1::error_code::cant_acquire_build_slot;
+
+        return false;
+    }
+
+    std::vector<uint64_t> earlier;
+
+    os_.iterate_directory(
+            e.limit.dir,
+            [&](const dir_entry& entry)
+            {
+                auto& name = entry.name;
+
+                if(name.compare(0, waiting_prefix.size(), waiting_prefix) != 0)
+                {
+                    return true;
+                }
+
+                uint64_t ticket;
+                auto [end, err] = std::from_chars(
+                        name.data() + waiting_prefix.size(),
+                        name.data() + name.size(),
+                        ticket);
+                if(err == std::errc{} && end == name.data() + name.size()
+                && ticket < e.ticket)
+                {
+                    earlier.push_back(ticket);
+                }
+
+                return true;
+            },
+            ec);
+    if(ec)
+    {
+        e.queue_lock->unlock();
+
+        ec = cis1::error_code::cant_acquire_build_slot;
+
+        return false;
+    }
+
+    bool first = true;
+
+    for(auto ticket : earlier)
+    {
+        std::error_code lock_ec;
+
+        auto path = waiting_path(e.limit.dir, ticket);
+        auto waiting = os_.open_lock_file(path, lock_ec);
+        if(lock_ec || !waiting)
+        {
+            continue;
+        }
+
+        // lock is free only if waiter died without leaving queue
+        if(waiting->try_lock())
+        {
+            os_.remove(path, lock_ec);
+        }
+        else
+        {
+            first = false;
+
+            break;
+        }
+    }
+
+    for(uint32_t i = 0; first && i < e.limit.slots; ++i)
+    {
+        std::error_code lock_ec;
+
+        auto slot = os_.open_lock_file(
+                e.limit.dir / ("slot." + std::to_string(i)),
+                lock_ec);
+        if(lock_ec || !slot)
+        {
+            continue;
+        }
+
+        if(slot->try_lock())
+        {
+            e.slot_lock = std::move(slot);
+
+            break;
+        }
+    }
+
+    if(e.slot_lock)
+    {
+        std::error_code remove_ec;
+
+        os_.remove(waiting_path(e.limit.dir, e.ticket), remove_ec);
+        e.waiting_lock.reset();
+    }
+
+    e.queue_lock->unlock();
+
+    return e.slot_lock != nullptr;
+}
+
+void build_queue::poll()
+{
+    std::error_code ec;
+
+    while(current_ < entries_.size())
+    {
+        auto& e = entries_[current_];
+
+        if(!e.queue_lock)
+        {
+            enqueue(e, ec);
+        }
+
+        if(!ec && !try_take_slot(e, ec) && !ec)
+        {
+            timer_.expires_after(poll_interval_);
+            timer_.async_wait(
+                    [this](const boost::system::error_code& err)
+                    {
+                        if(!err)
+                        {
+                            poll();
+                        }
+                    });
+
+            return;
+        }
+
+        if(ec)
+        {
+            release();
+
+            break;
+        }
+
+        ++current_;
+    }
+
+    finish(ec);
+}
+
+void build_queue::finish(std::error_code ec)
+{
+    wait_time_ = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started_);
+
+    // callback may release or destroy queue
+    auto cb = std::move(cb_);
+
+    cb(ec);
+}
+
+} // namespace cis1
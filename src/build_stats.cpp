@@ -0,0 +1,113 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "build_stats.h"
+
+#include <sstream>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace cis1
+{
+
+#if defined(__linux__) || defined(__APPLE__)
+std::chrono::microseconds to_microseconds(const timeval& tv)
+{
+    return std::chrono::seconds{tv.tv_sec}
+         + std::chrono::microseconds{tv.tv_usec};
+}
+
+build_stats children_usage()
+{
+    rusage usage{};
+
+    if(getrusage(RUSAGE_CHILDREN, &usage) != 0)
+    {
+        return {};
+    }
+
+    build_stats stats;
+
+    stats.user_cpu = to_microseconds(usage.ru_utime);
+    stats.system_cpu = to_microseconds(usage.ru_stime);
+#ifdef __APPLE__
+    // ru_maxrss is in bytes on macOS
+    stats.max_rss_kb = usage.ru_maxrss / 1024;
+#else
+    stats.max_rss_kb = usage.ru_maxrss;
+#endif
+    // block counters are in 512-byte units
+    stats.read_bytes = static_cast<uint64_t>(usage.ru_inblock) * 512;
+    stats.write_bytes = static_cast<uint64_t>(usage.ru_oublock) * 512;
+
+    return stats;
+}
+#else
+build_stats children_usage()
+{
+    return {};
+}
+#endif
+
+build_stats usage_delta(
+        const build_stats& before,
+        const build_stats& after)
+{
+    build_stats stats;
+
+    stats.wall_time = after.wall_time - before.wall_time;
+    stats.user_cpu = after.user_cpu - before.user_cpu;
+    stats.system_cpu = after.system_cpu - before.system_cpu;
+    // maximum resident set size is not additive
+    stats.max_rss_kb = after.max_rss_kb;
+    stats.read_bytes = after.read_bytes - before.read_bytes;
+    stats.write_bytes = after.write_bytes - before.write_bytes;
+    stats.accounting = after.accounting;
+    stats.timed_out = after.timed_out;
+
+    return stats;
+}
+
+void write_build_stats(
+        std::ostream& os,
+        const build_stats& stats)
+{
+    os << "wall_time_us=" << stats.wall_time.count() << "\n"
+       << "user_cpu_us=" << stats.user_cpu.count() << "\n"
+       << "system_cpu_us=" << stats.system_cpu.count() << "\n"
+       << "max_rss_kb=" << stats.max_rss_kb << "\n"
+       << "read_bytes=" << stats.read_bytes << "\n"
+       << "write_bytes=" << stats.write_bytes << "\n"
+       << "accounting=" << stats.accounting << "\n"
+       << "timed_out=" << stats.timed_out << "\n"
+       << "queue_wait_us=" << stats.queue_wait.count() << "\n";
+}
+
+std::string format_build_stats(const build_stats& stats)
+{
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+
+    std::stringstream ss;
+
+    ss << "wall_time_ms=" << duration_cast<milliseconds>(stats.wall_time).count()
+       << " user_cpu_ms=" << duration_cast<milliseconds>(stats.user_cpu).count()
+       << " system_cpu_ms=" << duration_cast<milliseconds>(stats.system_cpu).count()
+       << " max_rss_kb=" << stats.max_rss_kb
+       << " read_bytes=" << stats.read_bytes
+       << " write_bytes=" << stats.write_bytes
+       << " accounting=" << stats.accounting
+       << " timed_out=" << stats.timed_out
+       << " queue_wait_ms=" << duration_cast<milliseconds>(stats.queue_wait).count();
+
+    return ss.str();
+}
+
+} // namespace cis1
@@ -0,0 +1,187 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <ctime>
+
+#include <boost/program_options.hpp>
+
+#include "context.h"
+#include "os.h"
+#include "build_index.h"
+#include "cis_version.h"
+
+namespace po = boost::program_options;
+
+std::optional<int64_t> parse_time(const std::string& str)
+{
+    std::tm tm{};
+    std::stringstream ss(str);
+
+    ss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
+    if(!ss.fail() && ss.peek() == EOF)
+    {
+        tm.tm_isdst = -1;
+
+        return static_cast<int64_t>(std::mktime(&tm));
+    }
+
+    try
+    {
+        size_t pos = 0;
+        auto result = std::stoll(str, &pos);
+
+        if(pos == str.size())
+        {
+            return result;
+        }
+    }
+    catch(...)
+    {}
+
+    return std::nullopt;
+}
+
+int main(int argc, char* argv[])
+{
+    po::options_description desc("Buildquery options");
+    desc.add_options()
+        ("help", "produce help message")
+        ("version", "print version")
+        ("job", po::value<std::string>(), "job name mask (regex)")
+        ("state", po::value<std::string>(), "pending, successful or broken")
+        ("exit_code", po::value<int>(), "build exit code")
+        ("session", po::value<std::string>(), "session id")
+        ("since", po::value<std::string>(), "started at or after (unix time or YYYY-MM-DDTHH:MM:SS)")
+        ("until", po::value<std::string>(), "started before (unix time or YYYY-MM-DDTHH:MM:SS)")
+        ("limit", po::value<size_t>(), "max count of builds, newest first");
+
+    auto print_usage = [&]()
+    {
+        std::cout << "Usage: " << "\n"
+                  << desc << std::endl;
+    };
+
+    po::variables_map vm;
+
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+    }
+    catch(...)
+    {
+        std::cout << "Invalid args" << "\n";
+
+        print_usage();
+
+        return EXIT_FAILURE;
+    }
+
+    po::notify(vm);
+
+    if(vm.count("help"))
+    {
+        print_usage();
+
+        return EXIT_SUCCESS;
+    }
+    else if(vm.count("version"))
+    {
+        print_version();
+
+        return EXIT_SUCCESS;
+    }
+
+    cis1::build_filter filter;
+
+    if(vm.count("job"))
+    {
+        filter.job = cis1::job_mask::compile(vm["job"].as<std::string>());
+        if(!filter.job)
+        {
+            std::cout << "Invalid job mask" << std::endl;
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(vm.count("state"))
+    {
+        filter.state = cis1::build_state_from_string(
+                vm["state"].as<std::string>());
+        if(!filter.state || filter.state == cis1::build_state::removed)
+        {
+            std::cout << "Invalid build state" << std::endl;
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(vm.count("exit_code"))
+    {
+        filter.exit_code = vm["exit_code"].as<int>();
+    }
+
+    if(vm.count("session"))
+    {
+        filter.session_id = vm["session"].as<std::string>();
+    }
+
+    for(auto [name, value] : {
+                std::pair{"since", &filter.since},
+                std::pair{"until", &filter.until}})
+    {
+        if(vm.count(name))
+        {
+            *value = parse_time(vm[name].as<std::string>());
+            if(!*value)
+            {
+                std::cout << "Invalid time: " << name << std::endl;
+
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    if(vm.count("limit"))
+    {
+        filter.limit = vm["limit"].as<size_t>();
+    }
+
+    cis1::os std_os;
+
+    std::error_code ec;
+
+    auto ctx_opt = cis1::init_context(ec, std_os);
+    if(ec)
+    {
+        std::cerr << ec.message() << std::endl;
+
+        return 1;
+    }
+    auto& ctx = ctx_opt.value();
+
+    auto builds = cis1::query_builds(ctx.base_dir(), filter, ec, std_os);
+    if(ec)
+    {
+        std::cout << ec.message() << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    for(auto& build : builds)
+    {
+        std::cout << build.job << " ";
+
+        cis1::write_build_record(std::cout, build);
+    }
+
+    return EXIT_SUCCESS;
+}
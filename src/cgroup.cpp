@@ -0,0 +1,241 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "cgroup.h"
+
+#include <map>
+#include <memory>
+#include <sstream>
+
+#include <boost/asio/steady_timer.hpp>
+
+#include "error_code.h"
+
+namespace cis1
+{
+
+namespace
+{
+
+constexpr int remove_attempts = 10;
+
+void try_remove_cgroup(
+        std::shared_ptr<boost::asio::steady_timer> timer,
+        const std::filesystem::path& cgroup,
+        const os_interface& os,
+        int attempt,
+        std::function<void(std::error_code)> on_removed)
+{
+    std::error_code ec;
+
+    os.remove(cgroup, ec);
+    if(!ec || attempt + 1 == remove_attempts)
+    {
+        if(ec)
+        {
+            ec = cis1::error_code::cant_remove_cgroup;
+        }
+
+        if(on_removed)
+        {
+            on_removed(ec);
+        }
+
+        return;
+    }
+
+    timer->expires_after(std::chrono::milliseconds{10});
+    timer->async_wait(
+            [timer, cgroup, &os, attempt, on_removed = std::move(on_removed)](
+                    const boost::system::error_code&) mutable
+            {
+                try_remove_cgroup(
+                        timer,
+                        cgroup,
+                        os,
+                        attempt + 1,
+                        std::move(on_removed));
+            });
+}
+
+} // namespace
+
+bool write_cgroup_file(
+        const std::filesystem::path& file,
+        const std::string& value,
+        const os_interface& os)
+{
+    auto cgroup_file = os.open_ofstream(file);
+    if(!cgroup_file || !cgroup_file->is_open())
+    {
+        return false;
+    }
+
+    // cgroupfs reports errors on write, so flush before checking
+    cgroup_file->ostream() << value << std::flush;
+
+    return cgroup_file->ostream().good();
+}
+
+std::optional<std::filesystem::path> create_cgroup(
+        const std::filesystem::path& root,
+        const std::string& name,
+        const cgroup_limits& limits,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    // Enable controllers one by one, so a missing one
+    // doesn't prevent the others from being used.
+    for(auto controller : {"+cpu", "+memory", "+io"})
+    {
+        write_cgroup_file(root / "cgroup.subtree_control", controller, os);
+    }
+
+    auto path = root / name;
+
+    os.create_directory(path, ec);
+    if(ec)
+    {
+        ec = cis1::error_code::cant_create_cgroup;
+
+        return std::nullopt;
+    }
+
+    const std::pair<const char*, const std::string&> files[] =
+    {
+        {"cpu.max", limits.cpu_max},
+        {"memory.max", limits.memory_max},
+        {"io.max", limits.io_max}
+    };
+
+    for(auto& [file, value] : files)
+    {
+        if(!value.empty() && !write_cgroup_file(path / file, value, os))
+        {
+            std::error_code remove_ec;
+            os.remove(path, remove_ec);
+
+            ec = cis1::error_code::cant_apply_cgroup_limits;
+
+            return std::nullopt;
+        }
+    }
+
+    return path;
+}
+
+void read_cgroup_stats(
+        const std::filesystem::path& cgroup,
+        build_stats& stats,
+        const os_interface& os)
+{
+    auto cpu_stat_file = os.open_ifstream(cgroup / "cpu.stat");
+    if(!cpu_stat_file || !cpu_stat_file->is_open())
+    {
+        return;
+    }
+
+    std::map<std::string, uint64_t> cpu_stat;
+
+    std::string key;
+    uint64_t value;
+    while(cpu_stat_file->istream() >> key >> value)
+    {
+        cpu_stat[key] = value;
+    }
+
+    // Nothing was accounted: the child failed to join cgroup
+    // (e.g. cgroup.procs of the source cgroup is not writable).
+    if(cpu_stat["usage_usec"] == 0)
+    {
+        return;
+    }
+
+    stats.accounting = "cgroup";
+    stats.user_cpu = std::chrono::microseconds{cpu_stat["user_usec"]};
+    stats.system_cpu = std::chrono::microseconds{cpu_stat["system_usec"]};
+
+    // memory.peak is available since linux 5.19
+    if(auto peak_file = os.open_ifstream(cgroup / "memory.peak");
+            peak_file && peak_file->is_open())
+    {
+        uint64_t peak = 0;
+        if(peak_file->istream() >> peak)
+        {
+            stats.max_rss_kb = peak / 1024;
+        }
+    }
+
+    auto io_stat_file = os.open_ifstream(cgroup / "io.stat");
+    if(!io_stat_file || !io_stat_file->is_open())
+    {
+        return;
+    }
+
+    // Line format is "major:minor rbytes=N wbytes=N rios=N ..."
+    uint64_t read_bytes = 0;
+    uint64_t write_bytes = 0;
+
+    std::string line;
+    while(std::getline(io_stat_file->istream(), line))
+    {
+        std::stringstream ss(line);
+        std::string field;
+
+        while(ss >> field)
+        {
+            auto pos = field.find('=');
+            if(pos == std::string::npos)
+            {
+                continue;
+            }
+
+            auto name = field.substr(0, pos);
+            auto count = std::strtoull(field.c_str() + pos + 1, nullptr, 10);
+
+            if(name == "rbytes")
+            {
+                read_bytes += count;
+            }
+            else if(name == "wbytes")
+            {
+                write_bytes += count;
+            }
+        }
+    }
+
+    stats.read_bytes = read_bytes;
+    stats.write_bytes = write_bytes;
+}
+
+bool has_limits(const cgroup_limits& limits)
+{
+    return !limits.cpu_max.empty()
+        || !limits.memory_max.empty()
+        || !limits.io_max.empty();
+}
+
+void async_remove_cgroup(
+        boost::asio::io_context& io_ctx,
+        const std::filesystem::path& cgroup,
+        const os_interface& os,
+        std::function<void(std::error_code)> on_removed)
+{
+    // cgroup.kill is available since linux 5.14,
+    // it kills processes left by the build (e.g. daemonized ones)
+    write_cgroup_file(cgroup / "cgroup.kill", "1", os);
+
+    try_remove_cgroup(
+            std::make_shared<boost::asio::steady_timer>(io_ctx),
+            cgroup,
+            os,
+            0,
+            std::move(on_removed));
+}
+
+} // namespace cis1
@@ -0,0 +1,462 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "cis1_core_c.h"
+
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <optional>
+
+#ifdef __linux__
+#include <csignal>
+#endif
+
+#include "context.h"
+#include "session.h"
+#include "get_value.h"
+#include "set_value.h"
+#include "get_param.h"
+#include "set_param.h"
+#include "parallel_builds.h"
+#include "session_graph.h"
+#include "logger.h"
+#include "os.h"
+#include "webui_session.h"
+
+struct cis1_core
+{
+    cis1::os std_os;
+    std::optional<cis1::context> ctx;
+    std::optional<cis1::session> session;
+    std::shared_ptr<webui_session> webui;
+    std::string error;
+};
+
+namespace
+{
+
+#ifdef __linux__
+constexpr int forwarded_signals[] = {SIGTERM, SIGINT, SIGHUP};
+
+std::mutex host_signals_mutex;
+size_t host_signals_users = 0;
+struct sigaction host_signals[std::size(forwarded_signals)];
+#endif
+
+/**
+ * Restores signal handlers of the host process (e.g. python) after build,
+ * job_runner forwards SIGTERM, SIGINT and SIGHUP to the build and resets
+ * them to SIG_DFL when the last runner of the process is destroyed.
+ */
+class host_signals_guard
+{
+public:
+    host_signals_guard()
+    {
+#ifdef __linux__
+        std::lock_guard<std::mutex> lock(host_signals_mutex);
+
+        if(host_signals_users++ == 0)
+        {
+            for(size_t i = 0; i < std::size(forwarded_signals); ++i)
+            {
+                ::sigaction(forwarded_signals[i], nullptr, &host_signals[i]);
+            }
+        }
+#endif
+    }
+
+    host_signals_guard(const host_signals_guard&) = delete;
+    host_signals_guard& operator=(const host_signals_guard&) = delete;
+
+    ~host_signals_guard()
+    {
+#ifdef __linux__
+        std::lock_guard<std::mutex> lock(host_signals_mutex);
+
+        if(--host_signals_users == 0)
+        {
+            for(size_t i = 0; i < std::size(forwarded_signals); ++i)
+            {
+                ::sigaction(forwarded_signals[i], &host_signals[i], nullptr);
+            }
+        }
+#endif
+    }
+};
+
+/// Checks handle like executables check their session
+bool ready(cis1_core* core, const char* action)
+{
+    if(!core->ctx)
+    {
+        return false;
+    }
+
+    if(core->session->opened_by_me())
+    {
+        core->error = std::string("Cant ") + action + " outside the session";
+        TEE_LOG(actions::error, "%s", core->error);
+
+        return false;
+    }
+
+    core->error.clear();
+
+    return true;
+}
+
+int fail(cis1_core* core, const std::error_code& ec)
+{
+    core->error = ec.message();
+    TEE_LOG(actions::error, "%s", core->error);
+
+    return CIS1_ERROR;
+}
+
+int copy_result(
+        const std::string& result,
+        char* value,
+        size_t value_size,
+        size_t* required_size)
+{
+    if(required_size)
+    {
+        *required_size = result.size() + 1;
+    }
+
+    if(value_size <= result.size())
+    {
+        return CIS1_BUFFER_TOO_SMALL;
+    }
+
+    std::memcpy(value, result.c_str(), result.size() + 1);
+
+    return CIS1_OK;
+}
+
+} // namespace
+
+int cis1_abi_version(void)
+{
+    return CIS1_CORE_C_ABI_VERSION;
+}
+
+cis1_core* cis1_open(void)
+{
+    auto* core = new cis1_core;
+
+    std::error_code ec;
+
+    auto ctx_opt = cis1::init_context(ec, core->std_os);
+    if(ec)
+    {
+        core->error = ec.message();
+
+        return core;
+    }
+
+    core->ctx.emplace(std::move(ctx_opt.value()));
+
+    auto& ctx = core->ctx.value();
+
+    core->session.emplace(cis1::invoke_session(ctx, false, core->std_os));
+
+    const CoreLogger::Options options
+            = make_logger_options(core->session->session_id(), ctx, core->std_os);
+
+    core->webui = init_webui_session(ctx);
+
+    if(core->webui)
+    {
+        init_webui_log(options, core->webui);
+    }
+
+    init_cis_log(options, ctx);
+
+    if(core->webui)
+    {
+        core->webui->auth(core->session.value());
+    }
+
+    init_session_log(options, ctx, core->session.value());
+
+    return core;
+}
+
+void cis1_close(cis1_core* core)
+{
+    close_logs();
+
+    delete core;
+}
+
+const char* cis1_last_error(const cis1_core* core)
+{
+    return core->error.c_str();
+}
+
+int cis1_get_value(
+        cis1_core* core,
+        const char* name,
+        char* value,
+        size_t value_size,
+        size_t* required_size)
+{
+    if(!ready(core, "get value"))
+    {
+        return CIS1_ERROR;
+    }
+
+    std::error_code ec;
+
+    auto value_opt = cis1::get_value(
+            core->ctx.value(),
+            core->session.value(),
+            name,
+            ec,
+            core->std_os);
+    if(ec)
+    {
+        return fail(core, ec);
+    }
+
+    SES_LOG(actions::getvalue, R"("%s"="%s")", name, value_opt.value());
+
+    return copy_result(value_opt.value(), value, value_size, required_size);
+}
+
+int cis1_set_value(
+        cis1_core* core,
+        const char* name,
+        const char* value)
+{
+    if(!ready(core, "set value"))
+    {
+        return CIS1_ERROR;
+    }
+
+    std::error_code ec;
+
+    cis1::set_value(
+            core->ctx.value(),
+            core->session.value(),
+            name,
+            value,
+            ec,
+            core->std_os);
+    if(ec)
+    {
+        return fail(core, ec);
+    }
+
+    SES_LOG(actions::setvalue, R"("%s"="%s")", name, value);
+
+    return CIS1_OK;
+}
+
+int cis1_get_param(
+        cis1_core* core,
+        const char* name,
+        char* value,
+        size_t value_size,
+        size_t* required_size)
+{
+    if(!ready(core, "get param"))
+    {
+        return CIS1_ERROR;
+    }
+
+    std::error_code ec;
+
+    auto param_opt = cis1::get_param(
+            core->ctx.value(),
+            core->session.value(),
+            name,
+            ec,
+            core->std_os);
+    if(ec)
+    {
+        return fail(core, ec);
+    }
+
+    SES_LOG(actions::getparam, R"("%s"="%s")", name, param_opt.value());
+
+    return copy_result(param_opt.value(), value, value_size, required_size);
+}
+
+int cis1_set_param(
+        cis1_core* core,
+        const char* name,
+        const char* value)
+{
+    if(!ready(core, "set param"))
+    {
+        return CIS1_ERROR;
+    }
+
+    std::error_code ec;
+
+    cis1::set_param(
+            core->ctx.value(),
+            core->session.value(),
+            name,
+            value,
+            ec,
+            core->std_os);
+    if(ec)
+    {
+        return fail(core, ec);
+    }
+
+    SES_LOG(actions::setparam, R"("%s"="%s")", name, value);
+
+    return CIS1_OK;
+}
+
+int cis1_start_job(
+        cis1_core* core,
+        const char* job_name,
+        int* exit_code)
+{
+    if(!ready(core, "start job"))
+    {
+        return CIS1_ERROR;
+    }
+
+    auto& ctx = core->ctx.value();
+    auto& session = core->session.value();
+    auto& std_os = core->std_os;
+
+    std::error_code ec;
+
+    auto job_opt = cis1::load_job(job_name, ec, ctx, std_os);
+    if(ec)
+    {
+        return fail(core, ec);
+    }
+    auto& job = job_opt.value();
+
+    auto params = job.params();
+    if(!params.empty())
+    {
+        cis1::prepare_params(params, std_os, ctx, session, ec);
+    }
+
+    auto build_handle = job.prepare_build(ctx, session, params, ec);
+    if(ec)
+    {
+        return fail(core, ec);
+    }
+
+    const auto parent_job = std_os.get_env_var("job_name");
+    const auto parent_build = std_os.get_env_var("build_number");
+
+    // the handle is reused, so build variables aren't set in its context
+    auto env = ctx.env();
+
+    if(!parent_job.empty())
+    {
+        env.set("parent_job_name", parent_job);
+    }
+
+    if(!parent_build.empty())
+    {
+        env.set("parent_job_build_number", parent_build);
+    }
+
+    env.set("job_name", job_name);
+    env.set("build_number", build_handle.number_string());
+
+    std::vector<cis1::parallel_build> builds;
+    builds.push_back({job, build_handle.number(), std::move(env)});
+
+    SES_LOG(actions::start_job, R"(job_name="%s")", job_name);
+
+    {
+        host_signals_guard signals;
+
+        cis1::run_parallel(
+                builds,
+                1,
+                ctx,
+                false,
+                [](cis1::parallel_build&){},
+                [](cis1::parallel_build&){},
+                [](cis1::parallel_build&, bool error, const std::string& str)
+                {
+                    WEBUI_LOG(error ? actions::startjob_stderr : actions::startjob_stdout, R"(%s)", str);
+                });
+    }
+
+    auto& build = builds.front();
+
+    cis1::graph_node graph_node;
+    graph_node.job = job_name;
+    graph_node.build = build_handle.number_string();
+    graph_node.parent_job = parent_job;
+    graph_node.parent_build = parent_build;
+    graph_node.started_ms = build.started_ms;
+    graph_node.finished_ms = build.finished_ms;
+    graph_node.exit_code = build.exit_code;
+
+    std::error_code graph_ec;
+
+    cis1::append_graph_node(
+            cis1::session_graph_path(ctx.base_dir(), session.session_id()),
+            graph_node,
+            graph_ec,
+            std_os);
+    if(graph_ec)
+    {
+        CIS_LOG(actions::error, "%s", graph_ec.message());
+    }
+
+    std_os.spawn_process(
+            ctx.base_dir(),
+            std::filesystem::path{"core"} / ctx.get_env_var("maintenance"),
+            {"--job", job_name, "--session", session.session_id()},
+            ctx.env());
+
+    if(build.ec)
+    {
+        return fail(core, build.ec);
+    }
+
+    if(build.stats)
+    {
+        CIS_LOG(actions::job_stats,
+                R"(job_name="%s" build_number="%s" %s)",
+                job_name,
+                build_handle.number_string(),
+                cis1::format_build_stats(build.stats.value()));
+    }
+
+    SES_LOG(actions::finish_job, R"(job_name="%s")", job_name);
+
+    cis1::set_value(ctx, session, "last_job_name", job_name, ec, std_os);
+    if(!ec)
+    {
+        cis1::set_value(
+                ctx,
+                session,
+                "last_job_build_number",
+                build_handle.number_string(),
+                ec,
+                std_os);
+    }
+    if(ec)
+    {
+        return fail(core, ec);
+    }
+
+    *exit_code = build.exit_code;
+
+    return CIS1_OK;
+}
@@ -13,6 +13,7 @@
 #include "logger.h"
 #include "os.h"
 #include "cron.h"
+#include "job_mask.h"
 #include "cis_version.h"
 
 void usage()
@@ -39,7 +40,8 @@ int add(cis1::context_interface& ctx,
 {
     std::error_code ec;
 
-    auto cronexpr_opt = make_cron(cron, ec);
+    // hashed values are checked resolved for this job
+    auto cronexpr_opt = make_cron(cis1::resolve_hashed_cron(cron, job), ec);
 
     if(!cronexpr_opt)
     {
@@ -85,7 +87,8 @@ int del(cis1::context_interface& ctx,
 {
     std::error_code ec;
 
-    auto cronexpr_opt = make_cron(cron, ec);
+    // hashed values are checked resolved for this job
+    auto cronexpr_opt = make_cron(cis1::resolve_hashed_cron(cron, job), ec);
 
     if(!cronexpr_opt)
     {
@@ -131,7 +134,7 @@ int del(cis1::context_interface& ctx,
 
 int list(
         cis1::context_interface& ctx,
-        const char* mask,
+        const cis1::job_mask& mask,
         cis1::os_interface& os)
 {
     std::error_code ec;
@@ -151,11 +154,9 @@ int list(
     }
     auto& cron_list = opt_cron_list.value();
 
-    std::regex rx(mask);
-
     for(const auto& entry : cron_list.list())
     {
-        if(std::regex_match(entry.job(), rx))
+        if(mask.matches(entry.job()))
         {
             std::cout << entry.job() << " "
                       << entry.expr() << std::endl;
@@ -218,9 +219,9 @@ int main(int argc, char *argv[])
         {
             if(strcmp(argv[1], "--list") == 0)
             {
-                if(validate_mask(argv[2]))
+                if(auto mask = cis1::job_mask::compile(argv[2]); mask)
                 {
-                    return list(ctx, argv[2], std_os);
+                    return list(ctx, mask.value(), std_os);
                 }
 
                 std::cout << "Invalid mask." << std::endl;
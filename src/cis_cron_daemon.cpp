@@ -10,6 +10,7 @@
 #include <set>
 #include <chrono>
 #include <string>
+#include <functional>
 #include <iostream>
 
 #include <boost/asio.hpp>
@@ -23,6 +24,7 @@
 #include "logger.h"
 #include "os.h"
 #include "cron.h"
+#include "utils.h"
 #include "cis_version.h"
 
 int main(int argc, char* argv[])
@@ -56,10 +58,42 @@ int main(int argc, char* argv[])
 
     boost::asio::io_context io_ctx;
 
+    // fork and exec don't block timers and updates
+    cis1::process_launcher launcher(io_ctx, std_os);
+
     cron_manager cm(io_ctx, ctx, ctx.base_dir() / "core" / "crons", std_os);
+    cm.set_launcher(launcher);
+
+    if(auto rate = u32_from_string(ctx.get_env_var("cron_max_spawns_per_second"));
+            rate)
+    {
+        cm.set_max_spawns_per_second(rate.value());
+    }
 
     boost::asio::signal_set signals(io_ctx, SIGINT, SIGTERM);
 
+#ifdef __linux__
+    // kill -USR1 prints launcher counters without restarting daemon
+    boost::asio::signal_set stats_signals(io_ctx, SIGUSR1);
+
+    std::function<void()> wait_stats_signal = [&]()
+    {
+        stats_signals.async_wait(
+                [&](const boost::system::error_code& ec, int)
+                {
+                    if(ec)
+                    {
+                        return;
+                    }
+
+                    launcher.log_stats();
+                    wait_stats_signal();
+                });
+    };
+
+    wait_stats_signal();
+#endif
+
 #ifdef __linux__
     std::filesystem::remove("/dev/shm/cis1_cron_cv1", ec);
     if(ec)
@@ -116,4 +150,6 @@ int main(int argc, char* argv[])
     io_ctx.run();
 
     update_watcher.join();
+
+    launcher.log_stats();
 }
@@ -25,7 +25,7 @@ context::context(
         const std::map<std::string, std::string>& executables)
     : base_dir_(base_dir)
     , executables_(executables)
-    , env_(boost::this_process::environment())
+    , env_(environment::current().overlay(executables))
     , process_id_(boost::this_process::get_id())
     , parent_startjob_id_(0)
 {
@@ -35,34 +35,30 @@ context::context(
     {
         parent_startjob_id_ = parent_startjob_id_opt.value();
     }
-
-    for(auto& [k, v] : executables)
-    {
-        env_[k] = v;
-    }
 }
 
 void context::set_env_var(
         const std::string& key,
         const std::string& val)
 {
-    env_[key] = val;
+    env_.set(key, val);
 }
 
 std::string context::get_env_var(
         const std::string& key)
 {
-    std::string var;
-
-    if(auto it = env_.find(key); it != env_.end())
-    {
-        var = it->to_vector()[0];
-    }
-
-    return var;
+    auto var = env_.get(key);
+
+    // Only the first element of list value like boost::process
+    // environment entry to_vector()[0]
+#ifdef _WIN32
+    return var.substr(0, var.find(';'));
+#else
+    return var.substr(0, var.find(':'));
+#endif
 }
 
-const boost::process::environment& context::env() const
+const environment& context::env() const
 {
     return env_;
 }
@@ -95,16 +91,18 @@ std::optional<context> init_context(
         return std::nullopt;
     }
 
-    if(!os.is_directory(cis_base_dir, ec) || ec)
-    {
-        ec = cis1::error_code::base_dir_doesnt_exist;
-
-        return std::nullopt;
-    }
-
     auto is = os.open_ifstream(cis_base_dir / "core" / "cis.conf");
     if(!is || !is->is_open())
     {
+        // Base dir is checked only on failure to save a syscall
+        // in the common case
+        if(!os.is_directory(cis_base_dir, ec) || ec)
+        {
+            ec = cis1::error_code::base_dir_doesnt_exist;
+
+            return std::nullopt;
+        }
+
         ec = cis1::error_code::cant_read_base_conf_file;
 
         return std::nullopt;
@@ -8,11 +8,14 @@
 
 #include "cron.h"
 
+#include <algorithm>
+
 #include <boost/process/spawn.hpp>
 #include <boost/interprocess/sync/named_condition.hpp>
 
 #include "logger.h"
 #include "error_code.h"
+#include "job_mask.h"
 
 cron_entry::cron_entry(
         const std::string& job,
@@ -121,26 +124,34 @@ std::optional<cron_list> load_cron_list(
 }
 
 cron_timer::cron_timer(
-        const cron::cronexpr& expr,
+        const cis1::cron_schedule& schedule,
         boost::asio::io_context& ctx)
-    : expr_(expr)
+    : schedule_(schedule)
     , timer_(ctx)
 {}
 
 void cron_timer::run(const std::function<void()>& cb)
 {
     auto now = std::time(nullptr);
-    auto next = cron::cron_next(expr_, now);
+    auto next = schedule_.next(std::max(now, last_));
+    if(next == -1)
+    {
+        CIS_LOG(actions::error, "Cron expression has no next time");
+
+        return;
+    }
+
     auto time_to_next = std::chrono::system_clock::from_time_t(next)
                       - std::chrono::system_clock::from_time_t(now);
 
     timer_.expires_after(time_to_next);
 
     timer_.async_wait(
-        [&, cb](const boost::system::error_code& error)
+        [&, cb, next](const boost::system::error_code& error)
         {
             if(!error)
             {
+                last_ = next;
                 cb();
                 run(cb);
             }
@@ -161,6 +172,7 @@ cron_manager::cron_manager(
     , ctx_(ctx)
     , crons_file_path_(path)
     , os_(os)
+    , spawn_timer_(io_ctx)
 {}
 
 void cron_manager::update()
@@ -174,7 +186,7 @@ void cron_manager::update()
         return;
     }
 
-    std::set<cron_entry> crons;
+    std::map<std::string, std::set<std::string>> crons;
 
     while(crons_file->istream().good())
     {
@@ -189,9 +201,39 @@ void cron_manager::update()
             break;
         }
 
-        crons.insert(cron_entry{job, cron});
+        crons[cis1::resolve_hashed_cron(cron, job)].insert(job);
     }
 
+    auto add_group = [&](
+            std::map<std::string, cron_group>::iterator hint,
+            const std::string& expr,
+            std::set<std::string>&& jobs)
+    {
+        auto schedule = cis1::cron_schedule::compile(expr);
+        if(!schedule)
+        {
+            CIS_LOG(actions::error, "Invalid cron expression %s", expr);
+
+            return;
+        }
+
+        auto it = timers_.emplace_hint(
+                hint,
+                expr,
+                cron_group{
+                        cron_timer{schedule.value(), io_ctx_},
+                        std::move(jobs)});
+
+        it->second.timer.run(
+                [&, &group = it->second]()
+                {
+                    for(auto& job : group.jobs)
+                    {
+                        enqueue_job(job);
+                    }
+                });
+    };
+
     auto new_it = crons.begin();
     auto new_end = crons.end();
     auto old_it = timers_.begin();
@@ -199,29 +241,22 @@ void cron_manager::update()
 
     while(new_it != new_end && old_it != old_end)
     {
-        if(*new_it < old_it->first)
+        if(new_it->first < old_it->first)
         {
-            auto cronexpr = cron::make_cron(new_it->expr());
-            auto it = timers_.emplace_hint(
-                    old_it,
-                    *new_it,
-                    cron_timer{cronexpr, io_ctx_});
-
-            it->second.run(
-                    [&, job = it->first.job()]()
-                    {
-                        run_job(job);
-                    });
+            add_group(old_it, new_it->first, std::move(new_it->second));
 
             ++new_it;
         }
-        else if(old_it->first < *new_it)
+        else if(old_it->first < new_it->first)
         {
-            old_it->second.cancel();
+            old_it->second.timer.cancel();
             old_it = timers_.erase(old_it);
         }
         else
         {
+            // timer keeps running, only jobs are replaced
+            old_it->second.jobs = std::move(new_it->second);
+
             ++old_it;
             ++new_it;
         }
@@ -229,27 +264,129 @@ void cron_manager::update()
 
     for(; old_it != old_end; old_it = timers_.erase(old_it))
     {
-        old_it->second.cancel();
+        old_it->second.timer.cancel();
     }
 
     for(; new_it != new_end; ++new_it)
     {
-        auto cronexpr = cron::make_cron(new_it->expr());
-        auto it = timers_.emplace_hint(
-                old_it,
-                *new_it,
-                cron_timer{cronexpr, io_ctx_});
+        add_group(old_end, new_it->first, std::move(new_it->second));
+    }
 
-        it->second.run(
-                [&, job = it->first.job()]()
+    // jobs removed from crons aren't started from the spawn queue
+    for(auto it = queued_jobs_.begin(); it != queued_jobs_.end();)
+    {
+        bool scheduled = std::any_of(
+                timers_.begin(),
+                timers_.end(),
+                [&](const auto& group)
                 {
-                    run_job(job);
+                    return group.second.jobs.count(*it) != 0;
                 });
+
+        if(scheduled)
+        {
+            ++it;
+
+            continue;
+        }
+
+        spawn_queue_.erase(
+                std::remove(spawn_queue_.begin(), spawn_queue_.end(), *it),
+                spawn_queue_.end());
+        it = queued_jobs_.erase(it);
+    }
+}
+
+void cron_manager::set_max_spawns_per_second(uint32_t rate)
+{
+    max_spawns_per_second_ = rate;
+
+    if(rate == 0)
+    {
+        spawn_timer_.cancel();
+    }
+}
+
+void cron_manager::enqueue_job(const std::string& job)
+{
+    if(max_spawns_per_second_ == 0 && spawn_queue_.empty())
+    {
+        run_job(job);
+
+        return;
+    }
+
+    if(queued_jobs_.insert(job).second)
+    {
+        spawn_queue_.push_back(job);
+    }
+
+    spawn_queued();
+}
+
+void cron_manager::spawn_queued()
+{
+    if(spawn_timer_armed_)
+    {
+        return;
+    }
+
+    while(!spawn_queue_.empty())
+    {
+        auto now = std::chrono::steady_clock::now();
+
+        if(max_spawns_per_second_ != 0 && next_spawn_ > now)
+        {
+            spawn_timer_armed_ = true;
+            spawn_timer_.expires_at(next_spawn_);
+            spawn_timer_.async_wait(
+                    [&](const boost::system::error_code&)
+                    {
+                        // cancelled timer means limit is removed
+                        spawn_timer_armed_ = false;
+                        spawn_queued();
+                    });
+
+            return;
+        }
+
+        auto job = std::move(spawn_queue_.front());
+        spawn_queue_.pop_front();
+        queued_jobs_.erase(job);
+
+        run_job(job);
+
+        if(max_spawns_per_second_ != 0)
+        {
+            next_spawn_ = std::max(next_spawn_, now)
+                        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                std::chrono::seconds{1}) / max_spawns_per_second_;
+        }
     }
 }
 
+void cron_manager::set_launcher(cis1::process_launcher& launcher)
+{
+    launcher_ = &launcher;
+}
+
 void cron_manager::run_job(const std::string& job)
 {
+    if(launcher_)
+    {
+        auto executable =
+                std::filesystem::path{"core"}
+                / ctx_.get_env_var("startjob");
+
+        launcher_->launch(
+                ctx_.base_dir().generic_string(),
+                executable.generic_string(),
+                std::vector<std::string>{job},
+                ctx_.env());
+
+        return;
+    }
+
     try
     {
         auto executable =
@@ -317,14 +454,5 @@ std::optional<cron::cronexpr> make_cron(
 
 bool validate_mask(const char* mask)
 {
-    try
-    {
-        std::regex rx(mask);
-
-        return true;
-    }
-    catch(std::regex_error& err)
-    {
-        return false;
-    }
+    return cis1::job_mask::compile(mask).has_value();
 }
@@ -0,0 +1,633 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "cron_schedule.h"
+
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <string_view>
+#include <vector>
+
+namespace cis1
+{
+
+namespace
+{
+
+/// cron::cron_next doesn't look further too
+constexpr int max_years = 4;
+
+const char* const month_names[] =
+{
+    "JAN", "FEB", "MAR", "APR", "MAY", "JUN",
+    "JUL", "AUG", "SEP", "OCT", "NOV", "DEC"
+};
+
+const char* const day_names[] =
+{
+    "SUN", "MON", "TUE", "WED", "THU", "FRI", "SAT"
+};
+
+struct field_spec
+{
+    int min;
+    int max;
+    /// names of values from min, nullptr if field has no names
+    const char* const* names;
+    bool allow_question;
+};
+
+std::optional<int> parse_value(std::string_view str, const field_spec& spec)
+{
+    if(str.empty())
+    {
+        return std::nullopt;
+    }
+
+    if(spec.names && str.size() == 3)
+    {
+        for(int i = 0; i <= spec.max - spec.min; ++i)
+        {
+            bool equal = true;
+
+            for(size_t j = 0; j < 3; ++j)
+            {
+                auto c = str[j];
+                if(c >= 'a' && c <= 'z')
+                {
+                    c = c - 'a' + 'A';
+                }
+
+                equal = equal && c == spec.names[i][j];
+            }
+
+            if(equal)
+            {
+                return spec.min + i;
+            }
+        }
+    }
+
+    if(str.size() > 2)
+    {
+        return std::nullopt;
+    }
+
+    int value = 0;
+
+    for(auto c : str)
+    {
+        if(c < '0' || c > '9')
+        {
+            return std::nullopt;
+        }
+
+        value = value * 10 + (c - '0');
+    }
+
+    return value;
+}
+
+/**
+ * Parses comma separated list of "*", "?", "a", "a-b", "*\/s", "a/s"
+ * and "a-b/s". Returns false for anything else, croncpp decides then.
+ */
+bool parse_field(std::string_view field, const field_spec& spec, uint64_t& mask)
+{
+    mask = 0;
+
+    while(!field.empty())
+    {
+        auto comma = field.find(',');
+        auto item = field.substr(0, comma);
+        field = comma == std::string_view::npos
+                ? std::string_view{}
+                : field.substr(comma + 1);
+
+        if(comma != std::string_view::npos && field.empty())
+        {
+            return false;
+        }
+
+        int step = 1;
+
+        if(auto slash = item.find('/'); slash != std::string_view::npos)
+        {
+            auto step_opt = parse_value(item.substr(slash + 1), {0, 99, nullptr, false});
+            if(!step_opt || step_opt.value() == 0)
+            {
+                return false;
+            }
+
+            step = step_opt.value();
+            item = item.substr(0, slash);
+        }
+
+        int first;
+        int last;
+
+        if(item == "*" || (item == "?" && spec.allow_question && step == 1))
+        {
+            first = spec.min;
+            last = spec.max;
+        }
+        else if(auto dash = item.find('-'); dash != std::string_view::npos)
+        {
+            auto first_opt = parse_value(item.substr(0, dash), spec);
+            auto last_opt = parse_value(item.substr(dash + 1), spec);
+            if(!first_opt || !last_opt)
+            {
+                return false;
+            }
+
+            first = first_opt.value();
+            last = last_opt.value();
+        }
+        else
+        {
+            auto value = parse_value(item, spec);
+            if(!value)
+            {
+                return false;
+            }
+
+            first = value.value();
+            // "a/s" means from a to the end
+            last = step == 1 ? first : spec.max;
+        }
+
+        if(first < spec.min || last > spec.max || first > last)
+        {
+            return false;
+        }
+
+        for(int i = first; i <= last; i += step)
+        {
+            mask |= uint64_t{1} << i;
+        }
+    }
+
+    return mask != 0;
+}
+
+/// Lowest set bit not less than from or -1
+int next_bit(uint64_t mask, int from)
+{
+    if(from >= 64)
+    {
+        return -1;
+    }
+
+    mask &= ~uint64_t{0} << from;
+
+    if(mask == 0)
+    {
+        return -1;
+    }
+
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(mask);
+#else
+    int bit = from;
+    while(!(mask & (uint64_t{1} << bit)))
+    {
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+bool is_leap(int year)
+{
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+int days_in_month(int year, int month)
+{
+    static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+    return month == 2 && is_leap(year) ? 29 : days[month - 1];
+}
+
+/// 0 is sunday
+int day_of_week(int year, int month, int day)
+{
+    // days from 1970-01-01 of proleptic gregorian calendar
+    year -= month <= 2;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const int yoe = year - era * 400;
+    const int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    const long days = era * 146097L + doe - 719468;
+
+    // 1970-01-01 is thursday
+    return static_cast<int>(((days % 7) + 11) % 7);
+}
+
+/// Same time zone as croncpp: UTC unless CRON_USE_LOCAL_TIME is defined
+bool to_tm(std::time_t time, std::tm& tm)
+{
+#if defined(CRON_USE_LOCAL_TIME) && defined(_WIN32)
+    return localtime_s(&tm, &time) == 0;
+#elif defined(CRON_USE_LOCAL_TIME)
+    return localtime_r(&time, &tm) != nullptr;
+#elif defined(_WIN32)
+    return gmtime_s(&tm, &time) == 0;
+#else
+    return gmtime_r(&time, &tm) != nullptr;
+#endif
+}
+
+/// Inverse of to_tm
+std::time_t from_tm(std::tm tm)
+{
+#if defined(CRON_USE_LOCAL_TIME)
+    return std::mktime(&tm);
+#elif defined(_WIN32)
+    return _mkgmtime(&tm);
+#else
+    return timegm(&tm);
+#endif
+}
+
+/// FNV-1a with murmur3 finalizer, stable between runs and platforms
+/// unlike std::hash
+uint32_t hash_job(const std::string& job, size_t field)
+{
+    uint32_t hash = 2166136261u;
+
+    auto add = [&](unsigned char c)
+    {
+        hash ^= c;
+        hash *= 16777619u;
+    };
+
+    for(unsigned char c : job)
+    {
+        add(c);
+    }
+
+    add(0);
+    add(static_cast<unsigned char>(field));
+
+    // low bits of FNV are weak, values are taken modulo small numbers
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+
+    return hash;
+}
+
+std::optional<int> parse_number(std::string_view str)
+{
+    return parse_value(str, {0, 99, nullptr, false});
+}
+
+/**
+ * Resolves "H", "H(a-b)", "H/s" and "H(a-b)/s", other items are
+ * returned as is.
+ */
+std::string resolve_hashed_item(
+        std::string_view item,
+        const field_spec& spec,
+        int hashed_max,
+        uint32_t hash)
+{
+    if(item.empty() || item[0] != 'H')
+    {
+        return std::string{item};
+    }
+
+    auto rest = item.substr(1);
+    int first = spec.min;
+    int last = hashed_max;
+
+    if(!rest.empty() && rest[0] == '(')
+    {
+        auto close = rest.find(')');
+        auto dash = rest.find('-');
+        if(close == std::string_view::npos || dash > close)
+        {
+            return std::string{item};
+        }
+
+        auto first_opt = parse_number(rest.substr(1, dash - 1));
+        auto last_opt = parse_number(rest.substr(dash + 1, close - dash - 1));
+        if(!first_opt
+        || !last_opt
+        || first_opt.value() < spec.min
+        || last_opt.value() > spec.max
+        || first_opt.value() > last_opt.value())
+        {
+            return std::string{item};
+        }
+
+        first = first_opt.value();
+        last = last_opt.value();
+        rest = rest.substr(close + 1);
+    }
+
+    const int size = last - first + 1;
+
+    if(rest.empty())
+    {
+        return std::to_string(first + static_cast<int>(hash % size));
+    }
+
+    if(rest[0] != '/')
+    {
+        return std::string{item};
+    }
+
+    auto step = parse_number(rest.substr(1));
+    if(!step || step.value() == 0)
+    {
+        return std::string{item};
+    }
+
+    const int start = first + static_cast<int>(hash % std::min(step.value(), size));
+
+    return std::to_string(start)
+         + "-" + std::to_string(last)
+         + "/" + std::to_string(step.value());
+}
+
+} // namespace
+
+std::string resolve_hashed_cron(const std::string& expr, const std::string& job)
+{
+    if(expr.find('H') == std::string::npos)
+    {
+        return expr;
+    }
+
+    static const field_spec specs[] =
+    {
+        {0, 59, nullptr, false},
+        {0, 59, nullptr, false},
+        {0, 23, nullptr, false},
+        {1, 31, nullptr, false},
+        {1, 12, nullptr, false},
+        {0, 6, nullptr, false},
+    };
+
+    std::istringstream ss(expr);
+    std::vector<std::string> fields;
+
+    for(std::string field; ss >> field;)
+    {
+        fields.push_back(field);
+    }
+
+    if(fields.size() != std::size(specs))
+    {
+        return expr;
+    }
+
+    std::string result;
+
+    for(size_t i = 0; i < fields.size(); ++i)
+    {
+        auto& spec = specs[i];
+        // short months don't have days after 28
+        const int hashed_max = i == 3 ? 28 : spec.max;
+        const auto hash = hash_job(job, i);
+
+        std::string_view field = fields[i];
+
+        if(i != 0)
+        {
+            result += ' ';
+        }
+
+        for(;;)
+        {
+            auto comma = field.find(',');
+
+            result += resolve_hashed_item(
+                    field.substr(0, comma),
+                    spec,
+                    hashed_max,
+                    hash);
+
+            if(comma == std::string_view::npos)
+            {
+                break;
+            }
+
+            result += ',';
+            field = field.substr(comma + 1);
+        }
+    }
+
+    return result;
+}
+
+std::optional<cron_schedule> cron_schedule::compile(const std::string& expr)
+{
+    cron_schedule schedule;
+
+    try
+    {
+        schedule.fallback_ = cron::make_cron(expr);
+    }
+    catch(const cron::bad_cronexpr&)
+    {
+        return std::nullopt;
+    }
+
+    std::istringstream ss(expr);
+    std::vector<std::string> fields;
+
+    for(std::string field; ss >> field;)
+    {
+        fields.push_back(field);
+    }
+
+    if(fields.size() != 6)
+    {
+        return schedule;
+    }
+
+    uint64_t seconds;
+    uint64_t minutes;
+    uint64_t hours;
+    uint64_t days_of_month;
+    uint64_t months;
+    uint64_t days_of_week;
+
+    if(parse_field(fields[0], {0, 59, nullptr, false}, seconds)
+    && parse_field(fields[1], {0, 59, nullptr, false}, minutes)
+    && parse_field(fields[2], {0, 23, nullptr, false}, hours)
+    && parse_field(fields[3], {1, 31, nullptr, true}, days_of_month)
+    && parse_field(fields[4], {1, 12, month_names, false}, months)
+    && parse_field(fields[5], {0, 6, day_names, true}, days_of_week))
+    {
+        schedule.seconds_ = seconds;
+        schedule.minutes_ = minutes;
+        schedule.hours_ = static_cast<uint32_t>(hours);
+        schedule.days_of_month_ = static_cast<uint32_t>(days_of_month);
+        schedule.months_ = static_cast<uint16_t>(months);
+        schedule.days_of_week_ = static_cast<uint8_t>(days_of_week);
+        schedule.fallback_.reset();
+    }
+
+    return schedule;
+}
+
+std::time_t cron_schedule::next(std::time_t now) const
+{
+    if(fallback_)
+    {
+        auto time = cron::cron_next(fallback_.value(), now);
+
+        return time != -1 && time <= now ? -1 : time;
+    }
+
+    std::tm tm{};
+
+    if(!to_tm(now, tm))
+    {
+        return -1;
+    }
+
+    int year = tm.tm_year + 1900;
+    int month = tm.tm_mon + 1;
+    int day = tm.tm_mday;
+    int hour = tm.tm_hour;
+    int minute = tm.tm_min;
+    int second = tm.tm_sec + 1;
+
+    const int last_year = year + max_years;
+
+    // each step moves to the start of the next candidate month, day,
+    // hour or minute, overflowing values are carried on the next pass
+    while(year <= last_year)
+    {
+        if(month > 12)
+        {
+            month = 1;
+            ++year;
+
+            continue;
+        }
+
+        if(!(months_ & (1u << month)))
+        {
+            ++month;
+            day = 1;
+            hour = minute = second = 0;
+
+            continue;
+        }
+
+        auto next_day = next_bit(days_of_month_, day);
+        if(next_day < 0 || next_day > days_in_month(year, month))
+        {
+            ++month;
+            day = 1;
+            hour = minute = second = 0;
+
+            continue;
+        }
+
+        if(next_day != day)
+        {
+            day = next_day;
+            hour = minute = second = 0;
+        }
+
+        if(!(days_of_week_ & (1u << day_of_week(year, month, day))))
+        {
+            ++day;
+            hour = minute = second = 0;
+
+            continue;
+        }
+
+        auto next_hour = next_bit(hours_, hour);
+        if(next_hour < 0)
+        {
+            ++day;
+            hour = minute = second = 0;
+
+            continue;
+        }
+
+        if(next_hour != hour)
+        {
+            hour = next_hour;
+            minute = second = 0;
+        }
+
+        auto next_minute = next_bit(minutes_, minute);
+        if(next_minute < 0)
+        {
+            ++hour;
+            minute = second = 0;
+
+            continue;
+        }
+
+        if(next_minute != minute)
+        {
+            minute = next_minute;
+            second = 0;
+        }
+
+        auto next_second = next_bit(seconds_, second);
+        if(next_second < 0)
+        {
+            ++minute;
+            second = 0;
+
+            continue;
+        }
+
+        std::tm result{};
+        result.tm_year = year - 1900;
+        result.tm_mon = month - 1;
+        result.tm_mday = day;
+        result.tm_hour = hour;
+        result.tm_min = minute;
+        result.tm_sec = next_second;
+        result.tm_isdst = -1;
+
+        auto time = from_tm(result);
+
+        // local time repeated after dst ends may resolve to the earlier
+        // instant, standard time is the later one
+        if(time != -1 && time <= now)
+        {
+            result.tm_isdst = 0;
+            time = from_tm(result);
+        }
+
+        // never fire twice for the same second, cron_timer would spin
+        if(time != -1 && time <= now)
+        {
+            second = next_second + 1;
+
+            continue;
+        }
+
+        return time;
+    }
+
+    return -1;
+}
+
+bool cron_schedule::compiled() const
+{
+    return !fallback_.has_value();
+}
+
+} // namespace cis1
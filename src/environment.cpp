@@ -0,0 +1,218 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "environment.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <stdlib.h>
+#define environ _environ
+#else
+extern char** environ;
+#endif
+
+namespace cis1
+{
+
+char** environment::block::data()
+{
+    return entries_.data();
+}
+
+environment::environment()
+    : base_(std::make_shared<const base_t>())
+{}
+
+environment::environment(std::shared_ptr<const base_t> base)
+    : base_(std::move(base))
+{}
+
+environment environment::current()
+{
+    auto vars = std::make_shared<base_t>();
+
+    size_t size = 0;
+    for(char** entry = environ; entry && *entry; ++entry)
+    {
+        size += std::strlen(*entry) + 1;
+    }
+
+    // Reserved, so views into storage stay valid while it is filled
+    vars->storage.reserve(size);
+
+    for(char** entry = environ; entry && *entry; ++entry)
+    {
+        auto separator = std::strchr(*entry, '=');
+        if(separator == nullptr || separator == *entry)
+        {
+            continue;
+        }
+
+        const char* copy = vars->storage.data() + vars->storage.size();
+        vars->storage.append(*entry).push_back('\0');
+
+        // First occurrence wins like in getenv
+        vars->index.emplace(
+                std::string_view(copy, separator - *entry),
+                copy);
+    }
+
+    return environment{std::move(vars)};
+}
+
+std::optional<std::string_view> environment::find(std::string_view key) const
+{
+    if(overlay_)
+    {
+        if(auto it = overlay_->find(key); it != overlay_->end())
+        {
+            if(!it->second)
+            {
+                return std::nullopt;
+            }
+
+            return it->second.value();
+        }
+    }
+
+    if(auto it = base_->index.find(key); it != base_->index.end())
+    {
+        return std::string_view(it->second + key.size() + 1);
+    }
+
+    return std::nullopt;
+}
+
+std::string environment::get(std::string_view key) const
+{
+    if(auto val = find(key); val)
+    {
+        return std::string{val.value()};
+    }
+
+    return {};
+}
+
+environment::overlay_t& environment::mutable_overlay()
+{
+    if(!overlay_)
+    {
+        overlay_ = std::make_shared<overlay_t>();
+    }
+    else if(overlay_.use_count() > 1)
+    {
+        overlay_ = std::make_shared<overlay_t>(*overlay_);
+    }
+
+    return *overlay_;
+}
+
+void environment::set(
+        const std::string& key,
+        const std::string& val)
+{
+    mutable_overlay()[key] = val;
+}
+
+void environment::erase_prefixed(std::string_view prefix)
+{
+    auto& overlay = mutable_overlay();
+
+    for(auto it = overlay.lower_bound(prefix);
+            it != overlay.end() && std::string_view{it->first}.substr(0, prefix.size()) == prefix;
+            ++it)
+    {
+        it->second.reset();
+    }
+
+    for(auto& [k, entry] : base_->index)
+    {
+        if(k.substr(0, prefix.size()) == prefix)
+        {
+            overlay.insert_or_assign(std::string{k}, std::nullopt);
+        }
+    }
+}
+
+environment environment::overlay(
+        const std::map<std::string, std::string>& vars) const
+{
+    environment result = *this;
+
+    for(auto& [k, v] : vars)
+    {
+        result.set(k, v);
+    }
+
+    return result;
+}
+
+environment::block environment::make_block() const
+{
+    block result;
+
+    result.base_ = base_;
+    result.entries_.reserve(
+            base_->index.size() + (overlay_ ? overlay_->size() : 0) + 1);
+
+    for(auto& [k, entry] : base_->index)
+    {
+        if(!overlay_ || overlay_->count(k) == 0)
+        {
+            result.entries_.push_back(const_cast<char*>(entry));
+        }
+    }
+
+    if(overlay_)
+    {
+        // Reserved, so pointers to stored strings stay valid
+        result.storage_.reserve(overlay_->size());
+
+        for(auto& [k, v] : *overlay_)
+        {
+            if(v)
+            {
+                result.storage_.push_back(k + "=" + v.value());
+                result.entries_.push_back(result.storage_.back().data());
+            }
+        }
+    }
+
+    result.entries_.push_back(nullptr);
+
+    return result;
+}
+
+boost::process::environment environment::native() const
+{
+    boost::process::environment result;
+
+    for(auto& [k, entry] : base_->index)
+    {
+        if(!overlay_ || overlay_->count(k) == 0)
+        {
+            result[std::string{k}] = entry + k.size() + 1;
+        }
+    }
+
+    if(overlay_)
+    {
+        for(auto& [k, v] : *overlay_)
+        {
+            if(v)
+            {
+                result[k] = v.value();
+            }
+        }
+    }
+
+    return result;
+}
+
+} // namespace cis1
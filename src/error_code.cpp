@@ -98,6 +98,60 @@ std::string error_category::message(int ev) const
         case error_code::script_is_not_executable:
             return "Script is not executable";
 
+        case error_code::cant_write_build_stats_file:
+            return "Cant write build stats file";
+
+        case error_code::cant_create_cgroup:
+            return "Cant create cgroup";
+
+        case error_code::cant_apply_cgroup_limits:
+            return "Cant apply cgroup limits";
+
+        case error_code::cant_remove_cgroup:
+            return "Cant remove cgroup";
+
+        case error_code::cant_read_job_dir:
+            return "Cant read job dir";
+
+        case error_code::cant_read_build_index:
+            return "Cant read build index";
+
+        case error_code::cant_write_build_index:
+            return "Cant write build index";
+
+        case error_code::cant_read_session_graph:
+            return "Cant read session graph";
+
+        case error_code::cant_write_session_graph:
+            return "Cant write session graph";
+
+        case error_code::cant_acquire_build_slot:
+            return "Cant acquire build slot";
+
+        case error_code::cant_read_binary_log:
+            return "Cant read binary log";
+
+        case error_code::cant_write_binary_log:
+            return "Cant write binary log";
+
+        case error_code::cant_read_logs_dir:
+            return "Cant read logs dir";
+
+        case error_code::cant_compress_log:
+            return "Cant compress log";
+
+        case error_code::cant_write_session_index:
+            return "Cant write session index";
+
+        case error_code::cant_write_session_values_file:
+            return "Cant write session values file";
+
+        case error_code::cant_write_closed_sessions:
+            return "Cant write closed sessions journal";
+
+        case error_code::cant_collect_sessions:
+            return "Cant collect sessions";
+
         default:
             return "(unrecognized error)";
     }
@@ -0,0 +1,100 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "file_lock_adapter.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace cis1
+{
+
+file_lock_adapter::file_lock_adapter(
+        const std::filesystem::path& path,
+        std::error_code& ec)
+{
+#if defined(__linux__) || defined(__APPLE__)
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(fd_ == -1)
+    {
+        ec = std::error_code(errno, std::system_category());
+    }
+#else
+    (void) path;
+    (void) ec;
+#endif
+}
+
+file_lock_adapter::~file_lock_adapter()
+{
+#if defined(__linux__) || defined(__APPLE__)
+    if(fd_ != -1)
+    {
+        ::close(fd_);
+    }
+#endif
+}
+
+bool file_lock_adapter::lock()
+{
+#if defined(__linux__) || defined(__APPLE__)
+    return flock(LOCK_EX);
+#else
+    return true;
+#endif
+}
+
+bool file_lock_adapter::lock_shared()
+{
+#if defined(__linux__) || defined(__APPLE__)
+    return flock(LOCK_SH);
+#else
+    return true;
+#endif
+}
+
+bool file_lock_adapter::try_lock()
+{
+#if defined(__linux__) || defined(__APPLE__)
+    return flock(LOCK_EX | LOCK_NB);
+#else
+    return true;
+#endif
+}
+
+void file_lock_adapter::unlock()
+{
+#if defined(__linux__) || defined(__APPLE__)
+    flock(LOCK_UN);
+#endif
+}
+
+bool file_lock_adapter::flock(int operation)
+{
+#if defined(__linux__) || defined(__APPLE__)
+    int result;
+
+    do
+    {
+        result = ::flock(fd_, operation);
+    }
+    while(result == -1 && errno == EINTR);
+
+    return result == 0;
+#else
+    (void) operation;
+
+    return true;
+#endif
+}
+
+} // namespace cis1
@@ -13,10 +13,9 @@
 namespace cis1
 {
 
-std::optional<std::string> get_param(
+std::optional<std::map<std::string, std::string>> get_params(
         const cis1::context_interface& ctx,
         const session_interface& session,
-        const std::string& value_name,
         std::error_code& ec,
         const os_interface& os)
 {
@@ -46,7 +45,23 @@ std::optional<std::string> get_param(
         }
     }
 
-    if(auto it = values.find(value_name); it != values.end())
+    return values;
+}
+
+std::optional<std::string> get_param(
+        const cis1::context_interface& ctx,
+        const session_interface& session,
+        const std::string& param_name,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    auto params = get_params(ctx, session, ec, os);
+    if(!params)
+    {
+        return std::nullopt;
+    }
+
+    if(auto it = params->find(param_name); it != params->end())
     {
         return it->second;
     }
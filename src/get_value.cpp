@@ -13,10 +13,9 @@
 namespace cis1
 {
 
-std::optional<std::string> get_value(
+std::optional<std::map<std::string, std::string>> get_values(
         const cis1::context_interface& ctx,
         const session_interface& session,
-        const std::string& value_name,
         std::error_code& ec,
         const os_interface& os)
 {
@@ -43,7 +42,23 @@ std::optional<std::string> get_value(
         }
     }
 
-    if(auto it = values.find(value_name); it != values.end())
+    return values;
+}
+
+std::optional<std::string> get_value(
+        const cis1::context_interface& ctx,
+        const session_interface& session,
+        const std::string& value_name,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    auto values = get_values(ctx, session, ec, os);
+    if(!values)
+    {
+        return std::nullopt;
+    }
+
+    if(auto it = values->find(value_name); it != values->end())
     {
         return it->second;
     }
@@ -11,6 +11,7 @@
 #include "context.h"
 #include "session.h"
 #include "get_param.h"
+#include "kv_batch.h"
 #include "logger.h"
 #include "os.h"
 #include "webui_session.h"
@@ -19,7 +20,9 @@
 void usage()
 {
     std::cout << "Usage:" << "\n"
-              << "getparam value_name" << std::endl;
+              << "getparam value_name [value_name...]" << "\n"
+              << "getparam [--shell|--null] value_name [value_name...]" << "\n"
+              << "getparam [--shell|--null] --all" << std::endl;
 }
 
 int main(int argc, char *argv[])
@@ -65,7 +68,8 @@ int main(int argc, char *argv[])
 
     init_session_log(options, ctx, session);
 
-    if(argc != 2)
+    auto args = cis1::parse_kv_get_args({argv + 1, argv + argc});
+    if(!args)
     {
         std::cerr << "Wrong arguments" << std::endl;
         TEE_LOG(actions::error, "Wrong args count in getparam");
@@ -81,7 +85,7 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    auto param_opt = cis1::get_param(ctx, session, argv[1], ec, std_os);
+    auto params = cis1::get_params(ctx, session, ec, std_os);
     if(ec)
     {
         std::cerr << ec.message() << std::endl;
@@ -90,8 +94,14 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    std::cout << param_opt.value() << std::endl;
+    auto result = cis1::select_kv(args.value(), params.value());
 
-    SES_LOG(actions::getparam, R"("%s"="%s")", argv[1], param_opt.value());
+    if(cis1::print_kv(std::cout, result, args->format) != 0)
+    {
+        std::cerr << "Names which are not shell identifiers are skipped"
+                  << std::endl;
+    }
+
+    SES_LOG(actions::getparam, "%s", cis1::format_kv_record(result));
     return 0;
 }
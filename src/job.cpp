@@ -8,6 +8,7 @@
 
 #include "job.h"
 
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 #include <cis1_proto_utils/param_codec.h>
@@ -15,10 +16,53 @@
 #include <cis1_proto_utils/read_istream_kv_str.h>
 #include "utils.h"
 #include "error_code.h"
+#include "logger.h"
+#include "build_index.h"
+#include "build_inputs.h"
 
 namespace cis1
 {
 
+namespace
+{
+
+void remove_build_cgroup(
+        boost::asio::io_context& io_ctx,
+        const std::filesystem::path& cgroup,
+        const os_interface& os)
+{
+    async_remove_cgroup(
+            io_ctx,
+            cgroup,
+            os,
+            [cgroup](std::error_code ec)
+            {
+                if(ec)
+                {
+                    CIS_LOG(actions::error, R"(cgroup="%s" %s)", cgroup.string(), ec.message());
+                }
+            });
+}
+
+/// Index which missed an update gives wrong query results
+void on_index_error(
+        const std::filesystem::path& job_dir,
+        const std::error_code& index_ec,
+        const os_interface& os)
+{
+    CIS_LOG(actions::error, R"(job_dir="%s" %s)", job_dir.string(), index_ec.message());
+
+    std::error_code ec;
+
+    invalidate_build_index(job_dir, ec, os);
+    if(ec)
+    {
+        CIS_LOG(actions::error, R"(job_dir="%s" %s)", job_dir.string(), ec.message());
+    }
+}
+
+} // namespace
+
 job::build_handle::build_handle(
         job& job_arg,
         std::optional<uint32_t> number)
@@ -31,7 +75,8 @@ void job::build_handle::execute(
         bool force,
         std::error_code& ec,
         std::function<void(bool, const std::string&)> newline_cb,
-        int& exit_code)
+        int& exit_code,
+        std::optional<build_stats>& stats)
 {
     job_.execute(
             number_.value(),
@@ -39,9 +84,28 @@ void job::build_handle::execute(
             ec,
             newline_cb,
             exit_code,
+            stats,
             force);
 }
 
+std::unique_ptr<job_runner_interface> job::build_handle::async_execute(
+        boost::asio::io_context& io_ctx,
+        cis1::context_interface& ctx,
+        const environment& env,
+        bool force,
+        std::function<void(bool, const std::string&)> newline_cb,
+        on_build_finish_cb_t on_finish)
+{
+    return job_.async_execute(
+            number_.value(),
+            io_ctx,
+            ctx,
+            env,
+            force,
+            newline_cb,
+            std::move(on_finish));
+}
+
 std::string job::build_handle::number_string()
 {
     std::stringstream ss;
@@ -79,39 +143,108 @@ job::job(
 
 void job::cleanup(std::error_code& ec)
 {
-    size_t successful_builds_to_erase =
-            (successful_builds_.size() > config_.keep_successful_builds
-            ? successful_builds_.size() - config_.keep_successful_builds
-            : 0);
+    std::optional<std::filesystem::path> job_dir;
+    std::vector<uint32_t> removed;
 
-    for(size_t i = 0; i < successful_builds_to_erase; ++i)
+    auto remove_oldest = [&](
+            std::map<uint32_t, std::filesystem::path>& builds,
+            uint32_t keep)
     {
-        os_.remove_all(successful_builds_.begin()->second, ec);
+        size_t builds_to_erase =
+                (builds.size() > keep
+                ? builds.size() - keep
+                : 0);
 
-        if(ec)
+        for(size_t i = 0; i < builds_to_erase; ++i)
         {
-            return;
+            os_.remove_all(builds.begin()->second, ec);
+
+            if(ec)
+            {
+                return;
+            }
+
+            job_dir = builds.begin()->second.parent_path();
+            removed.push_back(builds.begin()->first);
+
+            builds.erase(builds.begin());
         }
+    };
+
+    remove_oldest(successful_builds_, config_.keep_successful_builds);
 
-        successful_builds_.erase(successful_builds_.begin());
+    if(!ec)
+    {
+        remove_oldest(broken_builds_, config_.keep_broken_builds);
+    }
+
+    if(!job_dir)
+    {
+        return;
     }
 
-    size_t broken_builds_to_erase =
-            (broken_builds_.size() > config_.keep_broken_builds
-            ? broken_builds_.size() - config_.keep_broken_builds
-            : 0);
+    // index is best effort, so its errors don't fail cleanup
+    std::error_code index_ec;
 
-    for(size_t i = 0; i < broken_builds_to_erase; ++i)
+    remove_build_records(job_dir.value(), name_, removed, index_ec, os_);
+    if(index_ec)
     {
-        os_.remove_all(broken_builds_.begin()->second, ec);
+        on_index_error(job_dir.value(), index_ec, os_);
+    }
+}
 
-        if(ec)
-        {
-            return;
-        }
+void job::discard_build(uint32_t build_number, std::error_code& ec)
+{
+    auto it = pending_builds_.find(build_number);
+    if(it == pending_builds_.end())
+    {
+        return;
+    }
+
+    auto build_dir = it->second;
 
-        broken_builds_.erase(broken_builds_.begin());
+    os_.remove_all(build_dir, ec);
+    if(ec)
+    {
+        return;
     }
+
+    pending_builds_.erase(it);
+    pending_records_.erase(build_number);
+
+    // index is best effort, so its errors don't fail discard
+    std::error_code index_ec;
+
+    remove_build_records(
+            build_dir.parent_path(),
+            name_,
+            {build_number},
+            index_ec,
+            os_);
+    if(index_ec)
+    {
+        on_index_error(build_dir.parent_path(), index_ec, os_);
+    }
+}
+
+const std::map<uint32_t, std::filesystem::path>& job::successful_builds() const
+{
+    return successful_builds_;
+}
+
+const std::map<uint32_t, std::filesystem::path>& job::broken_builds() const
+{
+    return broken_builds_;
+}
+
+const std::map<uint32_t, std::filesystem::path>& job::pending_builds() const
+{
+    return pending_builds_;
+}
+
+const std::string& job::name() const
+{
+    return name_;
 }
 
 const std::vector<std::pair<std::string, std::string>>& job::params() const
@@ -119,22 +252,84 @@ const std::vector<std::pair<std::string, std::string>>& job::params() const
     return config_.params;
 }
 
+uint32_t job::timeout() const
+{
+    return config_.timeout;
+}
+
+void job::set_timeout(uint32_t seconds)
+{
+    config_.timeout = seconds;
+}
+
 void job::execute(
         uint32_t build_number,
         cis1::context_interface& ctx,
         std::error_code& ec,
         std::function<void(bool, const std::string&)> newline_cb,
         int& exit_code,
+        std::optional<build_stats>& stats,
         bool force,
         job_runner_factory_t job_runner_factory)
 {
-    auto& build_dir = pending_builds_[build_number];
+    boost::asio::io_context io_ctx;
+
+    auto runner = async_execute(
+            build_number,
+            io_ctx,
+            ctx,
+            ctx.env(),
+            force,
+            newline_cb,
+            [&](std::error_code err, int exit, std::optional<build_stats> st)
+            {
+                ec = err;
+                exit_code = exit;
+                stats = st;
+            },
+            job_runner_factory);
+
+    io_ctx.run();
+}
+
+std::unique_ptr<job_runner_interface> job::async_execute(
+        uint32_t build_number,
+        boost::asio::io_context& io_ctx,
+        cis1::context_interface& ctx,
+        const environment& env,
+        bool force,
+        std::function<void(bool, const std::string&)> newline_cb,
+        on_build_finish_cb_t on_finish,
+        job_runner_factory_t job_runner_factory)
+{
+    auto build_dir = pending_builds_[build_number];
+
+    // finish record repeats start fields, so build stays in session
+    // and time queries even if pending record was lost
+    auto& index_record = pending_records_[build_number];
+    if(index_record.started == 0)
+    {
+        // build was prepared by other process
+        index_record.job = name_;
+        index_record.number = build_number;
+        index_record.started = unix_time_now();
+
+        if(auto session_id_file = os_.open_ifstream(build_dir / "session_id.txt");
+                session_id_file && session_id_file->is_open())
+        {
+            std::getline(session_id_file->istream(), index_record.session_id);
+        }
+    }
+
+    std::error_code ec;
 
     if(!os_.is_executable(build_dir / config_.script, ec))
     {
         if(ec)
         {
-            return;
+            on_finish(ec, -1, std::nullopt);
+
+            return nullptr;
         }
 
         if(force)
@@ -143,83 +338,310 @@ void job::execute(
 
             if(ec)
             {
-                return;
+                on_finish(ec, -1, std::nullopt);
+
+                return nullptr;
             }
         }
         else
         {
-            ec = cis1::error_code::script_is_not_executable;
+            on_finish(
+                    cis1::error_code::script_is_not_executable,
+                    -1,
+                    std::nullopt);
 
-            return;
+            return nullptr;
         }
     }
 
-    boost::asio::io_context io_ctx;
+    // scripts read their inputs without getparam and getvalue calls,
+    // inputs of parent build must not be taken for the nested build ones
+    auto build_env = env;
+    build_env.erase_prefixed("cis_param");
+    build_env.erase_prefixed("cis_value");
+
+    if(config_.export_params)
+    {
+        export_build_params(build_env, build_dir, ec, os_);
+    }
+
+    if(!ec && config_.export_session_values)
+    {
+        export_session_values(build_env, ctx.base_dir(), build_dir, ec, os_);
+    }
+
+    if(ec)
+    {
+        on_finish(ec, -1, std::nullopt);
+
+        return nullptr;
+    }
+
+    run_options options;
+    options.timeout = std::chrono::seconds{config_.timeout};
+
+    // cgroups are optional, build runs without isolation if unavailable
+    if(auto cgroup_root = ctx.get_env_var("cgroup_root"); !cgroup_root.empty())
+    {
+        std::stringstream cgroup_name;
+
+        cgroup_name << name_ << "-" << std::setfill('0')
+                    << std::setw(6) << build_number;
+
+        auto name = cgroup_name.str();
+        std::replace(name.begin(), name.end(), '/', '-');
+
+        std::error_code cgroup_ec;
+
+        options.cgroup = create_cgroup(
+                cgroup_root,
+                name,
+                config_.limits,
+                cgroup_ec,
+                os_);
+        if(cgroup_ec)
+        {
+            CIS_LOG(actions::error, R"(cgroup="%s" %s)", name, cgroup_ec.message());
+
+            // configured limits must not be silently ignored
+            if(has_limits(config_.limits))
+            {
+                on_finish(cgroup_ec, -1, std::nullopt);
+
+                return nullptr;
+            }
+        }
+    }
 
     auto runner = job_runner_factory(
             io_ctx,
-            ctx.env(),
+            build_env,
             build_dir,
+            options,
             os_);
 
-    auto output = os_.open_ofstream(build_dir / "output.txt");
+    // shared by output callbacks, lives as long as runner
+    std::shared_ptr<ofstream_interface> output =
+            os_.open_ofstream(build_dir / "output.txt");
     if(!output || !output->is_open())
     {
-        ec = cis1::error_code::cant_open_build_output_file;
+        if(options.cgroup)
+        {
+            remove_build_cgroup(io_ctx, options.cgroup.value(), os_);
+        }
 
-        return;
+        on_finish(
+                cis1::error_code::cant_open_build_output_file,
+                -1,
+                std::nullopt);
+
+        return nullptr;
     }
 
-    runner->run(
-            config_.script,
-            [&](std::error_code err, int exit)
-            {
-                if(err)
-                {
-                    ec = err;
-                }
-                else
+    std::vector<slot_limit> slot_limits;
+
+    // nested builds are not limited, their ancestors may already hold
+    // the slots (e.g. job starting itself) and would wait for them forever
+    if(!env.find("parent_job_name"))
+    {
+        if(config_.max_concurrent_builds != 0)
+        {
+            slot_limits.push_back({
+                    build_dir.parent_path() / ".queue",
+                    config_.max_concurrent_builds});
+        }
+
+        if(auto host_slots = u32_from_string(ctx.get_env_var("max_concurrent_builds"));
+                host_slots && host_slots.value() != 0)
+        {
+            slot_limits.push_back({ctx.base_dir() / "queue", host_slots.value()});
+        }
+    }
+
+    auto start = [this,
+                  &io_ctx,
+                  runner = runner.get(),
+                  build_number,
+                  build_dir,
+                  output,
+                  newline_cb,
+                  script = config_.script,
+                  cgroup = options.cgroup,
+                  on_finish]()
+    {
+        runner->run(
+                script,
+                [this,
+                 &io_ctx,
+                 runner,
+                 build_number,
+                 build_dir,
+                 cgroup,
+                 on_finish](std::error_code err, int exit)
                 {
-                    exit_code = exit;
+                    int exit_code = -1;
+                    std::optional<build_stats> stats;
+                    std::error_code ec;
 
-                    auto ec_file = os_.open_ofstream(build_dir / "exitcode.txt");
-                    if(!ec_file || !ec_file->is_open())
+                    [&]()
                     {
-                        ec = cis1::error_code::cant_open_build_exit_code_file;
+                        if(err)
+                        {
+                            ec = err;
+
+                            return;
+                        }
+
+                        exit_code = exit;
+
+                        auto ec_file = os_.open_ofstream(build_dir / "exitcode.txt");
+                        if(!ec_file || !ec_file->is_open())
+                        {
+                            ec = cis1::error_code::cant_open_build_exit_code_file;
+
+                            return;
+                        }
+
+                        ec_file->ostream() << exit << std::endl;
+
+                        auto record = pending_records_[build_number];
+                        record.state = exit == 0
+                                ? build_state::successful
+                                : build_state::broken;
+                        record.exit_code = exit;
+                        record.finished = unix_time_now();
+
+                        std::error_code index_ec;
+                        append_build_record(
+                                build_dir.parent_path(),
+                                record,
+                                index_ec,
+                                os_);
+                        if(index_ec)
+                        {
+                            on_index_error(build_dir.parent_path(), index_ec, os_);
+                        }
+
+                        stats = runner->stats();
+                        if(!stats)
+                        {
+                            return;
+                        }
+
+                        if(auto it = queues_.find(build_number); it != queues_.end())
+                        {
+                            stats->queue_wait = it->second->wait_time();
+                        }
+
+                        auto stats_file = os_.open_ofstream(build_dir / "stats.txt");
+                        if(!stats_file || !stats_file->is_open())
+                        {
+                            // stats are auxiliary, build result stands
+                            std::error_code stats_ec
+                                    = cis1::error_code::cant_write_build_stats_file;
+
+                            CIS_LOG(actions::error, "%s", stats_ec.message());
+
+                            return;
+                        }
+
+                        write_build_stats(stats_file->ostream(), stats.value());
+                    }();
+
+                    if(cgroup)
+                    {
+                        remove_build_cgroup(io_ctx, cgroup.value(), os_);
+                    }
 
-                        return;
+                    if(auto it = queues_.find(build_number); it != queues_.end())
+                    {
+                        // queue may be on the call stack
+                        it->second->release();
+                        boost::asio::post(
+                                io_ctx,
+                                [this, build_number]()
+                                {
+                                    queues_.erase(build_number);
+                                });
                     }
 
-                    ec_file->ostream() << exit << std::endl;
-                }
-            },
-            [&](const std::string& str)
-            {
-                output->ostream() << str << std::endl;
-            },
-            [&](const std::string& str)
-            {
-                output->ostream() << str << std::endl;
-            });
+                    pending_records_.erase(build_number);
 
-    io_ctx.run();
+                    if(ec
+                        && ec != cis1::error_code::cant_open_build_exit_code_file)
+                    {
+                        ec = cis1::error_code::cant_execute_script;
+                    }
 
-    if(ec
-        && ec != cis1::error_code::cant_open_build_exit_code_file)
-    {
-        ec = cis1::error_code::cant_execute_script;
-    }
+                    auto node = pending_builds_.extract(build_number);
+
+                    if(exit_code == 0)
+                    {
+                        successful_builds_.insert(std::move(node));
+                    }
+                    else
+                    {
+                        broken_builds_.insert(std::move(node));
+                    }
 
-    auto node = pending_builds_.extract(build_number);
+                    on_finish(ec, exit_code, stats);
+                },
+                [output, newline_cb](const std::string& str)
+                {
+                    output->ostream() << str << std::endl;
 
-    if(exit_code == 0)
-    {
-        successful_builds_.insert(std::move(node));
-    }
-    else
+                    if(newline_cb)
+                    {
+                        newline_cb(false, str);
+                    }
+                },
+                [output, newline_cb](const std::string& str)
+                {
+                    output->ostream() << str << std::endl;
+
+                    if(newline_cb)
+                    {
+                        newline_cb(true, str);
+                    }
+                });
+    };
+
+    if(slot_limits.empty())
     {
-        broken_builds_.insert(std::move(node));
+        start();
+
+        return runner;
     }
+
+    auto queue = std::make_shared<build_queue>(
+            io_ctx,
+            std::move(slot_limits),
+            os_);
+    queues_[build_number] = queue;
+
+    queue->async_acquire(
+            [this,
+             &io_ctx,
+             start,
+             cgroup = options.cgroup,
+             on_finish](std::error_code err)
+            {
+                if(!err)
+                {
+                    start();
+
+                    return;
+                }
+
+                if(cgroup)
+                {
+                    remove_build_cgroup(io_ctx, cgroup.value(), os_);
+                }
+
+                on_finish(err, -1, std::nullopt);
+            });
+
+    return runner;
 }
 
 job::build_handle job::prepare_build(
@@ -230,16 +652,28 @@ job::build_handle job::prepare_build(
 {
     int max_build_num = -1;
 
-    for(auto& entry : os_.list_directory(ctx.base_dir() / "jobs" / name_))
-    {
-        if(entry->is_directory() && is_build(entry->path().filename().string()))
-        {
-            int build_num = std::stoi(entry->path().filename().string());
-            if(build_num > max_build_num)
+    os_.iterate_directory(
+            ctx.base_dir() / "jobs" / name_,
+            [&](const dir_entry& entry)
             {
-                max_build_num = build_num;
-            }
-        }
+                if(entry.type == dir_entry_type::directory
+                && is_build(entry.name))
+                {
+                    int build_num = build_number(entry.name);
+                    if(build_num > max_build_num)
+                    {
+                        max_build_num = build_num;
+                    }
+                }
+
+                return true;
+            },
+            ec);
+    if(ec)
+    {
+        ec = cis1::error_code::cant_generate_build_num;
+
+        return {*this, std::nullopt};
     }
 
     ++max_build_num;
@@ -302,10 +736,29 @@ job::build_handle job::prepare_build(
         return {*this, std::nullopt};
     }
 
-    os->ostream() << session.session_id() << std::endl;
+    const auto& session_id = session.session_id();
+
+    os->ostream() << session_id << std::endl;
 
     pending_builds_.emplace(max_build_num, build_dir);
 
+    build_record record;
+    record.job = name_;
+    record.number = max_build_num;
+    record.state = build_state::pending;
+    record.started = unix_time_now();
+    record.session_id = session_id;
+
+    // index is best effort, query falls back to build dirs
+    std::error_code index_ec;
+    append_build_record(build_dir.parent_path(), record, index_ec, os_);
+    if(index_ec)
+    {
+        on_index_error(build_dir.parent_path(), index_ec, os_);
+    }
+
+    pending_records_.emplace(max_build_num, std::move(record));
+
     return {*this, max_build_num};
 }
 
@@ -360,6 +813,54 @@ std::optional<job> load_job(
         return std::nullopt;
     }
 
+    std::optional<uint32_t> timeout = 0;
+    if(conf.count("timeout"))
+    {
+        timeout = u32_from_string(conf["timeout"]);
+        if(!timeout)
+        {
+            ec = error_code::cant_read_job_conf_file;
+
+            return std::nullopt;
+        }
+    }
+
+    std::optional<uint32_t> max_concurrent_builds = 0;
+    if(conf.count("max_concurrent_builds"))
+    {
+        max_concurrent_builds = u32_from_string(conf["max_concurrent_builds"]);
+        if(!max_concurrent_builds)
+        {
+            ec = error_code::cant_read_job_conf_file;
+
+            return std::nullopt;
+        }
+    }
+
+    std::optional<bool> export_params = false;
+    if(conf.count("export_params"))
+    {
+        export_params = bool_from_string(conf["export_params"]);
+        if(!export_params)
+        {
+            ec = error_code::cant_read_job_conf_file;
+
+            return std::nullopt;
+        }
+    }
+
+    std::optional<bool> export_session_values = false;
+    if(conf.count("export_session_values"))
+    {
+        export_session_values = bool_from_string(conf["export_session_values"]);
+        if(!export_session_values)
+        {
+            ec = error_code::cant_read_job_conf_file;
+
+            return std::nullopt;
+        }
+    }
+
     if(!os.exists(job_path / conf["script"], ec) || ec)
     {
         ec = error_code::script_doesnt_exist;
@@ -386,56 +887,76 @@ std::optional<job> load_job(
     std::map<uint32_t, std::filesystem::path> broken_builds;
     std::map<uint32_t, std::filesystem::path> pending_builds;
 
-    for(auto& entry_ptr : os.list_directory(job_path))
-    {
-        auto& entry = *entry_ptr;
-
-        if(is_build(entry.path().filename().string()))
-        {
-            auto exitcode = [&]() -> std::optional<uint32_t>
+    os.iterate_directory(
+            job_path,
+            [&](const dir_entry& entry)
             {
-                auto exitcode_file = os.open_ifstream(
-                        entry.path() / "exitcode.txt");
-
-                if(!exitcode_file)
+                if(!is_build(entry.name))
                 {
-                    return std::nullopt;
+                    return true;
                 }
 
-                std::string exitcode_str;
+                auto build_path = job_path / entry.name;
 
-                std::getline(exitcode_file->istream(), exitcode_str);
+                auto exitcode = [&]() -> std::optional<uint32_t>
+                {
+                    auto exitcode_file = os.open_ifstream(
+                            build_path / "exitcode.txt");
 
-                return u32_from_string(exitcode_str);
-            }();
+                    if(!exitcode_file)
+                    {
+                        return std::nullopt;
+                    }
 
-            auto build_num = stoul(entry.path().filename().string());
+                    std::string exitcode_str;
 
-            if(!exitcode)
-            {
-                pending_builds.emplace(build_num, entry.path());
+                    std::getline(exitcode_file->istream(), exitcode_str);
 
-                continue;
-            }
+                    return u32_from_string(exitcode_str);
+                }();
 
-            if(*exitcode == 0)
-            {
-                successful_builds.emplace(build_num, entry.path());
-            }
-            else
-            {
-                broken_builds.emplace(build_num, entry.path());
-            }
-        }
+                auto build_num = build_number(entry.name);
+
+                if(!exitcode)
+                {
+                    pending_builds.emplace(build_num, build_path);
+                }
+                else if(*exitcode == 0)
+                {
+                    successful_builds.emplace(build_num, build_path);
+                }
+                else
+                {
+                    broken_builds.emplace(build_num, build_path);
+                }
+
+                return true;
+            },
+            ec);
+    if(ec)
+    {
+        ec = error_code::cant_read_job_dir;
+
+        return std::nullopt;
     }
 
+    cgroup_limits limits;
+    limits.cpu_max = conf["cpu_max"];
+    limits.memory_max = conf["memory_max"];
+    limits.io_max = conf["io_max"];
+
     return job{
         job_name,
         job::config{
             conf["script"],
             keep_successful_builds.value(),
             keep_broken_builds.value(),
-            job_params
+            job_params,
+            limits,
+            timeout.value(),
+            max_concurrent_builds.value(),
+            export_params.value(),
+            export_session_values.value()
         },
         successful_builds,
         broken_builds,
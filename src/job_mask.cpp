@@ -0,0 +1,123 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "job_mask.h"
+
+#include <cctype>
+#include <cstring>
+
+namespace cis1
+{
+
+/**
+ * Splits mask into literal segments separated by ".*"
+ * \return false if mask has other regex constructs
+ */
+bool split_wildcard_mask(
+        const std::string& mask,
+        std::vector<std::string>& segments)
+{
+    segments.assign(1, {});
+
+    for(size_t i = 0; i < mask.size(); ++i)
+    {
+        char c = mask[i];
+
+        if(c == '.' && i + 1 < mask.size() && mask[i + 1] == '*')
+        {
+            segments.emplace_back();
+            ++i;
+        }
+        else if(c == '\\')
+        {
+            // Escaped punctuation is literal, "\d", "\w" etc. are classes
+            if(i + 1 == mask.size()
+            || std::isalnum(static_cast<unsigned char>(mask[i + 1])))
+            {
+                return false;
+            }
+
+            segments.back() += mask[++i];
+        }
+        else if(std::strchr("^$.|?*+()[]{}", c) != nullptr)
+        {
+            return false;
+        }
+        else
+        {
+            segments.back() += c;
+        }
+    }
+
+    return true;
+}
+
+std::optional<job_mask> job_mask::compile(const std::string& mask)
+{
+    job_mask result;
+
+    if(split_wildcard_mask(mask, result.segments_))
+    {
+        return result;
+    }
+
+    result.segments_.clear();
+
+    try
+    {
+        result.regex_.emplace(mask);
+    }
+    catch(const std::regex_error&)
+    {
+        return std::nullopt;
+    }
+
+    return result;
+}
+
+bool job_mask::matches(std::string_view name) const
+{
+    if(regex_)
+    {
+        return std::regex_match(name.begin(), name.end(), regex_.value());
+    }
+
+    auto& first = segments_.front();
+
+    if(segments_.size() == 1)
+    {
+        return name == first;
+    }
+
+    auto& last = segments_.back();
+
+    if(name.size() < first.size() + last.size()
+    || name.substr(0, first.size()) != first
+    || name.substr(name.size() - last.size()) != last)
+    {
+        return false;
+    }
+
+    // Leftmost placement of middle segments is always optimal
+    auto rest = name.substr(first.size(), name.size() - first.size() - last.size());
+
+    for(size_t i = 1; i + 1 < segments_.size(); ++i)
+    {
+        auto pos = rest.find(segments_[i]);
+        if(pos == std::string_view::npos)
+        {
+            return false;
+        }
+
+        rest.remove_prefix(pos + segments_[i].size());
+    }
+
+    return true;
+}
+
+} // namespace cis1
@@ -9,6 +9,7 @@
 #include "job_runner.h"
 
 #include <functional>
+#include <utility>
 #include <vector>
 
 #include <boost/process/async_system.hpp>
@@ -19,20 +20,35 @@
 #include <boost/bind.hpp>
 #include <boost/asio/placeholders.hpp>
 
+#include "cgroup.h"
+
+#ifdef __linux__
+#include <signal.h>
+#endif
+
 namespace cis1
 {
 
+std::atomic<size_t> job_runner::running_{0};
+std::atomic<size_t> job_runner::started_{0};
+
 job_runner::job_runner(
         boost::asio::io_context& ctx,
-        boost::process::environment env,
+        const environment& env,
         const std::filesystem::path& working_dir,
+        const run_options& options,
         const os_interface& os)
     : ctx_(ctx)
     , out_pipe_(ctx)
     , err_pipe_(ctx)
     , env_(env)
     , working_dir_(working_dir)
+    , options_(options)
     , os_(os)
+    , timeout_timer_(ctx)
+    , kill_timer_(ctx)
+    , group_timer_(ctx)
+    , signals_(ctx)
 {}
 
 void job_runner::run(
@@ -48,6 +64,196 @@ void job_runner::run(
             std::move(on_err_line_read_cb));
 }
 
+std::optional<build_stats> job_runner::stats() const
+{
+    return stats_;
+}
+
+void job_runner::on_spawn(int pid)
+{
+    pgid_ = pid;
+
+    if(options_.timeout.count() > 0)
+    {
+        timeout_timer_.expires_after(options_.timeout);
+        timeout_timer_.async_wait(
+                [this](const boost::system::error_code& ec)
+                {
+                    if(!ec)
+                    {
+                        terminate(true);
+                    }
+                });
+    }
+
+#ifdef __linux__
+    // Pass termination request to the job instead of dying
+    // and leaving its process tree behind
+    signals_.add(SIGTERM);
+    signals_.add(SIGINT);
+    signals_.add(SIGHUP);
+    signals_.async_wait(
+            [this](const boost::system::error_code& ec, int)
+            {
+                if(!ec)
+                {
+                    terminate(false);
+                }
+            });
+#endif
+}
+
+void job_runner::terminate(bool timed_out)
+{
+    if(terminating_)
+    {
+        return;
+    }
+
+    terminating_ = true;
+    timed_out_ = timed_out;
+
+#ifdef __linux__
+    ::kill(-pgid_, SIGTERM);
+#endif
+
+    kill_timer_.expires_after(options_.kill_grace);
+    kill_timer_.async_wait(
+            [this](const boost::system::error_code& ec)
+            {
+                if(!ec)
+                {
+                    kill_process_group();
+                }
+            });
+}
+
+void job_runner::kill_process_group()
+{
+    if(options_.cgroup)
+    {
+        // Also catches processes which left the process group
+        if(auto kill_file = os_.open_ofstream(
+                    options_.cgroup.value() / "cgroup.kill");
+                kill_file && kill_file->is_open())
+        {
+            kill_file->ostream() << "1" << std::flush;
+        }
+    }
+
+#ifdef __linux__
+    ::kill(-pgid_, SIGKILL);
+#endif
+
+    // Don't wait for processes which ignore SIGKILL (e.g. in D state)
+    if(on_group_exit_)
+    {
+        group_timer_.cancel();
+
+        std::exchange(on_group_exit_, nullptr)();
+    }
+}
+
+void job_runner::wait_group_exit()
+{
+#ifdef __linux__
+    // Don't wait for the whole grace period if group exits earlier
+    group_timer_.expires_after(std::chrono::milliseconds{50});
+    group_timer_.async_wait(
+            [this](const boost::system::error_code& ec)
+            {
+                if(ec)
+                {
+                    return;
+                }
+
+                if(::kill(-pgid_, 0) != 0)
+                {
+                    kill_timer_.cancel();
+
+                    if(on_group_exit_)
+                    {
+                        std::exchange(on_group_exit_, nullptr)();
+                    }
+
+                    return;
+                }
+
+                wait_group_exit();
+            });
+#endif
+}
+
+void job_runner::on_exit(
+        std::error_code err,
+        int exit_code,
+        const on_exit_cb_t& on_exit_cb)
+{
+    timeout_timer_.cancel();
+    signals_.cancel();
+
+    if(timed_out_)
+    {
+        // Same as coreutils timeout(1)
+        exit_code = 124;
+    }
+
+    // The child is already waited for here, so it is accounted
+    // in RUSAGE_CHILDREN together with waited-for grandchildren.
+    const auto usage = children_usage();
+
+    stats_ = usage_delta(start_usage_, usage);
+    stats_->wall_time = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_time_);
+
+    --running_;
+    if(overlapped_ || started_ != start_index_ + 1)
+    {
+        // RUSAGE_CHILDREN is process-wide
+        stats_->accounting = "rusage_shared";
+    }
+
+    // RUSAGE_CHILDREN peak is kept for process lifetime, so peak which
+    // didn't grow belongs to earlier build
+    if(start_index_ != 0 && usage.max_rss_kb <= start_usage_.max_rss_kb)
+    {
+        stats_->max_rss_kb = 0;
+        stats_->accounting = "rusage_shared";
+    }
+
+    on_group_exit_ = [this, err, exit_code, on_exit_cb]()
+    {
+        if(options_.cgroup)
+        {
+            read_cgroup_stats(options_.cgroup.value(), stats_.value(), os_);
+        }
+
+        stats_->timed_out = timed_out_;
+
+        if(on_exit_cb)
+        {
+            on_exit_cb(err, exit_code);
+        }
+    };
+
+#ifdef __linux__
+    // Leftover group members (e.g. background jobs) would keep
+    // output pipes open forever, so they are terminated too.
+    // Build is finished when its whole group is gone.
+    if(pgid_ > 0 && ::kill(-pgid_, 0) == 0)
+    {
+        terminate(timed_out_);
+        wait_group_exit();
+
+        return;
+    }
+
+    kill_timer_.cancel();
+#endif
+
+    std::exchange(on_group_exit_, nullptr)();
+}
+
 std::string make_string(boost::asio::streambuf& streambuf, size_t size)
 {
     return {buffers_begin(streambuf.data()),
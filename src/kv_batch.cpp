@@ -0,0 +1,193 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "kv_batch.h"
+
+#include <cctype>
+
+namespace cis1
+{
+
+std::optional<kv_get_args> parse_kv_get_args(
+        const std::vector<std::string>& args)
+{
+    kv_get_args result;
+
+    bool format_set = false;
+
+    for(auto& arg : args)
+    {
+        if(arg == "--all")
+        {
+            result.all = true;
+        }
+        else if(arg == "--shell" || arg == "--null")
+        {
+            if(format_set)
+            {
+                return std::nullopt;
+            }
+
+            result.format = arg == "--shell"
+                    ? kv_output_format::shell
+                    : kv_output_format::null;
+            format_set = true;
+        }
+        else
+        {
+            result.names.push_back(arg);
+        }
+    }
+
+    if(result.all == !result.names.empty())
+    {
+        return std::nullopt;
+    }
+
+    if(result.all && !format_set)
+    {
+        result.format = kv_output_format::shell;
+    }
+
+    return result;
+}
+
+std::optional<kv_list> parse_kv_set_args(
+        const std::vector<std::string>& args)
+{
+    if(args.empty() || args.size() % 2 != 0)
+    {
+        return std::nullopt;
+    }
+
+    kv_list result;
+    result.reserve(args.size() / 2);
+
+    for(size_t i = 0; i < args.size(); i += 2)
+    {
+        result.emplace_back(args[i], args[i + 1]);
+    }
+
+    return result;
+}
+
+kv_list select_kv(
+        const kv_get_args& args,
+        const std::map<std::string, std::string>& values)
+{
+    if(args.all)
+    {
+        return {values.begin(), values.end()};
+    }
+
+    kv_list result;
+    result.reserve(args.names.size());
+
+    for(auto& name : args.names)
+    {
+        auto it = values.find(name);
+
+        result.emplace_back(name, it != values.end() ? it->second : "");
+    }
+
+    return result;
+}
+
+std::string shell_quote(const std::string& str)
+{
+    std::string quoted = "'";
+
+    for(char c : str)
+    {
+        if(c == '\'')
+        {
+            quoted += R"('\'')";
+        }
+        else
+        {
+            quoted += c;
+        }
+    }
+
+    quoted += '\'';
+
+    return quoted;
+}
+
+bool is_shell_identifier(const std::string& name)
+{
+    if(name.empty() || std::isdigit(static_cast<unsigned char>(name[0])))
+    {
+        return false;
+    }
+
+    for(unsigned char c : name)
+    {
+        if(!std::isalnum(c) && c != '_')
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+size_t print_kv(
+        std::ostream& os,
+        const kv_list& kv,
+        kv_output_format format)
+{
+    size_t skipped = 0;
+
+    for(auto& [name, value] : kv)
+    {
+        switch(format)
+        {
+            case kv_output_format::lines:
+                os << value << '\n';
+                break;
+
+            case kv_output_format::shell:
+                if(!is_shell_identifier(name))
+                {
+                    ++skipped;
+                    break;
+                }
+
+                os << name << '=' << shell_quote(value) << '\n';
+                break;
+
+            case kv_output_format::null:
+                os << name << '\0' << value << '\0';
+                break;
+        }
+    }
+
+    os.flush();
+
+    return skipped;
+}
+
+std::string format_kv_record(const kv_list& kv)
+{
+    std::string record;
+
+    for(auto& [name, value] : kv)
+    {
+        if(!record.empty())
+        {
+            record += ' ';
+        }
+
+        record += '"' + name + "\"=\"" + value + '"';
+    }
+
+    return record;
+}
+
+} // namespace cis1
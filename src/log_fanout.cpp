@@ -0,0 +1,217 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "log_fanout.h"
+
+namespace cis1
+{
+
+namespace
+{
+
+size_t sink_index(log_sink sink)
+{
+    size_t index = 0;
+
+    for(auto flag = static_cast<uint8_t>(sink); flag > 1; flag >>= 1)
+    {
+        ++index;
+    }
+
+    return index;
+}
+
+} // namespace
+
+async_log_writer::async_log_writer()
+    : thread_([this](){ run(); })
+{}
+
+async_log_writer::~async_log_writer()
+{
+    flush();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+
+    cv_.notify_all();
+    thread_.join();
+}
+
+void async_log_writer::post(log_record_ptr record, log_recorder_ptr recorder)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.emplace_back(std::move(record), std::move(recorder));
+    }
+
+    cv_.notify_all();
+}
+
+void async_log_writer::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    cv_.wait(
+            lock,
+            [this]()
+            {
+                return queue_.empty() && !busy_;
+            });
+}
+
+void async_log_writer::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    for(;;)
+    {
+        cv_.wait(
+                lock,
+                [this]()
+                {
+                    return stop_ || !queue_.empty();
+                });
+
+        if(queue_.empty())
+        {
+            return;
+        }
+
+        // records queued while the previous batch was written
+        // are written at once
+        auto batch = std::move(queue_);
+        queue_.clear();
+        busy_ = true;
+
+        lock.unlock();
+
+        for(auto& [record, recorder] : batch)
+        {
+            recorder->OnRecord(*record);
+        }
+
+        batch.clear();
+
+        lock.lock();
+        busy_ = false;
+
+        cv_.notify_all();
+    }
+}
+
+void log_fanout::set_sink(
+        log_sink sink,
+        log_recorder_ptr recorder,
+        bool async)
+{
+    if(async && !writer_)
+    {
+        writer_ = std::make_unique<async_log_writer>();
+    }
+
+    sinks_[sink_index(sink)] = {std::move(recorder), async};
+}
+
+bool log_fanout::has_sinks(uint8_t sinks) const
+{
+    for(size_t i = 0; i < sinks_count; ++i)
+    {
+        if((sinks & (1 << i)) && sinks_[i].recorder)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void log_fanout::dispatch(
+        const core_logger::CoreRecord& record,
+        uint8_t sinks)
+{
+    log_record_ptr shared_record;
+
+    for(size_t i = 0; i < sinks_count; ++i)
+    {
+        auto& sink = sinks_[i];
+
+        if(!(sinks & (1 << i)) || !sink.recorder)
+        {
+            continue;
+        }
+
+        if(!sink.async)
+        {
+            sink.recorder->OnRecord(record);
+
+            continue;
+        }
+
+        // single copy is shared by all async sinks
+        if(!shared_record)
+        {
+            shared_record = std::make_shared<const core_logger::CoreRecord>(record);
+        }
+
+        writer_->post(shared_record, sink.recorder);
+    }
+}
+
+void log_fanout::flush()
+{
+    if(writer_)
+    {
+        writer_->flush();
+    }
+}
+
+void log_fanout::reset()
+{
+    writer_.reset();
+
+    for(auto& sink : sinks_)
+    {
+        sink = {};
+    }
+}
+
+fanout_recorder::fanout_recorder(log_fanout& fanout, uint8_t sinks)
+    : fanout_(fanout)
+    , sinks_(sinks)
+{}
+
+void fanout_recorder::OnRecord(const core_logger::CoreRecord& record)
+{
+    fanout_.dispatch(record, sinks_);
+}
+
+daily_recorder::daily_recorder(log_recorder_ptr recorder, factory_t factory)
+    : recorder_(std::move(recorder))
+    , factory_(std::move(factory))
+{}
+
+void daily_recorder::OnRecord(const core_logger::CoreRecord& record)
+{
+    if(day_.changed())
+    {
+        if(auto recorder = factory_(); recorder)
+        {
+            recorder_ = std::move(recorder);
+        }
+    }
+
+    if(recorder_)
+    {
+        recorder_->OnRecord(record);
+    }
+}
+
+} // namespace cis1
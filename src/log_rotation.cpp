@@ -0,0 +1,649 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "log_rotation.h"
+
+#include <algorithm>
+#include <charconv>
+#include <map>
+#include <string_view>
+
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include "error_code.h"
+#include "session_gc.h"
+#include "utils.h"
+
+namespace cis1
+{
+
+namespace
+{
+
+std::tm local_time(std::time_t time)
+{
+    std::tm tm{};
+#ifdef _WIN32
+    localtime_s(&tm, &time);
+#else
+    localtime_r(&time, &tm);
+#endif
+
+    return tm;
+}
+
+/// "YYYY-MM-DD" in local time
+std::string local_date(std::time_t time)
+{
+    auto tm = local_time(time);
+
+    char date[16];
+    std::strftime(date, sizeof(date), "%Y-%m-%d", &tm);
+
+    return date;
+}
+
+bool is_date(std::string_view str)
+{
+    if(str.size() != 10 || str[4] != '-' || str[7] != '-')
+    {
+        return false;
+    }
+
+    for(size_t i : {0, 1, 2, 3, 5, 6, 8, 9})
+    {
+        if(str[i] < '0' || str[i] > '9')
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Checks name is "cis.YYYY-MM-DD.${n}.log" or "cis.YYYY-MM-DD.${n}.log.gz"
+bool is_cis_segment(const std::string& name)
+{
+    std::string_view stem = name;
+
+    if(ends_with(name, ".log.gz"))
+    {
+        stem.remove_suffix(7);
+    }
+    else if(ends_with(name, ".log"))
+    {
+        stem.remove_suffix(4);
+    }
+    else
+    {
+        return false;
+    }
+
+    const std::string_view prefix = "cis.";
+
+    if(stem.size() < prefix.size() + 12
+    || stem.substr(0, prefix.size()) != prefix
+    || !is_date(stem.substr(prefix.size(), 10))
+    || stem[prefix.size() + 10] != '.')
+    {
+        return false;
+    }
+
+    uint32_t number;
+    auto number_str = stem.substr(prefix.size() + 11);
+    auto [end, err] = std::from_chars(
+            number_str.data(),
+            number_str.data() + number_str.size(),
+            number);
+
+    return err == std::errc{} && end == number_str.data() + number_str.size();
+}
+
+/// Parses "10485760", "512K", "10M" or "1G"
+std::optional<size_t> size_from_string(const std::string& str)
+{
+    size_t value = 0;
+
+    auto [end, err] = std::from_chars(str.data(), str.data() + str.size(), value);
+    if(err != std::errc{} || str.empty())
+    {
+        return std::nullopt;
+    }
+
+    std::string_view suffix(end, str.data() + str.size() - end);
+
+    if(suffix.empty())
+    {
+        return value;
+    }
+    if(suffix == "K")
+    {
+        return value << 10;
+    }
+    if(suffix == "M")
+    {
+        return value << 20;
+    }
+    if(suffix == "G")
+    {
+        return value << 30;
+    }
+
+    return std::nullopt;
+}
+
+} // namespace
+
+log_rotation_options load_log_rotation_options(const environment& env)
+{
+    log_rotation_options options;
+
+    options.size_limit = size_from_string(env.get("log_size_limit"));
+
+    if(auto keep = u32_from_string(env.get("log_keep_segments")); keep)
+    {
+        options.keep_segments = keep.value();
+    }
+
+    if(auto seconds = u32_from_string(env.get("log_compress_after")); seconds)
+    {
+        options.compress_after = std::chrono::seconds{seconds.value()};
+    }
+
+    return options;
+}
+
+std::string dated_log_name(
+        const std::string& prefix,
+        const std::string& suffix)
+{
+    return prefix + "." + local_date(std::time(nullptr)) + suffix;
+}
+
+log_day::log_day(std::time_t now)
+    : next_day_(0)
+{
+    changed(now);
+}
+
+bool log_day::changed(std::time_t now)
+{
+    if(now < next_day_)
+    {
+        return false;
+    }
+
+    auto tm = local_time(now);
+    tm.tm_hour = 0;
+    tm.tm_min = 0;
+    tm.tm_sec = 0;
+    tm.tm_mday += 1;
+    tm.tm_isdst = -1;
+
+    next_day_ = std::mktime(&tm);
+
+    return true;
+}
+
+std::vector<std::filesystem::path> find_rotated_logs(
+        const std::filesystem::path& dir,
+        std::chrono::seconds compress_after,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    struct segment
+    {
+        uint32_t number;
+        std::filesystem::path path;
+        std::filesystem::file_time_type modified;
+    };
+
+    std::map<std::string, std::vector<segment>> series;
+
+    std::vector<std::string> names;
+
+    os.iterate_directory(
+            dir,
+            [&](const dir_entry& entry)
+            {
+                if(entry.type == dir_entry_type::regular)
+                {
+                    names.emplace_back(entry.name);
+                }
+
+                return true;
+            },
+            ec);
+    if(ec)
+    {
+        ec = cis1::error_code::cant_read_logs_dir;
+
+        return {};
+    }
+
+    for(auto& name : names)
+    {
+        if(!ends_with(name, ".log"))
+        {
+            continue;
+        }
+
+        auto stem = name.substr(0, name.size() - 4);
+        auto dot = stem.rfind('.');
+        if(dot == std::string::npos)
+        {
+            continue;
+        }
+
+        uint32_t number;
+        auto [end, err] = std::from_chars(
+                stem.data() + dot + 1,
+                stem.data() + stem.size(),
+                number);
+        if(err != std::errc{} || end != stem.data() + stem.size())
+        {
+            continue;
+        }
+
+        std::error_code time_ec;
+        auto modified = os.last_write_time(dir / name, time_ec);
+        if(time_ec)
+        {
+            continue;
+        }
+
+        series[stem.substr(0, dot)].push_back({number, dir / name, modified});
+    }
+
+    auto modified_before = std::filesystem::file_time_type::clock::now()
+            - compress_after;
+
+    const auto today = local_date(std::time(nullptr));
+
+    std::vector<std::filesystem::path> rotated;
+
+    for(auto& [name, segments] : series)
+    {
+        // past day series isn't written anymore
+        auto dot = name.rfind('.');
+        auto date = std::string_view(name).substr(dot == std::string::npos ? 0 : dot + 1);
+
+        bool past_day = dot != std::string::npos && is_date(date) && date != today;
+
+        auto newest = std::max_element(
+                segments.begin(),
+                segments.end(),
+                [](const segment& lhs, const segment& rhs)
+                {
+                    return lhs.number < rhs.number;
+                })->number;
+
+        for(auto& s : segments)
+        {
+            if((past_day || s.number < newest) && s.modified <= modified_before)
+            {
+                rotated.push_back(s.path);
+            }
+        }
+    }
+
+    std::sort(rotated.begin(), rotated.end());
+
+    return rotated;
+}
+
+std::vector<std::filesystem::path> find_rotated_session_logs(
+        const std::filesystem::path& sessions_dir,
+        const std::string& session_id,
+        std::chrono::seconds compress_after,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    auto modified_before = std::filesystem::file_time_type::clock::now()
+            - compress_after;
+
+    std::vector<std::filesystem::path> rotated;
+    std::optional<std::filesystem::path> newest;
+
+    for(uint32_t n = 0; ; ++n)
+    {
+        auto path = sessions_dir / (session_id + "." + std::to_string(n) + ".log");
+
+        auto gz_path = path;
+        gz_path += ".gz";
+
+        bool log = os.exists(path, ec);
+        bool gz = !ec && !log && os.exists(gz_path, ec);
+        if(ec)
+        {
+            ec = cis1::error_code::cant_read_logs_dir;
+
+            return {};
+        }
+
+        if(!log && !gz)
+        {
+            break;
+        }
+
+        // segment which is followed by another one isn't written anymore
+        if(newest)
+        {
+            std::error_code time_ec;
+            auto modified = os.last_write_time(newest.value(), time_ec);
+            if(!time_ec && modified <= modified_before)
+            {
+                rotated.push_back(std::move(newest.value()));
+            }
+        }
+
+        newest.reset();
+        if(log)
+        {
+            newest = std::move(path);
+        }
+    }
+
+    return rotated;
+}
+
+void compress_log(
+        const std::filesystem::path& path,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    auto modified = os.last_write_time(path, ec);
+    if(ec)
+    {
+        ec = cis1::error_code::cant_compress_log;
+
+        return;
+    }
+
+    auto gz_path = path;
+    gz_path += ".gz";
+
+    auto tmp_path = tmp_file_path(gz_path);
+
+    {
+        auto in = os.open_ifstream(path, std::ios_base::in | std::ios_base::binary);
+        auto file = os.open_ofstream(
+                tmp_path,
+                std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+        if(!in || !in->is_open() || !file || !file->is_open())
+        {
+            ec = cis1::error_code::cant_compress_log;
+        }
+        else
+        {
+            try
+            {
+                boost::iostreams::filtering_ostream out;
+                out.push(boost::iostreams::gzip_compressor());
+                out.push(file->ostream());
+
+                // closes the chain, so gzip trailer is written
+                boost::iostreams::copy(in->istream(), out);
+
+                if(!file->ostream().flush())
+                {
+                    ec = cis1::error_code::cant_compress_log;
+                }
+            }
+            catch(const std::exception&)
+            {
+                ec = cis1::error_code::cant_compress_log;
+            }
+        }
+    }
+
+    // retention sorts segments by modification time
+    if(!ec)
+    {
+        os.set_last_write_time(tmp_path, modified, ec);
+    }
+
+    if(!ec)
+    {
+        os.rename(tmp_path, gz_path, ec);
+    }
+
+    if(ec)
+    {
+        std::error_code remove_ec;
+        os.remove(tmp_path, remove_ec);
+
+        ec = cis1::error_code::cant_compress_log;
+
+        return;
+    }
+
+    os.remove(path, ec);
+    if(ec)
+    {
+        ec = cis1::error_code::cant_compress_log;
+    }
+}
+
+size_t apply_log_retention(
+        const std::filesystem::path& logs_dir,
+        size_t keep_segments,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    if(keep_segments == 0)
+    {
+        return 0;
+    }
+
+    std::vector<std::string> names;
+
+    os.iterate_directory(
+            logs_dir,
+            [&](const dir_entry& entry)
+            {
+                std::string name{entry.name};
+
+                // binary logs and other files aren't segments
+                if(entry.type == dir_entry_type::regular && is_cis_segment(name))
+                {
+                    names.push_back(std::move(name));
+                }
+
+                return true;
+            },
+            ec);
+    if(ec)
+    {
+        ec = cis1::error_code::cant_read_logs_dir;
+
+        return 0;
+    }
+
+    std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> segments;
+
+    for(auto& name : names)
+    {
+        std::error_code time_ec;
+        auto modified = os.last_write_time(logs_dir / name, time_ec);
+        if(!time_ec)
+        {
+            segments.emplace_back(modified, logs_dir / name);
+        }
+    }
+
+    if(segments.size() <= keep_segments)
+    {
+        return 0;
+    }
+
+    std::nth_element(
+            segments.begin(),
+            segments.begin() + keep_segments,
+            segments.end(),
+            std::greater<>{});
+
+    size_t removed = 0;
+
+    for(auto it = segments.begin() + keep_segments; it != segments.end(); ++it)
+    {
+        std::error_code remove_ec;
+        os.remove(it->second, remove_ec);
+        if(!remove_ec)
+        {
+            ++removed;
+        }
+    }
+
+    return removed;
+}
+
+void update_session_index(
+        const std::filesystem::path& base_dir,
+        const std::string& session_id,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    auto sessions_dir = base_dir / "sessions";
+    auto index_name = session_id + ".index";
+
+    // sessions dir may have millions of files, so it isn't listed
+    auto files = find_session_files(sessions_dir, session_id, ec, os);
+    if(ec)
+    {
+        ec = cis1::error_code::cant_write_session_index;
+
+        return;
+    }
+
+    std::sort(files.begin(), files.end());
+
+    auto index_path = sessions_dir / index_name;
+    auto tmp_path = tmp_file_path(index_path);
+
+    {
+        auto index = os.open_ofstream(tmp_path, std::ios_base::out | std::ios_base::trunc);
+        if(!index || !index->is_open())
+        {
+            ec = cis1::error_code::cant_write_session_index;
+
+            return;
+        }
+
+        auto& out = index->ostream();
+
+        for(auto& file : files)
+        {
+            out << file << "\n";
+        }
+
+        if(!out.flush())
+        {
+            ec = cis1::error_code::cant_write_session_index;
+        }
+    }
+
+    if(!ec)
+    {
+        os.rename(tmp_path, index_path, ec);
+    }
+
+    if(ec)
+    {
+        std::error_code remove_ec;
+        os.remove(tmp_path, remove_ec);
+
+        ec = cis1::error_code::cant_write_session_index;
+    }
+}
+
+log_compressor::log_compressor(
+        const os_interface& os,
+        on_compressed_cb_t on_compressed)
+    : os_(os.clone())
+    , on_compressed_(std::move(on_compressed))
+    , thread_([this](){ run(); })
+{}
+
+log_compressor::~log_compressor()
+{
+    wait();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+
+    cv_.notify_all();
+    thread_.join();
+}
+
+void log_compressor::enqueue(std::filesystem::path path)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(path));
+    }
+
+    cv_.notify_all();
+}
+
+void log_compressor::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    cv_.wait(
+            lock,
+            [this]()
+            {
+                return queue_.empty() && !busy_;
+            });
+}
+
+void log_compressor::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    for(;;)
+    {
+        cv_.wait(
+                lock,
+                [this]()
+                {
+                    return stop_ || !queue_.empty();
+                });
+
+        if(queue_.empty())
+        {
+            return;
+        }
+
+        auto path = std::move(queue_.front());
+        queue_.pop_front();
+        busy_ = true;
+
+        lock.unlock();
+
+        std::error_code ec;
+        compress_log(path, ec, *os_);
+
+        if(on_compressed_)
+        {
+            on_compressed_(path, ec);
+        }
+
+        lock.lock();
+        busy_ = false;
+
+        cv_.notify_all();
+    }
+}
+
+} // namespace cis1
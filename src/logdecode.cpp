@@ -0,0 +1,69 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include <iostream>
+#include <fstream>
+
+#include "binary_log.h"
+#include "cis_version.h"
+
+void usage(const char* self_name)
+{
+    std::cout << "Usage: \n"
+              << "\t" << self_name << " ${binary_log_file} [${binary_log_file}...]\n"
+              << "Prints binary cis or session log (*.blog) as text" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc == 2 && strcmp(argv[1], "--version") == 0)
+    {
+        print_version();
+
+        return EXIT_SUCCESS;
+    }
+
+    if(argc < 2)
+    {
+        usage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    for(int i = 1; i < argc; ++i)
+    {
+        std::ifstream file(argv[i], std::ios_base::in | std::ios_base::binary);
+        if(!file.is_open())
+        {
+            std::cerr << "Cant open " << argv[i] << std::endl;
+
+            return EXIT_FAILURE;
+        }
+
+        std::error_code ec;
+
+        cis1::read_binary_log(
+                file,
+                [](const cis1::binary_log_entry& entry)
+                {
+                    std::cout << cis1::format_binary_log_entry(entry) << "\n";
+                },
+                ec);
+
+        if(ec)
+        {
+            std::cerr << argv[i] << ": " << ec.message() << std::endl;
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout << std::flush;
+
+    return EXIT_SUCCESS;
+}
@@ -16,15 +16,126 @@
 #include <cis1_cwu_protocol/protocol.h>
 #include <tpl_helpers/overloaded.h>
 
+#include "log_fanout.h"
+#include "log_rotation.h"
+
 using CoreRecord = cis1::core_logger::CoreRecord;
 using RecordersCont = scl::RecordersCont<CoreRecord>;
 using FileRecorder = scl::FileRecorder<CoreRecord>;
 using FileRecorderPtr = scl::FileRecorderPtr<CoreRecord>;
 
+log_level log_threshold = log_level::info;
+
+// declared before the loggers which dispatch records to it
+cis1::log_fanout log_sinks;
+
 LoggerPtr cis_logger;
 LoggerPtr session_logger;
 LoggerPtr webui_logger;
-LoggerPtr offline_webui_logger;
+LoggerPtr tee_logger;
+std::unique_ptr<cis1::binary_log_writer> cis_binary_logger;
+std::unique_ptr<cis1::binary_log_writer> session_binary_logger;
+
+namespace
+{
+
+// binary cis log is reopened for each new day, see cis_binary_log()
+std::filesystem::path cis_binary_log_dir;
+std::optional<CoreLogger::Options> cis_binary_log_options;
+cis1::log_day cis_binary_log_day;
+
+// CoreLogger levels used before log_level was introduced are kept,
+// so only debug records differ
+scl::Level to_scl_level(log_level level)
+{
+    return level == log_level::debug
+            ? scl::Level::Debug
+            : scl::Level::Action;
+}
+
+constexpr uint8_t webui_sinks
+        = cis1::log_sink::webui | cis1::log_sink::offline_webui;
+constexpr uint8_t cis_sinks = webui_sinks | cis1::log_sink::cis;
+constexpr uint8_t session_sinks = webui_sinks | cis1::log_sink::session;
+constexpr uint8_t tee_sinks = cis_sinks | cis1::log_sink::session;
+
+bool binary_log_format(const cis1::context_interface& ctx)
+{
+    return ctx.env().get("log_format") == "binary";
+}
+
+bool async_log_writer(const cis1::context_interface& ctx)
+{
+    return ctx.env().get("log_writer") == "async";
+}
+
+template <class OnError>
+cis1::log_recorder_ptr make_file_recorder(
+        const FileRecorder::Options& recorder_options,
+        const OnError& on_error)
+{
+    return std::visit(
+            meta::overloaded{
+                    [](FileRecorderPtr&& val)
+                    { return cis1::log_recorder_ptr{std::move(val)}; },
+                    [&on_error](const auto& error)
+                    {
+                        on_error(FileRecorder::ToStr(error));
+                        return cis1::log_recorder_ptr{};
+                    }
+            },
+            FileRecorder::Init(recorder_options)
+    );
+}
+
+/// Makes logger which builds record once and passes it to sinks
+template <class OnError>
+LoggerPtr make_fanout_logger(
+        const CoreLogger::Options& options,
+        uint8_t sinks,
+        const OnError& on_error)
+{
+    RecordersCont recorders;
+    recorders.push_back(std::make_unique<cis1::fanout_recorder>(log_sinks, sinks));
+
+    return std::visit(
+            meta::overloaded{
+                    [](LoggerPtr&& val)
+                    { return std::move(val); },
+                    [&on_error](const auto& error)
+                    {
+                        on_error(CoreLogger::ToStr(error));
+                        return LoggerPtr{};
+                    }
+            },
+            CoreLogger::Init(options, std::move(recorders))
+    );
+}
+
+std::unique_ptr<cis1::binary_log_writer> open_binary_log(
+        const std::filesystem::path& path,
+        const CoreLogger::Options& options,
+        std::string_view name)
+{
+    std::error_code ec;
+
+    auto writer = cis1::binary_log_writer::open(
+            path,
+            options.pid,
+            options.parent_pid,
+            options.session_id.value_or(""),
+            ec);
+    if(ec)
+    {
+        std::cerr << "Couldn't create a " << name << ": error = "
+                  << ec.message() << std::endl;
+        exit(1);
+    }
+
+    return writer;
+}
+
+} // namespace
 
 class webui_recorder : public scl::IRecorder<CoreRecord>
 {
@@ -67,13 +178,50 @@ private:
 };
 
 
+std::optional<log_level> log_level_from_string(const std::string& str)
+{
+    if(str == "debug")
+    {
+        return log_level::debug;
+    }
+    if(str == "info")
+    {
+        return log_level::info;
+    }
+    if(str == "warning")
+    {
+        return log_level::warning;
+    }
+    if(str == "error")
+    {
+        return log_level::error;
+    }
+    if(str == "action")
+    {
+        return log_level::action;
+    }
+
+    return std::nullopt;
+}
+
 CoreLogger::Options make_logger_options(
         const std::optional<std::string>& session_id,
         const cis1::context_interface& ctx,
         const cis1::os& std_os)
 {
+    auto level_name = ctx.env().get("cis_log_level");
+    if(level_name.empty())
+    {
+        level_name = ctx.env().get("log_level");
+    }
+
+    if(auto level = log_level_from_string(level_name); level)
+    {
+        log_threshold = level.value();
+    }
+
     CoreLogger::Options options;
-    // TODO set the value from env var
+    // records are filtered by log_threshold before they are formatted
     options.level = scl::Level::Debug;
     options.parent_pid = static_cast<scl::ProcessId>(ctx.parent_startjob_id());
     options.pid = static_cast<scl::ProcessId>(ctx.process_id());
@@ -81,32 +229,70 @@ CoreLogger::Options make_logger_options(
     return options;
 }
 
-void cis_log(actions act, const std::string& message)
+bool webui_log_enabled()
+{
+    return log_sinks.has_sinks(webui_sinks);
+}
+
+cis1::binary_log_writer* cis_binary_log()
 {
-    if(!cis_logger)
+    if(cis_binary_logger && cis_binary_log_options && cis_binary_log_day.changed())
     {
-        return;
+        auto& options = cis_binary_log_options.value();
+
+        std::error_code ec;
+
+        auto writer = cis1::binary_log_writer::open(
+                cis_binary_log_dir / cis1::dated_log_name("cis", ".blog"),
+                options.pid,
+                options.parent_pid,
+                options.session_id.value_or(""),
+                ec);
+        if(writer)
+        {
+            cis_binary_logger = std::move(writer);
+        }
+        else
+        {
+            // records are kept in the log of previous day
+            std::cerr << "Couldn't create a cis log: error = "
+                      << ec.message() << std::endl;
+        }
     }
 
-    // TODO add a level param
-    // now put the lowest level
-    cis_logger->SesActRecord(scl::Level::Action, act, message);
-
-    webui_log(act, message);
+    return cis_binary_logger.get();
 }
 
-void session_log(actions act, const std::string& message)
+void cis_log(
+        actions act,
+        const std::string& message,
+        log_level level)
 {
-    if(!session_logger)
+    if(auto* binary_log = cis_binary_log(); binary_log)
     {
-        return;
+        binary_log->record(act, "%s", message);
     }
 
-    // TODO add a level param
-    // now put the lowest level
-    session_logger->ActRecord(scl::Level::Action, act, message);
+    if(cis_logger)
+    {
+        cis_logger->SesActRecord(to_scl_level(level), act, message);
+    }
+}
 
-    webui_log(act, message);
+void session_log(
+        actions act,
+        const std::string& message,
+        log_level level)
+{
+    if(session_binary_logger)
+    {
+        session_binary_logger->record(act, "%s", message);
+    }
+
+    if(session_logger)
+    {
+        session_logger->ActRecord(to_scl_level(level), act, message);
+    }
 }
 
 void webui_log(actions act, const std::string& message)
@@ -117,51 +303,64 @@ void webui_log(actions act, const std::string& message)
         // now put the lowest level
         webui_logger->SesActRecord(scl::Level::Action, act, message);
     }
+}
 
-    if(offline_webui_logger)
+void tee_log(
+        actions act,
+        const std::string& message,
+        log_level level)
+{
+    if(auto* binary_log = cis_binary_log(); binary_log)
     {
-        // TODO add a level param
-        // now put the lowest level
-        offline_webui_logger->ActRecord(scl::Level::Action, act, message);
+        binary_log->record(act, "%s", message);
     }
-}
 
-void tee_log(actions act, const std::string& message)
-{
-    if(cis_logger)
+    if(session_binary_logger)
     {
-        // TODO add a level param
-        // now put the lowest level
-        cis_logger->SesActRecord(scl::Level::Action, act, message);
+        session_binary_logger->record(act, "%s", message);
     }
 
-    if(session_logger)
+    if(tee_logger)
     {
-        // TODO add a level param
-        // now put the lowest level
-        session_logger->ActRecord(scl::Level::Action, act, message);
+        tee_logger->SesActRecord(to_scl_level(level), act, message);
     }
+}
 
-    webui_log(act, message);
+void flush_logs()
+{
+    log_sinks.flush();
+}
+
+void close_logs()
+{
+    cis_logger.reset();
+    session_logger.reset();
+    webui_logger.reset();
+    tee_logger.reset();
+    cis_binary_logger.reset();
+    cis_binary_log_options.reset();
+    session_binary_logger.reset();
+
+    log_sinks.reset();
 }
 
 void init_webui_log(
         const CoreLogger::Options& options,
         const std::shared_ptr<webui_session>& session)
 {
-    auto recorder = std::make_unique<webui_recorder>(session);
-    RecordersCont recorders;
-    recorders.push_back(std::move(recorder));
+    const auto on_error
+            = [](std::string_view error)
+            {
+                std::cerr << "Couldn't create a webui log: error = " << error << std::endl;
+                exit(1);
+            };
 
-    webui_logger = std::visit(
-            meta::overloaded{
-                    [](LoggerPtr&& val)
-                    { return std::move(val); },
-                    [](const auto&)
-                    { /*return an empty unique_ptr*/ return LoggerPtr{}; }
-            },
-            CoreLogger::Init(options, std::move(recorders))
-    );
+    // transport is used only from the thread which owns the session
+    log_sinks.set_sink(
+            cis1::log_sink::webui,
+            std::make_shared<webui_recorder>(session));
+
+    webui_logger = make_fanout_logger(options, webui_sinks, on_error);
 }
 
 void init_cis_log(
@@ -175,40 +374,53 @@ void init_cis_log(
                 exit(1);
             };
 
-    // TODO set the recorder_options.size_limit
-    FileRecorder::Options recorder_options;
-    recorder_options.log_directory = ctx.base_dir() / "logs";
-    recorder_options.file_name_template = "cis.%n.log";
-    recorder_options.align = true;
-
-    auto recorder = std::visit(
-            meta::overloaded{
-                    [](FileRecorderPtr&& val)
-                    { return std::move(val); },
-                    [&on_error](const auto& error)
+    if(binary_log_format(ctx))
+    {
+        cis_binary_log_dir = ctx.base_dir() / "logs";
+        cis_binary_log_options = options;
+        cis_binary_log_day = cis1::log_day{};
+
+        cis_binary_logger = open_binary_log(
+                cis_binary_log_dir / cis1::dated_log_name("cis", ".blog"),
+                options,
+                "cis log");
+    }
+    else
+    {
+        FileRecorder::Options recorder_options;
+        recorder_options.log_directory = ctx.base_dir() / "logs";
+        recorder_options.file_name_template = cis1::dated_log_name("cis", ".%n.log");
+        recorder_options.align = true;
+        recorder_options.size_limit
+                = cis1::load_log_rotation_options(ctx.env()).size_limit;
+
+        auto recorder = make_file_recorder(recorder_options, on_error);
+
+        // long-running processes (e.g. cis_cron_daemon) switch to
+        // the log of new day, failure to create it isn't fatal
+        auto next_day_recorder = [recorder_options]() mutable
+        {
+            recorder_options.file_name_template = cis1::dated_log_name("cis", ".%n.log");
+
+            return make_file_recorder(
+                    recorder_options,
+                    [](std::string_view error)
                     {
-                        on_error(FileRecorder::ToStr(error));
-                        return FileRecorderPtr{};
-                    }
-            },
-            FileRecorder::Init(recorder_options)
-    );
-
-    RecordersCont recorders;
-    recorders.push_back(std::move(recorder));
+                        std::cerr << "Couldn't create a cis log: error = " << error << std::endl;
+                    });
+        };
+
+        log_sinks.set_sink(
+                cis1::log_sink::cis,
+                std::make_shared<cis1::daily_recorder>(
+                        std::move(recorder),
+                        std::move(next_day_recorder)),
+                async_log_writer(ctx));
+    }
 
-    cis_logger = std::visit(
-            meta::overloaded{
-                    [](LoggerPtr&& val)
-                    { return std::move(val); },
-                    [&on_error](const auto& error)
-                    {
-                        on_error(CoreLogger::ToStr(error));
-                        return LoggerPtr{};
-                    },
-            },
-            CoreLogger::Init(options, std::move(recorders))
-    );
+    // text records are passed to webui logs even if cis log is binary
+    cis_logger = make_fanout_logger(options, cis_sinks, on_error);
+    tee_logger = make_fanout_logger(options, tee_sinks, on_error);
 }
 
 void init_offline_webui_log(
@@ -223,40 +435,18 @@ void init_offline_webui_log(
                 exit(1);
             };
 
-    // TODO set the recorder_options.size_limit
+    // webui reads the whole file, so it isn't split into segments
     FileRecorder::Options recorder_options;
     recorder_options.log_directory = ctx.base_dir() / "sessions";
     recorder_options.file_name_template = session.session_id() + ".combined.log";
     recorder_options.align = true;
 
-    auto recorder = std::visit(
-            meta::overloaded{
-                    [](FileRecorderPtr&& val)
-                    { return std::move(val); },
-                    [&on_error](const auto& error)
-                    {
-                        on_error(FileRecorder::ToStr(error));
-                        return FileRecorderPtr{};
-                    }
-            },
-            FileRecorder::Init(recorder_options)
-    );
+    log_sinks.set_sink(
+            cis1::log_sink::offline_webui,
+            make_file_recorder(recorder_options, on_error),
+            async_log_writer(ctx));
 
-    RecordersCont recorders;
-    recorders.push_back(std::move(recorder));
-
-    offline_webui_logger = std::visit(
-            meta::overloaded{
-                    [](LoggerPtr&& val)
-                    { return std::move(val); },
-                    [&on_error](const auto& error)
-                    {
-                        on_error(CoreLogger::ToStr(error));
-                        return LoggerPtr{};
-                    }
-            },
-            CoreLogger::Init(options, std::move(recorders))
-    );
+    webui_logger = make_fanout_logger(options, webui_sinks, on_error);
 }
 
 void init_session_log(
@@ -271,40 +461,30 @@ void init_session_log(
                 exit(1);
             };
 
-    // TODO set the recorder_options.size_limit
-    FileRecorder::Options recorder_options;
-    recorder_options.log_directory = ctx.base_dir() / "sessions";
-    recorder_options.file_name_template = session.session_id() + ".%n.log";
-    recorder_options.align = true;
-
-    auto recorder = std::visit(
-            meta::overloaded{
-                    [](FileRecorderPtr&& val)
-                    { return std::move(val); },
-                    [&on_error](const auto& error)
-                    {
-                        on_error(FileRecorder::ToStr(error));
-                        return FileRecorderPtr{};
-                    }
-            },
-            FileRecorder::Init(recorder_options)
-    );
-
-    RecordersCont recorders;
-    recorders.push_back(std::move(recorder));
-
-    session_logger = std::visit(
-            meta::overloaded{
-                    [](LoggerPtr&& val)
-                    { return std::move(val); },
-                    [&on_error](const auto& error)
-                    {
-                        on_error(CoreLogger::ToStr(error));
-                        return LoggerPtr{};
-                    }
-            },
-            CoreLogger::Init(options, std::move(recorders))
-    );
+    if(binary_log_format(ctx))
+    {
+        session_binary_logger = open_binary_log(
+                ctx.base_dir() / "sessions" / (session.session_id() + ".blog"),
+                options,
+                "session log");
+    }
+    else
+    {
+        FileRecorder::Options recorder_options;
+        recorder_options.log_directory = ctx.base_dir() / "sessions";
+        recorder_options.file_name_template = session.session_id() + ".%n.log";
+        recorder_options.align = true;
+        recorder_options.size_limit
+                = cis1::load_log_rotation_options(ctx.env()).size_limit;
+
+        log_sinks.set_sink(
+                cis1::log_sink::session,
+                make_file_recorder(recorder_options, on_error),
+                async_log_writer(ctx));
+    }
 
     init_offline_webui_log(options, ctx, session);
+
+    session_logger = make_fanout_logger(options, session_sinks, on_error);
+    tee_logger = make_fanout_logger(options, tee_sinks, on_error);
 }
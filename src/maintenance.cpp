@@ -7,17 +7,21 @@
  */
 
 #include <iostream>
+#include <mutex>
+#include <set>
+#include <vector>
 
 #include "context.h"
 #include "os.h"
 #include "logger.h"
 #include "job.h"
+#include "log_rotation.h"
 #include "cis_version.h"
 
 void usage(const char* self_name)
 {
     std::cout << "Usage: \n"
-              << "\t" << self_name << " --job ${job_name}" << std::endl;
+              << "\t" << self_name << " --job ${job_name} [--session ${session_id}]" << std::endl;
 }
 
 int main(int argc, char *argv[])
@@ -49,13 +53,19 @@ int main(int argc, char *argv[])
 
     init_cis_log(options, ctx);
 
-    if(argc != 3 || strcmp(argv[1], "--job") != 0)
+    if((argc != 3 && argc != 5)
+        || strcmp(argv[1], "--job") != 0
+        || (argc == 5 && strcmp(argv[3], "--session") != 0))
     {
         usage(argv[0]);
 
         return EXIT_FAILURE;
     }
 
+    // sessions dir may have millions of files, so only segments
+    // of the session which ran the build are looked for
+    const std::string build_session = argc == 5 ? argv[4] : "";
+
     auto job_opt = cis1::load_job(argv[2], ec, ctx, std_os);
     if(ec)
     {
@@ -65,7 +75,76 @@ int main(int argc, char *argv[])
     }
     auto& job = job_opt.value();
 
+    const auto rotation = cis1::load_log_rotation_options(ctx.env());
+
+    // logger isn't used from the compressor thread
+    std::mutex compressed_mutex;
+    std::set<std::string> compressed_sessions;
+    std::vector<std::filesystem::path> failed_segments;
+
+    // segments are compressed while the job dir is cleaned up
+    cis1::log_compressor compressor(
+            std_os,
+            [&](const std::filesystem::path& path, std::error_code ec)
+            {
+                std::lock_guard<std::mutex> lock(compressed_mutex);
+
+                if(ec)
+                {
+                    failed_segments.push_back(path);
+                }
+                else if(path.parent_path().filename() == "sessions")
+                {
+                    auto name = path.filename().string();
+                    compressed_sessions.insert(name.substr(0, name.find('.')));
+                }
+            });
+
+    std::error_code find_ec;
+
+    for(auto& path : cis1::find_rotated_logs(
+                ctx.base_dir() / "logs",
+                rotation.compress_after,
+                find_ec,
+                std_os))
+    {
+        compressor.enqueue(path);
+    }
+
+    if(!build_session.empty())
+    {
+        for(auto& path : cis1::find_rotated_session_logs(
+                    ctx.base_dir() / "sessions",
+                    build_session,
+                    rotation.compress_after,
+                    find_ec,
+                    std_os))
+        {
+            compressor.enqueue(path);
+        }
+    }
+
     job.cleanup(ec);
+
+    compressor.wait();
+
+    for(auto& path : failed_segments)
+    {
+        CIS_LOG(actions::error, R"(Cant compress log "%s")", path.string());
+    }
+
+    std::error_code rotation_ec;
+    cis1::apply_log_retention(
+            ctx.base_dir() / "logs",
+            rotation.keep_segments,
+            rotation_ec,
+            std_os);
+
+    for(auto& session_id : compressed_sessions)
+    {
+        cis1::update_session_index(ctx.base_dir(), session_id, rotation_ec, std_os);
+    }
+
     if(ec)
     {
         std::cout << ec.message() << std::endl;
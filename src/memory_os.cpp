@@ -0,0 +1,1165 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "memory_os.h"
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <streambuf>
+
+namespace cis1
+{
+
+struct memory_os::lock_state
+{
+    uint32_t shared = 0;
+    bool exclusive = false;
+};
+
+struct memory_os::node
+{
+    bool directory = false;
+    bool executable = false;
+    uint64_t inode = 0;
+    std::filesystem::file_time_type modified;
+    /// content of regular file, shared with opened ofstreams
+    std::shared_ptr<std::string> data;
+    /// flock state of regular file, shared with opened locks
+    std::shared_ptr<lock_state> lock;
+    std::map<std::string, std::unique_ptr<node>, std::less<>> children;
+};
+
+struct memory_os::state
+{
+    std::mutex mutex;
+    std::condition_variable locks_changed;
+    node root;
+    uint64_t last_inode = 1;
+    std::map<std::string, std::string> env;
+    std::vector<spawned_process> spawned;
+    spawn_handler_t spawn_handler;
+};
+
+namespace
+{
+
+using node = memory_os::node;
+using state = memory_os::state;
+using lock_state = memory_os::lock_state;
+
+std::vector<std::string> split(const std::filesystem::path& path)
+{
+    std::vector<std::string> parts;
+
+    // lexically_normal leaves ".." only at the beginning, it's root here
+    for(auto& part : path.lexically_normal().relative_path())
+    {
+        auto str = part.string();
+
+        if(!str.empty() && str != "." && str != "..")
+        {
+            parts.push_back(std::move(str));
+        }
+    }
+
+    return parts;
+}
+
+/**
+ * Walks first count parts, returns nullptr and sets ec if some is missing.
+ */
+node* walk(
+        state& s,
+        const std::vector<std::string>& parts,
+        size_t count,
+        std::error_code& ec)
+{
+    node* current = &s.root;
+
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(!current->directory)
+        {
+            ec = std::make_error_code(std::errc::not_a_directory);
+
+            return nullptr;
+        }
+
+        auto it = current->children.find(parts[i]);
+        if(it == current->children.end())
+        {
+            ec = std::make_error_code(std::errc::no_such_file_or_directory);
+
+            return nullptr;
+        }
+
+        current = it->second.get();
+    }
+
+    ec.clear();
+
+    return current;
+}
+
+node* find_entry(state& s, const std::vector<std::string>& parts, std::error_code& ec)
+{
+    return walk(s, parts, parts.size(), ec);
+}
+
+/**
+ * Finds directory containing entry, parts must not be empty.
+ */
+node* find_parent(
+        state& s,
+        const std::vector<std::string>& parts,
+        std::error_code& ec)
+{
+    auto parent = walk(s, parts, parts.size() - 1, ec);
+
+    if(parent && !parent->directory)
+    {
+        ec = std::make_error_code(std::errc::not_a_directory);
+
+        return nullptr;
+    }
+
+    return parent;
+}
+
+node* child(node* dir, const std::string& name)
+{
+    auto it = dir->children.find(name);
+
+    return it == dir->children.end() ? nullptr : it->second.get();
+}
+
+node& make_child(state& s, node* dir, const std::string& name, bool directory)
+{
+    auto& entry = dir->children[name];
+
+    entry = std::make_unique<node>();
+    entry->directory = directory;
+    entry->executable = directory;
+    entry->inode = ++s.last_inode;
+    entry->modified = std::filesystem::file_time_type::clock::now();
+
+    if(!directory)
+    {
+        entry->data = std::make_shared<std::string>();
+    }
+
+    return *entry;
+}
+
+bool copy_file(state& s, const node& from, node* dir, const std::string& name)
+{
+    if(child(dir, name))
+    {
+        return false;
+    }
+
+    auto& file = make_child(s, dir, name, false);
+    *file.data = *from.data;
+    file.executable = from.executable;
+
+    return true;
+}
+
+/**
+ * Writes straight to file content, so it's unbuffered.
+ */
+class memory_filebuf
+    : public std::streambuf
+{
+public:
+    memory_filebuf(
+            const std::shared_ptr<state>& s,
+            const std::shared_ptr<std::string>& data,
+            size_t pos,
+            bool append)
+        : state_(s)
+        , data_(data)
+        , pos_(pos)
+        , append_(append)
+    {}
+
+protected:
+    int_type overflow(int_type c) override
+    {
+        if(traits_type::eq_int_type(c, traits_type::eof()))
+        {
+            return traits_type::not_eof(c);
+        }
+
+        auto ch = traits_type::to_char_type(c);
+
+        xsputn(&ch, 1);
+
+        return c;
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+
+        auto& data = *data_;
+
+        if(append_)
+        {
+            pos_ = data.size();
+        }
+
+        auto count = static_cast<size_t>(n);
+
+        // file may be truncated by other stream
+        if(pos_ > data.size())
+        {
+            data.resize(pos_);
+        }
+
+        data.replace(pos_, std::min(count, data.size() - pos_), s, count);
+        pos_ += count;
+
+        return n;
+    }
+
+private:
+    std::shared_ptr<state> state_;
+    std::shared_ptr<std::string> data_;
+    size_t pos_;
+    bool append_;
+};
+
+class memory_ofstream
+    : public ofstream_interface
+{
+public:
+    memory_ofstream()
+        : os_(nullptr)
+    {}
+
+    memory_ofstream(
+            const std::shared_ptr<state>& s,
+            const std::shared_ptr<std::string>& data,
+            size_t pos,
+            bool append)
+        : buf_(std::make_unique<memory_filebuf>(s, data, pos, append))
+        , os_(buf_.get())
+    {}
+
+    bool is_open() const override
+    {
+        return buf_ != nullptr;
+    }
+
+    std::ostream& ostream() override
+    {
+        return os_;
+    }
+
+private:
+    std::unique_ptr<memory_filebuf> buf_;
+    std::ostream os_;
+};
+
+class memory_ifstream
+    : public ifstream_interface
+{
+public:
+    memory_ifstream()
+        : is_open_(false)
+    {
+        is_.setstate(std::ios_base::badbit);
+    }
+
+    memory_ifstream(std::string&& content, std::ios_base::openmode mode)
+        : is_(std::move(content), mode | std::ios_base::in)
+        , is_open_(true)
+    {}
+
+    bool is_open() const override
+    {
+        return is_open_;
+    }
+
+    std::istream& istream() override
+    {
+        return is_;
+    }
+
+private:
+    std::istringstream is_;
+    bool is_open_;
+};
+
+/**
+ * Same semantics as flock: lock belongs to file and is kept if file
+ * is removed or renamed, taking other mode converts the lock.
+ */
+class memory_file_lock
+    : public file_lock_interface
+{
+public:
+    memory_file_lock(
+            const std::shared_ptr<state>& s,
+            const std::shared_ptr<lock_state>& lock)
+        : state_(s)
+        , lock_(lock)
+    {}
+
+    ~memory_file_lock()
+    {
+        unlock();
+    }
+
+    bool lock() override
+    {
+        std::unique_lock<std::mutex> guard(state_->mutex);
+
+        release();
+
+        state_->locks_changed.wait(
+                guard,
+                [&]()
+                {
+                    return !lock_->exclusive && lock_->shared == 0;
+                });
+
+        lock_->exclusive = true;
+        held_ = held::exclusive;
+
+        return true;
+    }
+
+    bool lock_shared() override
+    {
+        std::unique_lock<std::mutex> guard(state_->mutex);
+
+        release();
+
+        state_->locks_changed.wait(
+                guard,
+                [&]()
+                {
+                    return !lock_->exclusive;
+                });
+
+        ++lock_->shared;
+        held_ = held::shared;
+
+        return true;
+    }
+
+    bool try_lock() override
+    {
+        std::lock_guard<std::mutex> guard(state_->mutex);
+
+        if(held_ == held::exclusive)
+        {
+            return true;
+        }
+
+        auto shared = lock_->shared - (held_ == held::shared ? 1 : 0);
+        if(lock_->exclusive || shared != 0)
+        {
+            return false;
+        }
+
+        release();
+
+        lock_->exclusive = true;
+        held_ = held::exclusive;
+
+        return true;
+    }
+
+    void unlock() override
+    {
+        std::lock_guard<std::mutex> guard(state_->mutex);
+
+        release();
+    }
+
+private:
+    enum class held
+    {
+        none,
+        shared,
+        exclusive,
+    };
+
+    std::shared_ptr<state> state_;
+    std::shared_ptr<lock_state> lock_;
+    held held_ = held::none;
+
+    /**
+     * State mutex must be locked.
+     */
+    void release()
+    {
+        if(held_ == held::exclusive)
+        {
+            lock_->exclusive = false;
+        }
+        else if(held_ == held::shared)
+        {
+            --lock_->shared;
+        }
+        else
+        {
+            return;
+        }
+
+        held_ = held::none;
+        state_->locks_changed.notify_all();
+    }
+};
+
+class memory_fs_entry
+    : public fs_entry_interface
+{
+public:
+    memory_fs_entry(const std::filesystem::path& path, bool directory)
+        : path_(path)
+        , directory_(directory)
+    {}
+
+    bool is_directory() const override
+    {
+        return directory_;
+    }
+
+    std::filesystem::path path() const override
+    {
+        return path_;
+    }
+
+private:
+    std::filesystem::path path_;
+    bool directory_;
+};
+
+} // namespace
+
+memory_os::memory_os()
+    : state_(std::make_shared<state>())
+{
+    state_->root.directory = true;
+    state_->root.executable = true;
+    state_->root.inode = 1;
+}
+
+memory_os::memory_os(const std::shared_ptr<state>& state)
+    : state_(state)
+{}
+
+std::unique_ptr<os_interface> memory_os::clone() const
+{
+    return std::unique_ptr<os_interface>(new memory_os(state_));
+}
+
+std::string memory_os::get_env_var(const std::string& name) const
+{
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    auto it = state_->env.find(name);
+
+    return it == state_->env.end() ? std::string{} : it->second;
+}
+
+bool memory_os::is_directory(
+        const std::filesystem::path& dir,
+        std::error_code& ec) const
+{
+    auto parts = split(dir);
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    auto entry = find_entry(*state_, parts, ec);
+
+    return entry && entry->directory;
+}
+
+bool memory_os::exists(
+        const std::filesystem::path& path,
+        std::error_code& ec) const
+{
+    auto parts = split(path);
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    auto entry = find_entry(*state_, parts, ec);
+
+    // missing entry isn't an error like in std::filesystem::exists
+    ec.clear();
+
+    return entry != nullptr;
+}
+
+void memory_os::iterate_directory(
+        const std::filesystem::path& path,
+        const dir_entry_cb_t& cb,
+        std::error_code& ec) const
+{
+    struct entry
+    {
+        std::string name;
+        dir_entry_type type;
+        uint64_t inode;
+    };
+
+    std::vector<entry> entries;
+
+    {
+        auto parts = split(path);
+
+        std::lock_guard<std::mutex> lock(state_->mutex);
+
+        auto dir = find_entry(*state_, parts, ec);
+        if(!dir)
+        {
+            return;
+        }
+
+        if(!dir->directory)
+        {
+            ec = std::make_error_code(std::errc::not_a_directory);
+
+            return;
+        }
+
+        entries.reserve(dir->children.size());
+
+        for(auto& [name, child] : dir->children)
+        {
+            entries.push_back({
+                    name,
+                    child->directory
+                            ? dir_entry_type::directory
+                            : dir_entry_type::regular,
+                    child->inode});
+        }
+    }
+
+    for(auto& e : entries)
+    {
+        if(!cb({e.name, e.type, e.inode}))
+        {
+            return;
+        }
+    }
+}
+
+std::vector<
+        std::unique_ptr<fs_entry_interface>> memory_os::list_directory(
+        const std::filesystem::path& path) const
+{
+    std::vector<std::unique_ptr<fs_entry_interface>> result;
+    std::error_code ec;
+
+    iterate_directory(
+            path,
+            [&](const dir_entry& entry)
+            {
+                result.push_back(std::make_unique<memory_fs_entry>(
+                        path / entry.name,
+                        entry.type == dir_entry_type::directory));
+
+                return true;
+            },
+            ec);
+    if(ec)
+    {
+        throw std::filesystem::filesystem_error(
+                "directory iterator cannot open directory",
+                path,
+                ec);
+    }
+
+    return result;
+}
+
+bool memory_os::create_directory(
+        const std::filesystem::path& dir,
+        std::error_code& ec) const
+{
+    auto parts = split(dir);
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    if(parts.empty())
+    {
+        ec.clear();
+
+        return false;
+    }
+
+    auto parent = find_parent(*state_, parts, ec);
+    if(!parent)
+    {
+        return false;
+    }
+
+    if(auto existing = child(parent, parts.back()); existing)
+    {
+        if(!existing->directory)
+        {
+            ec = std::make_error_code(std::errc::file_exists);
+        }
+
+        return false;
+    }
+
+    make_child(*state_, parent, parts.back(), true);
+
+    return true;
+}
+
+void memory_os::copy(
+        const std::filesystem::path& from,
+        const std::filesystem::path& to,
+        std::error_code& ec) const
+{
+    auto from_parts = split(from);
+    auto to_parts = split(to);
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    auto source = find_entry(*state_, from_parts, ec);
+    if(!source)
+    {
+        return;
+    }
+
+    if(to_parts.empty())
+    {
+        ec = std::make_error_code(std::errc::file_exists);
+
+        return;
+    }
+
+    auto parent = find_parent(*state_, to_parts, ec);
+    if(!parent)
+    {
+        return;
+    }
+
+    if(!source->directory)
+    {
+        if(!copy_file(*state_, *source, parent, to_parts.back()))
+        {
+            ec = std::make_error_code(std::errc::file_exists);
+        }
+
+        return;
+    }
+
+    auto target = child(parent, to_parts.back());
+    if(!target)
+    {
+        target = &make_child(*state_, parent, to_parts.back(), true);
+    }
+    else if(!target->directory)
+    {
+        ec = std::make_error_code(std::errc::file_exists);
+
+        return;
+    }
+
+    // names are collected first, target may be inside of source
+    std::vector<std::string> names;
+    for(auto& [name, entry] : source->children)
+    {
+        names.push_back(name);
+    }
+
+    for(auto& name : names)
+    {
+        auto entry = child(source, name);
+
+        if(entry->directory)
+        {
+            if(!child(target, name))
+            {
+                make_child(*state_, target, name, true);
+            }
+        }
+        else if(!copy_file(*state_, *entry, target, name))
+        {
+            ec = std::make_error_code(std::errc::file_exists);
+
+            return;
+        }
+    }
+}
+
+void memory_os::rename(
+        const std::filesystem::path& from,
+        const std::filesystem::path& to,
+        std::error_code& ec) const
+{
+    auto from_parts = split(from);
+    auto to_parts = split(to);
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    if(from_parts.empty() || to_parts.empty())
+    {
+        ec = std::make_error_code(std::errc::device_or_resource_busy);
+
+        return;
+    }
+
+    auto from_parent = find_parent(*state_, from_parts, ec);
+    if(!from_parent)
+    {
+        return;
+    }
+
+    auto source = child(from_parent, from_parts.back());
+    if(!source)
+    {
+        ec = std::make_error_code(std::errc::no_such_file_or_directory);
+
+        return;
+    }
+
+    if(from_parts == to_parts)
+    {
+        return;
+    }
+
+    if(to_parts.size() > from_parts.size()
+    && std::equal(from_parts.begin(), from_parts.end(), to_parts.begin()))
+    {
+        ec = std::make_error_code(std::errc::invalid_argument);
+
+        return;
+    }
+
+    auto to_parent = find_parent(*state_, to_parts, ec);
+    if(!to_parent)
+    {
+        return;
+    }
+
+    if(auto target = child(to_parent, to_parts.back()); target)
+    {
+        if(source->directory && !target->directory)
+        {
+            ec = std::make_error_code(std::errc::not_a_directory);
+
+            return;
+        }
+
+        if(!source->directory && target->directory)
+        {
+            ec = std::make_error_code(std::errc::is_a_directory);
+
+            return;
+        }
+
+        if(target->directory && !target->children.empty())
+        {
+            ec = std::make_error_code(std::errc::directory_not_empty);
+
+            return;
+        }
+    }
+
+    auto it = from_parent->children.find(from_parts.back());
+    auto entry = std::move(it->second);
+
+    from_parent->children.erase(it);
+    to_parent->children[to_parts.back()] = std::move(entry);
+}
+
+std::unique_ptr<ifstream_interface> memory_os::open_ifstream(
+        const std::filesystem::path& path,
+        std::ios_base::openmode mode) const
+{
+    auto parts = split(path);
+
+    std::string content;
+
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+
+        std::error_code ec;
+
+        auto file = find_entry(*state_, parts, ec);
+        if(!file || file->directory)
+        {
+            return std::make_unique<memory_ifstream>();
+        }
+
+        content = *file->data;
+    }
+
+    return std::make_unique<memory_ifstream>(std::move(content), mode);
+}
+
+std::unique_ptr<ofstream_interface> memory_os::open_ofstream(
+        const std::filesystem::path& path,
+        std::ios_base::openmode mode) const
+{
+    auto parts = split(path);
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    if(parts.empty())
+    {
+        return std::make_unique<memory_ofstream>();
+    }
+
+    std::error_code ec;
+
+    auto parent = find_parent(*state_, parts, ec);
+    if(!parent)
+    {
+        return std::make_unique<memory_ofstream>();
+    }
+
+    auto file = child(parent, parts.back());
+    if(!file)
+    {
+        file = &make_child(*state_, parent, parts.back(), false);
+    }
+    else if(file->directory)
+    {
+        return std::make_unique<memory_ofstream>();
+    }
+
+    const bool append = mode & std::ios_base::app;
+
+    file->modified = std::filesystem::file_time_type::clock::now();
+
+    // same as std::basic_filebuf::open
+    if((mode & std::ios_base::trunc)
+    || !(mode & (std::ios_base::app | std::ios_base::in)))
+    {
+        file->data->clear();
+    }
+
+    return std::make_unique<memory_ofstream>(
+            state_,
+            file->data,
+            mode & std::ios_base::ate ? file->data->size() : 0,
+            append);
+}
+
+std::unique_ptr<file_lock_interface> memory_os::open_lock_file(
+        const std::filesystem::path& path,
+        std::error_code& ec) const
+{
+    auto parts = split(path);
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    if(parts.empty())
+    {
+        ec = std::make_error_code(std::errc::is_a_directory);
+
+        return nullptr;
+    }
+
+    auto parent = find_parent(*state_, parts, ec);
+    if(!parent)
+    {
+        return nullptr;
+    }
+
+    auto file = child(parent, parts.back());
+    if(!file)
+    {
+        file = &make_child(*state_, parent, parts.back(), false);
+    }
+    else if(file->directory)
+    {
+        ec = std::make_error_code(std::errc::is_a_directory);
+
+        return nullptr;
+    }
+
+    if(!file->lock)
+    {
+        file->lock = std::make_shared<lock_state>();
+    }
+
+    return std::make_unique<memory_file_lock>(state_, file->lock);
+}
+
+void memory_os::spawn_process(
+        const std::string& start_dir,
+        const std::string& executable,
+        const std::vector<std::string>& args,
+        const environment& env) const
+{
+    spawned_process process{start_dir, executable, args, env};
+    spawn_handler_t handler;
+
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+
+        state_->spawned.push_back(process);
+        handler = state_->spawn_handler;
+    }
+
+    // handler may call this os
+    if(handler)
+    {
+        handler(process);
+    }
+}
+
+void memory_os::remove(
+        const std::filesystem::path& path,
+        std::error_code& ec) const
+{
+    auto parts = split(path);
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    if(parts.empty())
+    {
+        ec = std::make_error_code(std::errc::device_or_resource_busy);
+
+        return;
+    }
+
+    auto parent = find_parent(*state_, parts, ec);
+    if(!parent)
+    {
+        if(ec == std::errc::no_such_file_or_directory)
+        {
+            ec.clear();
+        }
+
+        return;
+    }
+
+    auto it = parent->children.find(parts.back());
+    if(it == parent->children.end())
+    {
+        return;
+    }
+
+    if(it->second->directory && !it->second->children.empty())
+    {
+        ec = std::make_error_code(std::errc::directory_not_empty);
+
+        return;
+    }
+
+    parent->children.erase(it);
+}
+
+void memory_os::remove_all(
+        const std::filesystem::path& path,
+        std::error_code& ec) const
+{
+    auto parts = split(path);
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    if(parts.empty())
+    {
+        ec = std::make_error_code(std::errc::device_or_resource_busy);
+
+        return;
+    }
+
+    auto parent = find_parent(*state_, parts, ec);
+    if(!parent)
+    {
+        if(ec == std::errc::no_such_file_or_directory)
+        {
+            ec.clear();
+        }
+
+        return;
+    }
+
+    parent->children.erase(parts.back());
+}
+
+bool memory_os::is_executable(
+        const std::filesystem::path& path,
+        std::error_code& ec) const
+{
+    auto parts = split(path);
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    auto entry = find_entry(*state_, parts, ec);
+
+    return entry && entry->executable;
+}
+
+void memory_os::make_executable(
+        const std::filesystem::path& path,
+        std::error_code& ec) const
+{
+    auto parts = split(path);
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    if(auto entry = find_entry(*state_, parts, ec); entry)
+    {
+        entry->executable = true;
+    }
+}
+
+std::filesystem::file_time_type memory_os::last_write_time(
+        const std::filesystem::path& path,
+        std::error_code& ec) const
+{
+    auto parts = split(path);
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    auto entry = find_entry(*state_, parts, ec);
+
+    return entry ? entry->modified : std::filesystem::file_time_type::min();
+}
+
+void memory_os::set_last_write_time(
+        const std::filesystem::path& path,
+        std::filesystem::file_time_type time,
+        std::error_code& ec) const
+{
+    auto parts = split(path);
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    if(auto entry = find_entry(*state_, parts, ec); entry)
+    {
+        entry->modified = time;
+    }
+}
+
+void memory_os::set_env_var(
+        const std::string& name,
+        const std::string& value)
+{
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    state_->env[name] = value;
+}
+
+void memory_os::create_directories(
+        const std::filesystem::path& dir,
+        std::error_code& ec)
+{
+    auto parts = split(dir);
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    ec.clear();
+
+    node* current = &state_->root;
+
+    for(auto& part : parts)
+    {
+        auto next = child(current, part);
+        if(!next)
+        {
+            next = &make_child(*state_, current, part, true);
+        }
+        else if(!next->directory)
+        {
+            ec = std::make_error_code(std::errc::not_a_directory);
+
+            return;
+        }
+
+        current = next;
+    }
+}
+
+void memory_os::write_file(
+        const std::filesystem::path& path,
+        const std::string& content,
+        std::error_code& ec,
+        bool executable)
+{
+    auto parts = split(path);
+
+    if(parts.empty())
+    {
+        ec = std::make_error_code(std::errc::is_a_directory);
+
+        return;
+    }
+
+    create_directories(path.parent_path(), ec);
+    if(ec)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    auto parent = find_parent(*state_, parts, ec);
+    if(!parent)
+    {
+        return;
+    }
+
+    auto file = child(parent, parts.back());
+    if(!file)
+    {
+        file = &make_child(*state_, parent, parts.back(), false);
+    }
+    else if(file->directory)
+    {
+        ec = std::make_error_code(std::errc::is_a_directory);
+
+        return;
+    }
+
+    *file->data = content;
+    file->executable = executable;
+    file->modified = std::filesystem::file_time_type::clock::now();
+}
+
+std::optional<std::string> memory_os::read_file(
+        const std::filesystem::path& path) const
+{
+    auto parts = split(path);
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    std::error_code ec;
+
+    auto file = find_entry(*state_, parts, ec);
+    if(!file || file->directory)
+    {
+        return std::nullopt;
+    }
+
+    return *file->data;
+}
+
+void memory_os::set_spawn_handler(spawn_handler_t handler)
+{
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    state_->spawn_handler = std::move(handler);
+}
+
+std::vector<spawned_process> memory_os::spawned() const
+{
+    std::lock_guard<std::mutex> lock(state_->mutex);
+
+    return state_->spawned;
+}
+
+} // namespace cis1
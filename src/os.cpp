@@ -8,11 +8,25 @@
 
 #include "os.h"
 
+#include <cstdlib>
+#include <string_view>
+
 #include <boost/process.hpp>
 
+#include "process.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
 #include "ifstream_adapter.h"
 #include "ofstream_adapter.h"
 #include "fs_entry_adapter.h"
+#include "file_lock_adapter.h"
 
 namespace cis1
 {
@@ -24,16 +38,23 @@ std::unique_ptr<os_interface> os::clone() const
 
 std::string os::get_env_var(const std::string& name) const
 {
-    auto env = boost::this_process::environment();
-
-    auto it = env.find(name);
-
-    if(it != env.end())
+    // Live lookup, host process (e.g. python with libcis1_core_c)
+    // may change environment between calls
+    auto var = std::getenv(name.c_str());
+    if(var == nullptr)
     {
-        return it->to_vector()[0];
+        return {};
     }
 
-    return {};
+    // Only the first element of list value like boost::process
+    // environment entry to_vector()[0]
+    std::string_view value{var};
+
+#ifdef _WIN32
+    return std::string{value.substr(0, value.find(';'))};
+#else
+    return std::string{value.substr(0, value.find(':'))};
+#endif
 }
 
 bool os::is_directory(
@@ -64,6 +85,144 @@ std::vector<
     return result;
 }
 
+#ifdef __linux__
+dir_entry_type to_dir_entry_type(mode_t mode)
+{
+    switch(mode & S_IFMT)
+    {
+        case S_IFREG:
+            return dir_entry_type::regular;
+        case S_IFDIR:
+            return dir_entry_type::directory;
+        case S_IFLNK:
+            return dir_entry_type::symlink;
+        default:
+            return dir_entry_type::other;
+    }
+}
+
+dir_entry_type to_dir_entry_type(unsigned char d_type)
+{
+    switch(d_type)
+    {
+        case DT_REG:
+            return dir_entry_type::regular;
+        case DT_DIR:
+            return dir_entry_type::directory;
+        case DT_LNK:
+            return dir_entry_type::symlink;
+        case DT_UNKNOWN:
+            return dir_entry_type::unknown;
+        default:
+            return dir_entry_type::other;
+    }
+}
+
+void os::iterate_directory(
+        const std::filesystem::path& path,
+        const dir_entry_cb_t& cb,
+        std::error_code& ec) const
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(fd == -1)
+    {
+        ec.assign(errno, std::system_category());
+
+        return;
+    }
+
+    // struct linux_dirent64 isn't exported by glibc headers
+    struct linux_dirent64
+    {
+        ino64_t d_ino;
+        off64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        // ISO C++ has no flexible array members,
+        // null terminated name continues past the struct
+        char d_name[1];
+    };
+
+    alignas(linux_dirent64) char buf[32 * 1024];
+
+    for(;;)
+    {
+        auto nread = ::syscall(SYS_getdents64, fd, buf, sizeof(buf));
+        if(nread == -1)
+        {
+            ec.assign(errno, std::system_category());
+
+            break;
+        }
+
+        if(nread == 0)
+        {
+            break;
+        }
+
+        for(long pos = 0; pos < nread;)
+        {
+            auto d = reinterpret_cast<linux_dirent64*>(buf + pos);
+            pos += d->d_reclen;
+
+            std::string_view name{d->d_name};
+            if(name == "." || name == "..")
+            {
+                continue;
+            }
+
+            auto type = to_dir_entry_type(d->d_type);
+
+            // Some filesystems don't fill d_type, symlinks are resolved
+            if(type == dir_entry_type::unknown
+            || type == dir_entry_type::symlink)
+            {
+                struct stat st;
+                if(::fstatat(fd, d->d_name, &st, 0) == 0
+                || ::fstatat(fd, d->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0)
+                {
+                    type = to_dir_entry_type(st.st_mode);
+                }
+            }
+
+            if(!cb({name, type, d->d_ino}))
+            {
+                ::close(fd);
+
+                return;
+            }
+        }
+    }
+
+    ::close(fd);
+}
+#else
+void os::iterate_directory(
+        const std::filesystem::path& path,
+        const dir_entry_cb_t& cb,
+        std::error_code& ec) const
+{
+    for(auto it = std::filesystem::directory_iterator(path, ec);
+            !ec && it != std::filesystem::directory_iterator();
+            it.increment(ec))
+    {
+        auto name = it->path().filename().string();
+
+        std::error_code type_ec;
+        auto type = it->is_directory(type_ec)
+                ? dir_entry_type::directory
+                : it->is_regular_file(type_ec)
+                        ? dir_entry_type::regular
+                        : dir_entry_type::other;
+
+        if(!cb({name, type, 0}))
+        {
+            return;
+        }
+    }
+}
+#endif
+
 bool os::create_directory(
         const std::filesystem::path& dir,
         std::error_code& ec) const
@@ -79,6 +238,14 @@ void os::copy(
     return std::filesystem::copy(from, to, ec);
 }
 
+void os::rename(
+        const std::filesystem::path& from,
+        const std::filesystem::path& to,
+        std::error_code& ec) const
+{
+    std::filesystem::rename(from, to, ec);
+}
+
 std::unique_ptr<ifstream_interface> os::open_ifstream(
         const std::filesystem::path& path,
         std::ios_base::openmode mode) const
@@ -93,17 +260,37 @@ std::unique_ptr<ofstream_interface> os::open_ofstream(
     return std::make_unique<ofstream_adapter>(path, mode);
 }
 
+std::unique_ptr<file_lock_interface> os::open_lock_file(
+        const std::filesystem::path& path,
+        std::error_code& ec) const
+{
+    auto lock = std::make_unique<file_lock_adapter>(path, ec);
+    if(ec)
+    {
+        return nullptr;
+    }
+
+    return lock;
+}
+
 void os::spawn_process(
         const std::string& start_dir,
         const std::string& executable,
         const std::vector<std::string>& args,
-        boost::process::environment env) const
+        const environment& env) const
 {
     boost::process::spawn(
             boost::process::start_dir = start_dir,
             boost::process::exe = executable,
             boost::process::args = args,
-            boost::process::env = env);
+#ifdef __linux__
+            // leave build process group, so detached process
+            // isn't terminated together with build
+            child_setup{},
+            env_setup{env});
+#else
+            boost::process::env = env.native());
+#endif
 
 }
 
@@ -147,4 +334,19 @@ void os::make_executable(
             ec);
 }
 
+std::filesystem::file_time_type os::last_write_time(
+        const std::filesystem::path& path,
+        std::error_code& ec) const
+{
+    return std::filesystem::last_write_time(path, ec);
+}
+
+void os::set_last_write_time(
+        const std::filesystem::path& path,
+        std::filesystem::file_time_type time,
+        std::error_code& ec) const
+{
+    std::filesystem::last_write_time(path, time, ec);
+}
+
 } // namespace cis1
@@ -0,0 +1,96 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "parallel_builds.h"
+
+#include "utils.h"
+
+namespace cis1
+{
+
+void run_parallel(
+        std::vector<parallel_build>& builds,
+        size_t max_concurrent,
+        cis1::context_interface& ctx,
+        bool force,
+        std::function<void(parallel_build&)> on_started,
+        std::function<void(parallel_build&)> on_finished,
+        std::function<void(parallel_build&, bool error, const std::string&)> on_line,
+        job::job_runner_factory_t job_runner_factory)
+{
+    boost::asio::io_context io_ctx;
+
+    // runners are kept until io_ctx is stopped, their handlers may
+    // still be pending after build is finished
+    std::vector<std::unique_ptr<job_runner_interface>> runners(builds.size());
+
+    size_t next = 0;
+    size_t running = 0;
+
+    std::function<void()> start_next = [&]()
+    {
+        while(next < builds.size()
+        && (max_concurrent == 0 || running < max_concurrent))
+        {
+            auto i = next++;
+            auto& build = builds[i];
+
+            ++running;
+
+            build.started_ms = unix_time_now_ms();
+
+            if(on_started)
+            {
+                on_started(build);
+            }
+
+            runners[i] = build.build_job.async_execute(
+                    build.build_number,
+                    io_ctx,
+                    ctx,
+                    build.env,
+                    force,
+                    [&, i](bool error, const std::string& line)
+                    {
+                        if(on_line)
+                        {
+                            on_line(builds[i], error, line);
+                        }
+                    },
+                    [&, i](
+                            std::error_code ec,
+                            int exit_code,
+                            std::optional<build_stats> stats)
+                    {
+                        auto& build = builds[i];
+
+                        build.ec = ec;
+                        build.exit_code = exit_code;
+                        build.stats = stats;
+                        build.finished_ms = unix_time_now_ms();
+
+                        --running;
+
+                        if(on_finished)
+                        {
+                            on_finished(build);
+                        }
+
+                        // may be called from inside async_execute
+                        boost::asio::post(io_ctx, start_next);
+                    },
+                    job_runner_factory);
+        }
+    };
+
+    start_next();
+
+    io_ctx.run();
+}
+
+} // namespace cis1
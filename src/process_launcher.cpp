@@ -0,0 +1,248 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "process_launcher.h"
+
+#ifdef __linux__
+#include <sys/wait.h>
+#endif
+
+#include "logger.h"
+
+namespace cis1
+{
+
+uint64_t launcher_stats::outstanding() const
+{
+    return spawned > reaped ? spawned - reaped : 0;
+}
+
+process_launcher::process_launcher(
+        boost::asio::io_context& io_ctx,
+        const os_interface& os)
+    : io_ctx_(io_ctx)
+    , os_(os.clone())
+#ifdef __linux__
+    , child_signals_(io_ctx, SIGCHLD)
+    , reap_timer_(io_ctx)
+#endif
+{
+#ifdef __linux__
+    // children exited before signal_set was installed
+    reap_children();
+    wait_child_signal();
+#endif
+
+    worker_ = std::thread(&process_launcher::work, this);
+}
+
+process_launcher::~process_launcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        stopping_ = true;
+    }
+
+    cv_.notify_one();
+    worker_.join();
+}
+
+void process_launcher::launch(
+        const std::string& start_dir,
+        const std::string& executable,
+        const std::vector<std::string>& args,
+        const environment& env)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        queue_.push_back({
+                start_dir,
+                executable,
+                args,
+                env,
+                std::chrono::steady_clock::now()});
+    }
+
+    cv_.notify_one();
+}
+
+const launcher_stats& process_launcher::stats() const
+{
+    return stats_;
+}
+
+void process_launcher::log_stats() const
+{
+    std::chrono::microseconds avg_latency{0};
+    if(stats_.spawned != 0)
+    {
+        avg_latency = stats_.total_latency
+                    / static_cast<std::chrono::microseconds::rep>(stats_.spawned);
+    }
+
+    CIS_LOG(actions::spawn,
+            R"(spawned=%s failed=%s reaped=%s outstanding=%s max_latency_us=%s avg_latency_us=%s)",
+            stats_.spawned,
+            stats_.failed,
+            stats_.reaped,
+            stats_.outstanding(),
+            stats_.max_latency.count(),
+            avg_latency.count());
+}
+
+void process_launcher::work()
+{
+    std::weak_ptr<void> alive = alive_;
+
+    for(;;)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        cv_.wait(
+                lock,
+                [&]()
+                {
+                    return stopping_ || !queue_.empty();
+                });
+
+        if(stopping_)
+        {
+            return;
+        }
+
+        auto req = std::move(queue_.front());
+        queue_.pop_front();
+
+        lock.unlock();
+
+        std::string error;
+
+        try
+        {
+            os_->spawn_process(
+                    req.start_dir,
+                    req.executable,
+                    req.args,
+                    req.env);
+        }
+        catch(const std::exception& ex)
+        {
+            error = ex.what();
+
+            if(error.empty())
+            {
+                error = "unknown error";
+            }
+        }
+
+        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - req.queued);
+
+        boost::asio::post(
+                io_ctx_,
+                [this, alive, req = std::move(req), latency, error]()
+                {
+                    if(alive.expired())
+                    {
+                        return;
+                    }
+
+                    on_spawned(req, latency, error);
+                });
+    }
+}
+
+void process_launcher::on_spawned(
+        const request& req,
+        std::chrono::microseconds latency,
+        const std::string& error)
+{
+    if(!error.empty())
+    {
+        ++stats_.failed;
+
+        CIS_LOG(actions::error,
+                "Can't start %s: %s",
+                req.executable,
+                error);
+
+        return;
+    }
+
+    ++stats_.spawned;
+    stats_.last_latency = latency;
+    stats_.max_latency = std::max(stats_.max_latency, latency);
+    stats_.total_latency += latency;
+
+    CIS_LOG(actions::spawn,
+            R"(executable="%s" args="%s" latency_us=%s outstanding=%s)",
+            req.executable,
+            req.args.empty() ? std::string{} : req.args.front(),
+            latency.count(),
+            stats_.outstanding());
+
+    poll_children();
+}
+
+void process_launcher::wait_child_signal()
+{
+#ifdef __linux__
+    child_signals_.async_wait(
+            [this](const boost::system::error_code& error, int)
+            {
+                if(error)
+                {
+                    return;
+                }
+
+                reap_children();
+                wait_child_signal();
+            });
+#endif
+}
+
+void process_launcher::poll_children()
+{
+#ifdef __linux__
+    if(reap_timer_armed_ || stats_.outstanding() == 0)
+    {
+        return;
+    }
+
+    reap_timer_armed_ = true;
+    reap_timer_.expires_after(std::chrono::seconds(1));
+    reap_timer_.async_wait(
+            [this](const boost::system::error_code& error)
+            {
+                if(error)
+                {
+                    return;
+                }
+
+                reap_timer_armed_ = false;
+                reap_children();
+                poll_children();
+            });
+#endif
+}
+
+void process_launcher::reap_children()
+{
+#ifdef __linux__
+    // signals of several children may be merged into one
+    int status;
+    while(::waitpid(-1, &status, WNOHANG) > 0)
+    {
+        ++stats_.reaped;
+    }
+#endif
+}
+
+} // namespace cis1
@@ -8,13 +8,7 @@
 
 #include "session.h"
 
-#include <chrono>
-#include <sstream>
-#include <iomanip>
-
-#include <boost/process.hpp>
-
-#include "get_parent_id.h"
+#include "session_id.h"
 
 namespace cis1
 {
@@ -66,14 +60,7 @@ session invoke_session(
     }
     else
     {
-        auto now = std::chrono::system_clock::now();
-        auto time = std::chrono::system_clock::to_time_t(now);
-        auto id = boost::this_process::get_id();
-        auto parent_id = get_parent_id();
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&time), "%Y-%m-%d-%H-%M-%S-")
-           << id << "_"  << parent_id;
-        session_id = ss.str();
+        session_id = generate_session_id();
     }
 
     ctx.set_env_var("session_id", session_id);
@@ -0,0 +1,490 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "session_gc.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#include <boost/process/environment.hpp>
+
+#include "error_code.h"
+#include "utils.h"
+
+namespace cis1
+{
+
+namespace
+{
+
+bool is_session_id(const std::string& id)
+{
+    return !id.empty()
+        && id.find_first_of("./\\") == std::string::npos;
+}
+
+/// Names of files of the session from its index, or probed if there is no index
+std::vector<std::string> session_files(
+        const std::filesystem::path& sessions_dir,
+        const std::string& session_id,
+        const os_interface& os)
+{
+    auto prefix = session_id + ".";
+    auto index_name = session_id + ".index";
+
+    std::vector<std::string> files;
+
+    auto index = os.open_ifstream(sessions_dir / index_name, std::ios_base::in);
+    if(index && index->is_open())
+    {
+        std::string name;
+        while(std::getline(index->istream(), name))
+        {
+            if(starts_with(name, prefix)
+                && name.find_first_of("/\\") == std::string::npos
+                && name != index_name)
+            {
+                files.push_back(name);
+            }
+        }
+    }
+    else
+    {
+        // files which can't be probed are left for the next collection
+        std::error_code ec;
+        files = find_session_files(sessions_dir, session_id, ec, os);
+    }
+
+    // index goes last, so interrupted collection can be repeated
+    files.push_back(index_name);
+
+    return files;
+}
+
+/// Runs f(i) for i in [0, count) on several threads
+template <class Function>
+void run_workers(
+        size_t count,
+        uint32_t threads,
+        Function f)
+{
+    std::atomic<size_t> next{0};
+
+    auto worker = [&]()
+    {
+        for(size_t i = next++; i < count; i = next++)
+        {
+            f(i);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for(size_t i = 1; i < std::min<size_t>(std::max<uint32_t>(threads, 1), count); ++i)
+    {
+        pool.emplace_back(worker);
+    }
+
+    worker();
+
+    for(auto& thread : pool)
+    {
+        thread.join();
+    }
+}
+
+/// Removes files of sessions, returns indexes of sessions with failed files
+std::vector<size_t> remove_sessions(
+        const std::filesystem::path& sessions_dir,
+        const std::vector<std::vector<std::string>>& sessions,
+        const session_gc_options& options,
+        session_gc_stats& stats,
+        const os_interface& os)
+{
+    rate_limiter limiter(options.max_removes_per_second);
+
+    std::atomic<size_t> removed_sessions{0};
+    std::atomic<size_t> removed_files{0};
+    std::atomic<size_t> failed_files{0};
+
+    std::mutex failed_mutex;
+    std::vector<size_t> failed;
+
+    run_workers(
+            sessions.size(),
+            options.threads,
+            [&](size_t i)
+            {
+                size_t session_removed = 0;
+                size_t session_failed = 0;
+
+                for(auto& name : sessions[i])
+                {
+                    auto path = sessions_dir / name;
+
+                    // probed names and stale index records aren't counted
+                    std::error_code ec;
+                    if(!os.exists(path, ec) && !ec)
+                    {
+                        continue;
+                    }
+
+                    limiter.acquire();
+
+                    ec.clear();
+                    os.remove(path, ec);
+                    if(ec)
+                    {
+                        ++session_failed;
+                    }
+                    else
+                    {
+                        ++session_removed;
+                    }
+                }
+
+                removed_files += session_removed;
+                failed_files += session_failed;
+
+                if(session_failed != 0)
+                {
+                    std::lock_guard<std::mutex> lock(failed_mutex);
+                    failed.push_back(i);
+                }
+                else if(session_removed != 0)
+                {
+                    ++removed_sessions;
+                }
+            });
+
+    stats.sessions += removed_sessions;
+    stats.files += removed_files;
+    stats.failed += failed_files;
+
+    return failed;
+}
+
+} // namespace
+
+std::vector<std::string> find_session_files(
+        const std::filesystem::path& sessions_dir,
+        const std::string& session_id,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    std::vector<std::string> files;
+
+    auto probe = [&](std::string name)
+    {
+        bool exists = os.exists(sessions_dir / name, ec);
+        if(exists)
+        {
+            files.push_back(std::move(name));
+        }
+
+        return exists;
+    };
+
+    for(const auto* suffix : {".dat", ".prm", ".dat.lock", ".prm.lock", ".graph", ".combined.log", ".blog"})
+    {
+        probe(session_id + suffix);
+
+        if(ec)
+        {
+            return files;
+        }
+    }
+
+    for(uint32_t n = 0; ; ++n)
+    {
+        auto segment = session_id + "." + std::to_string(n) + ".log";
+
+        bool log = probe(segment);
+        bool gz = !ec && probe(segment + ".gz");
+
+        if(ec || (!log && !gz))
+        {
+            return files;
+        }
+    }
+}
+
+session_gc_options load_session_gc_options(const environment& env)
+{
+    session_gc_options options;
+
+    if(auto hours = u32_from_string(env.get("session_keep_hours")); hours)
+    {
+        options.keep_closed = std::chrono::hours{hours.value()};
+    }
+
+    if(auto hours = u32_from_string(env.get("session_abandon_hours")); hours)
+    {
+        options.keep_abandoned = std::chrono::hours{hours.value()};
+    }
+
+    if(auto threads = u32_from_string(env.get("session_gc_threads"));
+            threads && threads.value() != 0)
+    {
+        options.threads = threads.value();
+    }
+
+    if(auto rate = u32_from_string(env.get("session_gc_rate")); rate)
+    {
+        options.max_removes_per_second = rate.value();
+    }
+
+    return options;
+}
+
+std::filesystem::path closed_sessions_path(const std::filesystem::path& base_dir)
+{
+    return base_dir / "sessions" / "closed_sessions";
+}
+
+void record_closed_session(
+        const std::filesystem::path& base_dir,
+        const std::string& session_id,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    std::stringstream line;
+    line << unix_time_now() << " " << session_id << "\n";
+
+    // one short append is atomic, so concurrent sessions don't mix records
+    auto journal = os.open_ofstream(
+            closed_sessions_path(base_dir),
+            std::ios_base::out | std::ios_base::app);
+    if(!journal
+        || !journal->is_open()
+        || !(journal->ostream() << line.str() << std::flush))
+    {
+        ec = cis1::error_code::cant_write_closed_sessions;
+    }
+}
+
+rate_limiter::rate_limiter(uint32_t per_second)
+    : interval_(per_second == 0
+            ? std::chrono::nanoseconds{0}
+            : std::chrono::nanoseconds{std::chrono::seconds{1}} / per_second)
+    , next_(std::chrono::steady_clock::now())
+{}
+
+void rate_limiter::acquire()
+{
+    if(interval_.count() == 0)
+    {
+        return;
+    }
+
+    std::chrono::steady_clock::time_point at;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        at = std::max(next_, std::chrono::steady_clock::now());
+        next_ = at + interval_;
+    }
+
+    std::this_thread::sleep_until(at);
+}
+
+session_gc_stats collect_closed_sessions(
+        const std::filesystem::path& base_dir,
+        const session_gc_options& options,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    session_gc_stats stats;
+
+    auto sessions_dir = base_dir / "sessions";
+    auto journal = closed_sessions_path(base_dir);
+
+    // sessions closed during collection append to the new journal
+    auto work = journal;
+    work += "." + std::to_string(boost::this_process::get_id()) + ".gc";
+
+    os.rename(journal, work, ec);
+    if(ec == std::errc::no_such_file_or_directory)
+    {
+        ec.clear();
+
+        return stats;
+    }
+    else if(ec)
+    {
+        ec = cis1::error_code::cant_collect_sessions;
+
+        return stats;
+    }
+
+    const auto now = unix_time_now();
+    const auto keep = options.keep_closed.count();
+
+    std::vector<std::string> kept;
+    std::vector<std::string> expired_lines;
+    std::vector<std::vector<std::string>> expired;
+
+    {
+        auto records = os.open_ifstream(work, std::ios_base::in);
+        if(!records || !records->is_open())
+        {
+            ec = cis1::error_code::cant_collect_sessions;
+
+            return stats;
+        }
+
+        std::string line;
+        while(std::getline(records->istream(), line))
+        {
+            std::istringstream ss(line);
+
+            int64_t closed = 0;
+            std::string session_id;
+
+            if(!(ss >> closed >> session_id) || !is_session_id(session_id))
+            {
+                continue;
+            }
+
+            if(closed + keep > now)
+            {
+                kept.push_back(line);
+
+                continue;
+            }
+
+            expired_lines.push_back(line);
+            expired.push_back(session_files(sessions_dir, session_id, os));
+        }
+    }
+
+    for(auto i : remove_sessions(sessions_dir, expired, options, stats, os))
+    {
+        kept.push_back(expired_lines[i]);
+    }
+
+    if(!kept.empty())
+    {
+        auto records = os.open_ofstream(
+                journal,
+                std::ios_base::out | std::ios_base::app);
+        if(!records || !records->is_open())
+        {
+            ec = cis1::error_code::cant_collect_sessions;
+
+            return stats;
+        }
+
+        auto& out = records->ostream();
+        for(auto& line : kept)
+        {
+            out << line << "\n";
+        }
+
+        if(!(out << std::flush))
+        {
+            // records aren't lost, they stay in the work file
+            ec = cis1::error_code::cant_collect_sessions;
+
+            return stats;
+        }
+    }
+
+    std::error_code remove_ec;
+    os.remove(work, remove_ec);
+
+    return stats;
+}
+
+session_gc_stats collect_abandoned_sessions(
+        const std::filesystem::path& base_dir,
+        const session_gc_options& options,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    session_gc_stats stats;
+
+    struct session_entry
+    {
+        std::filesystem::file_time_type modified;
+        std::vector<std::string> files;
+    };
+
+    std::map<std::string, session_entry> sessions;
+
+    auto sessions_dir = base_dir / "sessions";
+    auto journal_name = closed_sessions_path(base_dir).filename().string();
+
+    std::vector<std::string> names;
+
+    // names are collected first, os may hold directory while iterating
+    os.iterate_directory(
+            sessions_dir,
+            [&](const dir_entry& entry)
+            {
+                names.emplace_back(entry.name);
+
+                return true;
+            },
+            ec);
+    if(ec)
+    {
+        ec = cis1::error_code::cant_collect_sessions;
+
+        return stats;
+    }
+
+    for(auto& name : names)
+    {
+        auto session_id = name.substr(0, name.find('.'));
+
+        if(session_id == name
+            || !is_session_id(session_id)
+            || session_id == journal_name)
+        {
+            continue;
+        }
+
+        std::error_code time_ec;
+        auto modified = os.last_write_time(sessions_dir / name, time_ec);
+        if(time_ec)
+        {
+            continue;
+        }
+
+        auto& entry = sessions[session_id];
+        entry.files.push_back(std::move(name));
+
+        if(entry.files.size() == 1 || modified > entry.modified)
+        {
+            entry.modified = modified;
+        }
+    }
+
+    const auto threshold = std::filesystem::file_time_type::clock::now()
+            - options.keep_abandoned;
+
+    std::vector<std::vector<std::string>> abandoned;
+
+    for(auto& [session_id, entry] : sessions)
+    {
+        if(entry.modified < threshold)
+        {
+            abandoned.push_back(std::move(entry.files));
+        }
+    }
+
+    remove_sessions(sessions_dir, abandoned, options, stats, os);
+
+    return stats;
+}
+
+} // namespace cis1
@@ -0,0 +1,285 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "session_graph.h"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+#include "error_code.h"
+
+namespace cis1
+{
+
+namespace
+{
+
+using interval = std::pair<int64_t, int64_t>;
+
+/// Length of union of intervals clipped to [from, to)
+int64_t union_length(
+        std::vector<interval> intervals,
+        int64_t from,
+        int64_t to)
+{
+    std::sort(intervals.begin(), intervals.end());
+
+    int64_t result = 0;
+    int64_t covered = from;
+
+    for(auto [start, finish] : intervals)
+    {
+        start = std::max(start, covered);
+        finish = std::min(finish, to);
+
+        if(start < finish)
+        {
+            result += finish - start;
+            covered = finish;
+        }
+    }
+
+    return result;
+}
+
+} // namespace
+
+std::filesystem::path session_graph_path(
+        const std::filesystem::path& base_dir,
+        const std::string& session_id)
+{
+    return base_dir / "sessions" / (session_id + ".graph");
+}
+
+void append_graph_node(
+        const std::filesystem::path& path,
+        const graph_node& node,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    auto file = os.open_ofstream(
+            path,
+            std::ios_base::out | std::ios_base::app);
+    if(!file || !file->is_open())
+    {
+        ec = error_code::cant_write_session_graph;
+
+        return;
+    }
+
+    // single write, so lines of concurrent builds don't interleave
+    std::stringstream ss;
+
+    ss << node.job << " "
+       << node.build << " "
+       << (node.parent_job.empty() ? "-" : node.parent_job) << " "
+       << (node.parent_build.empty() ? "-" : node.parent_build) << " "
+       << node.started_ms << " "
+       << node.finished_ms << " "
+       << node.exit_code << "\n";
+
+    file->ostream() << ss.str() << std::flush;
+}
+
+std::vector<graph_node> read_session_graph(
+        const std::filesystem::path& path,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    auto file = os.open_ifstream(path);
+    if(!file || !file->is_open())
+    {
+        ec = error_code::cant_read_session_graph;
+
+        return {};
+    }
+
+    std::vector<graph_node> result;
+    std::string line;
+
+    while(std::getline(file->istream(), line))
+    {
+        std::stringstream ss(line);
+        graph_node node;
+
+        ss >> node.job
+           >> node.build
+           >> node.parent_job
+           >> node.parent_build
+           >> node.started_ms
+           >> node.finished_ms
+           >> node.exit_code;
+
+        // line may be torn if startjob was killed, it is skipped
+        if(ss.fail())
+        {
+            continue;
+        }
+
+        if(node.parent_job == "-")
+        {
+            node.parent_job.clear();
+        }
+
+        if(node.parent_build == "-")
+        {
+            node.parent_build.clear();
+        }
+
+        result.push_back(std::move(node));
+    }
+
+    return result;
+}
+
+graph_summary analyze_session_graph(const std::vector<graph_node>& nodes)
+{
+    graph_summary summary;
+
+    if(nodes.empty())
+    {
+        return summary;
+    }
+
+    std::map<std::pair<std::string, std::string>, size_t> by_build;
+
+    for(size_t i = 0; i < nodes.size(); ++i)
+    {
+        by_build.emplace(std::pair{nodes[i].job, nodes[i].build}, i);
+    }
+
+    std::vector<std::vector<size_t>> children(nodes.size());
+    std::vector<size_t> roots;
+
+    for(size_t i = 0; i < nodes.size(); ++i)
+    {
+        auto it = by_build.find({nodes[i].job, nodes[i].build});
+        if(it->second != i)
+        {
+            // duplicated record, first one is used
+            continue;
+        }
+
+        auto parent = by_build.find(
+                {nodes[i].parent_job, nodes[i].parent_build});
+        if(parent == by_build.end() || parent->second == i)
+        {
+            roots.push_back(i);
+        }
+        else
+        {
+            children[parent->second].push_back(i);
+        }
+    }
+
+    auto duration = [&](size_t i)
+    {
+        return nodes[i].finished_ms - nodes[i].started_ms;
+    };
+
+    auto children_intervals = [&](size_t i)
+    {
+        std::vector<interval> intervals;
+
+        for(auto child : children[i])
+        {
+            intervals.emplace_back(
+                    nodes[child].started_ms,
+                    nodes[child].finished_ms);
+        }
+
+        return intervals;
+    };
+
+    std::vector<int64_t> self(nodes.size(), 0);
+
+    int64_t first_start = nodes.front().started_ms;
+    int64_t last_finish = nodes.front().finished_ms;
+
+    for(auto& [key, i] : by_build)
+    {
+        self[i] = duration(i) - union_length(
+                children_intervals(i),
+                nodes[i].started_ms,
+                nodes[i].finished_ms);
+
+        summary.work_ms += self[i];
+
+        first_start = std::min(first_start, nodes[i].started_ms);
+        last_finish = std::max(last_finish, nodes[i].finished_ms);
+
+        if(children[i].size() > 1)
+        {
+            int64_t children_ms = 0;
+
+            for(auto child : children[i])
+            {
+                children_ms += duration(child);
+            }
+
+            summary.fan_outs.push_back({
+                    i,
+                    children[i].size(),
+                    children_ms,
+                    union_length(
+                            children_intervals(i),
+                            nodes[i].started_ms,
+                            nodes[i].finished_ms)});
+        }
+    }
+
+    summary.wall_ms = last_finish - first_start;
+
+    if(summary.wall_ms > 0)
+    {
+        summary.parallelism = static_cast<double>(summary.work_ms)
+                            / summary.wall_ms;
+    }
+
+    std::sort(
+            summary.fan_outs.begin(),
+            summary.fan_outs.end(),
+            [](auto& lhs, auto& rhs)
+            {
+                return lhs.busy_ms > rhs.busy_ms;
+            });
+
+    auto finished_last = [&](const std::vector<size_t>& candidates)
+    {
+        return *std::max_element(
+                candidates.begin(),
+                candidates.end(),
+                [&](size_t lhs, size_t rhs)
+                {
+                    return nodes[lhs].finished_ms < nodes[rhs].finished_ms;
+                });
+    };
+
+    // every build has parent only if parent links make a cycle
+    if(roots.empty())
+    {
+        return summary;
+    }
+
+    for(auto i = finished_last(roots);;)
+    {
+        summary.critical_path.push_back({i, duration(i), self[i]});
+
+        if(children[i].empty())
+        {
+            break;
+        }
+
+        i = finished_last(children[i]);
+    }
+
+    return summary;
+}
+
+} // namespace cis1
@@ -0,0 +1,192 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include "session_id.h"
+
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+#include <boost/process/environment.hpp>
+
+namespace cis1
+{
+
+namespace
+{
+
+const char crockford[] = "0123456789ABCDEFGHJKMNPQRSTVWXYZ";
+
+int crockford_value(char c)
+{
+    if(c >= 'a' && c <= 'z')
+    {
+        c = c - 'a' + 'A';
+    }
+
+    for(int i = 0; i < 32; ++i)
+    {
+        if(crockford[i] == c)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+uint64_t mix(uint64_t x)
+{
+    // splitmix64 finalizer
+    x += 0x9e3779b97f4a7c15;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+uint64_t make_seed()
+{
+    std::random_device device;
+
+    uint64_t seed = (static_cast<uint64_t>(device()) << 32) | device();
+
+    // random_device may be deterministic on some platforms
+    seed = mix(seed ^ static_cast<uint64_t>(boost::this_process::get_id()));
+    seed = mix(seed ^ static_cast<uint64_t>(
+            std::chrono::high_resolution_clock::now().time_since_epoch().count()));
+
+    return seed;
+}
+
+std::optional<session_id_info> parse_legacy_session_id(const std::string& session_id)
+{
+    // YYYY-MM-DD-HH-MM-SS-pid_ppid
+    std::tm tm{};
+    std::istringstream ss(session_id);
+
+    ss >> std::get_time(&tm, "%Y-%m-%d-%H-%M-%S-");
+    if(ss.fail())
+    {
+        return std::nullopt;
+    }
+
+    auto pids = session_id.substr(static_cast<size_t>(ss.tellg()));
+    auto separator = pids.find('_');
+
+    if(separator == 0
+        || separator == std::string::npos
+        || separator + 1 == pids.size()
+        || pids.find_first_not_of("0123456789_") != std::string::npos
+        || pids.find('_', separator + 1) != std::string::npos)
+    {
+        return std::nullopt;
+    }
+
+    tm.tm_isdst = -1;
+
+    return session_id_info{static_cast<int64_t>(std::mktime(&tm)) * 1000, true};
+}
+
+} // namespace
+
+session_id_generator::session_id_generator()
+    : session_id_generator(make_seed())
+{}
+
+session_id_generator::session_id_generator(uint64_t seed)
+    : random_(seed)
+{}
+
+std::string session_id_generator::next()
+{
+    return next(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+std::string session_id_generator::next(int64_t unix_time_ms)
+{
+    uint64_t time;
+    uint16_t hi;
+    uint64_t lo;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if(unix_time_ms > last_ms_)
+        {
+            last_ms_ = unix_time_ms;
+            random_hi_ = static_cast<uint16_t>(random_());
+            random_lo_ = random_();
+        }
+        else if(++random_lo_ == 0 && ++random_hi_ == 0)
+        {
+            // random part overflow, borrow the next millisecond
+            ++last_ms_;
+        }
+
+        time = static_cast<uint64_t>(last_ms_);
+        hi = random_hi_;
+        lo = random_lo_;
+    }
+
+    char id[session_id_size];
+
+    // 48 bit time in 10 chars, upper 2 bits are zero
+    for(int i = 9; i >= 0; --i)
+    {
+        id[i] = crockford[time & 31];
+        time >>= 5;
+    }
+
+    // 80 random bits in 16 chars, 5 bits each from the lowest
+    for(int i = 25; i >= 10; --i)
+    {
+        id[i] = crockford[lo & 31];
+        lo = (lo >> 5) | (static_cast<uint64_t>(hi & 31) << 59);
+        hi >>= 5;
+    }
+
+    return std::string(id, session_id_size);
+}
+
+std::string generate_session_id()
+{
+    static session_id_generator generator;
+
+    return generator.next();
+}
+
+std::optional<session_id_info> parse_session_id(const std::string& session_id)
+{
+    if(session_id.size() != session_id_size)
+    {
+        return parse_legacy_session_id(session_id);
+    }
+
+    int64_t time = 0;
+
+    for(size_t i = 0; i < session_id_size; ++i)
+    {
+        auto value = crockford_value(session_id[i]);
+        if(value < 0 || (i == 0 && value > 7))
+        {
+            // legacy id may have the same length
+            return parse_legacy_session_id(session_id);
+        }
+
+        if(i < 10)
+        {
+            time = (time << 5) | value;
+        }
+    }
+
+    return session_id_info{time, false};
+}
+
+} // namespace cis1
@@ -0,0 +1,149 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include <iostream>
+
+#include <boost/program_options.hpp>
+
+#include "context.h"
+#include "os.h"
+#include "logger.h"
+#include "session_gc.h"
+#include "cis_version.h"
+
+namespace po = boost::program_options;
+
+int main(int argc, char* argv[])
+{
+    po::options_description desc("Sessiongc options");
+    desc.add_options()
+        ("help", "produce help message")
+        ("version", "print version")
+        ("scan", "also list sessions dir and remove abandoned sessions")
+        ("keep_hours", po::value<uint32_t>(), "keep closed sessions for hours")
+        ("abandon_hours", po::value<uint32_t>(), "remove sessions without close record not modified for hours")
+        ("threads", po::value<uint32_t>(), "count of removing threads")
+        ("rate", po::value<uint32_t>(), "max removed files per second, 0 means no limit");
+
+    auto print_usage = [&]()
+    {
+        std::cout << "Usage: " << "\n"
+                  << desc << std::endl;
+    };
+
+    po::variables_map vm;
+
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+    }
+    catch(...)
+    {
+        std::cout << "Invalid args" << "\n";
+
+        print_usage();
+
+        return EXIT_FAILURE;
+    }
+
+    po::notify(vm);
+
+    if(vm.count("help"))
+    {
+        print_usage();
+
+        return EXIT_SUCCESS;
+    }
+    else if(vm.count("version"))
+    {
+        print_version();
+
+        return EXIT_SUCCESS;
+    }
+
+    cis1::os std_os;
+
+    std::error_code ec;
+
+    auto ctx_opt = cis1::init_context(ec, std_os);
+    if(ec)
+    {
+        std::cerr << ec.message() << std::endl;
+
+        return 1;
+    }
+    auto& ctx = ctx_opt.value();
+
+    // session id is not specified here
+    const auto session_id = std::nullopt;
+    const CoreLogger::Options options
+            = make_logger_options(session_id, ctx, std_os);
+
+    init_cis_log(options, ctx);
+
+    auto gc_options = cis1::load_session_gc_options(ctx.env());
+
+    if(vm.count("keep_hours"))
+    {
+        gc_options.keep_closed = std::chrono::hours{vm["keep_hours"].as<uint32_t>()};
+    }
+
+    if(vm.count("abandon_hours"))
+    {
+        gc_options.keep_abandoned = std::chrono::hours{vm["abandon_hours"].as<uint32_t>()};
+    }
+
+    if(vm.count("threads"))
+    {
+        gc_options.threads = vm["threads"].as<uint32_t>();
+    }
+
+    if(vm.count("rate"))
+    {
+        gc_options.max_removes_per_second = vm["rate"].as<uint32_t>();
+    }
+
+    auto stats = cis1::collect_closed_sessions(
+            ctx.base_dir(),
+            gc_options,
+            ec,
+            std_os);
+
+    if(!ec && vm.count("scan"))
+    {
+        auto scan_stats = cis1::collect_abandoned_sessions(
+                ctx.base_dir(),
+                gc_options,
+                ec,
+                std_os);
+
+        stats.sessions += scan_stats.sessions;
+        stats.files += scan_stats.files;
+        stats.failed += scan_stats.failed;
+    }
+
+    std::cout << "sessions=" << stats.sessions
+              << " files=" << stats.files
+              << " failed=" << stats.failed << std::endl;
+
+    CIS_LOG(actions::session_gc,
+            "sessions=%s files=%s failed=%s",
+            stats.sessions,
+            stats.files,
+            stats.failed);
+
+    if(ec)
+    {
+        std::cerr << ec.message() << std::endl;
+        CIS_LOG(actions::error, "%s", ec.message());
+
+        return EXIT_FAILURE;
+    }
+
+    return stats.failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
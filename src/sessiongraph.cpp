@@ -0,0 +1,104 @@
+/*
+ *    TomskSoft CIS1 Core
+ *
+ *   (c) 2019 TomskSoft LLC
+ *   (c) Mokin Innokentiy [mia@tomsksoft.com]
+ *
+ */
+
+#include <iostream>
+#include <iomanip>
+
+#include "context.h"
+#include "os.h"
+#include "session_graph.h"
+#include "cis_version.h"
+
+void usage(const char* self_name)
+{
+    std::cout << "Usage: \n"
+              << "\t" << self_name << " ${session_id}" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc == 2 && strcmp(argv[1], "--version") == 0)
+    {
+        print_version();
+
+        return EXIT_SUCCESS;
+    }
+
+    if(argc != 2)
+    {
+        usage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    cis1::os std_os;
+
+    std::error_code ec;
+
+    auto ctx_opt = cis1::init_context(ec, std_os);
+    if(ec)
+    {
+        std::cerr << ec.message() << std::endl;
+
+        return 1;
+    }
+    auto& ctx = ctx_opt.value();
+
+    auto nodes = cis1::read_session_graph(
+            cis1::session_graph_path(ctx.base_dir(), argv[1]),
+            ec,
+            std_os);
+    if(ec)
+    {
+        std::cout << ec.message() << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    auto summary = cis1::analyze_session_graph(nodes);
+
+    auto build_name = [&](size_t i)
+    {
+        return nodes[i].job + "#" + nodes[i].build;
+    };
+
+    std::cout << "builds=" << nodes.size()
+              << " wall_ms=" << summary.wall_ms
+              << " work_ms=" << summary.work_ms
+              << " parallelism=" << std::fixed << std::setprecision(2)
+              << summary.parallelism << "\n";
+
+    std::cout << "critical path:\n";
+
+    for(auto& step : summary.critical_path)
+    {
+        std::cout << "\t" << build_name(step.node)
+                  << " duration_ms=" << step.duration_ms
+                  << " self_ms=" << step.self_ms << "\n";
+    }
+
+    // children_ms / busy_ms close to 1 means children ran one by one
+    std::cout << "fan-outs:\n";
+
+    for(auto& fan_out : summary.fan_outs)
+    {
+        std::cout << "\t" << build_name(fan_out.node)
+                  << " children=" << fan_out.children
+                  << " children_ms=" << fan_out.children_ms
+                  << " busy_ms=" << fan_out.busy_ms
+                  << " parallelism=" << (fan_out.busy_ms > 0
+                            ? static_cast<double>(fan_out.children_ms)
+                                    / fan_out.busy_ms
+                            : 0.)
+                  << "\n";
+    }
+
+    std::cout << std::flush;
+
+    return EXIT_SUCCESS;
+}
@@ -10,20 +10,33 @@
 
 #include <cis1_proto_utils/param_codec.h>
 
+#include "utils.h"
+
 namespace cis1
 {
 
-void set_param(
+void set_params(
         const cis1::context_interface& ctx,
         const session_interface& session,
-        const std::string& param_name,
-        const std::string& value,
+        const std::vector<std::pair<std::string, std::string>>& new_params,
         std::error_code& ec,
         const os_interface& os)
 {
     auto session_prm = ctx.base_dir() / "sessions" / (session.session_id() + ".prm");
 
-    std::map<std::string, std::string> values;
+    // concurrent batches would drop keys of each other between read and rename
+    auto lock_path = session_prm;
+    lock_path += ".lock";
+
+    auto lock = os.open_lock_file(lock_path, ec);
+    if(!lock || !lock->lock())
+    {
+        ec = cis1::error_code::cant_write_session_params_file;
+
+        return;
+    }
+
+    std::map<std::string, std::string> params;
     if(os.exists(session_prm, ec))
     {
         auto session_prm_file = os.open_ifstream(session_prm);
@@ -33,7 +46,8 @@ void set_param(
 
             return;
         }
-        proto_utils::read_istream_kv_str(session_prm_file->istream(), values, ec);
+
+        proto_utils::read_istream_kv_str(session_prm_file->istream(), params, ec);
         if(ec)
         {
             ec = cis1::error_code::cant_read_session_values_file;
@@ -42,32 +56,66 @@ void set_param(
         }
     }
 
-    auto session_prm_file = os.open_ofstream(session_prm, std::ios::trunc);
-    if(!session_prm_file || !session_prm_file->is_open())
+    if(ec)
     {
-        ec = cis1::error_code::cant_write_session_params_file;
+        ec = cis1::error_code::cant_read_session_values_file;
 
         return;
     }
 
-    const auto encoded_param_name = proto_utils::encode_param(param_name);
-    const auto encoded_value = proto_utils::encode_param(value);
+    for(auto& [param_name, value] : new_params)
+    {
+        params[proto_utils::encode_param(param_name)]
+                = proto_utils::encode_param(value);
+    }
+
+    // readers see either old or new file, never partially written one
+    auto tmp_prm = tmp_file_path(session_prm);
 
-    bool found = false;
-    for(auto& [k, v] : values)
     {
-        if(k == encoded_param_name)
+        auto session_prm_file = os.open_ofstream(tmp_prm, std::ios::trunc);
+        if(!session_prm_file || !session_prm_file->is_open())
+        {
+            ec = cis1::error_code::cant_write_session_params_file;
+
+            return;
+        }
+
+        auto& out = session_prm_file->ostream();
+        for(auto& [k, v] : params)
+        {
+            out << k << '=' << v << '\n';
+        }
+
+        if(!out.flush())
         {
-            v = encoded_value;
-            found = true;
+            ec = cis1::error_code::cant_write_session_params_file;
         }
-        session_prm_file->ostream() << k << '=' << v << '\n';
     }
 
-    if(!found)
+    if(!ec)
     {
-        session_prm_file->ostream() << encoded_param_name << '=' << encoded_value << '\n';
+        os.rename(tmp_prm, session_prm, ec);
+    }
+
+    if(ec)
+    {
+        std::error_code remove_ec;
+        os.remove(tmp_prm, remove_ec);
+
+        ec = cis1::error_code::cant_write_session_params_file;
     }
 }
 
+void set_param(
+        const cis1::context_interface& ctx,
+        const session_interface& session,
+        const std::string& param_name,
+        const std::string& value,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    set_params(ctx, session, {{param_name, value}}, ec, os);
+}
+
 } // namespace cis1
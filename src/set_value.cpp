@@ -10,19 +10,32 @@
 
 #include <cis1_proto_utils/param_codec.h>
 
+#include "utils.h"
+
 namespace cis1
 {
 
-void set_value(
+void set_values(
         const cis1::context_interface& ctx,
         const session_interface& session,
-        const std::string& value_name,
-        const std::string& value,
+        const std::vector<std::pair<std::string, std::string>>& new_values,
         std::error_code& ec,
         const os_interface& os)
 {
     auto session_dat = ctx.base_dir() / "sessions" / (session.session_id() + ".dat");
 
+    // concurrent batches would drop keys of each other between read and rename
+    auto lock_path = session_dat;
+    lock_path += ".lock";
+
+    auto lock = os.open_lock_file(lock_path, ec);
+    if(!lock || !lock->lock())
+    {
+        ec = cis1::error_code::cant_write_session_values_file;
+
+        return;
+    }
+
     std::map<std::string, std::string> values;
     if(os.exists(session_dat, ec))
     {
@@ -43,32 +56,66 @@ void set_value(
         }
     }
 
-    auto session_dat_file = os.open_ofstream(session_dat, std::ios::trunc);
-    if(!session_dat_file || !session_dat_file->is_open())
+    if(ec)
     {
         ec = cis1::error_code::cant_read_session_values_file;
 
         return;
     }
 
-    const auto encoded_value_name = proto_utils::encode_param(value_name);
-    const auto encoded_value = proto_utils::encode_param(value);
+    for(auto& [value_name, value] : new_values)
+    {
+        values[proto_utils::encode_param(value_name)]
+                = proto_utils::encode_param(value);
+    }
+
+    // readers see either old or new file, never partially written one
+    auto tmp_dat = tmp_file_path(session_dat);
 
-    bool found = false;
-    for(auto& [k, v] : values)
     {
-        if(k == encoded_value_name)
+        auto session_dat_file = os.open_ofstream(tmp_dat, std::ios::trunc);
+        if(!session_dat_file || !session_dat_file->is_open())
+        {
+            ec = cis1::error_code::cant_write_session_values_file;
+
+            return;
+        }
+
+        auto& out = session_dat_file->ostream();
+        for(auto& [k, v] : values)
         {
-            v = encoded_value;
-            found = true;
+            out << k << '=' << v << '\n';
+        }
+
+        if(!out.flush())
+        {
+            ec = cis1::error_code::cant_write_session_values_file;
         }
-        session_dat_file->ostream() << k << '=' << v << '\n';
     }
 
-    if(!found)
+    if(!ec)
     {
-        session_dat_file->ostream() << encoded_value_name << '=' << encoded_value << '\n';
+        os.rename(tmp_dat, session_dat, ec);
     }
+
+    if(ec)
+    {
+        std::error_code remove_ec;
+        os.remove(tmp_dat, remove_ec);
+
+        ec = cis1::error_code::cant_write_session_values_file;
+    }
+}
+
+void set_value(
+        const cis1::context_interface& ctx,
+        const session_interface& session,
+        const std::string& value_name,
+        const std::string& value,
+        std::error_code& ec,
+        const os_interface& os)
+{
+    set_values(ctx, session, {{value_name, value}}, ec, os);
 }
 
 } // namespace cis1
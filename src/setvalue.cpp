@@ -11,6 +11,7 @@
 #include "context.h"
 #include "session.h"
 #include "set_value.h"
+#include "kv_batch.h"
 #include "logger.h"
 #include "os.h"
 #include "webui_session.h"
@@ -19,7 +20,7 @@
 void usage()
 {
     std::cout << "Usage:" << "\n"
-              << "setvalue value_name value_value" << std::endl;
+              << "setvalue value_name value_value [name value...]" << std::endl;
 }
 
 int main(int argc, char *argv[])
@@ -64,7 +65,8 @@ int main(int argc, char *argv[])
 
     init_session_log(options, ctx, session);
 
-    if(argc != 3)
+    auto values = cis1::parse_kv_set_args({argv + 1, argv + argc});
+    if(!values)
     {
         std::cerr << "Wrong arguments" << std::endl;
         TEE_LOG(actions::error, "Wrong args count in setvalue");
@@ -80,7 +82,7 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    cis1::set_value(ctx, session, argv[1], argv[2], ec, std_os);
+    cis1::set_values(ctx, session, values.value(), ec, std_os);
     if(ec)
     {
         std::cerr << ec.message() << std::endl;
@@ -89,6 +91,6 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    SES_LOG(actions::setvalue, R"("%s"="%s")", argv[1], argv[2]);
+    SES_LOG(actions::setvalue, "%s", cis1::format_kv_record(values.value()));
     return 0;
 }
@@ -10,6 +10,8 @@
 #include <vector>
 #include <string>
 #include <optional>
+#include <list>
+#include <set>
 
 #include <boost/program_options.hpp>
 #include <cis1_proto_utils/param_codec.h>
@@ -21,12 +23,27 @@
 #include "logger.h"
 #include "os.h"
 #include "webui_session.h"
+#include "session_graph.h"
+#include "log_rotation.h"
+#include "session_gc.h"
+#include "parallel_builds.h"
+#include "utils.h"
 #include "cis_version.h"
 
 namespace po = boost::program_options;
 
 std::optional<std::map<std::string, std::string>> prepared_params(po::variables_map& vm);
 
+int start_parallel(
+        const std::vector<std::string>& job_names,
+        size_t max_parallel,
+        bool force,
+        std::optional<uint32_t> timeout,
+        const std::optional<std::map<std::string, std::string>>& predefined_params,
+        cis1::context_interface& ctx,
+        cis1::session& session,
+        cis1::os& std_os);
+
 int main(int argc, char* argv[])
 {
     po::options_description common_desc("Common options");
@@ -38,7 +55,10 @@ int main(int argc, char* argv[])
     startjob_desc.add_options()
         ("force", "try to start job even if script is not executable")
         ("new_session", "makes new child session")
-        ("params", po::value<std::vector<std::string>>()->multitoken(), "params passed to job");
+        ("timeout", po::value<uint32_t>(), "build timeout in seconds, overrides job.conf (0 disables)")
+        ("params", po::value<std::vector<std::string>>()->multitoken(), "params passed to job")
+        ("parallel", po::value<std::vector<std::string>>()->multitoken(), "run several jobs concurrently (must be first arg instead of job name)")
+        ("max_parallel", po::value<size_t>(), "max count of concurrent builds with --parallel (0 means no limit)");
 
     auto print_usage = [&]()
     {
@@ -56,9 +76,14 @@ int main(int argc, char* argv[])
 
     po::variables_map vm;
 
+    const bool parallel = strcmp(argv[1], "--parallel") == 0;
+
     try
     {
-        po::store(po::parse_command_line(2, argv, common_desc), vm);
+        if(!parallel)
+        {
+            po::store(po::parse_command_line(2, argv, common_desc), vm);
+        }
     }
     catch(...)
     {
@@ -86,7 +111,15 @@ int main(int argc, char* argv[])
 
     try
     {
-        po::store(po::parse_command_line(argc - 1, argv + 1, startjob_desc), vm);
+        // there is no job name before options in parallel mode
+        if(parallel)
+        {
+            po::store(po::parse_command_line(argc, argv, startjob_desc), vm);
+        }
+        else
+        {
+            po::store(po::parse_command_line(argc - 1, argv + 1, startjob_desc), vm);
+        }
     }
     catch(...)
     {
@@ -105,7 +138,7 @@ int main(int argc, char* argv[])
 
     auto predefined_params = prepared_params(vm);
 
-    std::string job_name = argv[1];
+    std::string job_name = parallel ? "" : argv[1];
 
     cis1::os std_os;
 
@@ -148,9 +181,31 @@ int main(int argc, char* argv[])
         CIS_LOG(actions::open_session, "start");
 
         session.on_close(
-                [](cis1::session_interface&)
+                [&ctx, &std_os](cis1::session_interface& closed_session)
                 {
                     CIS_LOG(actions::close_session, "stop");
+
+                    std::error_code ec;
+                    cis1::update_session_index(
+                            ctx.base_dir(),
+                            closed_session.session_id(),
+                            ec,
+                            std_os);
+                    if(ec)
+                    {
+                        CIS_LOG(actions::error, "%s", ec.message());
+                    }
+
+                    ec.clear();
+                    cis1::record_closed_session(
+                            ctx.base_dir(),
+                            closed_session.session_id(),
+                            ec,
+                            std_os);
+                    if(ec)
+                    {
+                        CIS_LOG(actions::error, "%s", ec.message());
+                    }
                 });
     }
 
@@ -159,6 +214,25 @@ int main(int argc, char* argv[])
         WEBUI_LOG(actions::startjob_stdout, R"(%s)", session.session_id());
     }
 
+    if(parallel)
+    {
+        std::optional<uint32_t> timeout;
+        if(vm.count("timeout"))
+        {
+            timeout = vm["timeout"].as<uint32_t>();
+        }
+
+        return start_parallel(
+                vm["parallel"].as<std::vector<std::string>>(),
+                vm.count("max_parallel") ? vm["max_parallel"].as<size_t>() : 0,
+                force,
+                timeout,
+                predefined_params,
+                ctx,
+                session,
+                std_os);
+    }
+
     auto job_opt = cis1::load_job(job_name, ec, ctx, std_os);
     if(ec)
     {
@@ -168,6 +242,11 @@ int main(int argc, char* argv[])
     }
     auto& job = job_opt.value();
 
+    if(vm.count("timeout"))
+    {
+        job.set_timeout(vm["timeout"].as<uint32_t>());
+    }
+
     auto params = job.params();
     if(!params.empty() && session.opened_by_me() && !predefined_params)
     {
@@ -222,14 +301,20 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    if(auto var = std_os.get_env_var("job_name"); !var.empty())
+    cis1::graph_node graph_node;
+    graph_node.job = job_name;
+    graph_node.build = build_handle.number_string();
+    graph_node.parent_job = std_os.get_env_var("job_name");
+    graph_node.parent_build = std_os.get_env_var("build_number");
+
+    if(!graph_node.parent_job.empty())
     {
-        ctx.set_env_var("parent_job_name", var);
+        ctx.set_env_var("parent_job_name", graph_node.parent_job);
     }
 
-    if(auto var = std_os.get_env_var("build_number"); !var.empty())
+    if(!graph_node.parent_build.empty())
     {
-        ctx.set_env_var("parent_job_build_number", var);
+        ctx.set_env_var("parent_job_build_number", graph_node.parent_build);
     }
 
     ctx.set_env_var("job_name", job_name);
@@ -237,8 +322,18 @@ int main(int argc, char* argv[])
     ctx.set_env_var("build_number", build_handle.number_string());
 
     SES_LOG(actions::start_job, R"(job_name="%s")", job_name);
+    SES_DEBUG(
+            actions::start_job,
+            R"(job_name="%s" build_number="%s" params=%s parent_job_name="%s")",
+            job_name,
+            build_handle.number_string(),
+            params.size(),
+            graph_node.parent_job);
 
     int exit_code = -1;
+    std::optional<cis1::build_stats> stats;
+
+    graph_node.started_ms = unix_time_now_ms();
 
     build_handle.execute(
             ctx,
@@ -248,7 +343,24 @@ int main(int argc, char* argv[])
             {
                 WEBUI_LOG(error ? actions::startjob_stderr : actions::startjob_stdout, R"(%s)", str);
             },
-            exit_code);
+            exit_code,
+            stats);
+
+    graph_node.finished_ms = unix_time_now_ms();
+    graph_node.exit_code = exit_code;
+
+    std::error_code graph_ec;
+
+    cis1::append_graph_node(
+            cis1::session_graph_path(ctx.base_dir(), session.session_id()),
+            graph_node,
+            graph_ec,
+            std_os);
+    if(graph_ec)
+    {
+        CIS_LOG(actions::error, "%s", graph_ec.message());
+    }
+
     if(ec)
     {
         std::cerr << ec.message() << std::endl;
@@ -257,6 +369,22 @@ int main(int argc, char* argv[])
         return 1;
     }
 
+    if(stats && stats->timed_out)
+    {
+        std::cerr << "Build timed out" << std::endl;
+        TEE_LOG(actions::error, "Build timed out after %s seconds",
+                std::to_string(job.timeout()));
+    }
+
+    if(stats)
+    {
+        CIS_LOG(actions::job_stats,
+                R"(job_name="%s" build_number="%s" %s)",
+                job_name,
+                build_handle.number_string(),
+                cis1::format_build_stats(stats.value()));
+    }
+
     SES_LOG(actions::finish_job, R"(job_name="%s")", job_name);
 
     if(!session.opened_by_me())
@@ -316,7 +444,7 @@ int main(int argc, char* argv[])
     std_os.spawn_process(
             ctx.base_dir(),
             std::filesystem::path{"core"} / ctx.get_env_var("maintenance"),
-            {"--job", job_name},
+            {"--job", job_name, "--session", session.session_id()},
             ctx.env());
 }
 
@@ -345,3 +473,267 @@ std::optional<std::map<std::string, std::string>> prepared_params(po::variables_
 
     return std::nullopt;
 }
+
+int start_parallel(
+        const std::vector<std::string>& job_names,
+        size_t max_parallel,
+        bool force,
+        std::optional<uint32_t> timeout,
+        const std::optional<std::map<std::string, std::string>>& predefined_params,
+        cis1::context_interface& ctx,
+        cis1::session& session,
+        cis1::os& std_os)
+{
+    std::error_code ec;
+
+    // builds keep references to jobs
+    std::list<cis1::job> jobs;
+    std::vector<cis1::parallel_build> builds;
+
+    auto parent_job = std_os.get_env_var("job_name");
+    auto parent_build = std_os.get_env_var("build_number");
+
+    std::vector<std::vector<std::pair<std::string, std::string>>> job_params;
+
+    // all jobs are loaded before first build is prepared,
+    // so invalid job name doesn't leave pending builds
+    for(auto& job_name : job_names)
+    {
+        auto job_opt = cis1::load_job(job_name, ec, ctx, std_os);
+        if(ec)
+        {
+            std::cout << job_name << ": " << ec.message() << std::endl;
+
+            return EXIT_FAILURE;
+        }
+        auto& job = jobs.emplace_back(std::move(job_opt.value()));
+
+        if(timeout)
+        {
+            job.set_timeout(timeout.value());
+        }
+
+        // params can't be asked interactively for several jobs
+        auto& params = job_params.emplace_back(job.params());
+        if(predefined_params)
+        {
+            for(auto& [k, v] : params)
+            {
+                if(auto it = predefined_params->find(k);
+                        it != predefined_params->end())
+                {
+                    v = it->second;
+                }
+            }
+        }
+        else if(!params.empty())
+        {
+            cis1::prepare_params(params, std_os, ctx, session, ec);
+            if(ec)
+            {
+                std::cerr << job_name << ": " << ec.message() << std::endl;
+                TEE_LOG(actions::error, "%s", ec.message());
+
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    auto params_it = job_params.begin();
+
+    for(auto& job : jobs)
+    {
+        auto& job_name = job.name();
+
+        auto build_handle = job.prepare_build(ctx, session, *params_it++, ec);
+        if(ec)
+        {
+            std::cerr << job_name << ": " << ec.message() << std::endl;
+            TEE_LOG(actions::error, "%s", ec.message());
+
+            // none of builds is started, so prepared ones are removed
+            for(auto& build : builds)
+            {
+                std::error_code discard_ec;
+
+                build.build_job.discard_build(build.build_number, discard_ec);
+                if(discard_ec)
+                {
+                    CIS_LOG(actions::error, "%s", discard_ec.message());
+                }
+            }
+
+            return EXIT_FAILURE;
+        }
+
+        auto env = ctx.env();
+
+        if(!parent_job.empty())
+        {
+            env.set("parent_job_name", parent_job);
+        }
+
+        if(!parent_build.empty())
+        {
+            env.set("parent_job_build_number", parent_build);
+        }
+
+        env.set("job_name", job_name);
+        env.set("build_number", build_handle.number_string());
+
+        builds.push_back({job, build_handle.number(), std::move(env)});
+    }
+
+    auto build_name = [&](const cis1::parallel_build& build)
+    {
+        std::stringstream ss;
+
+        ss << std::setfill('0') << std::setw(6) << build.build_number;
+
+        return ss.str();
+    };
+
+    cis1::run_parallel(
+            builds,
+            max_parallel,
+            ctx,
+            force,
+            [&](cis1::parallel_build& build)
+            {
+                SES_LOG(actions::start_job, R"(job_name="%s")", build.build_job.name());
+                SES_DEBUG(
+                        actions::start_job,
+                        R"(job_name="%s" build_number="%s" parallel=%s)",
+                        build.build_job.name(),
+                        build_name(build),
+                        max_parallel);
+            },
+            [&](cis1::parallel_build& build)
+            {
+                auto& job_name = build.build_job.name();
+
+                cis1::graph_node graph_node;
+                graph_node.job = job_name;
+                graph_node.build = build_name(build);
+                graph_node.parent_job = parent_job;
+                graph_node.parent_build = parent_build;
+                graph_node.started_ms = build.started_ms;
+                graph_node.finished_ms = build.finished_ms;
+                graph_node.exit_code = build.exit_code;
+
+                std::error_code graph_ec;
+
+                cis1::append_graph_node(
+                        cis1::session_graph_path(ctx.base_dir(), session.session_id()),
+                        graph_node,
+                        graph_ec,
+                        std_os);
+                if(graph_ec)
+                {
+                    CIS_LOG(actions::error, "%s", graph_ec.message());
+                }
+
+                if(build.ec)
+                {
+                    std::cerr << job_name << ": " << build.ec.message() << std::endl;
+                    TEE_LOG(actions::error, "%s", build.ec.message());
+
+                    return;
+                }
+
+                if(build.stats && build.stats->timed_out)
+                {
+                    std::cerr << job_name << ": Build timed out" << std::endl;
+                    TEE_LOG(actions::error, "Build timed out after %s seconds",
+                            std::to_string(build.build_job.timeout()));
+                }
+
+                if(build.stats)
+                {
+                    CIS_LOG(actions::job_stats,
+                            R"(job_name="%s" build_number="%s" %s)",
+                            job_name,
+                            build_name(build),
+                            cis1::format_build_stats(build.stats.value()));
+                }
+
+                SES_LOG(actions::finish_job, R"(job_name="%s")", job_name);
+            },
+            [](cis1::parallel_build&, bool error, const std::string& str)
+            {
+                WEBUI_LOG(error ? actions::startjob_stderr : actions::startjob_stdout, R"(%s)", str);
+            });
+
+    // session values are written once, for the last build in args order
+    if(!session.opened_by_me())
+    {
+        auto& last = builds.back();
+
+        cis1::set_value(ctx, session, "last_job_name", last.build_job.name(), ec, std_os);
+        if(!ec)
+        {
+            cis1::set_value(
+                    ctx,
+                    session,
+                    "last_job_build_number",
+                    build_name(last),
+                    ec,
+                    std_os);
+        }
+        if(ec)
+        {
+            std::cerr << ec.message() << std::endl;
+            TEE_LOG(actions::error, "%s", ec.message());
+
+            return 1;
+        }
+    }
+
+    size_t failed = 0;
+
+    for(auto& build : builds)
+    {
+        std::stringstream ss;
+
+        ss << "session_id=" << session.session_id()
+           << " action=start_job"
+           << " job_name=" << build.build_job.name()
+           << " build_dir=" << build_name(build)
+           << " pid=" << ctx.process_id()
+           << " ppid=" << ctx.parent_startjob_id();
+
+        if(session.opened_by_me())
+        {
+            WEBUI_LOG(actions::startjob_stdout, R"(%s)", ss.str());
+        }
+
+        std::cout << ss.str() << std::endl;
+
+        ss.str("");
+
+        ss << "Exit code: " << build.exit_code;
+
+        if(session.opened_by_me())
+        {
+            WEBUI_LOG(actions::startjob_stdout, R"(%s)", ss.str());
+        }
+
+        std::cout << ss.str() << std::endl;
+
+        if(build.ec || build.exit_code != 0)
+        {
+            ++failed;
+        }
+    }
+
+    for(auto& job_name : std::set<std::string>(job_names.begin(), job_names.end()))
+    {
+        std_os.spawn_process(
+                ctx.base_dir(),
+                std::filesystem::path{"core"} / ctx.get_env_var("maintenance"),
+                {"--job", job_name, "--session", session.session_id()},
+                ctx.env());
+    }
+
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
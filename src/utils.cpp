@@ -8,12 +8,40 @@
 
 #include "utils.h"
 
-#include <regex>
+#include <chrono>
+#include <functional>
+#include <thread>
 
-bool is_build(const std::string& dir_name)
+#include <boost/process/environment.hpp>
+
+bool is_build(std::string_view dir_name)
 {
-    static const std::regex build_mask("^\\d{6}$");
-    return std::regex_match(dir_name, build_mask);
+    if(dir_name.size() != 6)
+    {
+        return false;
+    }
+
+    for(auto c : dir_name)
+    {
+        if(c < '0' || c > '9')
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+uint32_t build_number(std::string_view dir_name)
+{
+    uint32_t result = 0;
+
+    for(auto c : dir_name)
+    {
+        result = result * 10 + (c - '0');
+    }
+
+    return result;
 }
 
 std::optional<uint32_t> u32_from_string(const std::string& str)
@@ -27,3 +55,56 @@ std::optional<uint32_t> u32_from_string(const std::string& str)
         return std::nullopt;
     }
 }
+
+std::optional<bool> bool_from_string(const std::string& str)
+{
+    if(str == "true")
+    {
+        return true;
+    }
+
+    if(str == "false")
+    {
+        return false;
+    }
+
+    return std::nullopt;
+}
+
+bool starts_with(std::string_view str, std::string_view prefix)
+{
+    return str.substr(0, prefix.size()) == prefix;
+}
+
+bool ends_with(std::string_view str, std::string_view suffix)
+{
+    return str.size() >= suffix.size()
+        && str.substr(str.size() - suffix.size()) == suffix;
+}
+
+std::filesystem::path tmp_file_path(const std::filesystem::path& path)
+{
+    // threads of one host process (libcis1_core_c) may write the same file
+    auto tmp_path = path;
+    tmp_path += "." + std::to_string(boost::this_process::get_id())
+              + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()))
+              + ".tmp";
+
+    return tmp_path;
+}
+
+int64_t unix_time_now()
+{
+    using namespace std::chrono;
+
+    return duration_cast<seconds>(
+            system_clock::now().time_since_epoch()).count();
+}
+
+int64_t unix_time_now_ms()
+{
+    using namespace std::chrono;
+
+    return duration_cast<milliseconds>(
+            system_clock::now().time_since_epoch()).count();
+}
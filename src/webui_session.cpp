@@ -10,23 +10,18 @@
 
 #include <cis1_cwu_protocol/protocol.h>
 
-std::string get_address(const boost::process::environment& env)
+std::string get_address(const cis1::environment& env)
 {
-    if(auto addr = env.find("webui_internal_address"); addr != env.end())
-    {
-        return addr->to_string();
-    }
-
-    return {};
+    return env.get("webui_internal_address");
 }
 
-uint16_t get_port(const boost::process::environment& env)
+uint16_t get_port(const cis1::environment& env)
 {
-    if(auto port = env.find("webui_internal_port"); port != env.end())
+    if(auto port = env.find("webui_internal_port"); port)
     {
         try
         {
-            return std::stoul(port->to_string());
+            return std::stoul(std::string{port.value()});
         }
         catch(...)
         {
@@ -18,7 +18,7 @@ public:
 
     MOCK_CONST_METHOD0(
             env,
-            const boost::process::environment&());
+            const cis1::environment&());
 
     MOCK_CONST_METHOD0(
             base_dir,
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <gmock/gmock.h>
+
+#include "file_lock_interface.h"
+
+class file_lock_mock
+    : public cis1::file_lock_interface
+{
+public:
+    MOCK_METHOD0(lock, bool());
+
+    MOCK_METHOD0(lock_shared, bool());
+
+    MOCK_METHOD0(try_lock, bool());
+
+    MOCK_METHOD0(unlock, void());
+};
+
+/**
+ * \brief Action for open_lock_file returning lock taken exclusively once
+ */
+inline auto exclusive_file_lock()
+{
+    return [](auto&&...) -> std::unique_ptr<cis1::file_lock_interface>
+    {
+        using namespace ::testing;
+
+        auto lock = std::make_unique<StrictMock<file_lock_mock>>();
+
+        EXPECT_CALL(*lock, lock())
+            .WillOnce(Return(true));
+
+        return lock;
+    };
+}
+
+/**
+ * \brief Action for open_lock_file returning lock taken shared once
+ */
+inline auto shared_file_lock()
+{
+    return [](auto&&...) -> std::unique_ptr<cis1::file_lock_interface>
+    {
+        using namespace ::testing;
+
+        auto lock = std::make_unique<StrictMock<file_lock_mock>>();
+
+        EXPECT_CALL(*lock, lock_shared())
+            .WillOnce(Return(true));
+
+        return lock;
+    };
+}
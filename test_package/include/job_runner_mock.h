@@ -27,6 +27,10 @@ public:
                     on_exit_cb_t& on_exit_cb,
                     on_line_read_cb_t& on_out_line_read_cb,
                     on_line_read_cb_t& on_err_line_read_cb));
+
+    MOCK_CONST_METHOD0(
+            stats,
+            std::optional<cis1::build_stats>());
 };
 
 class job_runner_factory_mock
@@ -34,18 +38,20 @@ class job_runner_factory_mock
 public:
     std::unique_ptr<cis1::job_runner_interface> operator()(
             boost::asio::io_context& ctx,
-            boost::process::environment env,
+            const cis1::environment& env,
             const std::filesystem::path& working_dir,
+            const cis1::run_options& options,
             const cis1::os_interface& os) const
     {
-        return call_operator(ctx, env, working_dir, os);
+        return call_operator(ctx, env, working_dir, options, os);
     }
 
-    MOCK_CONST_METHOD4(
+    MOCK_CONST_METHOD5(
             call_operator,
             std::unique_ptr<cis1::job_runner_interface>(
                     boost::asio::io_context& ctx,
-                    boost::process::environment env,
+                    const cis1::environment& env,
                     const std::filesystem::path& working_dir,
+                    const cis1::run_options& options,
                     const cis1::os_interface& os));
 };
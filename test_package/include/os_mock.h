@@ -24,6 +24,12 @@ public:
             exists,
             bool(const std::filesystem::path& path, std::error_code& ec));
 
+    MOCK_CONST_METHOD3(
+            iterate_directory,
+            void(   const std::filesystem::path& path,
+                    const cis1::dir_entry_cb_t& cb,
+                    std::error_code& ec));
+
     MOCK_CONST_METHOD1(
             list_directory,
             std::vector<
@@ -40,6 +46,12 @@ public:
                     const std::filesystem::path& to,
                     std::error_code& ec));
 
+    MOCK_CONST_METHOD3(
+            rename,
+            void(   const std::filesystem::path& from,
+                    const std::filesystem::path& to,
+                    std::error_code& ec));
+
     MOCK_CONST_METHOD2(
             open_ifstream,
             std::unique_ptr<cis1::ifstream_interface>(
@@ -52,12 +64,18 @@ public:
                     const std::filesystem::path& path,
                     std::ios_base::openmode mode));
 
+    MOCK_CONST_METHOD2(
+            open_lock_file,
+            std::unique_ptr<cis1::file_lock_interface>(
+                    const std::filesystem::path& path,
+                    std::error_code& ec));
+
     MOCK_CONST_METHOD4(
             spawn_process,
             void(   const std::string& start_dir,
                     const std::string& executable,
                     const std::vector<std::string>& args,
-                    boost::process::environment env));
+                    const cis1::environment& env));
 
     MOCK_CONST_METHOD2(
             remove,
@@ -82,4 +100,17 @@ public:
             void(
                     const std::filesystem::path& path,
                     std::error_code& ec));
+
+    MOCK_CONST_METHOD2(
+            last_write_time,
+            std::filesystem::file_time_type(
+                    const std::filesystem::path& path,
+                    std::error_code& ec));
+
+    MOCK_CONST_METHOD3(
+            set_last_write_time,
+            void(
+                    const std::filesystem::path& path,
+                    std::filesystem::file_time_type time,
+                    std::error_code& ec));
 };
@@ -7,6 +7,8 @@
 
 #include <gmock/gmock.h>
 
+#include "process.h"
+
 class sys_stream_mock
 {
 public:
@@ -27,15 +29,16 @@ public:
 class process_mock
 {
 public:
-    MOCK_CONST_METHOD8(async_system,
+    MOCK_CONST_METHOD9(async_system,
             void(
                     boost::asio::io_context& io_ctx,
                     std::function<void(
                             boost::system::error_code err,
                             int exit_code)>&& cb,
                     std::string cmd,
-                    boost::process::environment env,
+                    const cis1::environment& env,
                     std::filesystem::path path,
+                    const cis1::child_setup& setup,
                     sys_stream_mock& std_in,
                     sys_stream_mock& std_out,
                     sys_stream_mock& std_err));
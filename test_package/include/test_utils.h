@@ -1,6 +1,41 @@
 #pragma once
 
 #include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "dir_entry.h"
+
+/**
+ * \brief Fixture with dir "cis1_${name}_${pid}" in system temp directory,
+ *        it is removed before and after each test
+ */
+class temp_dir_test
+    : public ::testing::Test
+{
+protected:
+    explicit temp_dir_test(const std::string& name)
+        : dir(std::filesystem::temp_directory_path()
+                / ("cis1_" + name + "_" + std::to_string(::getpid())))
+    {}
+
+    void SetUp() override
+    {
+        std::filesystem::remove_all(dir);
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::filesystem::path dir;
+};
 
 template <class Map>
 bool is_maps_equal(Map const &lhs, Map const &rhs)
@@ -9,3 +44,17 @@ bool is_maps_equal(Map const &lhs, Map const &rhs)
         && std::equal(lhs.begin(), lhs.end(),
                       rhs.begin());
 }
+
+inline auto iterate_entries(std::vector<cis1::dir_entry> entries)
+{
+    return [entries](auto&&, const cis1::dir_entry_cb_t& cb, auto&&)
+    {
+        for(auto& entry : entries)
+        {
+            if(!cb(entry))
+            {
+                break;
+            }
+        }
+    };
+}
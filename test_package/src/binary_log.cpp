@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+
+#include "binary_log.h"
+#include "error_code.h"
+#include "test_utils.h"
+
+class binary_log_test
+    : public temp_dir_test
+{
+protected:
+    binary_log_test()
+        : temp_dir_test("binary_log")
+        , path(dir / "cis.blog")
+    {}
+
+    std::filesystem::path path;
+};
+
+TEST_F(binary_log_test, round_trip)
+{
+    std::error_code ec;
+
+    {
+        auto first = cis1::binary_log_writer::open(path, 10, 1, "", ec);
+        ASSERT_FALSE(ec);
+
+        auto second = cis1::binary_log_writer::open(path, 11, 10, "session", ec);
+        ASSERT_FALSE(ec);
+
+        first->record(actions::start_job, R"(job_name="%s")", std::string("p/job"));
+        second->record(actions::job_stats, "build %s exit %s in %s s", 12u, -1, 0.5);
+        first->record(actions::finish_job, R"(job_name="%s")", "p/job");
+        first->record(actions::error, "no args");
+    }
+
+    // torn record of dying writer
+    std::ofstream(path, std::ios_base::app | std::ios_base::binary)
+            << std::string("\x40\x00\x00\x00\x03", 5);
+
+    std::ifstream file(path, std::ios_base::binary);
+
+    std::vector<cis1::binary_log_entry> entries;
+
+    cis1::read_binary_log(
+            file,
+            [&](const cis1::binary_log_entry& entry)
+            {
+                entries.push_back(entry);
+            },
+            ec);
+
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(entries.size(), 4);
+
+    ASSERT_EQ(entries[0].pid, 10);
+    ASSERT_EQ(entries[0].ppid, 1);
+    ASSERT_EQ(entries[0].session_id, "");
+    ASSERT_EQ(entries[0].action, static_cast<uint16_t>(actions::start_job));
+    ASSERT_EQ(entries[0].message, R"(job_name="p/job")");
+
+    ASSERT_EQ(entries[1].pid, 11);
+    ASSERT_EQ(entries[1].ppid, 10);
+    ASSERT_EQ(entries[1].session_id, "session");
+    ASSERT_EQ(entries[1].message, "build 12 exit -1 in 0.5 s");
+
+    ASSERT_EQ(entries[2].message, R"(job_name="p/job")");
+    ASSERT_EQ(entries[3].message, "no args");
+    ASSERT_LE(entries[0].time_ns, entries[3].time_ns);
+
+    auto line = cis1::format_binary_log_entry(entries[1]);
+    ASSERT_NE(line.find(" 11 10 session job_stats build 12"), std::string::npos);
+}
+
+TEST_F(binary_log_test, not_binary_log)
+{
+    std::stringstream ss("2019-01-01 00:00:00 text log line\n");
+
+    std::error_code ec;
+
+    cis1::read_binary_log(ss, [](auto&&){}, ec);
+
+    ASSERT_EQ(ec, cis1::error_code::cant_read_binary_log);
+}
@@ -0,0 +1,390 @@
+#include <gtest/gtest.h>
+
+#include "build_index.h"
+#include "error_code.h"
+#include "memory_os.h"
+#include "os_mock.h"
+#include "ifstream_mock.h"
+#include "ofstream_mock.h"
+#include "file_lock_mock.h"
+#include "test_utils.h"
+#include "utils.h"
+
+std::unique_ptr<cis1::ifstream_interface> make_ifstream(std::stringstream& ss)
+{
+    using namespace ::testing;
+
+    auto file = std::make_unique<StrictMock<ifstream_mock>>();
+
+    EXPECT_CALL(*file, is_open())
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(*file, istream())
+        .WillRepeatedly(ReturnRef(ss));
+
+    return file;
+}
+
+TEST(read_build_index, merges_records)
+{
+    using namespace ::testing;
+
+    StrictMock<os_mock> os;
+
+    std::filesystem::path job_dir = "test_base_dir/jobs/test_job";
+
+    std::stringstream index(
+            "000001 pending - 100 0 session_a\n"
+            "000002 pending - 200 0 session_b\n"
+            "000001 successful 0 0 150 -\n"
+            "000003 pending - 300 0 session_c\n"
+            "000002 broken 2 0 250 -\n"
+            "000003 removed - 0 0 -\n"
+            "000004 pend");
+
+    EXPECT_CALL(os, open_ifstream(job_dir / "builds.index", _))
+        .WillOnce(Return(ByMove(make_ifstream(index))));
+
+    std::error_code ec;
+
+    auto builds = cis1::read_build_index(job_dir, "test_job", ec, os);
+
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(builds.size(), 2);
+
+    ASSERT_EQ(builds[0].job, "test_job");
+    ASSERT_EQ(builds[0].number, 1);
+    ASSERT_EQ(builds[0].state, cis1::build_state::successful);
+    ASSERT_EQ(builds[0].exit_code, 0);
+    ASSERT_EQ(builds[0].started, 100);
+    ASSERT_EQ(builds[0].finished, 150);
+    ASSERT_EQ(builds[0].session_id, "session_a");
+
+    ASSERT_EQ(builds[1].number, 2);
+    ASSERT_EQ(builds[1].state, cis1::build_state::broken);
+    ASSERT_EQ(builds[1].exit_code, 2);
+    ASSERT_EQ(builds[1].started, 200);
+    ASSERT_EQ(builds[1].finished, 250);
+    ASSERT_EQ(builds[1].session_id, "session_b");
+}
+
+TEST(read_build_index, scans_build_dirs_without_index)
+{
+    using namespace ::testing;
+
+    StrictMock<os_mock> os;
+
+    std::filesystem::path job_dir = "test_base_dir/jobs/test_job";
+
+    EXPECT_CALL(os, open_ifstream(job_dir / "builds.index", _))
+        .WillOnce(Return(ByMove(nullptr)));
+
+    EXPECT_CALL(os, iterate_directory(job_dir, _, _))
+        .WillOnce(Invoke(iterate_entries({
+                {"000002", cis1::dir_entry_type::directory, 1},
+                {"000001", cis1::dir_entry_type::directory, 2},
+                {"job.conf", cis1::dir_entry_type::regular, 3}})));
+
+    std::stringstream exitcode("1\n");
+    std::stringstream session_a("session_a\n");
+    std::stringstream session_b("session_b\n");
+
+    EXPECT_CALL(os, open_ifstream(job_dir / "000001" / "exitcode.txt", _))
+        .WillOnce(Return(ByMove(make_ifstream(exitcode))));
+
+    EXPECT_CALL(os, open_ifstream(job_dir / "000001" / "session_id.txt", _))
+        .WillOnce(Return(ByMove(make_ifstream(session_a))));
+
+    EXPECT_CALL(os, open_ifstream(job_dir / "000002" / "exitcode.txt", _))
+        .WillOnce(Return(ByMove(nullptr)));
+
+    EXPECT_CALL(os, open_ifstream(job_dir / "000002" / "session_id.txt", _))
+        .WillOnce(Return(ByMove(make_ifstream(session_b))));
+
+    std::error_code ec;
+
+    auto builds = cis1::read_build_index(job_dir, "test_job", ec, os);
+
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(builds.size(), 2);
+
+    ASSERT_EQ(builds[0].number, 1);
+    ASSERT_EQ(builds[0].state, cis1::build_state::broken);
+    ASSERT_EQ(builds[0].exit_code, 1);
+    ASSERT_EQ(builds[0].session_id, "session_a");
+
+    ASSERT_EQ(builds[1].number, 2);
+    ASSERT_EQ(builds[1].state, cis1::build_state::pending);
+    ASSERT_EQ(builds[1].exit_code, std::nullopt);
+    ASSERT_EQ(builds[1].session_id, "session_b");
+}
+
+TEST(append_build_record, correct)
+{
+    using namespace ::testing;
+
+    StrictMock<os_mock> os;
+
+    std::filesystem::path job_dir = "test_base_dir/jobs/test_job";
+
+    EXPECT_CALL(os, open_lock_file(job_dir / "builds.index.lock", _))
+        .WillOnce(Invoke(shared_file_lock()));
+
+    EXPECT_CALL(os, exists(job_dir / "builds.index", _))
+        .WillOnce(Return(true));
+
+    auto file = std::make_unique<StrictMock<ofstream_mock>>();
+
+    std::stringstream index;
+
+    EXPECT_CALL(*file, is_open())
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(*file, ostream())
+        .WillOnce(ReturnRef(index));
+
+    EXPECT_CALL(os, open_ofstream(
+                job_dir / "builds.index",
+                std::ios_base::out | std::ios_base::app))
+        .WillOnce(Return(ByMove(std::move(file))));
+
+    cis1::build_record record;
+    record.job = "test_job";
+    record.number = 12;
+    record.state = cis1::build_state::broken;
+    record.exit_code = -1;
+    record.finished = 42;
+
+    std::error_code ec;
+
+    cis1::append_build_record(job_dir, record, ec, os);
+
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(index.str(), "000012 broken -1 0 42 -\n");
+}
+
+TEST(write_build_index, replaces_index)
+{
+    cis1::memory_os os;
+
+    std::filesystem::path job_dir = "/jobs/test_job";
+
+    std::error_code ec;
+
+    os.write_file(
+            job_dir / "builds.index",
+            "000001 successful 0 10 11 session_a\n"
+            "000002 pending - 20 0 session_b\n",
+            ec);
+    ASSERT_FALSE(ec);
+
+    cis1::build_record record;
+    record.number = 3;
+    record.started = 30;
+    record.session_id = "session_c";
+
+    cis1::append_build_record(job_dir, record, ec, os);
+    ASSERT_FALSE(ec);
+
+    record.state = cis1::build_state::successful;
+    record.exit_code = 0;
+    record.finished = 31;
+
+    cis1::append_build_record(job_dir, record, ec, os);
+    ASSERT_FALSE(ec);
+
+    cis1::remove_build_records(job_dir, "test_job", {1}, ec, os);
+    ASSERT_FALSE(ec);
+
+    ASSERT_EQ(
+            os.read_file(job_dir / "builds.index"),
+            "000002 pending - 20 0 session_b\n"
+            "000003 successful 0 30 31 session_c\n");
+
+    std::vector<std::string> files;
+    os.iterate_directory(
+            job_dir,
+            [&](const cis1::dir_entry& entry)
+            {
+                files.emplace_back(entry.name);
+
+                return true;
+            },
+            ec);
+
+    ASSERT_EQ(
+            files,
+            (std::vector<std::string>{"builds.index", "builds.index.lock"}));
+}
+
+TEST(write_build_index, keeps_index_on_error)
+{
+    using namespace ::testing;
+
+    StrictMock<os_mock> os;
+
+    std::filesystem::path job_dir = "test_base_dir/jobs/test_job";
+
+    EXPECT_CALL(os, open_lock_file(job_dir / "builds.index.lock", _))
+        .WillOnce(Invoke([](auto&&...)
+                    -> std::unique_ptr<cis1::file_lock_interface>
+                {
+                    auto lock = std::make_unique<StrictMock<file_lock_mock>>();
+
+                    EXPECT_CALL(*lock, lock())
+                        .WillOnce(Return(true));
+
+                    return lock;
+                }));
+
+    auto file = std::make_unique<StrictMock<ofstream_mock>>();
+
+    std::stringstream index;
+    index.setstate(std::ios_base::badbit);
+
+    EXPECT_CALL(*file, is_open())
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(*file, ostream())
+        .WillOnce(ReturnRef(index));
+
+    auto tmp_path = tmp_file_path(job_dir / "builds.index");
+
+    EXPECT_CALL(os, open_ofstream(tmp_path, std::ios_base::trunc))
+        .WillOnce(Return(ByMove(std::move(file))));
+
+    EXPECT_CALL(os, remove(tmp_path, _))
+        .Times(1);
+
+    cis1::build_record record;
+    record.number = 1;
+
+    std::error_code ec;
+
+    cis1::write_build_index(job_dir, {record}, ec, os);
+
+    ASSERT_EQ(ec, cis1::error_code::cant_write_build_index);
+}
+
+TEST(query_builds, filters)
+{
+    using namespace ::testing;
+
+    StrictMock<os_mock> os;
+
+    std::filesystem::path base_dir = "test_base_dir";
+    auto jobs_dir = base_dir / "jobs";
+
+    EXPECT_CALL(os, iterate_directory(jobs_dir, _, _))
+        .WillOnce(Invoke(iterate_entries({
+                {"project", cis1::dir_entry_type::directory, 1}})));
+
+    EXPECT_CALL(os, exists(jobs_dir / "project" / "job.conf", _))
+        .WillOnce(Return(false));
+
+    EXPECT_CALL(os, iterate_directory(jobs_dir / "project", _, _))
+        .WillOnce(Invoke(iterate_entries({
+                {"job_a", cis1::dir_entry_type::directory, 2},
+                {"job_b", cis1::dir_entry_type::directory, 3},
+                {"other", cis1::dir_entry_type::directory, 4}})));
+
+    EXPECT_CALL(os, exists(jobs_dir / "project" / "job_a" / "job.conf", _))
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(os, exists(jobs_dir / "project" / "job_b" / "job.conf", _))
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(os, exists(jobs_dir / "project" / "other" / "job.conf", _))
+        .WillOnce(Return(true));
+
+    std::stringstream index_a(
+            "000001 broken 1 100 110 session_a\n"
+            "000002 successful 0 200 210 session_a\n"
+            "000003 broken 2 300 310 session_b\n");
+
+    std::stringstream index_b(
+            "000001 broken 1 250 260 session_b\n");
+
+    EXPECT_CALL(os, open_ifstream(
+                jobs_dir / "project" / "job_a" / "builds.index",
+                _))
+        .WillOnce(Return(ByMove(make_ifstream(index_a))));
+
+    EXPECT_CALL(os, open_ifstream(
+                jobs_dir / "project" / "job_b" / "builds.index",
+                _))
+        .WillOnce(Return(ByMove(make_ifstream(index_b))));
+
+    cis1::build_filter filter;
+    filter.job = cis1::job_mask::compile("project/job_.*");
+    filter.state = cis1::build_state::broken;
+    filter.since = 150;
+    filter.limit = 2;
+
+    std::error_code ec;
+
+    auto builds = cis1::query_builds(base_dir, filter, ec, os);
+
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(builds.size(), 2);
+
+    ASSERT_EQ(builds[0].job, "project/job_a");
+    ASSERT_EQ(builds[0].number, 3);
+
+    ASSERT_EQ(builds[1].job, "project/job_b");
+    ASSERT_EQ(builds[1].number, 1);
+}
+
+TEST(build_record, matches)
+{
+    cis1::build_record record;
+    record.state = cis1::build_state::broken;
+    record.exit_code = 3;
+    record.started = 100;
+    record.session_id = "session";
+
+    cis1::build_filter filter;
+
+    ASSERT_TRUE(cis1::matches(record, filter));
+
+    filter.exit_code = 3;
+    filter.session_id = "session";
+    filter.until = 101;
+
+    ASSERT_TRUE(cis1::matches(record, filter));
+
+    filter.until = 100;
+
+    ASSERT_FALSE(cis1::matches(record, filter));
+
+    filter.until.reset();
+    filter.exit_code = 0;
+
+    ASSERT_FALSE(cis1::matches(record, filter));
+}
+
+TEST(invalidate_build_index, falls_back_to_build_dirs)
+{
+    cis1::memory_os os;
+
+    std::filesystem::path job_dir = "/jobs/test_job";
+
+    std::error_code ec;
+
+    os.write_file(job_dir / "000001" / "exitcode.txt", "0\n", ec);
+    os.write_file(job_dir / "000002" / "exitcode.txt", "1\n", ec);
+    os.write_file(job_dir / "builds.index", "1 successful 0 10 20 -\n", ec);
+    ASSERT_FALSE(ec);
+
+    // the second build is missing in the index
+    ASSERT_EQ(cis1::read_build_index(job_dir, "test_job", ec, os).size(), 1);
+
+    cis1::invalidate_build_index(job_dir, ec, os);
+    ASSERT_FALSE(ec);
+
+    auto records = cis1::read_build_index(job_dir, "test_job", ec, os);
+
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(records.size(), 2);
+    ASSERT_EQ(records[1].state, cis1::build_state::broken);
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include "build_inputs.h"
+#include "error_code.h"
+#include "os_mock.h"
+#include "ifstream_mock.h"
+
+TEST(encode_env_name, correct)
+{
+    ASSERT_EQ(cis1::encode_env_name("param_1"), "param_1");
+    ASSERT_EQ(cis1::encode_env_name("a.b c"), "a%2Eb%20c");
+    ASSERT_EQ(cis1::encode_env_name("a\nb"), "a%0Ab");
+}
+
+TEST(export_kv_file, correct)
+{
+    using namespace ::testing;
+
+    StrictMock<os_mock> os;
+
+    EXPECT_CALL(os, exists(std::filesystem::path{"job.params"}, _))
+        .WillOnce(Return(true));
+
+    auto ss = std::make_unique<StrictMock<ifstream_mock>>();
+
+    EXPECT_CALL(*ss, is_open())
+        .WillOnce(Return(true));
+
+    std::stringstream fc;
+
+    fc << "param_1=value_1\n";
+    fc << R"(param.2=2 \= 4)";
+
+    EXPECT_CALL(*ss, istream())
+        .WillOnce(ReturnRef(fc));
+
+    EXPECT_CALL(os, open_ifstream(std::filesystem::path{"job.params"}, _))
+        .WillOnce(Return(ByMove(std::move(ss))));
+
+    cis1::environment env;
+    std::error_code ec;
+
+    cis1::export_kv_file(env, "job.params", "cis_param", ec, os);
+
+    ASSERT_EQ((bool)ec, false);
+    ASSERT_EQ(env.get("cis_params"), "env");
+    ASSERT_EQ(env.get("cis_params_file"), "job.params");
+    ASSERT_EQ(env.get("cis_param_param_1"), "value_1");
+    ASSERT_EQ(env.get("cis_param_param%2E2"), "2 = 4");
+}
+
+TEST(export_kv_file, file_fallback)
+{
+    using namespace ::testing;
+
+    StrictMock<os_mock> os;
+
+    EXPECT_CALL(os, exists(std::filesystem::path{"job.params"}, _))
+        .WillOnce(Return(true));
+
+    auto ss = std::make_unique<StrictMock<ifstream_mock>>();
+
+    EXPECT_CALL(*ss, is_open())
+        .WillOnce(Return(true));
+
+    std::stringstream fc;
+
+    fc << "param_1=" << std::string(64, 'x');
+
+    EXPECT_CALL(*ss, istream())
+        .WillOnce(ReturnRef(fc));
+
+    EXPECT_CALL(os, open_ifstream(std::filesystem::path{"job.params"}, _))
+        .WillOnce(Return(ByMove(std::move(ss))));
+
+    cis1::environment env;
+    std::error_code ec;
+
+    cis1::export_kv_file(env, "job.params", "cis_param", ec, os, 32);
+
+    ASSERT_EQ((bool)ec, false);
+    ASSERT_EQ(env.get("cis_params"), "file");
+    ASSERT_EQ(env.get("cis_params_file"), "job.params");
+    ASSERT_EQ((bool)env.find("cis_param_param_1"), false);
+}
+
+TEST(export_kv_file, no_file)
+{
+    using namespace ::testing;
+
+    StrictMock<os_mock> os;
+
+    EXPECT_CALL(os, exists(std::filesystem::path{"job.params"}, _))
+        .WillOnce(Return(false));
+
+    cis1::environment env;
+    std::error_code ec;
+
+    cis1::export_kv_file(env, "job.params", "cis_param", ec, os);
+
+    ASSERT_EQ((bool)ec, false);
+    ASSERT_EQ(env.get("cis_params"), "env");
+    ASSERT_EQ((bool)env.find("cis_params_file"), false);
+}
+
+TEST(export_build_params, invalid_file)
+{
+    using namespace ::testing;
+
+    StrictMock<os_mock> os;
+
+    auto params_path = std::filesystem::path{"build"} / "job.params";
+
+    EXPECT_CALL(os, exists(params_path, _))
+        .WillOnce(Return(true));
+
+    auto ss = std::make_unique<StrictMock<ifstream_mock>>();
+
+    EXPECT_CALL(*ss, is_open())
+        .WillOnce(Return(true));
+
+    std::stringstream fc;
+
+    // Unknown "\?" escaping
+    fc << R"(param_1=2 \? 2)";
+
+    EXPECT_CALL(*ss, istream())
+        .WillOnce(ReturnRef(fc));
+
+    EXPECT_CALL(os, open_ifstream(params_path, _))
+        .WillOnce(Return(ByMove(std::move(ss))));
+
+    cis1::environment env;
+    std::error_code ec;
+
+    cis1::export_build_params(env, "build", ec, os);
+
+    ASSERT_EQ(ec, cis1::error_code::cant_read_job_params_file);
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include "build_queue.h"
+#include "memory_os.h"
+#include "os.h"
+#include "test_utils.h"
+
+class build_queue_test
+    : public temp_dir_test
+{
+protected:
+    build_queue_test()
+        : temp_dir_test("build_queue")
+    {}
+
+    cis1::os os;
+};
+
+TEST_F(build_queue_test, fifo_order)
+{
+    using namespace std::chrono_literals;
+
+    boost::asio::io_context io_ctx;
+
+    std::vector<std::unique_ptr<cis1::build_queue>> queues;
+    std::vector<size_t> started;
+
+    for(size_t i = 0; i < 4; ++i)
+    {
+        queues.push_back(std::make_unique<cis1::build_queue>(
+                io_ctx,
+                std::vector<cis1::slot_limit>{{dir, 2}},
+                os,
+                1ms));
+    }
+
+    for(size_t i = 0; i < queues.size(); ++i)
+    {
+        queues[i]->async_acquire(
+                [&, i](std::error_code ec)
+                {
+                    ASSERT_FALSE(ec);
+
+                    started.push_back(i);
+
+                    // each build holds slot for a while
+                    auto timer = std::make_shared<boost::asio::steady_timer>(
+                            io_ctx,
+                            5ms);
+                    timer->async_wait(
+                            [&, i, timer](auto&&)
+                            {
+                                queues[i]->release();
+                            });
+                });
+    }
+
+    // the first two builds take both slots at once
+    ASSERT_EQ(started, (std::vector<size_t>{0, 1}));
+
+    io_ctx.run();
+
+    ASSERT_EQ(started, (std::vector<size_t>{0, 1, 2, 3}));
+    ASSERT_EQ(queues[0]->wait_time().count() < 1000, true);
+    ASSERT_EQ(queues[3]->wait_time() >= 5ms, true);
+}
+
+TEST_F(build_queue_test, dead_waiter)
+{
+    using namespace std::chrono_literals;
+
+    std::filesystem::create_directories(dir);
+
+    // waiter with ticket 0 died without leaving queue
+    std::ofstream(dir / "queue.lock") << "1";
+    std::ofstream(dir / "waiting.0");
+
+    boost::asio::io_context io_ctx;
+
+    cis1::build_queue queue(
+            io_ctx,
+            {{dir, 1}},
+            os,
+            1ms);
+
+    bool acquired = false;
+
+    queue.async_acquire(
+            [&](std::error_code ec)
+            {
+                ASSERT_FALSE(ec);
+
+                acquired = true;
+            });
+
+    ASSERT_TRUE(acquired);
+    ASSERT_FALSE(std::filesystem::exists(dir / "waiting.0"));
+    ASSERT_FALSE(std::filesystem::exists(dir / "waiting.1"));
+}
+
+TEST_F(build_queue_test, no_limit)
+{
+    boost::asio::io_context io_ctx;
+
+    cis1::build_queue queue(
+            io_ctx,
+            {{dir, 0}},
+            os);
+
+    bool acquired = false;
+
+    queue.async_acquire(
+            [&](std::error_code ec)
+            {
+                ASSERT_FALSE(ec);
+
+                acquired = true;
+            });
+
+    ASSERT_TRUE(acquired);
+    ASSERT_FALSE(std::filesystem::exists(dir));
+}
+
+TEST(build_queue, memory_os)
+{
+    using namespace std::chrono_literals;
+
+    cis1::memory_os os;
+
+    std::error_code ec;
+
+    os.create_directory("/queue", ec);
+    ASSERT_FALSE(ec);
+
+    boost::asio::io_context io_ctx;
+
+    cis1::build_queue first(io_ctx, {{"/queue", 1}}, os, 1ms);
+    cis1::build_queue second(io_ctx, {{"/queue", 1}}, os, 1ms);
+
+    bool first_acquired = false;
+    bool second_acquired = false;
+
+    first.async_acquire(
+            [&](std::error_code ec)
+            {
+                ASSERT_FALSE(ec);
+
+                first_acquired = true;
+            });
+
+    second.async_acquire(
+            [&](std::error_code ec)
+            {
+                ASSERT_FALSE(ec);
+
+                second_acquired = true;
+            });
+
+    ASSERT_TRUE(first_acquired);
+    ASSERT_FALSE(second_acquired);
+    ASSERT_EQ(os.read_file("/queue/queue.lock"), "2");
+    ASSERT_TRUE(os.exists("/queue/waiting.1", ec));
+
+    first.release();
+
+    io_ctx.run_one();
+
+    ASSERT_TRUE(second_acquired);
+    ASSERT_FALSE(os.exists("/queue/waiting.1", ec));
+}
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "build_stats.h"
+
+TEST(build_stats, usage_delta)
+{
+    cis1::build_stats before;
+    before.user_cpu = std::chrono::microseconds{100};
+    before.system_cpu = std::chrono::microseconds{50};
+    before.max_rss_kb = 10;
+    before.read_bytes = 512;
+    before.write_bytes = 1024;
+
+    cis1::build_stats after;
+    after.user_cpu = std::chrono::microseconds{350};
+    after.system_cpu = std::chrono::microseconds{75};
+    after.max_rss_kb = 30;
+    after.read_bytes = 2048;
+    after.write_bytes = 1024;
+
+    auto delta = cis1::usage_delta(before, after);
+
+    ASSERT_EQ(delta.user_cpu.count(), 250);
+    ASSERT_EQ(delta.system_cpu.count(), 25);
+    ASSERT_EQ(delta.max_rss_kb, 30u);
+    ASSERT_EQ(delta.read_bytes, 1536u);
+    ASSERT_EQ(delta.write_bytes, 0u);
+}
+
+TEST(build_stats, write)
+{
+    cis1::build_stats stats;
+    stats.wall_time = std::chrono::microseconds{3000};
+    stats.user_cpu = std::chrono::microseconds{2000};
+    stats.system_cpu = std::chrono::microseconds{1000};
+    stats.max_rss_kb = 4096;
+    stats.read_bytes = 8192;
+    stats.write_bytes = 16384;
+    stats.queue_wait = std::chrono::microseconds{500};
+
+    std::stringstream ss;
+
+    cis1::write_build_stats(ss, stats);
+
+    ASSERT_EQ(
+            ss.str(),
+            "wall_time_us=3000\n"
+            "user_cpu_us=2000\n"
+            "system_cpu_us=1000\n"
+            "max_rss_kb=4096\n"
+            "read_bytes=8192\n"
+            "write_bytes=16384\n"
+            "accounting=rusage\n"
+            "timed_out=0\n"
+            "queue_wait_us=500\n");
+}
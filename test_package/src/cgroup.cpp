@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+
+#include "cgroup.h"
+#include "error_code.h"
+#include "os_mock.h"
+#include "ifstream_mock.h"
+#include "ofstream_mock.h"
+
+TEST(read_cgroup_stats, correct)
+{
+    using namespace ::testing;
+
+    StrictMock<os_mock> os;
+
+    std::filesystem::path cgroup = "cgroup_root/test_job-000012";
+
+    std::stringstream cpu_stat(
+            "usage_usec 3000\n"
+            "user_usec 2000\n"
+            "system_usec 1000\n");
+
+    auto cpu_stat_file = std::make_unique<StrictMock<ifstream_mock>>();
+
+    EXPECT_CALL(*cpu_stat_file, is_open())
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(*cpu_stat_file, istream())
+        .WillRepeatedly(ReturnRef(cpu_stat));
+
+    EXPECT_CALL(os, open_ifstream(cgroup / "cpu.stat", _))
+        .WillOnce(Return(ByMove(std::move(cpu_stat_file))));
+
+    std::stringstream memory_peak("4194304\n");
+
+    auto memory_peak_file = std::make_unique<StrictMock<ifstream_mock>>();
+
+    EXPECT_CALL(*memory_peak_file, is_open())
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(*memory_peak_file, istream())
+        .WillRepeatedly(ReturnRef(memory_peak));
+
+    EXPECT_CALL(os, open_ifstream(cgroup / "memory.peak", _))
+        .WillOnce(Return(ByMove(std::move(memory_peak_file))));
+
+    std::stringstream io_stat(
+            "8:0 rbytes=1024 wbytes=2048 rios=1 wios=2\n"
+            "8:16 rbytes=512 wbytes=0 rios=1 wios=0\n");
+
+    auto io_stat_file = std::make_unique<StrictMock<ifstream_mock>>();
+
+    EXPECT_CALL(*io_stat_file, is_open())
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(*io_stat_file, istream())
+        .WillRepeatedly(ReturnRef(io_stat));
+
+    EXPECT_CALL(os, open_ifstream(cgroup / "io.stat", _))
+        .WillOnce(Return(ByMove(std::move(io_stat_file))));
+
+    cis1::build_stats stats;
+
+    cis1::read_cgroup_stats(cgroup, stats, os);
+
+    ASSERT_EQ(stats.accounting, "cgroup");
+    ASSERT_EQ(stats.user_cpu.count(), 2000);
+    ASSERT_EQ(stats.system_cpu.count(), 1000);
+    ASSERT_EQ(stats.max_rss_kb, 4096u);
+    ASSERT_EQ(stats.read_bytes, 1536u);
+    ASSERT_EQ(stats.write_bytes, 2048u);
+}
+
+TEST(read_cgroup_stats, nothing_accounted)
+{
+    using namespace ::testing;
+
+    StrictMock<os_mock> os;
+
+    std::filesystem::path cgroup = "cgroup_root/test_job-000012";
+
+    std::stringstream cpu_stat(
+            "usage_usec 0\n"
+            "user_usec 0\n"
+            "system_usec 0\n");
+
+    auto cpu_stat_file = std::make_unique<StrictMock<ifstream_mock>>();
+
+    EXPECT_CALL(*cpu_stat_file, is_open())
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(*cpu_stat_file, istream())
+        .WillRepeatedly(ReturnRef(cpu_stat));
+
+    EXPECT_CALL(os, open_ifstream(cgroup / "cpu.stat", _))
+        .WillOnce(Return(ByMove(std::move(cpu_stat_file))));
+
+    cis1::build_stats stats;
+    stats.max_rss_kb = 100;
+
+    cis1::read_cgroup_stats(cgroup, stats, os);
+
+    ASSERT_EQ(stats.accounting, "rusage");
+    ASSERT_EQ(stats.max_rss_kb, 100u);
+}
+
+TEST(create_cgroup, not_delegated)
+{
+    using namespace ::testing;
+
+    StrictMock<os_mock> os;
+
+    std::filesystem::path root = "cgroup_root";
+
+    EXPECT_CALL(os, open_ofstream(root / "cgroup.subtree_control", _))
+        .Times(3)
+        .WillRepeatedly(
+                [](auto&&...)
+                {
+                    return std::unique_ptr<cis1::ofstream_interface>{};
+                });
+
+    EXPECT_CALL(os, create_directory(root / "test_job-000012", _))
+        .WillOnce(
+                DoAll(
+                        SetArgReferee<1>(
+                                std::make_error_code(
+                                        std::errc::permission_denied)),
+                        Return(false)));
+
+    std::error_code ec;
+
+    auto cgroup = cis1::create_cgroup(
+            root,
+            "test_job-000012",
+            {},
+            ec,
+            os);
+
+    ASSERT_FALSE(cgroup);
+    ASSERT_EQ(ec, cis1::error_code::cant_create_cgroup);
+}
+
+TEST(async_remove_cgroup, retries)
+{
+    using namespace ::testing;
+
+    StrictMock<os_mock> os;
+
+    std::filesystem::path cgroup = "cgroup_root/test_job-000012";
+
+    EXPECT_CALL(os, open_ofstream(cgroup / "cgroup.kill", _))
+        .WillOnce(
+                [](auto&&...)
+                {
+                    return std::unique_ptr<cis1::ofstream_interface>{};
+                });
+
+    // killed processes are still leaving the cgroup
+    EXPECT_CALL(os, remove(cgroup, _))
+        .WillOnce(SetArgReferee<1>(std::make_error_code(std::errc::device_or_resource_busy)))
+        .WillOnce(SetArgReferee<1>(std::make_error_code(std::errc::device_or_resource_busy)))
+        .WillOnce(Return());
+
+    boost::asio::io_context io_ctx;
+
+    std::optional<std::error_code> result;
+
+    cis1::async_remove_cgroup(
+            io_ctx,
+            cgroup,
+            os,
+            [&](std::error_code ec)
+            {
+                result = ec;
+            });
+
+    // removal doesn't block the caller
+    ASSERT_FALSE(result);
+
+    io_ctx.run();
+
+    ASSERT_TRUE(result);
+    ASSERT_FALSE(result.value());
+}
+
+TEST(async_remove_cgroup, busy)
+{
+    using namespace ::testing;
+
+    NiceMock<os_mock> os;
+
+    std::filesystem::path cgroup = "cgroup_root/test_job-000012";
+
+    EXPECT_CALL(os, remove(cgroup, _))
+        .Times(10)
+        .WillRepeatedly(SetArgReferee<1>(std::make_error_code(std::errc::device_or_resource_busy)));
+
+    boost::asio::io_context io_ctx;
+
+    std::error_code result;
+
+    cis1::async_remove_cgroup(
+            io_ctx,
+            cgroup,
+            os,
+            [&](std::error_code ec)
+            {
+                result = ec;
+            });
+
+    io_ctx.run();
+
+    ASSERT_EQ(result, cis1::error_code::cant_remove_cgroup);
+}
@@ -205,11 +205,11 @@ TEST(cron_manager, run_job)
 
     std::string job_name = "test/test";
 
-    boost::process::environment env;
+    cis1::environment env;
 
     std::string startjob = "test_exec";
 
-    env["startjob"] = startjob;
+    env.set("startjob", startjob);
 
     EXPECT_CALL(ctx, env())
         .WillRepeatedly(ReturnRef(env));
@@ -253,11 +253,11 @@ TEST(cron_manager, update)
 
     std::string job_name = "test/test";
 
-    boost::process::environment env;
+    cis1::environment env;
 
     std::string startjob = "test_exec";
 
-    env["startjob"] = startjob;
+    env.set("startjob", startjob);
 
     EXPECT_CALL(ctx, env())
         .WillRepeatedly(ReturnRef(env));
@@ -287,7 +287,114 @@ TEST(cron_manager, update)
 
     cm.update();
 
-    ASSERT_TRUE(cm.timers_.count({job1, cron1}) == 1);
+    ASSERT_TRUE(cm.timers_.count(cron1) == 1);
+    ASSERT_TRUE(cm.timers_.at(cron1).jobs.count(job1) == 1);
+}
+
+TEST(cron_manager, update_groups)
+{
+    using namespace ::testing;
+
+    StrictMock<context_mock> ctx;
+    StrictMock<os_mock> os;
+
+    boost::asio::io_context io_ctx;
+
+    std::filesystem::path crons_path = "/test/crons";
+
+    cron_manager cm(io_ctx, ctx, crons_path, os);
+
+    std::stringstream fc1;
+    fc1 << "a 0 * * * * *\n"
+        << "b 0 * * * * *\n"
+        << "c 0 0 * * * *\n";
+
+    std::stringstream fc2;
+    fc2 << "b 0 * * * * *\n"
+        << "d 0 */2 * * * *\n";
+
+    // newer expectations are matched first
+    for(auto fc : {&fc2, &fc1})
+    {
+        auto ss = std::make_unique<StrictMock<ifstream_mock>>();
+
+        EXPECT_CALL(*ss, is_open())
+            .WillRepeatedly(Return(true));
+
+        EXPECT_CALL(*ss, istream())
+            .WillRepeatedly(ReturnRef(*fc));
+
+        EXPECT_CALL(os, open_ifstream(crons_path, _))
+            .WillOnce(Return(ByMove(std::move(ss))))
+            .RetiresOnSaturation();
+    }
+
+    cm.update();
+
+    ASSERT_EQ(cm.timers_.size(), 2);
+    ASSERT_EQ(cm.timers_.at("0 * * * * *").jobs, (std::set<std::string>{"a", "b"}));
+
+    // queued jobs which are no longer scheduled are dropped
+    cm.spawn_queue_ = {"a", "b"};
+    cm.queued_jobs_ = {"a", "b"};
+
+    cm.update();
+
+    ASSERT_EQ(cm.spawn_queue_, std::deque<std::string>{"b"});
+    ASSERT_EQ(cm.queued_jobs_, std::set<std::string>{"b"});
+
+    ASSERT_EQ(cm.timers_.size(), 2);
+    ASSERT_EQ(cm.timers_.at("0 * * * * *").jobs, std::set<std::string>{"b"});
+    ASSERT_EQ(cm.timers_.at("0 */2 * * * *").jobs, std::set<std::string>{"d"});
+}
+
+TEST(cron_manager, spawn_rate)
+{
+    using namespace ::testing;
+
+    NiceMock<context_mock> ctx;
+    StrictMock<os_mock> os;
+
+    boost::asio::io_context io_ctx;
+
+    cron_manager cm(io_ctx, ctx, "/test/crons", os);
+
+    cis1::environment env;
+    std::filesystem::path base_dir = "/base_dir";
+
+    EXPECT_CALL(ctx, env())
+        .WillRepeatedly(ReturnRef(env));
+
+    EXPECT_CALL(ctx, base_dir())
+        .WillRepeatedly(ReturnRef(base_dir));
+
+    std::vector<std::string> spawned;
+
+    EXPECT_CALL(os, spawn_process(_, _, _, _))
+        .WillRepeatedly(
+                [&](auto&, auto&, auto& args, auto&)
+                {
+                    spawned.push_back(args[0]);
+                });
+
+    cm.set_max_spawns_per_second(20);
+
+    auto start = std::chrono::steady_clock::now();
+
+    cm.enqueue_job("a");
+    cm.enqueue_job("b");
+    cm.enqueue_job("b");
+    cm.enqueue_job("c");
+
+    // the first job isn't delayed, the rest are queued once
+    ASSERT_EQ(spawned, std::vector<std::string>{"a"});
+
+    io_ctx.run();
+
+    ASSERT_EQ(spawned, (std::vector<std::string>{"a", "b", "c"}));
+    ASSERT_GE(
+            std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds{100});
 }
 
 TEST(cron, start_daemon)
@@ -297,11 +404,11 @@ TEST(cron, start_daemon)
     StrictMock<context_mock> ctx;
     StrictMock<os_mock> os;
 
-    boost::process::environment env;
+    cis1::environment env;
 
     std::string cis_cron_daemon = "test_exec";
 
-    env["cis_cron_daemon"] = cis_cron_daemon;
+    env.set("cis_cron_daemon", cis_cron_daemon);
 
     EXPECT_CALL(ctx, env())
         .WillRepeatedly(ReturnRef(env));
@@ -0,0 +1,240 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <sstream>
+
+#include "cron_schedule.h"
+
+class cron_schedule_test
+    : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        if(auto tz = std::getenv("TZ"); tz)
+        {
+            tz_ = tz;
+        }
+
+        set_tz("UTC");
+    }
+
+    void TearDown() override
+    {
+        if(tz_)
+        {
+            ::setenv("TZ", tz_->c_str(), 1);
+        }
+        else
+        {
+            ::unsetenv("TZ");
+        }
+
+        ::tzset();
+    }
+
+    void set_tz(const char* tz)
+    {
+        ::setenv("TZ", tz, 1);
+        ::tzset();
+    }
+
+    void expect_same_as_croncpp(const std::vector<std::time_t>& times)
+    {
+        const std::vector<std::string> exprs =
+        {
+            "* * * * * *",
+            "0 * * * * *",
+            "0 0 * * * *",
+            "*/15 * * * * *",
+            "0 */5 * * * *",
+            "30 5/10 1-3,22 * * *",
+            "0 0 0 1 * *",
+            "0 0 12 31 * *",
+            "0 0 0 ? * SUN",
+            "0 0 0 13 * 5",
+            "0 15 10 * JAN,jul-SEP ?",
+            "0 0 0 29 2 *",
+            "59 59 23 28-31 2 *",
+            "0 0 0 1-7 * MON",
+            "1,2,3 4,5 6,7 8,9 10,11 0-6",
+            "0 0 0/6 */2 */3 1-5",
+            "0 30 1,2 * * *",
+            "0 30 2 * * *",
+        };
+
+        for(auto& expr : exprs)
+        {
+            auto schedule = cis1::cron_schedule::compile(expr);
+            ASSERT_TRUE(schedule) << expr;
+            ASSERT_TRUE(schedule->compiled()) << expr;
+
+            auto cronexpr = cron::make_cron(expr);
+
+            for(auto t : times)
+            {
+                auto next = schedule->next(t);
+
+                ASSERT_EQ(next, cron::cron_next(cronexpr, t))
+                        << expr << " at " << t;
+                ASSERT_TRUE(next == -1 || next > t) << expr << " at " << t;
+            }
+        }
+    }
+
+private:
+    std::optional<std::string> tz_;
+};
+
+TEST(cron_schedule, compile_invalid)
+{
+    ASSERT_FALSE(cis1::cron_schedule::compile(""));
+    ASSERT_FALSE(cis1::cron_schedule::compile("* * * * *"));
+    ASSERT_FALSE(cis1::cron_schedule::compile("60 * * * * *"));
+    ASSERT_FALSE(cis1::cron_schedule::compile("* * * 0 * *"));
+    ASSERT_FALSE(cis1::cron_schedule::compile("* * * * * 7"));
+    ASSERT_FALSE(cis1::cron_schedule::compile("* * 5-2 * * *"));
+}
+
+TEST_F(cron_schedule_test, known_times)
+{
+    // 2019-03-01 12:00:00 UTC, friday
+    const std::time_t now = 1551441600;
+
+    auto every_second = cis1::cron_schedule::compile("* * * * * *");
+    ASSERT_TRUE(every_second);
+    ASSERT_EQ(every_second->next(now), now + 1);
+
+    auto leap_day = cis1::cron_schedule::compile("0 0 0 29 2 *");
+    ASSERT_TRUE(leap_day);
+    // 2020-02-29 00:00:00
+    ASSERT_EQ(leap_day->next(now), 1582934400);
+
+    auto never = cis1::cron_schedule::compile("0 0 0 30 2 *");
+    ASSERT_TRUE(never);
+    ASSERT_EQ(never->next(now), -1);
+
+    auto weekdays = cis1::cron_schedule::compile("0 30 9 * * mon-FRI");
+    ASSERT_TRUE(weekdays);
+    // 2019-03-04 09:30:00, monday
+    ASSERT_EQ(weekdays->next(now), 1551691800);
+}
+
+TEST_F(cron_schedule_test, same_as_croncpp)
+{
+    // 2019-01-01 .. 2031-01-01
+    std::mt19937_64 random(42);
+    std::uniform_int_distribution<std::time_t> time(1546300800, 1924992000);
+
+    std::vector<std::time_t> times
+    {
+        1551398399, // 2019-02-28 23:59:59
+        1582934399, // 2020-02-28 23:59:59
+        1609459199, // 2020-12-31 23:59:59
+    };
+
+    for(int i = 0; i < 200; ++i)
+    {
+        times.push_back(time(random));
+    }
+
+    expect_same_as_croncpp(times);
+}
+
+TEST_F(cron_schedule_test, same_as_croncpp_dst)
+{
+    // local time mismatch between evaluators shows up around dst switches
+    set_tz("America/New_York");
+
+    std::vector<std::time_t> times;
+
+    for(std::time_t transition : {
+            1615705200, // 2021-03-14 07:00:00 UTC, 02:00 EST skipped
+            1636264800}) // 2021-11-07 06:00:00 UTC, 01:00 EST repeated
+    {
+        for(int hour = -3; hour <= 3; ++hour)
+        {
+            for(std::time_t offset : {-1, 0, 1, 1799, 1800})
+            {
+                times.push_back(transition + hour * 3600 + offset);
+            }
+        }
+    }
+
+    expect_same_as_croncpp(times);
+
+    // minute steps through the repeated hour never go back
+    auto every_minute = cis1::cron_schedule::compile("0 * * * * *");
+    ASSERT_TRUE(every_minute);
+
+    for(std::time_t t = 1636261200; t < 1636268400; t += 60)
+    {
+        ASSERT_EQ(every_minute->next(t), t + 60) << t;
+    }
+}
+
+TEST(resolve_hashed_cron, resolve)
+{
+    ASSERT_EQ(cis1::resolve_hashed_cron("0 * * * * *", "job"), "0 * * * * *");
+
+    auto resolved = cis1::resolve_hashed_cron("H H * * * *", "project/job");
+
+    // stable for job
+    ASSERT_EQ(resolved, cis1::resolve_hashed_cron("H  H * * * *", "project/job"));
+    ASSERT_NE(resolved.find(" * * * *"), std::string::npos);
+    ASSERT_TRUE(cis1::cron_schedule::compile(resolved));
+
+    int first;
+    int last;
+    int step;
+    char c;
+
+    std::istringstream(cis1::resolve_hashed_cron("0 H(10-20)/4 * * * *", "job"))
+            >> first >> first >> c >> last >> c >> step;
+    ASSERT_GE(first, 10);
+    ASSERT_LT(first, 14);
+    ASSERT_EQ(last, 20);
+    ASSERT_EQ(step, 4);
+
+    std::istringstream(cis1::resolve_hashed_cron("0 0 0 H * *", "job")) >> first >> first >> first >> first;
+    ASSERT_GE(first, 1);
+    ASSERT_LE(first, 28);
+
+    // lists keep other items
+    auto list = cis1::resolve_hashed_cron("0 0 1,H,23 * * *", "job");
+    ASSERT_EQ(list.substr(0, 6), "0 0 1,");
+    ASSERT_EQ(list.substr(list.size() - 9), ",23 * * *");
+}
+
+TEST(resolve_hashed_cron, malformed)
+{
+    for(auto expr : {
+            "H(5-2) * * * * *",
+            "H(5-70) * * * * *",
+            "H/0 * * * * *",
+            "Hx * * * * *",
+            "H(1-2 * * * * *"})
+    {
+        auto resolved = cis1::resolve_hashed_cron(expr, "job");
+
+        ASSERT_EQ(resolved, expr);
+        ASSERT_FALSE(cis1::cron_schedule::compile(resolved)) << expr;
+    }
+}
+
+TEST(resolve_hashed_cron, spread)
+{
+    std::set<std::string> resolved;
+
+    for(int i = 0; i < 100; ++i)
+    {
+        resolved.insert(cis1::resolve_hashed_cron(
+                "H H * * * *",
+                "project/job_" + std::to_string(i)));
+    }
+
+    // hundred jobs don't share a few start times
+    ASSERT_GT(resolved.size(), 90);
+}
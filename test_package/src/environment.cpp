@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+
+#include "environment.h"
+
+TEST(environment, copy_on_write)
+{
+    cis1::environment env;
+
+    env.set("var", "original");
+
+    auto snapshot = env;
+
+    env.set("var", "changed");
+    env.set("new_var", "value");
+
+    ASSERT_EQ(snapshot.get("var"), "original");
+    ASSERT_FALSE(snapshot.find("new_var"));
+    ASSERT_EQ(env.get("var"), "changed");
+    ASSERT_EQ(env.get("new_var"), "value");
+}
+
+TEST(environment, overlay)
+{
+    cis1::environment env;
+
+    env.set("base", "base_value");
+    env.set("overridden", "old");
+
+    auto overlaid = env.overlay({{"overridden", "new"}, {"added", "1"}});
+
+    ASSERT_EQ(env.get("overridden"), "old");
+    ASSERT_EQ(overlaid.get("overridden"), "new");
+    ASSERT_EQ(overlaid.get("base"), "base_value");
+    ASSERT_EQ(overlaid.get("added"), "1");
+
+    auto native = overlaid.native();
+
+    ASSERT_EQ(native.at("overridden").to_string(), "new");
+    ASSERT_EQ(native.at("base").to_string(), "base_value");
+    ASSERT_EQ(native.at("added").to_string(), "1");
+}
+
+TEST(environment, make_block)
+{
+    auto env = cis1::environment::current();
+
+    env.set("cis1_block_var", "value");
+
+    auto block = env.make_block();
+
+    size_t found = 0;
+    size_t count = 0;
+    for(auto entry = block.data(); *entry != nullptr; ++entry, ++count)
+    {
+        if(std::string{*entry} == "cis1_block_var=value")
+        {
+            ++found;
+        }
+    }
+
+    ASSERT_EQ(found, 1u);
+    ASSERT_EQ(count, boost::this_process::environment().size() + 1);
+}
+
+TEST(environment, current)
+{
+    auto env = cis1::environment::current();
+
+    auto native = boost::this_process::environment();
+
+    auto it = native.find("PATH");
+    if(it != native.end())
+    {
+        ASSERT_EQ(env.get("PATH"), it->to_string());
+    }
+
+    ASSERT_FALSE(env.find("cis1_surely_unset_variable"));
+}
+
+TEST(environment, current_owns_values)
+{
+    ::setenv("cis1_test_snapshot_var", "before", 1);
+
+    auto snapshot = cis1::environment::current();
+
+    // replaces environ entry, old string may be freed
+    ::setenv("cis1_test_snapshot_var", "after", 1);
+
+    ASSERT_EQ(snapshot.get("cis1_test_snapshot_var"), "before");
+    ASSERT_EQ(
+            cis1::environment::current().get("cis1_test_snapshot_var"),
+            "after");
+
+    auto block = cis1::environment::current().make_block();
+
+    bool found = false;
+    for(char** entry = block.data(); *entry; ++entry)
+    {
+        found |= std::string(*entry) == "cis1_test_snapshot_var=after";
+    }
+
+    ::unsetenv("cis1_test_snapshot_var");
+
+    ASSERT_TRUE(found);
+}
+
+TEST(environment, erase_prefixed)
+{
+    ::setenv("cis_param_inherited", "parent", 1);
+    ::setenv("cis_params", "env", 1);
+
+    auto env = cis1::environment::current();
+
+    ::unsetenv("cis_param_inherited");
+    ::unsetenv("cis_params");
+
+    env.set("cis_param_local", "value");
+    env.set("cis_parameter", "value");
+
+    auto snapshot = env;
+
+    env.erase_prefixed("cis_param");
+
+    ASSERT_FALSE(env.find("cis_param_inherited"));
+    ASSERT_FALSE(env.find("cis_params"));
+    ASSERT_FALSE(env.find("cis_param_local"));
+    ASSERT_FALSE(env.find("cis_parameter"));
+    ASSERT_EQ(snapshot.get("cis_param_inherited"), "parent");
+
+    auto native = env.native();
+
+    ASSERT_EQ(native.count("cis_param_inherited"), 0);
+    ASSERT_EQ(native.count("cis_params"), 0);
+
+    auto block = env.make_block();
+
+    for(auto entry = block.data(); *entry != nullptr; ++entry)
+    {
+        ASSERT_NE(std::string{*entry}.compare(0, 9, "cis_param"), 0);
+    }
+
+    env.set("cis_params", "file");
+
+    ASSERT_EQ(env.get("cis_params"), "file");
+}
@@ -16,9 +16,6 @@ TEST(init_context, correct)
 
     std::filesystem::path path{"/test/path/cis_base_dir"};
 
-    EXPECT_CALL(os, is_directory(path, _))
-        .WillOnce(Return(true));
-
     auto ss = std::make_unique<StrictMock<ifstream_mock>>();
 
     EXPECT_CALL(*ss, is_open())
@@ -75,6 +72,9 @@ TEST(init_context, no_base_dir)
 
     std::filesystem::path path{"/test/path/cis_base_dir"};
 
+    EXPECT_CALL(os, open_ifstream(path / "core" / "cis.conf", _))
+        .WillOnce(Return(ByMove(std::unique_ptr<cis1::ifstream_interface>{})));
+
     EXPECT_CALL(os, is_directory(path, _))
         .WillOnce(Return(false));
 
@@ -97,9 +97,6 @@ TEST(init_context, no_base_conf_file)
 
     std::filesystem::path path{"/test/path/cis_base_dir"};
 
-    EXPECT_CALL(os, is_directory(path, _))
-        .WillOnce(Return(true));
-
     auto ss = std::make_unique<StrictMock<ifstream_mock>>();
 
     EXPECT_CALL(*ss, is_open())
@@ -108,6 +105,9 @@ TEST(init_context, no_base_conf_file)
     EXPECT_CALL(os, open_ifstream(path / "core" / "cis.conf", _))
         .WillOnce(Return(ByMove(std::move(ss))));
 
+    EXPECT_CALL(os, is_directory(path, _))
+        .WillOnce(Return(true));
+
     std::error_code ec;
 
     auto ctx = cis1::init_context(ec, os);
@@ -127,9 +127,6 @@ TEST(init_context, invalid_base_conf_file)
 
     std::filesystem::path path{"/test/path/cis_base_dir"};
 
-    EXPECT_CALL(os, is_directory(path, _))
-        .WillOnce(Return(true));
-
     auto ss = std::make_unique<StrictMock<ifstream_mock>>();
 
     EXPECT_CALL(*ss, is_open())
@@ -153,3 +150,31 @@ TEST(init_context, invalid_base_conf_file)
     ASSERT_EQ((bool)ctx, false);
 }
 
+
+TEST(context, env_overrides)
+{
+    cis1::context ctx{"/test/path/cis_base_dir", {{"startjob", "startjob"}}};
+
+    ctx.set_env_var("test_var", "before");
+
+    ASSERT_EQ(ctx.get_env_var("startjob"), "startjob");
+    ASSERT_EQ(ctx.get_env_var("test_var"), "before");
+
+    auto& env = ctx.env();
+
+    ctx.set_env_var("test_var", "after");
+
+    ASSERT_EQ(ctx.get_env_var("test_var"), "after");
+    ASSERT_EQ(env.get("test_var"), "after");
+    ASSERT_EQ(env.get("startjob"), "startjob");
+}
+
+TEST(context, env_list_value)
+{
+    cis1::context ctx{"/test/path/cis_base_dir", {}};
+
+    ctx.set_env_var("test_var", "first:second");
+
+    ASSERT_EQ(ctx.get_env_var("test_var"), "first");
+    ASSERT_EQ(ctx.env().get("test_var"), "first:second");
+}
@@ -1,14 +1,16 @@
 #include <gtest/gtest.h>
 
 #include "job.h"
+#include "memory_os.h"
 #include "os_mock.h"
 #include "context_mock.h"
 #include "error_code.h"
 #include "ifstream_mock.h"
 #include "ofstream_mock.h"
+#include "file_lock_mock.h"
 #include "utils.h"
 #include "session_mock.h"
-#include "fs_entry_mock.h"
+#include "test_utils.h"
 #include "process_mock.h"
 #include "job_runner_mock.h"
 
@@ -106,6 +108,135 @@ TEST(load_job, invalid_job_conf)
     ASSERT_EQ((bool)job_opt, false);
 }
 
+TEST(load_job, invalid_timeout)
+{
+    using namespace ::testing;
+
+    StrictMock<os_mock> os;
+    StrictMock<context_mock> ctx;
+
+    std::filesystem::path base_dir = "test_base_dir";
+
+    EXPECT_CALL(ctx, base_dir())
+        .WillOnce(ReturnRef(base_dir));
+
+    auto job_dir = base_dir / "jobs" / "test_job";
+
+    EXPECT_CALL(os, exists(job_dir, _))
+        .WillOnce(Return(true));
+
+    auto ss = std::make_unique<StrictMock<ifstream_mock>>();
+
+    EXPECT_CALL(*ss, is_open())
+        .WillOnce(Return(true));
+
+    std::stringstream fc;
+
+    fc << "script=test_script\n";
+    fc << "keep_last_success_builds=5\n";
+    fc << "keep_last_break_builds=5\n";
+    fc << "timeout=forever";
+
+    EXPECT_CALL(*ss, istream())
+        .WillOnce(ReturnRef(fc));
+
+    EXPECT_CALL(os, open_ifstream(job_dir / "job.conf", _))
+        .WillOnce(Return(ByMove(std::move(ss))));
+
+    std::error_code ec;
+
+    auto job_opt = cis1::load_job("test_job", ec, ctx, os);
+
+    ASSERT_EQ(ec, cis1::error_code::cant_read_job_conf_file);
+    ASSERT_EQ((bool)job_opt, false);
+}
+
+TEST(load_job, invalid_max_concurrent_builds)
+{
+    using namespace ::testing;
+
+    StrictMock<os_mock> os;
+    StrictMock<context_mock> ctx;
+
+    std::filesystem::path base_dir = "test_base_dir";
+
+    EXPECT_CALL(ctx, base_dir())
+        .WillOnce(ReturnRef(base_dir));
+
+    auto job_dir = base_dir / "jobs" / "test_job";
+
+    EXPECT_CALL(os, exists(job_dir, _))
+        .WillOnce(Return(true));
+
+    auto ss = std::make_unique<StrictMock<ifstream_mock>>();
+
+    EXPECT_CALL(*ss, is_open())
+        .WillOnce(Return(true));
+
+    std::stringstream fc;
+
+    fc << "script=test_script\n";
+    fc << "keep_last_success_builds=5\n";
+    fc << "keep_last_break_builds=5\n";
+    fc << "max_concurrent_builds=many";
+
+    EXPECT_CALL(*ss, istream())
+        .WillOnce(ReturnRef(fc));
+
+    EXPECT_CALL(os, open_ifstream(job_dir / "job.conf", _))
+        .WillOnce(Return(ByMove(std::move(ss))));
+
+    std::error_code ec;
+
+    auto job_opt = cis1::load_job("test_job", ec, ctx, os);
+
+    ASSERT_EQ(ec, cis1::error_code::cant_read_job_conf_file);
+    ASSERT_EQ((bool)job_opt, false);
+}
+
+TEST(load_job, invalid_export_params)
+{
+    using namespace ::testing;
+
+    StrictMock<os_mock> os;
+    StrictMock<context_mock> ctx;
+
+    std::filesystem::path base_dir = "test_base_dir";
+
+    EXPECT_CALL(ctx, base_dir())
+        .WillOnce(ReturnRef(base_dir));
+
+    auto job_dir = base_dir / "jobs" / "test_job";
+
+    EXPECT_CALL(os, exists(job_dir, _))
+        .WillOnce(Return(true));
+
+    auto ss = std::make_unique<StrictMock<ifstream_mock>>();
+
+    EXPECT_CALL(*ss, is_open())
+        .WillOnce(Return(true));
+
+    std::stringstream fc;
+
+    fc << "script=test_script\n";
+    fc << "keep_last_success_builds=5\n";
+    fc << "keep_last_break_builds=5\n";
+    fc << "export_params=yes";
+
+    EXPECT_CALL(*ss, istream())
+        .WillOnce(ReturnRef(fc));
+
+    EXPECT_CALL(os, open_ifstream(job_dir / "job.conf", _))
+        .WillOnce(Return(ByMove(std::move(ss))));
+
+    std::error_code ec;
+
+    auto job_opt = cis1::load_job("test_job", ec, ctx, os);
+
+    ASSERT_EQ(ec, cis1::error_code::cant_read_job_conf_file);
+    ASSERT_EQ((bool)job_opt, false);
+}
+
 TEST(load_job, script_doesnt_exist)
 {
     using namespace ::testing;
@@ -196,9 +327,8 @@ TEST(load_job, job_without_params)
     EXPECT_CALL(os, open_ifstream(job_dir / "job.params", _))
         .WillOnce(Return(ByMove(std::move(ss))));
 
-    EXPECT_CALL(os, list_directory(job_dir))
-        .WillOnce(Return(ByMove(
-                    std::vector<std::unique_ptr<cis1::fs_entry_interface>>{})));
+    EXPECT_CALL(os, iterate_directory(job_dir, _, _))
+        .WillOnce(Invoke(iterate_entries({})));
 
     std::error_code ec;
 
@@ -294,7 +424,8 @@ TEST(load_job, correct)
 
     fc << "script=test_script\n";
     fc << "keep_last_success_builds=5\n";
-    fc << "keep_last_break_builds=5";
+    fc << "keep_last_break_builds=5\n";
+    fc << "timeout=30";
 
     EXPECT_CALL(*ss, istream())
         .WillOnce(ReturnRef(fc));
@@ -327,9 +458,8 @@ TEST(load_job, correct)
     EXPECT_CALL(os, open_ifstream(job_dir / "job.params", _))
         .WillOnce(Return(ByMove(std::move(ss))));
 
-    EXPECT_CALL(os, list_directory(job_dir))
-        .WillOnce(Return(ByMove(
-                    std::vector<std::unique_ptr<cis1::fs_entry_interface>>{})));
+    EXPECT_CALL(os, iterate_directory(job_dir, _, _))
+        .WillOnce(Invoke(iterate_entries({})));
 
     std::error_code ec;
 
@@ -338,6 +468,7 @@ TEST(load_job, correct)
     ASSERT_EQ((bool)ec, false);
     ASSERT_EQ((bool)job_opt, true);
     ASSERT_THAT(job_opt->params(), ElementsAreArray(params));
+    ASSERT_EQ(job_opt->timeout(), 30u);
 }
 
 TEST(job, create_directory_error)
@@ -355,9 +486,8 @@ TEST(job, create_directory_error)
 
     std::filesystem::path job_dir = base_dir / "jobs" / "test_job";
 
-    EXPECT_CALL(os, list_directory(job_dir))
-        .WillOnce(Return(ByMove(
-                std::vector<std::unique_ptr<cis1::fs_entry_interface>>{})));
+    EXPECT_CALL(os, iterate_directory(job_dir, _, _))
+        .WillOnce(Invoke(iterate_entries({})));
 
     std::error_code err;
     err.assign(1, err.category());
@@ -398,9 +528,8 @@ TEST(job, copy_error)
 
     std::filesystem::path job_dir = base_dir / "jobs" / "test_job";
 
-    EXPECT_CALL(os, list_directory(job_dir))
-        .WillOnce(Return(ByMove(
-                std::vector<std::unique_ptr<cis1::fs_entry_interface>>{})));
+    EXPECT_CALL(os, iterate_directory(job_dir, _, _))
+        .WillOnce(Invoke(iterate_entries({})));
 
     EXPECT_CALL(os, create_directory(job_dir / "000000", _))
         .WillOnce(Return(true));
@@ -447,9 +576,8 @@ TEST(job, cant_open_job_params)
 
     std::filesystem::path job_dir = base_dir / "jobs" / "test_job";
 
-    EXPECT_CALL(os, list_directory(job_dir))
-        .WillOnce(Return(ByMove(
-                std::vector<std::unique_ptr<cis1::fs_entry_interface>>{})));
+    EXPECT_CALL(os, iterate_directory(job_dir, _, _))
+        .WillOnce(Invoke(iterate_entries({})));
 
     EXPECT_CALL(os, create_directory(job_dir / "000000", _))
         .WillOnce(Return(true));
@@ -503,27 +631,10 @@ TEST(job, cant_open_session_id)
 
     std::filesystem::path job_dir = base_dir / "jobs" / "test_job";
 
-    std::vector<std::unique_ptr<cis1::fs_entry_interface>> fs_entries;
-    auto entry1 = std::make_unique<fs_entry_mock>();
-
-    EXPECT_CALL(*entry1, is_directory())
-        .WillRepeatedly(Return(true));
-
-    EXPECT_CALL(*entry1, path())
-        .WillRepeatedly(Return(job_dir / "000011"));
-
-    fs_entries.push_back(std::move(entry1));
-
-    auto entry2 = std::make_unique<fs_entry_mock>();
-
-    EXPECT_CALL(*entry2, is_directory())
-        .WillRepeatedly(Return(false));
-
-    fs_entries.push_back(std::move(entry2));
-
-    EXPECT_CALL(os, list_directory(job_dir))
-        .WillOnce(Return(ByMove(
-             std::move(fs_entries))));
+    EXPECT_CALL(os, iterate_directory(job_dir, _, _))
+        .WillOnce(Invoke(iterate_entries({
+                {"000011", cis1::dir_entry_type::directory, 1},
+                {"job.conf", cis1::dir_entry_type::regular, 2}})));
 
     EXPECT_CALL(os, create_directory(job_dir / "000012", _))
         .WillOnce(Return(true));
@@ -593,27 +704,10 @@ TEST(job, correct)
 
     std::filesystem::path job_dir = base_dir / "jobs" / "test_job";
 
-    std::vector<std::unique_ptr<cis1::fs_entry_interface>> fs_entries;
-    auto entry1 = std::make_unique<fs_entry_mock>();
-
-    EXPECT_CALL(*entry1, is_directory())
-        .WillRepeatedly(Return(true));
-
-    EXPECT_CALL(*entry1, path())
-        .WillRepeatedly(Return(job_dir / "000011"));
-
-    fs_entries.push_back(std::move(entry1));
-
-    auto entry2 = std::make_unique<fs_entry_mock>();
-
-    EXPECT_CALL(*entry2, is_directory())
-        .WillRepeatedly(Return(false));
-
-    fs_entries.push_back(std::move(entry2));
-
-    EXPECT_CALL(os, list_directory(job_dir))
-        .WillOnce(Return(ByMove(
-             std::move(fs_entries))));
+    EXPECT_CALL(os, iterate_directory(job_dir, _, _))
+        .WillOnce(Invoke(iterate_entries({
+                {"000011", cis1::dir_entry_type::directory, 1},
+                {"job.conf", cis1::dir_entry_type::regular, 2}})));
 
     EXPECT_CALL(os, create_directory(job_dir / "000012", _))
         .WillOnce(Return(true));
@@ -660,6 +754,27 @@ TEST(job, correct)
     EXPECT_CALL(session, session_id())
         .WillOnce(ReturnRef(session_id));
 
+    EXPECT_CALL(os, open_lock_file(job_dir / "builds.index.lock", _))
+        .WillOnce(Invoke(shared_file_lock()));
+
+    EXPECT_CALL(os, exists(job_dir / "builds.index", _))
+        .WillOnce(Return(true));
+
+    ss = std::make_unique<StrictMock<ofstream_mock>>();
+
+    EXPECT_CALL(*ss, is_open())
+        .WillOnce(Return(true));
+
+    std::stringstream index;
+
+    EXPECT_CALL(*ss, ostream())
+        .WillOnce(ReturnRef(index));
+
+    EXPECT_CALL(os, open_ofstream(
+                job_dir / "builds.index",
+                std::ios_base::out | std::ios_base::app))
+        .WillOnce(Return(ByMove(std::move(ss))));
+
     cis1::job job(
             "test_job",
             {
@@ -677,6 +792,39 @@ TEST(job, correct)
 
     ASSERT_EQ((bool)ec, false);
     ASSERT_STREQ(fc.str().c_str(), (session_id + "\n").c_str());
+    ASSERT_THAT(index.str(), MatchesRegex("000012 pending - [0-9]+ 0 test_session\n"));
+}
+
+TEST(job, discard_build)
+{
+    cis1::memory_os os;
+
+    std::filesystem::path job_dir = "/jobs/test_job";
+
+    std::error_code ec;
+
+    os.write_file(job_dir / "000001" / "job.params", "", ec);
+    ASSERT_FALSE(ec);
+
+    os.write_file(
+            job_dir / "builds.index",
+            "000001 pending - 10 0 test_session\n",
+            ec);
+    ASSERT_FALSE(ec);
+
+    cis1::job job(
+            "test_job",
+            cis1::job::config{"test_script", 5, 5, {}},
+            {}, {},
+            {{1, job_dir / "000001"}},
+            os);
+
+    job.discard_build(1, ec);
+
+    ASSERT_FALSE(ec);
+    ASSERT_TRUE(job.pending_builds().empty());
+    ASSERT_FALSE(os.exists(job_dir / "000001", ec));
+    ASSERT_EQ(os.read_file(job_dir / "builds.index"), "");
 }
 
 ACTION_TEMPLATE(SaveArgReferee,
@@ -701,7 +849,7 @@ TEST(job_execute, job_runner)
 
     std::filesystem::path job_dir = base_dir / "jobs" / "test_job";
 
-    boost::process::environment env{};
+    cis1::environment env{};
 
     EXPECT_CALL(ctx, env())
         .WillOnce(ReturnRef(env));
@@ -752,6 +900,7 @@ TEST(job_execute, job_runner)
                     _,
                     _,
                     _,
+                    _,
                     _))
         .Times(1);
 
@@ -771,6 +920,7 @@ TEST(job_execute, job_runner)
             io_ctx,
             ctx.env(),
             job_dir / "000012",
+            {},
             os);
 
     runner.run_impl(
@@ -819,28 +969,236 @@ TEST(job_execute, correct)
 
     std::filesystem::path job_dir = base_dir / "jobs" / "test_job";
 
-    std::vector<std::unique_ptr<cis1::fs_entry_interface>> fs_entries;
+    EXPECT_CALL(os, iterate_directory(job_dir, _, _))
+        .WillOnce(Invoke(iterate_entries({
+                {"000011", cis1::dir_entry_type::directory, 1},
+                {"job.conf", cis1::dir_entry_type::regular, 2}})));
 
-    auto entry1 = std::make_unique<fs_entry_mock>();
+    EXPECT_CALL(os, create_directory(job_dir / "000012", _))
+        .WillOnce(Return(true));
 
-    EXPECT_CALL(*entry1, is_directory())
+    EXPECT_CALL(os, copy(
+                job_dir / "test_script",
+                job_dir / "000012" / "test_script",
+                _))
+        .Times(1);
+
+    auto ss = std::make_unique<StrictMock<ofstream_mock>>();
+
+    EXPECT_CALL(*ss, is_open())
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(os, open_ofstream(
+                job_dir / "000012" / "job.params",
+                _))
+        .WillOnce(Return(ByMove(std::move(ss))));
+
+    EXPECT_CALL(os, copy(
+                job_dir / "job.conf",
+                job_dir / "000012" / "job.conf",
+                _))
+        .Times(1);
+
+    cis1::environment env{};
+
+    EXPECT_CALL(ctx, env())
+        .WillOnce(ReturnRef(env));
+
+    EXPECT_CALL(ctx, get_env_var("cgroup_root"))
+        .WillOnce(Return(""));
+
+    EXPECT_CALL(ctx, get_env_var("max_concurrent_builds"))
+        .WillOnce(Return(""));
+
+    StrictMock<job_runner_factory_mock> job_runner_factory;
+
+    auto job_runner = std::make_unique<job_runner_mock>();
+
+    std::error_code err;
+
+    EXPECT_CALL(
+            *job_runner,
+            run_impl(
+                    "test_script",
+                    _,
+                    _,
+                    _))
+        .WillOnce(InvokeArgument<1>(err, 0));
+
+    cis1::build_stats stats;
+    stats.wall_time = std::chrono::microseconds{1500};
+    stats.max_rss_kb = 2048;
+
+    EXPECT_CALL(*job_runner, stats())
+        .WillOnce(Return(stats));
+
+    EXPECT_CALL(
+            job_runner_factory,
+            call_operator(
+                    _,
+                    _,
+                    _,
+                    _,
+                    _))
+        .WillOnce(Return(ByMove(std::move(job_runner))));
+
+    ss = std::make_unique<StrictMock<ofstream_mock>>();
+
+    EXPECT_CALL(*ss, is_open())
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(os, open_ofstream(
+                job_dir / "000012" / "output.txt",
+                _))
+        .WillOnce(Return(ByMove(std::move(ss))));
+
+    ss = std::make_unique<StrictMock<ofstream_mock>>();
+
+    std::stringstream fc;
+
+    EXPECT_CALL(*ss, ostream())
+        .WillOnce(ReturnRef(fc));
+
+    EXPECT_CALL(*ss, is_open())
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(
+            os,
+            open_ofstream(
+                    job_dir / "000012" / "exitcode.txt",
+                    _))
+        .WillOnce(Return(ByMove(std::move(ss))));
+
+    ss = std::make_unique<StrictMock<ofstream_mock>>();
+
+    std::stringstream stats_fc;
+
+    EXPECT_CALL(*ss, ostream())
+        .WillOnce(ReturnRef(stats_fc));
+
+    EXPECT_CALL(*ss, is_open())
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(
+            os,
+            open_ofstream(
+                    job_dir / "000012" / "stats.txt",
+                    _))
+        .WillOnce(Return(ByMove(std::move(ss))));
+
+    std::string session_id = "test_session";
+
+    EXPECT_CALL(session, session_id())
+        .WillOnce(ReturnRef(session_id));
+
+    ss = std::make_unique<StrictMock<ofstream_mock>>();
+
+    EXPECT_CALL(*ss, is_open())
+        .WillOnce(Return(true));
+
+    std::stringstream fc2;
+
+    EXPECT_CALL(*ss, ostream())
+        .WillOnce(ReturnRef(fc2));
+
+    EXPECT_CALL(os, open_ofstream(
+                job_dir / "000012" / "session_id.txt",
+                _))
+        .WillOnce(Return(ByMove(std::move(ss))));
+
+    EXPECT_CALL(os, open_lock_file(job_dir / "builds.index.lock", _))
+        .Times(2)
+        .WillRepeatedly(Invoke(shared_file_lock()));
+
+    EXPECT_CALL(os, exists(job_dir / "builds.index", _))
         .WillRepeatedly(Return(true));
 
-    EXPECT_CALL(*entry1, path())
-        .WillRepeatedly(Return(job_dir / "000011"));
+    std::stringstream index;
 
-    fs_entries.push_back(std::move(entry1));
+    EXPECT_CALL(os, open_ofstream(
+                job_dir / "builds.index",
+                std::ios_base::out | std::ios_base::app))
+        .Times(2)
+        .WillRepeatedly(Invoke([&](auto&&...)
+                    -> std::unique_ptr<cis1::ofstream_interface>
+                {
+                    auto file = std::make_unique<StrictMock<ofstream_mock>>();
 
-    auto entry2 = std::make_unique<fs_entry_mock>();
+                    EXPECT_CALL(*file, is_open())
+                        .WillOnce(Return(true));
 
-    EXPECT_CALL(*entry2, is_directory())
-        .WillRepeatedly(Return(false));
+                    EXPECT_CALL(*file, ostream())
+                        .WillOnce(ReturnRef(index));
+
+                    return file;
+                }));
+
+    cis1::job job(
+            "test_job",
+            {
+                "test_script",
+                5,
+                5,
+                {}
+            },
+            {}, {}, {},
+            os);
+
+    std::error_code ec;
+
+    job.prepare_build(ctx, session, {}, ec);
+
+    ASSERT_EQ((bool)ec, false);
 
-    fs_entries.push_back(std::move(entry2));
+    int exit_code = -1;
+    std::optional<cis1::build_stats> result_stats;
 
-    EXPECT_CALL(os, list_directory(job_dir))
-        .WillOnce(Return(ByMove(
-             std::move(fs_entries))));
+    EXPECT_CALL(os, is_executable(
+                job_dir / "000012" / "test_script",
+                _))
+        .WillOnce(Return(true));
+
+    job.execute(
+            12,
+            ctx,
+            ec,
+            [](auto&&...){},
+            exit_code,
+            result_stats,
+            false,
+            std::ref(job_runner_factory));
+
+    ASSERT_EQ((bool)ec, false);
+    ASSERT_EQ(exit_code, 0);
+    ASSERT_STREQ(fc2.str().c_str(), (session_id + "\n").c_str());
+    ASSERT_TRUE((bool)result_stats);
+    ASSERT_EQ(result_stats->max_rss_kb, 2048u);
+    ASSERT_NE(stats_fc.str().find("wall_time_us=1500\n"), std::string::npos);
+    ASSERT_NE(stats_fc.str().find("max_rss_kb=2048\n"), std::string::npos);
+    ASSERT_THAT(index.str(), MatchesRegex(
+            "000012 pending - [0-9]+ 0 test_session\n"
+            "000012 successful 0 [0-9]+ [0-9]+ test_session\n"));
+}
+
+TEST(job_execute, cant_write_stats)
+{
+    using namespace ::testing;
+
+    StrictMock<os_mock> os;
+    StrictMock<context_mock> ctx;
+    StrictMock<session_mock> session;
+
+    std::filesystem::path base_dir = "test_base_dir";
+
+    EXPECT_CALL(ctx, base_dir())
+        .WillRepeatedly(ReturnRef(base_dir));
+
+    std::filesystem::path job_dir = base_dir / "jobs" / "test_job";
+
+    EXPECT_CALL(os, iterate_directory(job_dir, _, _))
+        .WillOnce(Invoke(iterate_entries({
+                {"000011", cis1::dir_entry_type::directory, 1},
+                {"job.conf", cis1::dir_entry_type::regular, 2}})));
 
     EXPECT_CALL(os, create_directory(job_dir / "000012", _))
         .WillOnce(Return(true));
@@ -867,11 +1225,17 @@ TEST(job_execute, correct)
                 _))
         .Times(1);
 
-    boost::process::environment env{};
+    cis1::environment env{};
 
     EXPECT_CALL(ctx, env())
         .WillOnce(ReturnRef(env));
 
+    EXPECT_CALL(ctx, get_env_var("cgroup_root"))
+        .WillOnce(Return(""));
+
+    EXPECT_CALL(ctx, get_env_var("max_concurrent_builds"))
+        .WillOnce(Return(""));
+
     StrictMock<job_runner_factory_mock> job_runner_factory;
 
     auto job_runner = std::make_unique<job_runner_mock>();
@@ -887,12 +1251,20 @@ TEST(job_execute, correct)
                     _))
         .WillOnce(InvokeArgument<1>(err, 0));
 
+    cis1::build_stats stats;
+    stats.wall_time = std::chrono::microseconds{1500};
+    stats.max_rss_kb = 2048;
+
+    EXPECT_CALL(*job_runner, stats())
+        .WillOnce(Return(stats));
+
     EXPECT_CALL(
             job_runner_factory,
             call_operator(
                     _,
                     _,
                     _,
+                    _,
                     _))
         .WillOnce(Return(ByMove(std::move(job_runner))));
 
@@ -923,6 +1295,18 @@ TEST(job_execute, correct)
                     _))
         .WillOnce(Return(ByMove(std::move(ss))));
 
+    ss = std::make_unique<StrictMock<ofstream_mock>>();
+
+    EXPECT_CALL(*ss, is_open())
+        .WillOnce(Return(false));
+
+    EXPECT_CALL(
+            os,
+            open_ofstream(
+                    job_dir / "000012" / "stats.txt",
+                    _))
+        .WillOnce(Return(ByMove(std::move(ss))));
+
     std::string session_id = "test_session";
 
     EXPECT_CALL(session, session_id())
@@ -943,6 +1327,33 @@ TEST(job_execute, correct)
                 _))
         .WillOnce(Return(ByMove(std::move(ss))));
 
+    EXPECT_CALL(os, open_lock_file(job_dir / "builds.index.lock", _))
+        .Times(2)
+        .WillRepeatedly(Invoke(shared_file_lock()));
+
+    EXPECT_CALL(os, exists(job_dir / "builds.index", _))
+        .WillRepeatedly(Return(true));
+
+    std::stringstream index;
+
+    EXPECT_CALL(os, open_ofstream(
+                job_dir / "builds.index",
+                std::ios_base::out | std::ios_base::app))
+        .Times(2)
+        .WillRepeatedly(Invoke([&](auto&&...)
+                    -> std::unique_ptr<cis1::ofstream_interface>
+                {
+                    auto file = std::make_unique<StrictMock<ofstream_mock>>();
+
+                    EXPECT_CALL(*file, is_open())
+                        .WillOnce(Return(true));
+
+                    EXPECT_CALL(*file, ostream())
+                        .WillOnce(ReturnRef(index));
+
+                    return file;
+                }));
+
     cis1::job job(
             "test_job",
             {
@@ -961,6 +1372,7 @@ TEST(job_execute, correct)
     ASSERT_EQ((bool)ec, false);
 
     int exit_code = -1;
+    std::optional<cis1::build_stats> result_stats;
 
     EXPECT_CALL(os, is_executable(
                 job_dir / "000012" / "test_script",
@@ -973,10 +1385,16 @@ TEST(job_execute, correct)
             ec,
             [](auto&&...){},
             exit_code,
+            result_stats,
             false,
             std::ref(job_runner_factory));
 
     ASSERT_EQ((bool)ec, false);
     ASSERT_EQ(exit_code, 0);
     ASSERT_STREQ(fc2.str().c_str(), (session_id + "\n").c_str());
+    ASSERT_TRUE((bool)result_stats);
+    ASSERT_EQ(result_stats->max_rss_kb, 2048u);
+    ASSERT_THAT(index.str(), MatchesRegex(
+            "000012 pending - [0-9]+ 0 test_session\n"
+            "000012 successful 0 [0-9]+ [0-9]+ test_session\n"));
 }
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include <regex>
+
+#include "job_mask.h"
+#include "utils.h"
+
+TEST(job_mask, equivalent_to_regex)
+{
+    const std::vector<std::string> masks =
+    {
+        "",
+        ".*",
+        "project/job",
+        "project/.*",
+        ".*_nightly",
+        "project/.*_nightly",
+        ".*/.*/.*",
+        "a.*b.*a",
+        "project\\/job",
+        "project/job.",
+        "project/jo[a-z]",
+        "(project|other)/.*",
+        "project/\\w+",
+        "project/job?",
+    };
+
+    const std::vector<std::string> names =
+    {
+        "",
+        "project/job",
+        "project/jobs",
+        "project/job_nightly",
+        "other/job_nightly",
+        "project/nested/job",
+        "aba",
+        "ab",
+        "abba",
+        "projectXjob",
+    };
+
+    for(auto& mask : masks)
+    {
+        auto compiled = cis1::job_mask::compile(mask);
+        ASSERT_TRUE(compiled) << mask;
+
+        std::regex rx(mask);
+
+        for(auto& name : names)
+        {
+            ASSERT_EQ(compiled->matches(name), std::regex_match(name, rx))
+                << "mask: " << mask << " name: " << name;
+        }
+    }
+}
+
+TEST(job_mask, invalid)
+{
+    ASSERT_FALSE(cis1::job_mask::compile("project/(job"));
+    ASSERT_FALSE(cis1::job_mask::compile("[a-"));
+    ASSERT_FALSE(cis1::job_mask::compile("\\"));
+}
+
+TEST(is_build, correct)
+{
+    ASSERT_TRUE(is_build("000000"));
+    ASSERT_TRUE(is_build("123456"));
+    ASSERT_FALSE(is_build("12345"));
+    ASSERT_FALSE(is_build("1234567"));
+    ASSERT_FALSE(is_build("12345a"));
+    ASSERT_FALSE(is_build("job.conf"));
+    ASSERT_FALSE(is_build(""));
+}
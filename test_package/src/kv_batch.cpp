@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "kv_batch.h"
+
+TEST(parse_kv_get_args, names)
+{
+    auto args = cis1::parse_kv_get_args({"a", "b"});
+
+    ASSERT_EQ((bool)args, true);
+    ASSERT_EQ(args->all, false);
+    ASSERT_EQ(args->format, cis1::kv_output_format::lines);
+    ASSERT_EQ(args->names, std::vector<std::string>({"a", "b"}));
+}
+
+TEST(parse_kv_get_args, all)
+{
+    auto shell = cis1::parse_kv_get_args({"--all"});
+
+    ASSERT_EQ((bool)shell, true);
+    ASSERT_EQ(shell->all, true);
+    ASSERT_EQ(shell->format, cis1::kv_output_format::shell);
+
+    auto null = cis1::parse_kv_get_args({"--null", "--all"});
+
+    ASSERT_EQ((bool)null, true);
+    ASSERT_EQ(null->format, cis1::kv_output_format::null);
+}
+
+TEST(parse_kv_get_args, invalid)
+{
+    ASSERT_EQ((bool)cis1::parse_kv_get_args({}), false);
+    ASSERT_EQ((bool)cis1::parse_kv_get_args({"--all", "a"}), false);
+    ASSERT_EQ((bool)cis1::parse_kv_get_args({"--shell", "--null", "a"}), false);
+}
+
+TEST(parse_kv_set_args, correct)
+{
+    auto kv = cis1::parse_kv_set_args({"a", "1", "b", "2"});
+
+    ASSERT_EQ((bool)kv, true);
+    ASSERT_EQ(kv.value(), cis1::kv_list({{"a", "1"}, {"b", "2"}}));
+}
+
+TEST(parse_kv_set_args, invalid)
+{
+    ASSERT_EQ((bool)cis1::parse_kv_set_args({}), false);
+    ASSERT_EQ((bool)cis1::parse_kv_set_args({"a", "1", "b"}), false);
+}
+
+TEST(select_kv, correct)
+{
+    std::map<std::string, std::string> values = {{"a", "1"}, {"b", "2"}};
+
+    ASSERT_EQ(
+            cis1::select_kv(*cis1::parse_kv_get_args({"b", "c"}), values),
+            cis1::kv_list({{"b", "2"}, {"c", ""}}));
+
+    ASSERT_EQ(
+            cis1::select_kv(*cis1::parse_kv_get_args({"--all"}), values),
+            cis1::kv_list({{"a", "1"}, {"b", "2"}}));
+}
+
+TEST(print_kv, formats)
+{
+    cis1::kv_list kv = {{"a", "it's"}, {"b.c", "x\ny"}};
+
+    std::stringstream lines;
+
+    ASSERT_EQ(cis1::print_kv(lines, kv, cis1::kv_output_format::lines), 0);
+    ASSERT_EQ(lines.str(), "it's\nx\ny\n");
+
+    std::stringstream shell;
+
+    ASSERT_EQ(cis1::print_kv(shell, kv, cis1::kv_output_format::shell), 1);
+    ASSERT_EQ(shell.str(), "a='it'\\''s'\n");
+
+    std::stringstream null;
+
+    ASSERT_EQ(cis1::print_kv(null, kv, cis1::kv_output_format::null), 0);
+    ASSERT_EQ(null.str(), std::string("a\0it's\0b.c\0x\ny\0", 15));
+}
+
+TEST(format_kv_record, correct)
+{
+    ASSERT_EQ(cis1::format_kv_record({{"a", "1"}}), R"("a"="1")");
+    ASSERT_EQ(
+            cis1::format_kv_record({{"a", "1"}, {"b", "2"}}),
+            R"("a"="1" "b"="2")");
+}
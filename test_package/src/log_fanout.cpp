@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "log_fanout.h"
+
+using CoreRecord = cis1::core_logger::CoreRecord;
+
+class recording_recorder
+    : public scl::IRecorder<CoreRecord>
+{
+public:
+    void OnRecord(const CoreRecord& record) final
+    {
+        records.push_back(&record);
+        threads.push_back(std::this_thread::get_id());
+    }
+
+    std::vector<const CoreRecord*> records;
+    std::vector<std::thread::id> threads;
+};
+
+TEST(log_fanout, dispatch_to_sinks)
+{
+    cis1::log_fanout fanout;
+
+    auto cis = std::make_shared<recording_recorder>();
+    auto session = std::make_shared<recording_recorder>();
+    auto webui = std::make_shared<recording_recorder>();
+
+    fanout.set_sink(cis1::log_sink::cis, cis);
+    fanout.set_sink(cis1::log_sink::session, session);
+    fanout.set_sink(cis1::log_sink::webui, webui);
+
+    ASSERT_TRUE(fanout.has_sinks(cis1::log_sink::cis | cis1::log_sink::offline_webui));
+    ASSERT_FALSE(fanout.has_sinks(static_cast<uint8_t>(cis1::log_sink::offline_webui)));
+
+    CoreRecord record{};
+
+    cis1::fanout_recorder tee(
+            fanout,
+            cis1::log_sink::cis
+            | cis1::log_sink::session
+            | cis1::log_sink::offline_webui);
+    tee.OnRecord(record);
+
+    // record isn't copied for sync sinks
+    ASSERT_EQ(cis->records, std::vector<const CoreRecord*>{&record});
+    ASSERT_EQ(session->records, std::vector<const CoreRecord*>{&record});
+    ASSERT_TRUE(webui->records.empty());
+}
+
+TEST(log_fanout, async_sinks)
+{
+    auto cis = std::make_shared<recording_recorder>();
+    auto session = std::make_shared<recording_recorder>();
+    auto webui = std::make_shared<recording_recorder>();
+
+    {
+        cis1::log_fanout fanout;
+
+        fanout.set_sink(cis1::log_sink::cis, cis, true);
+        fanout.set_sink(cis1::log_sink::session, session, true);
+        fanout.set_sink(cis1::log_sink::webui, webui);
+
+        CoreRecord record{};
+
+        for(int i = 0; i < 3; ++i)
+        {
+            fanout.dispatch(
+                    record,
+                    cis1::log_sink::cis
+                    | cis1::log_sink::session
+                    | cis1::log_sink::webui);
+        }
+
+        fanout.flush();
+
+        ASSERT_EQ(cis->records.size(), 3);
+        ASSERT_EQ(session->records.size(), 3);
+        ASSERT_EQ(webui->records.size(), 3);
+
+        fanout.dispatch(record, static_cast<uint8_t>(cis1::log_sink::cis));
+    }
+
+    // queued record is written when fanout is destroyed
+    ASSERT_EQ(cis->records.size(), 4);
+
+    // both async sinks get the same copy
+    ASSERT_EQ(cis->records[0], session->records[0]);
+    ASSERT_NE(cis->records[0], webui->records[0]);
+
+    // async sinks share one writer thread
+    ASSERT_EQ(cis->threads[0], session->threads[0]);
+    ASSERT_NE(cis->threads[0], std::this_thread::get_id());
+    ASSERT_EQ(webui->threads[0], std::this_thread::get_id());
+}
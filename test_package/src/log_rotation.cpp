@@ -0,0 +1,278 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include "log_rotation.h"
+#include "error_code.h"
+#include "memory_os.h"
+#include "os.h"
+#include "test_utils.h"
+
+class log_rotation_test
+    : public temp_dir_test
+{
+protected:
+    log_rotation_test()
+        : temp_dir_test("log_rotation")
+    {}
+
+    void SetUp() override
+    {
+        temp_dir_test::SetUp();
+
+        std::filesystem::create_directories(dir / "logs");
+        std::filesystem::create_directories(dir / "sessions");
+    }
+
+    void write(
+            const std::filesystem::path& path,
+            const std::string& content,
+            std::chrono::seconds age = std::chrono::seconds{3600})
+    {
+        std::ofstream(path) << content;
+
+        std::filesystem::last_write_time(
+                path,
+                std::filesystem::file_time_type::clock::now() - age);
+    }
+
+    cis1::os os;
+};
+
+TEST(log_rotation, load_options)
+{
+    cis1::environment env;
+    env.set("log_size_limit", "10M");
+    env.set("log_keep_segments", "5");
+    env.set("log_compress_after", "30");
+
+    auto options = cis1::load_log_rotation_options(env);
+
+    ASSERT_EQ(options.size_limit, 10 * 1024 * 1024);
+    ASSERT_EQ(options.keep_segments, 5);
+    ASSERT_EQ(options.compress_after, std::chrono::seconds{30});
+
+    env.set("log_size_limit", "10X");
+    env.set("log_keep_segments", "many");
+
+    options = cis1::load_log_rotation_options(env);
+
+    ASSERT_FALSE(options.size_limit);
+    ASSERT_EQ(options.keep_segments, 0);
+}
+
+TEST(log_rotation, log_day)
+{
+    std::tm tm{};
+    tm.tm_year = 119;
+    tm.tm_mon = 0;
+    tm.tm_mday = 1;
+    tm.tm_hour = 23;
+    tm.tm_min = 59;
+    tm.tm_isdst = -1;
+
+    auto before_midnight = std::mktime(&tm);
+
+    cis1::log_day day(before_midnight);
+
+    ASSERT_FALSE(day.changed(before_midnight + 59));
+    ASSERT_TRUE(day.changed(before_midnight + 60));
+    ASSERT_FALSE(day.changed(before_midnight + 3600));
+}
+
+TEST_F(log_rotation_test, find_rotated_logs)
+{
+    const auto today = cis1::dated_log_name("cis", "");
+
+    write(dir / "logs" / "cis.2019-01-01.0.log", "old");
+    write(dir / "logs" / "cis.2019-01-01.1.log", "newest of past day");
+    write(dir / "logs" / "cis.2019-01-02.0.log", "recent", std::chrono::seconds{0});
+    write(dir / "logs" / "cis.2019-01-02.1.log", "recent", std::chrono::seconds{0});
+    write(dir / "logs" / "cis.2019-01-03.blog", "binary");
+    write(dir / "logs" / (today + ".0.log"), "old");
+    write(dir / "logs" / (today + ".1.log"), "current");
+    write(dir / "logs" / "s1.0.log", "old");
+    write(dir / "logs" / "s1.1.log", "newest of session");
+
+    std::error_code ec;
+
+    auto rotated = cis1::find_rotated_logs(
+            dir / "logs",
+            std::chrono::seconds{60},
+            ec,
+            os);
+
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(rotated, (std::vector<std::filesystem::path>{
+            dir / "logs" / "cis.2019-01-01.0.log",
+            dir / "logs" / "cis.2019-01-01.1.log",
+            dir / "logs" / (today + ".0.log"),
+            dir / "logs" / "s1.0.log"}));
+
+    cis1::find_rotated_logs(dir / "missing", std::chrono::seconds{60}, ec, os);
+
+    ASSERT_EQ(ec, cis1::error_code::cant_read_logs_dir);
+}
+
+TEST_F(log_rotation_test, compressor)
+{
+    const std::string content(100000, 'x');
+
+    write(dir / "sessions" / "s1.0.log", content);
+    write(dir / "sessions" / "s2.0.log", content);
+
+    std::vector<std::filesystem::path> compressed;
+
+    {
+        cis1::log_compressor compressor(
+                os,
+                [&](const std::filesystem::path& path, std::error_code ec)
+                {
+                    ASSERT_FALSE(ec);
+                    compressed.push_back(path);
+                });
+
+        compressor.enqueue(dir / "sessions" / "s1.0.log");
+        compressor.enqueue(dir / "sessions" / "s2.0.log");
+    }
+
+    ASSERT_EQ(compressed.size(), 2);
+    ASSERT_FALSE(std::filesystem::exists(dir / "sessions" / "s1.0.log"));
+
+    auto gz_path = dir / "sessions" / "s1.0.log.gz";
+    ASSERT_LT(std::filesystem::file_size(gz_path), content.size());
+
+    std::ifstream file(gz_path, std::ios_base::in | std::ios_base::binary);
+    boost::iostreams::filtering_istream in;
+    in.push(boost::iostreams::gzip_decompressor());
+    in.push(file);
+
+    std::stringstream ss;
+    boost::iostreams::copy(in, ss);
+
+    ASSERT_EQ(ss.str(), content);
+}
+
+TEST_F(log_rotation_test, retention)
+{
+    write(dir / "logs" / "cis.2019-01-01.0.log.gz", "", std::chrono::seconds{400});
+    write(dir / "logs" / "cis.2019-01-01.1.log", "", std::chrono::seconds{300});
+    write(dir / "logs" / "cis.2019-01-01.blog", "", std::chrono::seconds{500});
+    write(dir / "logs" / "cis.2019-01-02.0.log", "", std::chrono::seconds{200});
+    write(dir / "logs" / "cis.2019-01-02.1.log", "", std::chrono::seconds{100});
+    write(dir / "logs" / "cis.old.log", "", std::chrono::seconds{1000});
+    write(dir / "logs" / "other.log", "", std::chrono::seconds{1000});
+
+    std::error_code ec;
+
+    ASSERT_EQ(cis1::apply_log_retention(dir / "logs", 0, ec, os), 0);
+    ASSERT_EQ(cis1::apply_log_retention(dir / "logs", 2, ec, os), 2);
+    ASSERT_FALSE(ec);
+
+    ASSERT_FALSE(std::filesystem::exists(dir / "logs" / "cis.2019-01-01.0.log.gz"));
+    ASSERT_FALSE(std::filesystem::exists(dir / "logs" / "cis.2019-01-01.1.log"));
+    ASSERT_TRUE(std::filesystem::exists(dir / "logs" / "cis.2019-01-01.blog"));
+    ASSERT_TRUE(std::filesystem::exists(dir / "logs" / "cis.old.log"));
+    ASSERT_TRUE(std::filesystem::exists(dir / "logs" / "cis.2019-01-02.0.log"));
+    ASSERT_TRUE(std::filesystem::exists(dir / "logs" / "cis.2019-01-02.1.log"));
+    ASSERT_TRUE(std::filesystem::exists(dir / "logs" / "other.log"));
+}
+
+TEST_F(log_rotation_test, session_index)
+{
+    write(dir / "sessions" / "s1.0.log.gz", "");
+    write(dir / "sessions" / "s1.1.log", "");
+    write(dir / "sessions" / "s1.combined.log", "");
+    write(dir / "sessions" / "s1.graph", "");
+    write(dir / "sessions" / "s10.0.log", "");
+
+    std::error_code ec;
+
+    cis1::update_session_index(dir, "s1", ec, os);
+    ASSERT_FALSE(ec);
+
+    // index is not listed in itself
+    cis1::update_session_index(dir, "s1", ec, os);
+    ASSERT_FALSE(ec);
+
+    std::ifstream index(dir / "sessions" / "s1.index");
+    std::stringstream ss;
+    ss << index.rdbuf();
+
+    ASSERT_EQ(ss.str(), "s1.0.log.gz\ns1.1.log\ns1.combined.log\ns1.graph\n");
+}
+
+TEST(log_rotation, compress_memory_os)
+{
+    cis1::memory_os os;
+
+    std::error_code ec;
+
+    os.write_file("/logs/cis.2019-01-01.0.log", "records", ec);
+    ASSERT_FALSE(ec);
+
+    auto modified = std::filesystem::file_time_type::clock::now()
+            - std::chrono::hours{1};
+    os.set_last_write_time("/logs/cis.2019-01-01.0.log", modified, ec);
+
+    cis1::compress_log("/logs/cis.2019-01-01.0.log", ec, os);
+    ASSERT_FALSE(ec);
+
+    ASSERT_FALSE(os.read_file("/logs/cis.2019-01-01.0.log"));
+    ASSERT_EQ(os.last_write_time("/logs/cis.2019-01-01.0.log.gz", ec), modified);
+
+    std::stringstream gz(os.read_file("/logs/cis.2019-01-01.0.log.gz").value());
+    boost::iostreams::filtering_istream in;
+    in.push(boost::iostreams::gzip_decompressor());
+    in.push(gz);
+
+    std::stringstream ss;
+    boost::iostreams::copy(in, ss);
+
+    ASSERT_EQ(ss.str(), "records");
+}
+
+TEST(log_rotation, find_rotated_session_logs)
+{
+    cis1::memory_os os;
+
+    std::error_code ec;
+
+    const auto old = std::filesystem::file_time_type::clock::now()
+            - std::chrono::hours{1};
+
+    for(auto name : {"s1.0.log.gz", "s1.1.log", "s1.2.log", "s1.3.log", "s10.0.log"})
+    {
+        os.write_file(std::filesystem::path{"/sessions"} / name, "", ec);
+        os.set_last_write_time(std::filesystem::path{"/sessions"} / name, old, ec);
+    }
+
+    // recently written segment is left
+    os.write_file("/sessions/s1.2.log", "", ec);
+    ASSERT_FALSE(ec);
+
+    auto rotated = cis1::find_rotated_session_logs(
+            "/sessions",
+            "s1",
+            std::chrono::seconds{60},
+            ec,
+            os);
+
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(rotated, std::vector<std::filesystem::path>{"/sessions/s1.1.log"});
+
+    rotated = cis1::find_rotated_session_logs(
+            "/sessions",
+            "s2",
+            std::chrono::seconds{60},
+            ec,
+            os);
+
+    ASSERT_FALSE(ec);
+    ASSERT_TRUE(rotated.empty());
+}
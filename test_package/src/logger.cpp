@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include "logger.h"
+
+TEST(logger, log_level_from_string)
+{
+    ASSERT_EQ(log_level_from_string("debug"), log_level::debug);
+    ASSERT_EQ(log_level_from_string("warning"), log_level::warning);
+    ASSERT_EQ(log_level_from_string("action"), log_level::action);
+    ASSERT_FALSE(log_level_from_string("verbose"));
+}
+
+TEST(logger, action_log_level)
+{
+    static_assert(action_log_level(actions::error) == log_level::error);
+    static_assert(action_log_level(actions::job_stats) == log_level::info);
+    static_assert(action_log_level(actions::start_job) == log_level::action);
+}
+
+TEST(logger, skip_below_threshold)
+{
+    auto threshold = log_threshold;
+    log_threshold = log_level::info;
+
+    int evaluated = 0;
+
+    auto arg = [&]()
+    {
+        ++evaluated;
+
+        return std::string("arg");
+    };
+
+    CIS_DEBUG(actions::start_job, "%s", arg());
+    SES_DEBUG(actions::start_job, "%s", arg());
+
+    ASSERT_EQ(evaluated, 0);
+
+    CIS_LOG(actions::start_job, "%s", arg());
+
+    ASSERT_EQ(evaluated, 1);
+
+    log_threshold = log_level::debug;
+
+    CIS_DEBUG(actions::start_job, "%s", arg());
+
+    ASSERT_EQ(evaluated, log_level_compiled(log_level::debug) ? 2 : 1);
+
+    log_threshold = log_level::action;
+
+    CIS_LOG(actions::error, "%s", arg());
+    CIS_LOG(actions::job_stats, "%s", arg());
+
+    ASSERT_EQ(evaluated, log_level_compiled(log_level::debug) ? 2 : 1);
+
+    log_threshold = log_level::error;
+
+    CIS_LOG(actions::error, "%s", arg());
+
+    ASSERT_EQ(evaluated, log_level_compiled(log_level::debug) ? 3 : 2);
+
+    log_threshold = threshold;
+}
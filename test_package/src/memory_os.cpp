@@ -0,0 +1,271 @@
+#include <gtest/gtest.h>
+
+#include "memory_os.h"
+#include "context.h"
+#include "job.h"
+#include "session.h"
+
+TEST(memory_os, directories)
+{
+    cis1::memory_os os;
+    std::error_code ec;
+
+    ASSERT_TRUE(os.create_directory("/a", ec));
+    ASSERT_EQ((bool)ec, false);
+
+    ASSERT_FALSE(os.create_directory("/a", ec));
+    ASSERT_EQ((bool)ec, false);
+
+    ASSERT_FALSE(os.create_directory("/b/c", ec));
+    ASSERT_EQ(ec, std::errc::no_such_file_or_directory);
+
+    os.create_directories("/b/c/d", ec);
+    ASSERT_EQ((bool)ec, false);
+
+    ASSERT_TRUE(os.is_directory("/b/c/./d/", ec));
+    ASSERT_TRUE(os.exists("/b/c/../c/d", ec));
+
+    ASSERT_FALSE(os.exists("/x/y", ec));
+    ASSERT_EQ((bool)ec, false);
+
+    ASSERT_FALSE(os.is_directory("/x", ec));
+    ASSERT_EQ(ec, std::errc::no_such_file_or_directory);
+
+    os.remove("/b/c", ec);
+    ASSERT_EQ(ec, std::errc::directory_not_empty);
+
+    os.remove_all("/b", ec);
+    ASSERT_EQ((bool)ec, false);
+    ASSERT_FALSE(os.exists("/b", ec));
+
+    os.remove("/b", ec);
+    ASSERT_EQ((bool)ec, false);
+}
+
+TEST(memory_os, iterate_directory)
+{
+    cis1::memory_os os;
+    std::error_code ec;
+
+    os.write_file("/dir/b", "", ec);
+    os.write_file("/dir/a", "", ec);
+    os.create_directories("/dir/c", ec);
+
+    std::vector<std::pair<std::string, cis1::dir_entry_type>> entries;
+
+    os.iterate_directory(
+            "/dir",
+            [&](const cis1::dir_entry& entry)
+            {
+                entries.emplace_back(entry.name, entry.type);
+
+                // directory can be modified from callback
+                std::error_code remove_ec;
+                os.remove("/dir/c", remove_ec);
+
+                return true;
+            },
+            ec);
+
+    ASSERT_EQ((bool)ec, false);
+    ASSERT_EQ(entries.size(), 3);
+    ASSERT_EQ(entries[0].first, "a");
+    ASSERT_EQ(entries[0].second, cis1::dir_entry_type::regular);
+    ASSERT_EQ(entries[2].first, "c");
+    ASSERT_EQ(entries[2].second, cis1::dir_entry_type::directory);
+
+    ASSERT_EQ(os.list_directory("/dir").size(), 2);
+
+    os.iterate_directory("/dir/a", [](auto&){ return true; }, ec);
+    ASSERT_EQ(ec, std::errc::not_a_directory);
+
+    ASSERT_THROW(os.list_directory("/missing"), std::filesystem::filesystem_error);
+}
+
+TEST(memory_os, streams)
+{
+    cis1::memory_os os;
+    std::error_code ec;
+
+    os.create_directories("/dir", ec);
+
+    auto out = os.open_ofstream("/dir/file");
+    ASSERT_TRUE(out->is_open());
+
+    out->ostream() << "line " << 1 << "\n";
+
+    // visible without flush
+    ASSERT_EQ(os.read_file("/dir/file").value(), "line 1\n");
+
+    os.open_ofstream("/dir/file", std::ios_base::app)->ostream() << "line 2\n";
+
+    auto in = os.open_ifstream("/dir/file");
+    ASSERT_TRUE(in->is_open());
+
+    std::string line;
+    std::getline(in->istream(), line);
+    ASSERT_EQ(line, "line 1");
+    std::getline(in->istream(), line);
+    ASSERT_EQ(line, "line 2");
+
+    os.open_ofstream("/dir/file")->ostream() << "new";
+    ASSERT_EQ(os.read_file("/dir/file").value(), "new");
+
+    ASSERT_FALSE(os.open_ofstream("/missing/file")->is_open());
+    ASSERT_FALSE(os.open_ofstream("/dir")->is_open());
+    ASSERT_FALSE(os.open_ifstream("/dir/missing")->is_open());
+    ASSERT_FALSE(os.open_ifstream("/dir")->is_open());
+}
+
+TEST(memory_os, rename)
+{
+    cis1::memory_os os;
+    std::error_code ec;
+
+    os.write_file("/dir/file.tmp", "new", ec);
+    os.write_file("/dir/file", "old", ec);
+
+    auto out = os.open_ofstream("/dir/file.tmp", std::ios_base::app);
+
+    os.rename("/dir/file.tmp", "/dir/file", ec);
+    ASSERT_EQ((bool)ec, false);
+    ASSERT_FALSE(os.exists("/dir/file.tmp", ec));
+
+    // opened stream follows renamed file
+    out->ostream() << "er";
+    ASSERT_EQ(os.read_file("/dir/file").value(), "newer");
+
+    os.create_directories("/dir/sub/inner", ec);
+
+    os.rename("/dir/file", "/dir/sub", ec);
+    ASSERT_EQ(ec, std::errc::is_a_directory);
+
+    os.rename("/dir", "/dir/sub/inner/dir", ec);
+    ASSERT_EQ(ec, std::errc::invalid_argument);
+
+    os.rename("/dir/missing", "/dir/other", ec);
+    ASSERT_EQ(ec, std::errc::no_such_file_or_directory);
+
+    os.rename("/dir/sub", "/moved", ec);
+    ASSERT_EQ((bool)ec, false);
+    ASSERT_TRUE(os.is_directory("/moved/inner", ec));
+}
+
+TEST(memory_os, file_locks)
+{
+    cis1::memory_os os;
+    auto other = os.clone();
+    std::error_code ec;
+
+    auto first = os.open_lock_file("/queue.lock", ec);
+    ASSERT_EQ((bool)ec, false);
+    ASSERT_TRUE(os.exists("/queue.lock", ec));
+
+    auto second = other->open_lock_file("/queue.lock", ec);
+    ASSERT_EQ((bool)ec, false);
+
+    ASSERT_TRUE(first->lock_shared());
+    ASSERT_TRUE(second->lock_shared());
+    ASSERT_FALSE(second->try_lock());
+
+    first->unlock();
+    ASSERT_TRUE(second->try_lock());
+    ASSERT_FALSE(first->try_lock());
+
+    // lock belongs to file, not to path
+    os.remove("/queue.lock", ec);
+    auto third = os.open_lock_file("/queue.lock", ec);
+    ASSERT_TRUE(third->try_lock());
+    ASSERT_FALSE(first->try_lock());
+
+    second.reset();
+    ASSERT_TRUE(first->try_lock());
+
+    ASSERT_EQ(os.open_lock_file("/", ec), nullptr);
+    ASSERT_EQ(ec, std::errc::is_a_directory);
+}
+
+TEST(memory_os, copy)
+{
+    cis1::memory_os os;
+    std::error_code ec;
+
+    os.write_file("/job/script", "#!/bin/sh\n", ec, true);
+    os.create_directories("/job/000001", ec);
+
+    os.copy("/job/script", "/job/000001/script", ec);
+    ASSERT_EQ((bool)ec, false);
+    ASSERT_EQ(os.read_file("/job/000001/script").value(), "#!/bin/sh\n");
+    ASSERT_TRUE(os.is_executable("/job/000001/script", ec));
+
+    os.copy("/job/script", "/job/000001/script", ec);
+    ASSERT_EQ(ec, std::errc::file_exists);
+
+    // copy is independent of source
+    os.write_file("/job/script", "changed", ec);
+    ASSERT_EQ(os.read_file("/job/000001/script").value(), "#!/bin/sh\n");
+
+    os.copy("/job", "/copy", ec);
+    ASSERT_EQ((bool)ec, false);
+    ASSERT_TRUE(os.exists("/copy/script", ec));
+    ASSERT_TRUE(os.is_directory("/copy/000001", ec));
+    ASSERT_FALSE(os.exists("/copy/000001/script", ec));
+}
+
+TEST(memory_os, clone_and_spawn)
+{
+    cis1::memory_os os;
+    std::error_code ec;
+
+    os.set_env_var("cis_base_dir", "/base");
+
+    auto clone = os.clone();
+    ASSERT_EQ(clone->get_env_var("cis_base_dir"), "/base");
+    ASSERT_EQ(clone->get_env_var("missing"), "");
+
+    os.set_spawn_handler(
+            [&](const cis1::spawned_process& process)
+            {
+                // simulated process effect
+                std::error_code spawn_ec;
+                os.write_file(process.start_dir + "/started", process.executable, spawn_ec);
+            });
+
+    clone->spawn_process("/base", "startjob", {"job"}, cis1::environment{});
+
+    auto spawned = os.spawned();
+    ASSERT_EQ(spawned.size(), 1);
+    ASSERT_EQ(spawned[0].args, std::vector<std::string>{"job"});
+    ASSERT_EQ(os.read_file("/base/started").value(), "startjob");
+}
+
+TEST(memory_os, prepare_build)
+{
+    cis1::memory_os os;
+    std::error_code ec;
+
+    os.write_file(
+            "/base/jobs/job/job.conf",
+            "script=script\n"
+            "keep_last_success_builds=1\n"
+            "keep_last_break_builds=1\n",
+            ec);
+    os.write_file("/base/jobs/job/job.params", "param=value\n", ec);
+    os.write_file("/base/jobs/job/script", "#!/bin/sh\n", ec, true);
+    os.create_directories("/base/jobs/job/000041", ec);
+
+    cis1::context ctx("/base", {});
+    cis1::session session{"session", false};
+
+    auto job = cis1::load_job("job", ec, ctx, os);
+    ASSERT_EQ((bool)ec, false);
+    ASSERT_TRUE(job);
+
+    auto handle = job->prepare_build(ctx, session, job->params(), ec);
+    ASSERT_EQ((bool)ec, false);
+    ASSERT_EQ(handle.number_string(), "000042");
+
+    ASSERT_EQ(os.read_file("/base/jobs/job/000042/job.params").value(), "param=value\n");
+    ASSERT_EQ(os.read_file("/base/jobs/job/000042/session_id.txt").value(), "session\n");
+    ASSERT_TRUE(os.exists("/base/jobs/job/000042/script", ec));
+}
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include "parallel_builds.h"
+#include "os_mock.h"
+#include "context_mock.h"
+#include "ofstream_mock.h"
+#include "job_runner_mock.h"
+
+TEST(run_parallel, concurrency_limit)
+{
+    using namespace ::testing;
+
+    NiceMock<os_mock> os;
+    NiceMock<context_mock> ctx;
+
+    std::stringstream sink;
+
+    ON_CALL(os, is_executable(_, _))
+        .WillByDefault(Return(true));
+
+    ON_CALL(os, exists(_, _))
+        .WillByDefault(Return(true));
+
+    ON_CALL(os, open_ofstream(_, _))
+        .WillByDefault(Invoke([&](auto&&...)
+                -> std::unique_ptr<cis1::ofstream_interface>
+                {
+                    auto file = std::make_unique<NiceMock<ofstream_mock>>();
+
+                    ON_CALL(*file, is_open())
+                        .WillByDefault(Return(true));
+
+                    ON_CALL(*file, ostream())
+                        .WillByDefault(ReturnRef(sink));
+
+                    return file;
+                }));
+
+    std::filesystem::path jobs_dir = "test_base_dir/jobs";
+
+    std::vector<cis1::job> jobs;
+    jobs.reserve(3);
+
+    for(auto name : {"job_0", "job_1", "job_2"})
+    {
+        jobs.emplace_back(
+                name,
+                cis1::job::config{"test_script", 5, 5, {}},
+                std::map<uint32_t, std::filesystem::path>{},
+                std::map<uint32_t, std::filesystem::path>{},
+                std::map<uint32_t, std::filesystem::path>{
+                        {1, jobs_dir / name / "000001"}},
+                os);
+    }
+
+    std::vector<cis1::parallel_build> builds;
+
+    for(auto& job : jobs)
+    {
+        builds.push_back({job, 1, cis1::environment{}});
+    }
+
+    size_t running = 0;
+    size_t max_running = 0;
+
+    StrictMock<job_runner_factory_mock> job_runner_factory;
+
+    EXPECT_CALL(job_runner_factory, call_operator(_, _, _, _, _))
+        .Times(3)
+        .WillRepeatedly(Invoke([&](
+                        boost::asio::io_context& io_ctx,
+                        const cis1::environment&,
+                        const std::filesystem::path& working_dir,
+                        auto&&...)
+                -> std::unique_ptr<cis1::job_runner_interface>
+                {
+                    auto runner = std::make_unique<NiceMock<job_runner_mock>>();
+
+                    int exit_code = working_dir.parent_path().filename() == "job_1"
+                            ? 3
+                            : 0;
+
+                    ON_CALL(*runner, run_impl(_, _, _, _))
+                        .WillByDefault(Invoke([&, exit_code](
+                                        auto&&,
+                                        auto& on_exit,
+                                        auto& on_out_line,
+                                        auto&&...)
+                                {
+                                    max_running = std::max(max_running, ++running);
+
+                                    on_out_line("output");
+
+                                    // finishes when io_context is run
+                                    boost::asio::post(
+                                            io_ctx,
+                                            [&running, on_exit, exit_code]()
+                                            {
+                                                --running;
+                                                on_exit({}, exit_code);
+                                            });
+                                }));
+
+                    return runner;
+                }));
+
+    std::vector<std::string> finished;
+    std::vector<std::string> lines;
+
+    cis1::run_parallel(
+            builds,
+            2,
+            ctx,
+            false,
+            {},
+            [&](cis1::parallel_build& build)
+            {
+                finished.push_back(build.build_job.name());
+            },
+            [&](cis1::parallel_build& build, bool error, const std::string& line)
+            {
+                ASSERT_FALSE(error);
+
+                lines.push_back(build.build_job.name() + ": " + line);
+            },
+            std::ref(job_runner_factory));
+
+    ASSERT_EQ(max_running, 2);
+    ASSERT_EQ(finished.size(), 3);
+    ASSERT_EQ(finished.back(), "job_2");
+    ASSERT_EQ(lines, (std::vector<std::string>{
+            "job_0: output",
+            "job_1: output",
+            "job_2: output"}));
+
+    ASSERT_FALSE(builds[0].ec);
+    ASSERT_EQ(builds[0].exit_code, 0);
+    ASSERT_EQ(builds[1].exit_code, 3);
+    ASSERT_EQ(builds[2].exit_code, 0);
+    ASSERT_LE(builds[2].started_ms, builds[2].finished_ms);
+
+    ASSERT_EQ(jobs[0].successful_builds().count(1), 1);
+    ASSERT_EQ(jobs[1].broken_builds().count(1), 1);
+    ASSERT_TRUE(jobs[2].pending_builds().empty());
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+#include "memory_os.h"
+#include "os.h"
+#include "process_launcher.h"
+
+namespace
+{
+
+// launcher keeps waiting for SIGCHLD, so io_context never runs out of work
+template <class Predicate>
+bool run_until(boost::asio::io_context& io_ctx, Predicate&& predicate)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+
+    while(!predicate() && std::chrono::steady_clock::now() < deadline)
+    {
+        io_ctx.run_one_for(std::chrono::milliseconds{10});
+    }
+
+    return predicate();
+}
+
+} // namespace
+
+TEST(process_launcher, launch)
+{
+    cis1::memory_os os;
+    boost::asio::io_context io_ctx;
+
+    auto main_thread = std::this_thread::get_id();
+    std::thread::id spawn_thread;
+
+    os.set_spawn_handler(
+            [&](const cis1::spawned_process&)
+            {
+                spawn_thread = std::this_thread::get_id();
+            });
+
+    cis1::process_launcher launcher(io_ctx, os);
+
+    launcher.launch("/base", "core/startjob", {"job1"}, cis1::environment{});
+    launcher.launch("/base", "core/startjob", {"job2"}, cis1::environment{});
+
+    ASSERT_TRUE(run_until(
+            io_ctx,
+            [&]()
+            {
+                return launcher.stats().spawned == 2;
+            }));
+
+    ASSERT_NE(spawn_thread, main_thread);
+
+    auto spawned = os.spawned();
+    ASSERT_EQ(spawned.size(), 2);
+    ASSERT_EQ(spawned[0].args, std::vector<std::string>{"job1"});
+    ASSERT_EQ(spawned[1].args, std::vector<std::string>{"job2"});
+
+    auto& stats = launcher.stats();
+    ASSERT_EQ(stats.failed, 0);
+    ASSERT_GE(stats.max_latency, stats.last_latency);
+    ASSERT_GE(stats.total_latency, stats.max_latency);
+}
+
+TEST(process_launcher, spawn_error)
+{
+    cis1::memory_os os;
+    boost::asio::io_context io_ctx;
+
+    os.set_spawn_handler(
+            [&](const cis1::spawned_process&)
+            {
+                throw std::runtime_error("no such executable");
+            });
+
+    cis1::process_launcher launcher(io_ctx, os);
+
+    launcher.launch("/base", "core/startjob", {"job"}, cis1::environment{});
+
+    ASSERT_TRUE(run_until(
+            io_ctx,
+            [&]()
+            {
+                return launcher.stats().failed == 1;
+            }));
+
+    ASSERT_EQ(launcher.stats().spawned, 0);
+}
+
+TEST(process_launcher, destroyed_with_posted_results)
+{
+    cis1::memory_os os;
+    boost::asio::io_context io_ctx;
+
+    {
+        cis1::process_launcher launcher(io_ctx, os);
+
+        launcher.launch("/base", "core/startjob", {"job"}, cis1::environment{});
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+        while(os.spawned().empty() && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+
+        ASSERT_EQ(os.spawned().size(), 1);
+    }
+
+    // result of spawn is posted after launcher is gone
+    io_ctx.poll();
+}
+
+#ifdef __linux__
+TEST(process_launcher, reap_children)
+{
+    cis1::os std_os;
+    boost::asio::io_context io_ctx;
+
+    cis1::process_launcher launcher(io_ctx, std_os);
+
+    launcher.launch("/", "/bin/sh", {"-c", "exit 0"}, cis1::environment::current());
+
+    ASSERT_TRUE(run_until(
+            io_ctx,
+            [&]()
+            {
+                return launcher.stats().spawned == 1
+                    && launcher.stats().reaped >= 1;
+            }))
+            << "spawned=" << launcher.stats().spawned
+            << " failed=" << launcher.stats().failed
+            << " reaped=" << launcher.stats().reaped;
+
+    ASSERT_EQ(launcher.stats().outstanding(), 0);
+}
+#endif
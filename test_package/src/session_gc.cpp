@@ -0,0 +1,263 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include "session_gc.h"
+#include "memory_os.h"
+#include "os.h"
+#include "test_utils.h"
+#include "utils.h"
+
+class session_gc_test
+    : public temp_dir_test
+{
+protected:
+    session_gc_test()
+        : temp_dir_test("session_gc")
+    {}
+
+    void SetUp() override
+    {
+        temp_dir_test::SetUp();
+
+        std::filesystem::create_directories(dir / "sessions");
+    }
+
+    void write(
+            const std::string& name,
+            const std::string& content = "",
+            std::chrono::hours age = std::chrono::hours{0})
+    {
+        auto path = dir / "sessions" / name;
+
+        std::ofstream(path) << content;
+
+        std::filesystem::last_write_time(
+                path,
+                std::filesystem::file_time_type::clock::now() - age);
+    }
+
+    bool exists(const std::string& name)
+    {
+        return std::filesystem::exists(dir / "sessions" / name);
+    }
+
+    std::string journal()
+    {
+        std::ifstream file(cis1::closed_sessions_path(dir));
+        return {std::istreambuf_iterator<char>(file), {}};
+    }
+
+    cis1::os os;
+};
+
+TEST(session_gc, load_options)
+{
+    cis1::environment env;
+    env.set("session_keep_hours", "2");
+    env.set("session_abandon_hours", "48");
+    env.set("session_gc_threads", "0");
+    env.set("session_gc_rate", "100");
+
+    auto options = cis1::load_session_gc_options(env);
+
+    ASSERT_EQ(options.keep_closed, std::chrono::hours{2});
+    ASSERT_EQ(options.keep_abandoned, std::chrono::hours{48});
+    ASSERT_EQ(options.threads, 4);
+    ASSERT_EQ(options.max_removes_per_second, 100);
+}
+
+TEST_F(session_gc_test, record_closed_session)
+{
+    std::error_code ec;
+
+    cis1::record_closed_session(dir, "s1", ec, os);
+    ASSERT_EQ((bool)ec, false);
+
+    cis1::record_closed_session(dir, "s2", ec, os);
+    ASSERT_EQ((bool)ec, false);
+
+    auto records = journal();
+
+    ASSERT_NE(records.find(" s1\n"), std::string::npos);
+    ASSERT_NE(records.find(" s2\n"), std::string::npos);
+}
+
+TEST_F(session_gc_test, collect_closed_sessions)
+{
+    auto old = std::to_string(unix_time_now() - 3 * 3600);
+    auto recent = std::to_string(unix_time_now());
+
+    // old session with index
+    write("s1.dat");
+    write("s1.0.log");
+    write("s1.0.log.gz");
+    write("s1.index", "s1.dat\ns1.0.log\ns1.0.log.gz\n../escape\n");
+    // old session without index
+    write("s2.dat");
+    write("s2.prm");
+    write("s2.0.log");
+    write("s2.1.log.gz");
+    write("s2.combined.log");
+    // recently closed session
+    write("s3.dat");
+    write("s3.index", "s3.dat\n");
+    // not closed session
+    write("s4.dat");
+
+    std::ofstream(cis1::closed_sessions_path(dir))
+            << old << " s1\n"
+            << old << " s2\n"
+            << recent << " s3\n"
+            << "invalid\n"
+            << old << " ../escape\n";
+
+    cis1::session_gc_options options;
+    options.keep_closed = std::chrono::hours{1};
+    options.threads = 2;
+
+    std::error_code ec;
+
+    auto stats = cis1::collect_closed_sessions(dir, options, ec, os);
+
+    ASSERT_EQ((bool)ec, false);
+    ASSERT_EQ(stats.sessions, 2);
+    ASSERT_EQ(stats.files, 9);
+    ASSERT_EQ(stats.failed, 0);
+
+    ASSERT_FALSE(exists("s1.dat"));
+    ASSERT_FALSE(exists("s1.index"));
+    ASSERT_FALSE(exists("s2.1.log.gz"));
+    ASSERT_FALSE(exists("s2.combined.log"));
+    ASSERT_TRUE(exists("s3.dat"));
+    ASSERT_TRUE(exists("s3.index"));
+    ASSERT_TRUE(exists("s4.dat"));
+
+    ASSERT_EQ(journal(), recent + " s3\n");
+}
+
+TEST_F(session_gc_test, collect_closed_sessions_no_journal)
+{
+    std::error_code ec;
+
+    auto stats = cis1::collect_closed_sessions(
+            dir,
+            cis1::session_gc_options{},
+            ec,
+            os);
+
+    ASSERT_EQ((bool)ec, false);
+    ASSERT_EQ(stats.sessions, 0);
+}
+
+TEST_F(session_gc_test, collect_abandoned_sessions)
+{
+    write("old.dat", "", std::chrono::hours{5});
+    write("old.0.log", "", std::chrono::hours{3});
+    write("active.dat", "", std::chrono::hours{5});
+    write("active.0.log");
+    write("closed_sessions", "", std::chrono::hours{5});
+
+    cis1::session_gc_options options;
+    options.keep_abandoned = std::chrono::hours{2};
+
+    std::error_code ec;
+
+    auto stats = cis1::collect_abandoned_sessions(dir, options, ec, os);
+
+    ASSERT_EQ((bool)ec, false);
+    ASSERT_EQ(stats.sessions, 1);
+    ASSERT_EQ(stats.files, 2);
+
+    ASSERT_FALSE(exists("old.dat"));
+    ASSERT_FALSE(exists("old.0.log"));
+    ASSERT_TRUE(exists("active.dat"));
+    ASSERT_TRUE(exists("active.0.log"));
+    ASSERT_TRUE(exists("closed_sessions"));
+}
+
+TEST(session_gc, find_session_files)
+{
+    cis1::memory_os os;
+
+    std::error_code ec;
+
+    for(auto name : {"s1.dat", "s1.dat.lock", "s1.graph", "s1.0.log.gz", "s1.1.log", "s1.3.log", "s10.dat"})
+    {
+        os.write_file(std::filesystem::path{"/sessions"} / name, "", ec);
+    }
+
+    auto files = cis1::find_session_files("/sessions", "s1", ec, os);
+
+    ASSERT_FALSE(ec);
+    // segments are probed until the first missing number
+    ASSERT_EQ(files, (std::vector<std::string>{
+            "s1.dat", "s1.dat.lock", "s1.graph", "s1.0.log.gz", "s1.1.log"}));
+}
+
+TEST(session_gc, memory_os)
+{
+    cis1::memory_os os;
+
+    std::error_code ec;
+
+    os.create_directories("/cis/sessions", ec);
+    ASSERT_FALSE(ec);
+
+    os.write_file("/cis/sessions/s1.dat", "", ec);
+    os.write_file("/cis/sessions/s1.index", "s1.dat\ns1.0.log\n", ec);
+    os.write_file("/cis/sessions/s2.dat", "", ec);
+    os.write_file("/cis/sessions/s3.dat", "", ec);
+    os.set_last_write_time(
+            "/cis/sessions/s3.dat",
+            std::filesystem::file_time_type::clock::now() - std::chrono::hours{5},
+            ec);
+    ASSERT_FALSE(ec);
+
+    auto old = std::to_string(unix_time_now() - 3 * 3600);
+
+    os.write_file(cis1::closed_sessions_path("/cis"), old + " s1\n", ec);
+
+    cis1::record_closed_session("/cis", "s2", ec, os);
+    ASSERT_FALSE(ec);
+
+    cis1::session_gc_options options;
+    options.keep_closed = std::chrono::hours{1};
+    options.keep_abandoned = std::chrono::hours{2};
+
+    auto stats = cis1::collect_closed_sessions("/cis", options, ec, os);
+
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(stats.sessions, 1);
+    ASSERT_EQ(stats.files, 2);
+    ASSERT_FALSE(os.read_file("/cis/sessions/s1.index"));
+    ASSERT_TRUE(os.read_file("/cis/sessions/s2.dat"));
+
+    auto journal = os.read_file(cis1::closed_sessions_path("/cis"));
+    ASSERT_TRUE(journal);
+    ASSERT_NE(journal.value().find(" s2\n"), std::string::npos);
+    ASSERT_EQ(journal.value().find(" s1\n"), std::string::npos);
+
+    stats = cis1::collect_abandoned_sessions("/cis", options, ec, os);
+
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(stats.sessions, 1);
+    ASSERT_EQ(stats.files, 1);
+    ASSERT_FALSE(os.read_file("/cis/sessions/s3.dat"));
+}
+
+TEST(rate_limiter, limits_rate)
+{
+    cis1::rate_limiter limiter(100);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(int i = 0; i < 11; ++i)
+    {
+        limiter.acquire();
+    }
+
+    ASSERT_GE(
+            std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds{100});
+}
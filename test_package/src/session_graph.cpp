@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include "session_graph.h"
+#include "error_code.h"
+#include "os_mock.h"
+#include "ifstream_mock.h"
+#include "ofstream_mock.h"
+
+TEST(session_graph, append_node)
+{
+    using namespace ::testing;
+
+    StrictMock<os_mock> os;
+
+    auto path = cis1::session_graph_path("test_base_dir", "test_session");
+
+    ASSERT_EQ(path, std::filesystem::path("test_base_dir/sessions/test_session.graph"));
+
+    auto file = std::make_unique<StrictMock<ofstream_mock>>();
+
+    std::stringstream graph;
+
+    EXPECT_CALL(*file, is_open())
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(*file, ostream())
+        .WillOnce(ReturnRef(graph));
+
+    EXPECT_CALL(os, open_ofstream(path, std::ios_base::out | std::ios_base::app))
+        .WillOnce(Return(ByMove(std::move(file))));
+
+    cis1::graph_node node;
+    node.job = "project/child";
+    node.build = "000003";
+    node.started_ms = 1000;
+    node.finished_ms = 1500;
+    node.exit_code = 1;
+
+    std::error_code ec;
+
+    cis1::append_graph_node(path, node, ec, os);
+
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(graph.str(), "project/child 000003 - - 1000 1500 1\n");
+}
+
+TEST(session_graph, read_nodes)
+{
+    using namespace ::testing;
+
+    StrictMock<os_mock> os;
+
+    std::filesystem::path path = "test_base_dir/sessions/test_session.graph";
+
+    std::stringstream graph(
+            "p/child 000001 p/root 000007 10 20 0\n"
+            "p/root 000007 - - 0 30 1\n"
+            "p/torn 0000");
+
+    auto file = std::make_unique<StrictMock<ifstream_mock>>();
+
+    EXPECT_CALL(*file, is_open())
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(*file, istream())
+        .WillRepeatedly(ReturnRef(graph));
+
+    EXPECT_CALL(os, open_ifstream(path, _))
+        .WillOnce(Return(ByMove(std::move(file))));
+
+    std::error_code ec;
+
+    auto nodes = cis1::read_session_graph(path, ec, os);
+
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(nodes.size(), 2);
+
+    ASSERT_EQ(nodes[0].job, "p/child");
+    ASSERT_EQ(nodes[0].parent_job, "p/root");
+    ASSERT_EQ(nodes[0].parent_build, "000007");
+    ASSERT_EQ(nodes[0].started_ms, 10);
+    ASSERT_EQ(nodes[0].finished_ms, 20);
+
+    ASSERT_EQ(nodes[1].job, "p/root");
+    ASSERT_TRUE(nodes[1].parent_job.empty());
+    ASSERT_TRUE(nodes[1].parent_build.empty());
+    ASSERT_EQ(nodes[1].exit_code, 1);
+}
+
+TEST(session_graph, analyze)
+{
+    // root [0, 100) runs a [10, 40) and b [40, 90) one by one,
+    // b runs c [45, 85) and d [50, 70) in parallel
+    std::vector<cis1::graph_node> nodes{
+        {"c", "000001", "b", "000001", 45, 85, 0},
+        {"d", "000001", "b", "000001", 50, 70, 0},
+        {"a", "000001", "root", "000001", 10, 40, 0},
+        {"b", "000001", "root", "000001", 40, 90, 0},
+        {"root", "000001", "", "", 0, 100, 0},
+    };
+
+    auto summary = cis1::analyze_session_graph(nodes);
+
+    ASSERT_EQ(summary.wall_ms, 100);
+    // root 20 + a 30 + b 10 + c 40 + d 20
+    ASSERT_EQ(summary.work_ms, 120);
+    ASSERT_DOUBLE_EQ(summary.parallelism, 1.2);
+
+    ASSERT_EQ(summary.critical_path.size(), 3);
+    ASSERT_EQ(summary.critical_path[0].node, 4);
+    ASSERT_EQ(summary.critical_path[0].self_ms, 20);
+    ASSERT_EQ(summary.critical_path[1].node, 3);
+    ASSERT_EQ(summary.critical_path[1].self_ms, 10);
+    ASSERT_EQ(summary.critical_path[2].node, 0);
+    ASSERT_EQ(summary.critical_path[2].duration_ms, 40);
+
+    ASSERT_EQ(summary.fan_outs.size(), 2);
+    ASSERT_EQ(summary.fan_outs[0].node, 4);
+    ASSERT_EQ(summary.fan_outs[0].children_ms, 80);
+    ASSERT_EQ(summary.fan_outs[0].busy_ms, 80);
+    ASSERT_EQ(summary.fan_outs[1].node, 3);
+    ASSERT_EQ(summary.fan_outs[1].children_ms, 60);
+    ASSERT_EQ(summary.fan_outs[1].busy_ms, 40);
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <set>
+#include <thread>
+
+#include "session_id.h"
+
+TEST(session_id, format)
+{
+    cis1::session_id_generator generator(1);
+
+    auto id = generator.next(1571036400123);
+
+    ASSERT_EQ(id.size(), cis1::session_id_size);
+    ASSERT_EQ(id.find_first_not_of("0123456789ABCDEFGHJKMNPQRSTVWXYZ"), std::string::npos);
+
+    auto info = cis1::parse_session_id(id);
+
+    ASSERT_EQ((bool)info, true);
+    ASSERT_EQ(info->unix_time_ms, 1571036400123);
+    ASSERT_EQ(info->legacy, false);
+}
+
+TEST(session_id, sorted_by_time)
+{
+    cis1::session_id_generator generator(1);
+
+    auto first = generator.next(1000);
+    auto second = generator.next(1000);
+    auto third = generator.next(1001);
+    // clock goes back
+    auto fourth = generator.next(999);
+
+    ASSERT_LT(first, second);
+    ASSERT_LT(second, third);
+    ASSERT_LT(third, fourth);
+
+    auto global_first = cis1::generate_session_id();
+    auto global_second = cis1::generate_session_id();
+
+    ASSERT_LT(global_first, global_second);
+}
+
+TEST(session_id, parse_legacy)
+{
+    auto info = cis1::parse_session_id("2019-10-14-12-00-00-1234_1");
+
+    ASSERT_EQ((bool)info, true);
+    ASSERT_EQ(info->legacy, true);
+
+    std::tm tm{};
+    tm.tm_year = 2019 - 1900;
+    tm.tm_mon = 9;
+    tm.tm_mday = 14;
+    tm.tm_hour = 12;
+    tm.tm_isdst = -1;
+
+    ASSERT_EQ(info->unix_time_ms, std::mktime(&tm) * 1000);
+
+    ASSERT_EQ((bool)cis1::parse_session_id("2019-10-14-12-00-00-15282_15275"), true);
+}
+
+TEST(session_id, parse_invalid)
+{
+    ASSERT_EQ((bool)cis1::parse_session_id(""), false);
+    ASSERT_EQ((bool)cis1::parse_session_id("2019-10-14-12-00-00-1234"), false);
+    ASSERT_EQ((bool)cis1::parse_session_id("2019-10-14-12-00-00-12_a"), false);
+    ASSERT_EQ((bool)cis1::parse_session_id("80000000000000000000000000"), false);
+    ASSERT_EQ((bool)cis1::parse_session_id("0000000000000000000000000U"), false);
+}
+
+TEST(session_id, unique_under_load)
+{
+    // generators of several hosts creating ids in the same milliseconds
+    const size_t hosts = 4;
+    const size_t threads_per_host = 4;
+    const size_t ids_per_thread = 20000;
+
+    std::vector<std::unique_ptr<cis1::session_id_generator>> generators;
+    for(size_t i = 0; i < hosts; ++i)
+    {
+        generators.push_back(std::make_unique<cis1::session_id_generator>());
+    }
+
+    std::vector<std::vector<std::string>> ids(hosts * threads_per_host);
+    std::vector<std::thread> threads;
+
+    for(size_t i = 0; i < ids.size(); ++i)
+    {
+        threads.emplace_back(
+                [&, i]()
+                {
+                    auto& generator = *generators[i % hosts];
+
+                    ids[i].reserve(ids_per_thread);
+                    for(size_t j = 0; j < ids_per_thread; ++j)
+                    {
+                        ids[i].push_back(generator.next(1571036400000 + j / 1000));
+                    }
+                });
+    }
+
+    for(auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    std::set<std::string> unique;
+
+    for(auto& thread_ids : ids)
+    {
+        ASSERT_TRUE(std::is_sorted(thread_ids.begin(), thread_ids.end()));
+
+        unique.insert(thread_ids.begin(), thread_ids.end());
+    }
+
+    ASSERT_EQ(unique.size(), hosts * threads_per_host * ids_per_thread);
+}
@@ -1,11 +1,13 @@
 #include <gtest/gtest.h>
 
 #include "set_param.h"
+#include "utils.h"
 #include "os_mock.h"
 #include "context_mock.h"
 #include "session_mock.h"
 #include "ifstream_mock.h"
 #include "ofstream_mock.h"
+#include "file_lock_mock.h"
 
 #define VALUE_NAME "origin\nvalue"
 #define VALUE R"(2 = 4 \ 2)"
@@ -32,6 +34,9 @@ TEST(set_param, correct)
     EXPECT_CALL(session, session_id())
         .WillOnce(ReturnRef(session_id));
 
+    EXPECT_CALL(os, open_lock_file(base_dir / "sessions" / (session_id + ".prm.lock"), _))
+        .WillOnce(exclusive_file_lock());
+
     EXPECT_CALL(
             os,
             exists( base_dir / "sessions" / (session_id + ".prm"),
@@ -65,13 +70,15 @@ TEST(set_param, correct)
     EXPECT_CALL(*oss, ostream())
         .WillOnce(ReturnRef(fc2));
 
+    auto session_prm = base_dir / "sessions" / (session_id + ".prm");
+
     EXPECT_CALL(
             os,
-            open_ofstream(
-                    base_dir / "sessions" / (session_id + ".prm"),
-                    _))
+            open_ofstream(tmp_file_path(session_prm), _))
         .WillOnce(Return(ByMove(std::move(oss))));
 
+    EXPECT_CALL(os, rename(tmp_file_path(session_prm), session_prm, _));
+
     std::error_code ec;
 
     cis1::set_param(ctx, session, VALUE_NAME, VALUE, ec, os);
@@ -98,6 +105,9 @@ TEST(set_param, no_file)
     EXPECT_CALL(session, session_id())
         .WillOnce(ReturnRef(session_id));
 
+    EXPECT_CALL(os, open_lock_file(base_dir / "sessions" / (session_id + ".prm.lock"), _))
+        .WillOnce(exclusive_file_lock());
+
     EXPECT_CALL(
             os,
             exists( base_dir / "sessions" / (session_id + ".prm"),
@@ -114,13 +124,15 @@ TEST(set_param, no_file)
     EXPECT_CALL(*oss, ostream())
         .WillOnce(ReturnRef(fc2));
 
+    auto session_prm = base_dir / "sessions" / (session_id + ".prm");
+
     EXPECT_CALL(
             os,
-            open_ofstream(
-                    base_dir / "sessions" / (session_id + ".prm"),
-                    _))
+            open_ofstream(tmp_file_path(session_prm), _))
         .WillOnce(Return(ByMove(std::move(oss))));
 
+    EXPECT_CALL(os, rename(tmp_file_path(session_prm), session_prm, _));
+
     std::error_code ec;
 
     cis1::set_param(ctx, session, "test_value", "value", ec, os);
@@ -147,6 +159,9 @@ TEST(set_param, invalid_file)
     EXPECT_CALL(session, session_id())
         .WillOnce(ReturnRef(session_id));
 
+    EXPECT_CALL(os, open_lock_file(base_dir / "sessions" / (session_id + ".prm.lock"), _))
+        .WillOnce(exclusive_file_lock());
+
     EXPECT_CALL(
             os,
             exists( base_dir / "sessions" / (session_id + ".prm"),
@@ -1,11 +1,17 @@
 #include <gtest/gtest.h>
 
+#include <thread>
+
 #include "set_value.h"
+#include "get_value.h"
+#include "memory_os.h"
+#include "utils.h"
 #include "os_mock.h"
 #include "context_mock.h"
 #include "session_mock.h"
 #include "ifstream_mock.h"
 #include "ofstream_mock.h"
+#include "file_lock_mock.h"
 
 #define VALUE_NAME "origin\nvalue"
 #define VALUE R"(2 = 4 \ 2)"
@@ -32,6 +38,9 @@ TEST(set_value, correct)
     EXPECT_CALL(session, session_id())
         .WillOnce(ReturnRef(session_id));
 
+    EXPECT_CALL(os, open_lock_file(base_dir / "sessions" / (session_id + ".dat.lock"), _))
+        .WillOnce(exclusive_file_lock());
+
     EXPECT_CALL(
             os,
             exists( base_dir / "sessions" / (session_id + ".dat"),
@@ -65,13 +74,15 @@ TEST(set_value, correct)
     EXPECT_CALL(*oss, ostream())
         .WillOnce(ReturnRef(fc2));
 
+    auto session_dat = base_dir / "sessions" / (session_id + ".dat");
+
     EXPECT_CALL(
             os,
-            open_ofstream(
-                    base_dir / "sessions" / (session_id + ".dat"),
-                    _))
+            open_ofstream(tmp_file_path(session_dat), _))
         .WillOnce(Return(ByMove(std::move(oss))));
 
+    EXPECT_CALL(os, rename(tmp_file_path(session_dat), session_dat, _));
+
     std::error_code ec;
 
     cis1::set_value(ctx, session, VALUE_NAME, VALUE, ec, os);
@@ -98,6 +109,9 @@ TEST(set_value, no_file)
     EXPECT_CALL(session, session_id())
         .WillOnce(ReturnRef(session_id));
 
+    EXPECT_CALL(os, open_lock_file(base_dir / "sessions" / (session_id + ".dat.lock"), _))
+        .WillOnce(exclusive_file_lock());
+
     EXPECT_CALL(
             os,
             exists( base_dir / "sessions" / (session_id + ".dat"),
@@ -114,13 +128,15 @@ TEST(set_value, no_file)
     EXPECT_CALL(*oss, ostream())
         .WillOnce(ReturnRef(fc2));
 
+    auto session_dat = base_dir / "sessions" / (session_id + ".dat");
+
     EXPECT_CALL(
             os,
-            open_ofstream(
-                    base_dir / "sessions" / (session_id + ".dat"),
-                    _))
+            open_ofstream(tmp_file_path(session_dat), _))
         .WillOnce(Return(ByMove(std::move(oss))));
 
+    EXPECT_CALL(os, rename(tmp_file_path(session_dat), session_dat, _));
+
     std::error_code ec;
 
     cis1::set_value(ctx, session, "test_value", "value", ec, os);
@@ -147,6 +163,9 @@ TEST(set_value, invalid_file)
     EXPECT_CALL(session, session_id())
         .WillOnce(ReturnRef(session_id));
 
+    EXPECT_CALL(os, open_lock_file(base_dir / "sessions" / (session_id + ".dat.lock"), _))
+        .WillOnce(exclusive_file_lock());
+
     EXPECT_CALL(
             os,
             exists( base_dir / "sessions" / (session_id + ".dat"),
@@ -178,3 +197,202 @@ TEST(set_value, invalid_file)
 
     ASSERT_EQ((bool)ec, true);
 }
+
+TEST(set_values, batch)
+{
+    using namespace ::testing;
+
+    StrictMock<context_mock> ctx;
+    StrictMock<session_mock> session;
+    StrictMock<os_mock> os;
+
+    std::filesystem::path base_dir = "/";
+
+    EXPECT_CALL(ctx, base_dir())
+        .WillOnce(ReturnRef(base_dir));
+
+    std::string session_id = "test_session";
+
+    EXPECT_CALL(session, session_id())
+        .WillOnce(ReturnRef(session_id));
+
+    EXPECT_CALL(os, open_lock_file(base_dir / "sessions" / (session_id + ".dat.lock"), _))
+        .WillOnce(exclusive_file_lock());
+
+    auto session_dat = base_dir / "sessions" / (session_id + ".dat");
+
+    EXPECT_CALL(os, exists(session_dat, _))
+        .WillOnce(Return(true));
+
+    auto iss = std::make_unique<StrictMock<ifstream_mock>>();
+
+    EXPECT_CALL(*iss, is_open())
+        .WillOnce(Return(true));
+
+    std::stringstream fc;
+
+    fc << "a=old\n";
+    fc << "c=kept\n";
+
+    EXPECT_CALL(*iss, istream())
+        .WillOnce(ReturnRef(fc));
+
+    EXPECT_CALL(os, open_ifstream(session_dat, _))
+        .WillOnce(Return(ByMove(std::move(iss))));
+
+    auto oss = std::make_unique<StrictMock<ofstream_mock>>();
+
+    EXPECT_CALL(*oss, is_open())
+        .WillOnce(Return(true));
+
+    std::stringstream fc2;
+
+    EXPECT_CALL(*oss, ostream())
+        .WillOnce(ReturnRef(fc2));
+
+    EXPECT_CALL(os, open_ofstream(tmp_file_path(session_dat), _))
+        .WillOnce(Return(ByMove(std::move(oss))));
+
+    EXPECT_CALL(os, rename(tmp_file_path(session_dat), session_dat, _));
+
+    std::error_code ec;
+
+    cis1::set_values(
+            ctx,
+            session,
+            {{"a", "new"}, {VALUE_NAME, VALUE}, {"b", "1"}, {"b", "2"}},
+            ec,
+            os);
+
+    ASSERT_EQ((bool)ec, false);
+    ASSERT_STREQ(
+            fc2.str().c_str(),
+            "a=new\n"
+            "b=2\n"
+            "c=kept\n"
+            ENCODED_VALUE_NAME "=" ENCODED_VALUE "\n");
+}
+
+TEST(set_values, rename_error)
+{
+    using namespace ::testing;
+
+    StrictMock<context_mock> ctx;
+    StrictMock<session_mock> session;
+    StrictMock<os_mock> os;
+
+    std::filesystem::path base_dir = "/";
+
+    EXPECT_CALL(ctx, base_dir())
+        .WillOnce(ReturnRef(base_dir));
+
+    std::string session_id = "test_session";
+
+    EXPECT_CALL(session, session_id())
+        .WillOnce(ReturnRef(session_id));
+
+    EXPECT_CALL(os, open_lock_file(base_dir / "sessions" / (session_id + ".dat.lock"), _))
+        .WillOnce(exclusive_file_lock());
+
+    auto session_dat = base_dir / "sessions" / (session_id + ".dat");
+
+    EXPECT_CALL(os, exists(session_dat, _))
+        .WillOnce(Return(false));
+
+    auto oss = std::make_unique<StrictMock<ofstream_mock>>();
+
+    EXPECT_CALL(*oss, is_open())
+        .WillOnce(Return(true));
+
+    std::stringstream fc2;
+
+    EXPECT_CALL(*oss, ostream())
+        .WillOnce(ReturnRef(fc2));
+
+    EXPECT_CALL(os, open_ofstream(tmp_file_path(session_dat), _))
+        .WillOnce(Return(ByMove(std::move(oss))));
+
+    EXPECT_CALL(os, rename(tmp_file_path(session_dat), session_dat, _))
+        .WillOnce(SetArgReferee<2>(
+                std::make_error_code(std::errc::permission_denied)));
+
+    EXPECT_CALL(os, remove(tmp_file_path(session_dat), _));
+
+    std::error_code ec;
+
+    cis1::set_values(ctx, session, {{"a", "1"}, {"b", "2"}}, ec, os);
+
+    ASSERT_EQ(ec, cis1::error_code::cant_write_session_values_file);
+}
+
+TEST(set_value, tmp_file_per_thread)
+{
+    std::filesystem::path session_dat = "test_base_dir/sessions/test_session.dat";
+
+    std::filesystem::path other_thread_tmp;
+
+    std::thread([&]()
+    {
+        other_thread_tmp = tmp_file_path(session_dat);
+    }).join();
+
+    ASSERT_EQ(tmp_file_path(session_dat), tmp_file_path(session_dat));
+    ASSERT_NE(tmp_file_path(session_dat), other_thread_tmp);
+}
+
+TEST(set_values, concurrent_batches)
+{
+    using namespace ::testing;
+
+    NiceMock<context_mock> ctx;
+    NiceMock<session_mock> session;
+    cis1::memory_os os;
+
+    std::filesystem::path base_dir = "/";
+    std::string session_id = "test_session";
+
+    EXPECT_CALL(ctx, base_dir())
+        .WillRepeatedly(ReturnRef(base_dir));
+
+    EXPECT_CALL(session, session_id())
+        .WillRepeatedly(ReturnRef(session_id));
+
+    std::error_code ec;
+
+    os.create_directories("/sessions", ec);
+    ASSERT_FALSE(ec);
+
+    auto writer = [&](const std::string& prefix)
+    {
+        for(int i = 0; i < 50; ++i)
+        {
+            std::error_code set_ec;
+
+            cis1::set_values(
+                    ctx,
+                    session,
+                    {{prefix + std::to_string(i), "1"}},
+                    set_ec,
+                    os);
+
+            ASSERT_FALSE(set_ec);
+        }
+    };
+
+    std::thread first(writer, "a");
+    std::thread second(writer, "b");
+
+    first.join();
+    second.join();
+
+    // keys of concurrent batches aren't lost
+    for(auto* name : {"a0", "a49", "b0", "b49"})
+    {
+        ASSERT_EQ(cis1::get_value(ctx, session, name, ec, os), "1");
+        ASSERT_FALSE(ec);
+    }
+
+    auto content = os.read_file("/sessions/test_session.dat");
+    ASSERT_TRUE(content);
+    ASSERT_EQ(std::count(content->begin(), content->end(), '\n'), 100);
+}